@@ -175,6 +175,7 @@ static void PrintHelp()
   std::cout << "  -t --tile %d,%d            set tile size." << std::endl;
   std::cout << "  -n --number-resolution %d  set number of resolution." << std::endl;
   std::cout << "     --irreversible          set irreversible." << std::endl;
+  std::cout << "     --threads %d            number of frames encoded/decoded concurrently (0: one per processor)." << std::endl;
   std::cout << "Special Options:" << std::endl;
   std::cout << "  -I --ignore-errors   convert even if file is corrupted (advanced users only, see disclaimers)." << std::endl;
   std::cout << "Env var:" << std::endl;
@@ -485,6 +486,7 @@ int main (int argc, char *argv[])
   int ignoreerrors = 0;
   int jpeglserror = 0;
   int jpeglserror_value = 0;
+  int nthreads = 1;
 
   while (1) {
     //int this_option_optind = optind ? optind : 1;
@@ -541,6 +543,7 @@ int main (int argc, char *argv[])
         {"number-resolution", 1, &nres, 1}, //
         {"irreversible", 0, &irreversible, 1}, //
         {"allowed-error", 1, &jpeglserror, 1}, //
+        {"threads", 1, 0, 0}, //
 
 // General options !
         {"verbose", 0, &verbose, 1},
@@ -633,6 +636,11 @@ int main (int argc, char *argv[])
             assert( strcmp(s, "allowed-error") == 0 );
             jpeglserror_value = atoi(optarg);
             }
+          else if( option_index == 49 ) /* threads */
+            {
+            assert( strcmp(s, "threads") == 0 );
+            nthreads = atoi(optarg);
+            }
           //printf (" with arg %s, index = %d", optarg, option_index);
           }
         //printf ("\n");
@@ -1165,6 +1173,9 @@ int main (int argc, char *argv[])
     gdcm::ImageChangeTransferSyntax change;
     change.SetForce( (force > 0 ? true: false));
     change.SetCompressIconImage( (compressicon > 0 ? true: false));
+    image.SetNumberOfThreads( nthreads );
+    change.SetNumberOfThreads( nthreads );
+    j2kcodec.SetNumberOfThreads( nthreads );
     if( jpeg )
       {
       if( lossy )
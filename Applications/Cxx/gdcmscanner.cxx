@@ -60,6 +60,8 @@ static void PrintHelp()
   std::cout << "Options:" << std::endl;
   std::cout << "  -p --print      Print output." << std::endl;
   std::cout << "  -r --recursive  Recusively descend directory." << std::endl;
+  std::cout << "     --threads %d Number of threads reading files (0: one per processor)." << std::endl;
+  std::cout << "     --index %s   Persistent index, only read files modified since the last scan." << std::endl;
   std::cout << "General Options:" << std::endl;
   std::cout << "  -V --verbose    more verbose (warning+error)." << std::endl;
   std::cout << "  -W --warning    print warning info." << std::endl;
@@ -76,6 +78,8 @@ int main(int argc, char *argv[])
 
   bool print = false;
   bool recursive = false;
+  unsigned int nthreads = 1;
+  std::string indexfilename;
   std::string dirname;
   typedef std::vector<gdcm::Tag> VectorTags;
   typedef std::vector<gdcm::PrivateTag> VectorPrivateTags;
@@ -100,6 +104,8 @@ int main(int argc, char *argv[])
         {"recursive", 1, 0, 0},
         {"print", 1, 0, 0},
         {"private-tag", 1, 0, 0},
+        {"threads", 1, 0, 0},
+        {"index", 1, 0, 0},
 
 // General options !
         {"verbose", 0, &verbose, 1},
@@ -123,7 +129,17 @@ int main(int argc, char *argv[])
       {
     case 0:
         {
-        //const char *s = long_options[option_index].name;
+        const char *s = long_options[option_index].name; (void)s;
+        if( option_index == 5 ) /* threads */
+          {
+          assert( strcmp(s, "threads") == 0 );
+          nthreads = (unsigned int)atoi(optarg);
+          }
+        else if( option_index == 6 ) /* index */
+          {
+          assert( strcmp(s, "index") == 0 );
+          indexfilename = optarg;
+          }
         //printf ("option %s", s);
         //if (optarg)
         //  {
@@ -262,6 +278,11 @@ int main(int argc, char *argv[])
 
   gdcm::SmartPointer<gdcm::Scanner> ps = new gdcm::Scanner;
   gdcm::Scanner &s = *ps;
+  s.SetNumberOfThreads( nthreads );
+  if( !indexfilename.empty() )
+    {
+    s.SetIndexFileName( indexfilename.c_str() );
+    }
   //gdcm::SimpleSubjectWatcher watcher(ps, "Scanner");
   for( VectorTags::const_iterator it = tags.begin(); it != tags.end(); ++it)
     {
@@ -22,6 +22,7 @@
  */
 
 #include "gdcmCompositeNetworkFunctions.h"
+#include "gdcmULStorageServer.h"
 
 #include <iostream>
 #include <fstream>
@@ -51,6 +52,7 @@ static void PrintHelp()
 {
   PrintVersion();
   std::cout << "Usage: gdcmscu [OPTION]...[OPERATION]...HOSTNAME...[PORT]..." << std::endl;
+  std::cout << "   or: gdcmscu --server [OPTION]... -p PORT" << std::endl;
   std::cout << "Execute a DICOM Q/R operation to HOSTNAME, using port PORT (104 when not specified)\n";
   std::cout << "Options:" << std::endl;
   std::cout << "  -H --hostname       Hostname." << std::endl;
@@ -63,10 +65,13 @@ static void PrintHelp()
   std::cout << "     --find           C-FIND." << std::endl;
   std::cout << "     --move           C-MOVE." << std::endl;
   std::cout << "     --get            C-GET." << std::endl;
+  std::cout << "     --server         C-STORE SCP: receive files on PORT until interrupted." << std::endl;
   std::cout << "C-STORE Options:" << std::endl;
   std::cout << "  -i --input          DICOM filename" << std::endl;
   std::cout << "  -r --recursive      recursively process (sub-)directories." << std::endl;
   std::cout << "     --store-query    Store constructed query in file." << std::endl;
+  std::cout << "     --associations   Number of concurrent associations (default 1, 0 for one per processor)." << std::endl;
+  std::cout << "     --operations     Number of C-STORE outstanding per association (default 1, 0 for no limit)." << std::endl;
   std::cout << "C-FIND Options:" << std::endl;
   std::cout << "     --worklist       C-FIND Worklist Model." << std::endl;
   std::cout << "     --patientroot    C-FIND Patient Root Model." << std::endl;
@@ -84,6 +89,9 @@ static void PrintHelp()
   std::cout << "     --key            0123,4567=VALUE for specifying search criteria (wildcard not allowed)." << std::endl;
   std::cout << "  Note that C-MOVE supports the same queries as C-FIND, but no wildcards are allowed." << std::endl;
   std::cout << "C-GET Options:" << std::endl;
+  std::cout << "C-STORE SCP Options:" << std::endl;
+  std::cout << "  -o --output         DICOM output directory (default is current directory)." << std::endl;
+  std::cout << "     --associations   Number of associations served concurrently (default 1, 0 for one per processor)." << std::endl;
   std::cout << "General Options:" << std::endl;
   std::cout << "     --root-uid               Root UID." << std::endl;
   std::cout << "  -V --verbose   more verbose (warning+error)." << std::endl;
@@ -164,6 +172,7 @@ int main(int argc, char *argv[])
   int findmode = 0;
   int movemode = 0;
   int getmode = 0;
+  int servermode = 0;
   int findworklist = 0;
   int findpatientroot = 0;
   int findstudyroot = 0;
@@ -178,6 +187,10 @@ int main(int argc, char *argv[])
   int recursive = 0;
   int logfile = 0;
   std::string logfilename;
+  int associations = 0;
+  unsigned int nassociations = 1;
+  int operations = 0;
+  unsigned int maxoperations = 1;
   gdcm::Tag tag;
   std::vector< std::pair<gdcm::Tag, std::string> > keys;
   
@@ -224,6 +237,9 @@ int main(int argc, char *argv[])
       {"image", 0, &imagequery, 1}, // --image
       {"log-file", 1, &logfile, 1}, // --log-file
       {"get", 0, &getmode, 1}, // --get
+      {"associations", 1, &associations, 1}, // (31) --associations
+      {"operations", 1, &operations, 1}, // --operations
+      {"server", 0, &servermode, 1}, // --server
       {0, 0, 0, 0} // required
     };
     static const char short_options[] = "i:H:p:L:VWDEhvk:o:r";
@@ -305,6 +321,16 @@ int main(int argc, char *argv[])
             assert( strcmp(s, "log-file") == 0 );
             logfilename = optarg;
           }
+          else if( option_index == 31 ) /* associations */
+          {
+            assert( strcmp(s, "associations") == 0 );
+            nassociations = atoi(optarg);
+          }
+          else if( option_index == 32 ) /* operations */
+          {
+            assert( strcmp(s, "operations") == 0 );
+            maxoperations = atoi(optarg);
+          }
           else
           {
             // If you reach here someone mess-up the index and the argument in
@@ -494,7 +520,7 @@ int main(int argc, char *argv[])
     gdcm::UIDGenerator::SetRoot( root.c_str() );
     }
   
-  if( shostname.empty() )
+  if( shostname.empty() && !servermode )
     {
     //std::cerr << "Hostname missing" << std::endl;
     PrintHelp(); // needed to display help message when no arg
@@ -543,6 +569,10 @@ int main(int argc, char *argv[])
     {
     mode = "get";
     }
+  else if ( servermode )
+    {
+    mode = "server";
+    }
   else if ( findworklist )
     {
     mode = "worklist";
@@ -552,9 +582,21 @@ int main(int argc, char *argv[])
 
   if ( mode == "server" ) // C-STORE SCP
     {
-    // MM: Do not expose that to user for now (2010/10/11).
-    //CStoreServer( port );
-    return 1;
+    // ./bin/gdcmscu --server -p 11112 -o /incoming --associations 8
+    gdcm::network::ULStorageServer server;
+    server.SetPort( (uint16_t)port );
+    if( !outputdir.empty() )
+      {
+      server.SetDirectory( outputdir );
+      }
+    server.SetNumberOfThreads( nassociations );
+    if( !server.Listen() )
+      {
+      std::cerr << "Could not listen on port " << port << std::endl;
+      return 1;
+      }
+    server.Run(); // until interrupted
+    return 0;
     }
   else if ( mode == "echo" ) // C-ECHO SCU
     {
@@ -757,9 +799,37 @@ int main(int argc, char *argv[])
         thefiles.push_back(*file);
         }
       }
-    bool didItWork = 
-      gdcm::CompositeNetworkFunctions::CStore(hostname, (uint16_t)port, thefiles,
-        callingaetitle.c_str(), callaetitle.c_str());
+    bool didItWork;
+    if( nassociations == 1 && maxoperations == 1 )
+      {
+      didItWork =
+        gdcm::CompositeNetworkFunctions::CStore(hostname, (uint16_t)port, thefiles,
+          callingaetitle.c_str(), callaetitle.c_str());
+      }
+    else
+      {
+      gdcm::CompositeNetworkFunctions::StoreReport report;
+      didItWork =
+        gdcm::CompositeNetworkFunctions::CStore(hostname, (uint16_t)port, thefiles,
+          nassociations, &report, callingaetitle.c_str(), callaetitle.c_str(),
+          (uint16_t)maxoperations);
+      for( size_t i = 0; i < report.Statuses.size(); ++i )
+        {
+        if( report.Statuses[i] < 0 )
+          std::cerr << "Not sent: " << thefiles[i] << std::endl;
+        else if( report.Statuses[i] != 0 )
+          std::cerr << "Status 0x" << std::hex << report.Statuses[i] << std::dec
+            << ": " << thefiles[i] << std::endl;
+        }
+      if( report.NumberOfAssociations )
+        {
+        std::cout << "Stored " << report.NumberOfBytes << " bytes over "
+          << report.NumberOfAssociations << " associations in " << report.Seconds << "s";
+        if( report.Seconds > 0 )
+          std::cout << " (" << (double)report.NumberOfBytes / report.Seconds / (1024. * 1024.) << " MB/s)";
+        std::cout << std::endl;
+        }
+      }
 
     gdcmDebugMacro( (didItWork ? "Store was successful." : "Store failed.") );
     return didItWork ? 0 : 1;
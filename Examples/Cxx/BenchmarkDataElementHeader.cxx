@@ -0,0 +1,228 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+/*
+ * Benchmark of the Explicit VR Little Endian header fast path
+ * (see ExplicitDataElement::DecodePreValue).
+ *
+ * First decode the headers of a synthetic buffer of data elements, through
+ * the regular ReadPreValue (one std::istream::read per field) and through
+ * DecodePreValue. Then, for each Explicit VR Little Endian file given on the
+ * command line, compare a regular Reader (std::istringstream) with a memory
+ * mapped Reader, which uses the fast path, and check both DataSet are
+ * identical. Note that the second number includes opening and mapping the
+ * file, which dominates for small files.
+ *
+ * Usage:
+ *   BenchmarkDataElementHeader
+ *   BenchmarkDataElementHeader gdcmData/
+ *   BenchmarkDataElementHeader file1.dcm file2.dcm ...
+ */
+#include "gdcmReader.h"
+#include "gdcmDirectory.h"
+#include "gdcmSystem.h"
+#include "gdcmExplicitDataElement.h"
+#include "gdcmSwapper.h"
+#include "gdcmTrace.h"
+
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+
+static double Elapsed(std::clock_t start)
+{
+  return double(std::clock() - start) / CLOCKS_PER_SEC;
+}
+
+// Mix of 16bits and 32bits VL elements, with short values
+static std::string CreateBuffer(unsigned int nelements)
+{
+  std::ostringstream os;
+  for( unsigned int i = 0; i < nelements; ++i )
+    {
+    gdcm::DataElement de( gdcm::Tag(0x0009, (uint16_t)(i % 0xffff)) );
+    switch( i % 3 )
+      {
+    case 0:
+      de.SetVR( gdcm::VR::US );
+      de.SetByteValue( "\1\0", 2 );
+      break;
+    case 1:
+      de.SetVR( gdcm::VR::UI );
+      de.SetByteValue( "1.2.840.10008.1.2.1", 20 );
+      break;
+    default:
+      de.SetVR( gdcm::VR::OB );
+      de.SetByteValue( "\0\1\2\3", 4 );
+      }
+    static_cast<gdcm::ExplicitDataElement&>(de).Write<gdcm::SwapperNoOp>( os );
+    }
+  return os.str();
+}
+
+static void BenchmarkHeaders(int niter)
+{
+  const unsigned int nelements = 100000;
+  const std::string buffer = CreateBuffer( nelements );
+  gdcm::ExplicitDataElement de;
+
+  size_t nheaders = 0, check1 = 0;
+  std::clock_t start = std::clock();
+  for( int iter = 0; iter < niter; ++iter )
+    {
+    std::istringstream is( buffer );
+    while( de.ReadPreValue<gdcm::SwapperNoOp>( is ) )
+      {
+      check1 += de.GetTag().GetElement() + de.GetVL();
+      is.seekg( de.GetVL(), std::ios::cur );
+      ++nheaders;
+      }
+    }
+  const double tstream = Elapsed(start);
+
+  size_t check2 = 0;
+  start = std::clock();
+  for( int iter = 0; iter < niter; ++iter )
+    {
+    const char *p = buffer.c_str();
+    const char *end = p + buffer.size();
+    size_t n;
+    while( (n = de.DecodePreValue( p, end - p )) != 0 )
+      {
+      check2 += de.GetTag().GetElement() + de.GetVL();
+      p += n + de.GetVL();
+      }
+    }
+  const double tbuffer = Elapsed(start);
+
+  std::cout << "Headers (" << nelements << " elements):" << std::endl;
+  std::cout << "  ReadPreValue:   " << (tstream > 0 ? nheaders / tstream : 0) << " headers/s" << std::endl;
+  std::cout << "  DecodePreValue: " << (tbuffer > 0 ? nheaders / tbuffer : 0) << " headers/s" << std::endl;
+  if( check1 != check2 )
+    {
+    std::cerr << "Headers differ" << std::endl;
+    }
+}
+
+static size_t CountDataElements(const gdcm::DataSet &ds)
+{
+  size_t n = 0;
+  for( gdcm::DataSet::ConstIterator it = ds.Begin(); it != ds.End(); ++it )
+    {
+    ++n;
+    gdcm::SmartPointer<gdcm::SequenceOfItems> sqi = it->GetValueAsSQ();
+    if( !sqi ) continue;
+    for( gdcm::SequenceOfItems::SizeType i = 1; i <= sqi->GetNumberOfItems(); ++i )
+      {
+      n += CountDataElements( sqi->GetItem(i).GetNestedDataSet() );
+      }
+    }
+  return n;
+}
+
+int main(int argc, char *argv[])
+{
+  gdcm::Trace::WarningOff();
+  gdcm::Trace::ErrorOff();
+  const int niter = 10;
+  BenchmarkHeaders( niter );
+  if( argc < 2 ) return 0;
+
+  std::vector<std::string> filenames;
+  for( int i = 1; i < argc; ++i )
+    {
+    if( gdcm::System::FileIsDirectory( argv[i] ) )
+      {
+      gdcm::Directory d;
+      d.Load( argv[i], true );
+      filenames.insert( filenames.end(), d.GetFilenames().begin(), d.GetFilenames().end() );
+      }
+    else
+      {
+      filenames.push_back( argv[i] );
+      }
+    }
+
+  // Keep the Explicit VR Little Endian files, in memory
+  std::vector<std::string> selected;
+  std::vector<std::string> buffers;
+  size_t nelements = 0;
+  for( size_t i = 0; i < filenames.size(); ++i )
+    {
+    std::ifstream is( filenames[i].c_str(), std::ios::binary );
+    std::ostringstream os;
+    os << is.rdbuf();
+    gdcm::Reader reader;
+    std::istringstream iss( os.str() );
+    reader.SetStream( iss );
+    if( !reader.Read() ) continue;
+    const gdcm::File &file = reader.GetFile();
+    if( file.GetHeader().GetDataSetTransferSyntax()
+      != gdcm::TransferSyntax::ExplicitVRLittleEndian ) continue;
+    gdcm::Reader mmreader;
+    mmreader.SetMemoryMappedFile( filenames[i].c_str() );
+    if( !mmreader.Read() ) continue;
+    const gdcm::DataSet &ds1 = file.GetDataSet();
+    const gdcm::DataSet &ds2 = mmreader.GetFile().GetDataSet();
+    bool same = ds1.Size() == ds2.Size();
+    gdcm::DataSet::ConstIterator it1 = ds1.Begin(), it2 = ds2.Begin();
+    for( ; same && it1 != ds1.End(); ++it1, ++it2 )
+      {
+      same = *it1 == *it2;
+      }
+    if( !same )
+      {
+      std::cerr << "DataSet differ: " << filenames[i] << std::endl;
+      return 1;
+      }
+    selected.push_back( filenames[i] );
+    buffers.push_back( os.str() );
+    nelements += CountDataElements( ds1 );
+    }
+  if( selected.empty() )
+    {
+    std::cerr << "No Explicit VR Little Endian file found" << std::endl;
+    return 1;
+    }
+
+  std::cout << "Files (Explicit VR Little Endian): " << selected.size() << std::endl;
+  std::clock_t start = std::clock();
+  for( int iter = 0; iter < niter; ++iter )
+    {
+    for( size_t i = 0; i < buffers.size(); ++i )
+      {
+      std::istringstream iss( buffers[i] );
+      gdcm::Reader reader;
+      reader.SetStream( iss );
+      reader.Read();
+      }
+    }
+  double t = Elapsed(start);
+  std::cout << "  std::istringstream: " << (t > 0 ? niter * nelements / t : 0) << " elements/s" << std::endl;
+  start = std::clock();
+  for( int iter = 0; iter < niter; ++iter )
+    {
+    for( size_t i = 0; i < selected.size(); ++i )
+      {
+      gdcm::Reader reader;
+      reader.SetMemoryMappedFile( selected[i].c_str() );
+      reader.Read();
+      }
+    }
+  t = Elapsed(start);
+  std::cout << "  MemoryMappedFile:   " << (t > 0 ? niter * nelements / t : 0) << " elements/s" << std::endl;
+
+  return 0;
+}
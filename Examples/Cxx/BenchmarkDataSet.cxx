@@ -0,0 +1,229 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+/*
+ * Benchmark of the DataSet storage (see GDCM_DATASET_SORTED_VECTOR).
+ *
+ * Measure parse, lookup and Write<> throughput of the DataSet storage GDCM
+ * was compiled with, then compare std::set<DataElement> and
+ * SortedVector<DataElement> directly on the elements of the corpus.
+ * Build GDCM once with and once without GDCM_DATASET_SORTED_VECTOR to compare
+ * the parse numbers.
+ *
+ * Usage:
+ *   BenchmarkDataSet gdcmData/
+ *   BenchmarkDataSet file1.dcm file2.dcm ...
+ */
+#include "gdcmReader.h"
+#include "gdcmDirectory.h"
+#include "gdcmSystem.h"
+#include "gdcmExplicitDataElement.h"
+#include "gdcmImplicitDataElement.h"
+#include "gdcmSwapper.h"
+#include "gdcmSortedVector.h"
+#include "gdcmTrace.h"
+
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <set>
+
+static double Elapsed(std::clock_t start)
+{
+  return double(std::clock() - start) / CLOCKS_PER_SEC;
+}
+
+template <typename TContainer>
+static void BenchmarkContainer(const char *name,
+  std::vector< std::vector<gdcm::DataElement> > const &corpus, int niter)
+{
+  std::vector<TContainer> containers( corpus.size() );
+  size_t nelements = 0;
+  std::clock_t start = std::clock();
+  for( int iter = 0; iter < niter; ++iter )
+    {
+    for( size_t i = 0; i < corpus.size(); ++i )
+      {
+      TContainer &c = containers[i];
+      c.clear();
+      // Insert in file (ascending tag) order, as the parser does
+      for( std::vector<gdcm::DataElement>::const_iterator it = corpus[i].begin();
+        it != corpus[i].end(); ++it )
+        {
+        c.insert( *it );
+        }
+      nelements += c.size();
+      }
+    }
+  const double tinsert = Elapsed(start);
+
+  size_t nfound = 0;
+  start = std::clock();
+  for( int iter = 0; iter < niter; ++iter )
+    {
+    for( size_t i = 0; i < corpus.size(); ++i )
+      {
+      const TContainer &c = containers[i];
+      for( std::vector<gdcm::DataElement>::const_iterator it = corpus[i].begin();
+        it != corpus[i].end(); ++it )
+        {
+        if( c.find( gdcm::DataElement( it->GetTag() ) ) != c.end() ) ++nfound;
+        }
+      }
+    }
+  const double tlookup = Elapsed(start);
+
+  size_t nvisited = 0;
+  start = std::clock();
+  for( int iter = 0; iter < niter; ++iter )
+    {
+    for( size_t i = 0; i < containers.size(); ++i )
+      {
+      const TContainer &c = containers[i];
+      for( typename TContainer::const_iterator it = c.begin(); it != c.end(); ++it )
+        {
+        nvisited += it->GetTag().GetElement();
+        }
+      }
+    }
+  const double titer = Elapsed(start);
+
+  std::cout << name << ":" << std::endl;
+  std::cout << "  insert:  " << (tinsert > 0 ? nelements / tinsert : 0) << " elements/s" << std::endl;
+  std::cout << "  lookup:  " << (tlookup > 0 ? nfound / tlookup : 0) << " lookups/s" << std::endl;
+  std::cout << "  iterate: " << (titer > 0 ? nelements / titer : 0) << " elements/s"
+    << " (" << nvisited % 2 << ")" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << argv[0] << " directory|file..." << std::endl;
+    return 1;
+    }
+  gdcm::Trace::WarningOff();
+
+  std::vector<std::string> filenames;
+  for( int i = 1; i < argc; ++i )
+    {
+    if( gdcm::System::FileIsDirectory( argv[i] ) )
+      {
+      gdcm::Directory d;
+      d.Load( argv[i], true );
+      filenames.insert( filenames.end(), d.GetFilenames().begin(), d.GetFilenames().end() );
+      }
+    else
+      {
+      filenames.push_back( argv[i] );
+      }
+    }
+
+  // Load the corpus in memory to measure parsing only
+  std::vector<std::string> buffers;
+  for( size_t i = 0; i < filenames.size(); ++i )
+    {
+    std::ifstream is( filenames[i].c_str(), std::ios::binary );
+    std::ostringstream os;
+    os << is.rdbuf();
+    gdcm::Reader reader;
+    std::istringstream iss( os.str() );
+    reader.SetStream( iss );
+    if( reader.Read() ) buffers.push_back( os.str() );
+    }
+  if( buffers.empty() )
+    {
+    std::cerr << "No DICOM file found" << std::endl;
+    return 1;
+    }
+  const int niter = 10;
+
+#ifdef GDCM_DATASET_SORTED_VECTOR
+  std::cout << "DataSet storage: SortedVector" << std::endl;
+#else
+  std::cout << "DataSet storage: std::set" << std::endl;
+#endif
+  std::cout << "Files: " << buffers.size() << std::endl;
+
+  // Parse
+  size_t nbytes = 0;
+  std::vector<gdcm::File> files( buffers.size() );
+  std::clock_t start = std::clock();
+  for( int iter = 0; iter < niter; ++iter )
+    {
+    for( size_t i = 0; i < buffers.size(); ++i )
+      {
+      std::istringstream iss( buffers[i] );
+      gdcm::Reader reader;
+      reader.SetStream( iss );
+      reader.Read();
+      files[i] = reader.GetFile();
+      nbytes += buffers[i].size();
+      }
+    }
+  double t = Elapsed(start);
+  std::cout << "Parse:  " << (t > 0 ? nbytes / t / (1024. * 1024.) : 0) << " MB/s" << std::endl;
+
+  // Lookup (hits and misses)
+  std::vector< std::vector<gdcm::DataElement> > corpus( files.size() );
+  for( size_t i = 0; i < files.size(); ++i )
+    {
+    const gdcm::DataSet &ds = files[i].GetDataSet();
+    corpus[i].assign( ds.Begin(), ds.End() );
+    }
+  size_t nlookups = 0, nfound = 0;
+  start = std::clock();
+  for( int iter = 0; iter < niter; ++iter )
+    {
+    for( size_t i = 0; i < files.size(); ++i )
+      {
+      const gdcm::DataSet &ds = files[i].GetDataSet();
+      for( size_t j = 0; j < corpus[i].size(); ++j )
+        {
+        const gdcm::Tag &tag = corpus[i][j].GetTag();
+        if( ds.FindDataElement( tag ) ) ++nfound;
+        if( ds.FindDataElement( gdcm::Tag(tag.GetGroup(), (uint16_t)(tag.GetElement() + 1)) ) ) ++nfound;
+        nlookups += 2;
+        }
+      }
+    }
+  t = Elapsed(start);
+  std::cout << "Lookup: " << (t > 0 ? nlookups / t : 0) << " lookups/s" << std::endl;
+
+  // Write<>
+  nbytes = 0;
+  start = std::clock();
+  for( int iter = 0; iter < niter; ++iter )
+    {
+    for( size_t i = 0; i < files.size(); ++i )
+      {
+      std::ostringstream os;
+      const gdcm::DataSet &ds = files[i].GetDataSet();
+      if( files[i].GetHeader().GetDataSetTransferSyntax().IsImplicit() )
+        ds.Write<gdcm::ImplicitDataElement,gdcm::SwapperNoOp>( os );
+      else
+        ds.Write<gdcm::ExplicitDataElement,gdcm::SwapperNoOp>( os );
+      nbytes += (size_t)os.tellp();
+      }
+    }
+  t = Elapsed(start);
+  std::cout << "Write:  " << (t > 0 ? nbytes / t / (1024. * 1024.) : 0) << " MB/s" << std::endl;
+
+  // Containers side by side
+  BenchmarkContainer< std::set<gdcm::DataElement> >( "std::set", corpus, niter );
+  BenchmarkContainer< gdcm::SortedVector<gdcm::DataElement> >( "SortedVector", corpus, niter );
+
+  return nfound ? 0 : 1;
+}
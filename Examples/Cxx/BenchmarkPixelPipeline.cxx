@@ -0,0 +1,353 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+/*
+ * Benchmark of the pixel post-processing done after decoding (see
+ * ImageCodec::DecodeInPlace): byte swap, overlay cleanup, padded composite
+ * pixel code and planar configuration, on synthetic 512x512 frames.
+ *
+ * RAW frames only go through the post-processing, RLE frames also include
+ * the RLE decoding itself. Rescale measures the modality LUT (Rescaler) on
+ * Stored Pixel Values, Palette the PALETTE COLOR lookup (LookupTable).
+ * 12 bits packed measures Unpacker12Bits, and the RAW decoding of packed
+ * 12 bits pixels (old ACR-NEMA files). YBR compares the per pixel template
+ * of ImageChangePhotometricInterpretation with the (scalar and vectorized)
+ * fixed point conversion, and measures the 4:2:2 upsampling of RAWCodec.
+ *
+ * Usage:
+ *   BenchmarkPixelPipeline [number of frames]
+ */
+#include "gdcmRAWCodec.h"
+#include "gdcmRLECodec.h"
+#include "gdcmImageChangeTransferSyntax.h"
+#include "gdcmImage.h"
+#include "gdcmRescaler.h"
+#include "gdcmLookupTable.h"
+#include "gdcmUnpacker12Bits.h"
+#include "gdcmImageChangePhotometricInterpretation.h"
+#include "gdcmPixelKernels.h"
+#include "gdcmTrace.h"
+
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+static double Elapsed(std::clock_t start)
+{
+  return double(std::clock() - start) / CLOCKS_PER_SEC;
+}
+
+static const unsigned int Size = 512;
+
+static std::vector<char> CreateFrame(gdcm::PixelFormat const &pf)
+{
+  std::vector<char> frame( Size * Size * pf.GetPixelSize() );
+  for( size_t i = 0; i < frame.size(); ++i )
+    {
+    frame[i] = (char)((i / 8 + i / 4096) % 97);
+    }
+  return frame;
+}
+
+static void Report(const char *name, double t, int nframes, size_t framelen)
+{
+  std::cout << name << ": " << (t > 0 ? 1000. * t / nframes : 0) << " ms/frame, "
+    << (t > 0 ? (double)framelen * nframes / t / (1024. * 1024.) : 0) << " MB/s"
+    << std::endl;
+}
+
+static bool BenchmarkRAW(const char *name, gdcm::PixelFormat const &pf,
+  bool byteswap, bool overlaycleanup, int nframes)
+{
+  const std::vector<char> frame = CreateFrame( pf );
+  gdcm::DataElement in( gdcm::Tag(0x7fe0,0x0010) );
+  in.SetByteValue( &frame[0], (uint32_t)frame.size() );
+
+  gdcm::RAWCodec codec;
+  const unsigned int dims[3] = { Size, Size, 1 };
+  codec.SetNumberOfDimensions( 2 );
+  codec.SetDimensions( dims );
+  codec.SetPixelFormat( pf );
+  codec.SetPhotometricInterpretation( gdcm::PhotometricInterpretation::MONOCHROME2 );
+  codec.SetNeedByteSwap( byteswap );
+  codec.SetNeedOverlayCleanup( overlaycleanup );
+
+  std::clock_t start = std::clock();
+  for( int i = 0; i < nframes; ++i )
+    {
+    gdcm::DataElement out;
+    if( !codec.Decode( in, out ) ) return false;
+    }
+  Report( name, Elapsed(start), nframes, frame.size() );
+  return true;
+}
+
+static bool BenchmarkRLE(const char *name, gdcm::PixelFormat const &pf,
+  gdcm::PhotometricInterpretation::PIType pi, int nframes)
+{
+  const std::vector<char> frame = CreateFrame( pf );
+  gdcm::SmartPointer<gdcm::Image> image = new gdcm::Image;
+  const unsigned int dims[3] = { Size, Size, 1 };
+  image->SetNumberOfDimensions( 2 );
+  image->SetDimension( 0, Size );
+  image->SetDimension( 1, Size );
+  image->SetPixelFormat( pf );
+  image->SetPhotometricInterpretation( pi );
+  image->SetTransferSyntax( gdcm::TransferSyntax::ExplicitVRLittleEndian );
+  gdcm::DataElement pixeldata( gdcm::Tag(0x7fe0,0x0010) );
+  pixeldata.SetByteValue( &frame[0], (uint32_t)frame.size() );
+  image->SetDataElement( pixeldata );
+
+  gdcm::ImageChangeTransferSyntax change;
+  change.SetTransferSyntax( gdcm::TransferSyntax::RLELossless );
+  change.SetInput( *image );
+  if( !change.Change() ) return false;
+  const gdcm::DataElement &in = change.GetOutput().GetDataElement();
+
+  gdcm::RLECodec codec;
+  codec.SetNumberOfDimensions( 2 );
+  codec.SetDimensions( dims );
+  codec.SetPixelFormat( pf );
+  codec.SetPhotometricInterpretation( pi );
+  codec.SetPlanarConfiguration( 0 );
+  codec.SetBufferLength( (unsigned long)frame.size() );
+
+  std::clock_t start = std::clock();
+  for( int i = 0; i < nframes; ++i )
+    {
+    gdcm::DataElement out;
+    if( !codec.Decode( in, out ) ) return false;
+    }
+  Report( name, Elapsed(start), nframes, frame.size() );
+  return true;
+}
+
+static bool BenchmarkRescale(const char *name, gdcm::PixelFormat const &pf,
+  double intercept, double slope, int nframes)
+{
+  std::vector<char> frame( Size * Size * pf.GetPixelSize() );
+  const int64_t range = pf.GetMax() - pf.GetMin() + 1;
+  for( size_t i = 0; i < Size * Size; ++i )
+    {
+    const int64_t v = pf.GetMin() + (int64_t)((i / 8 + i / 4096) * 31) % range;
+    if( pf.GetPixelSize() == 2 )
+      {
+      const uint16_t c = (uint16_t)v;
+      memcpy( &frame[2 * i], &c, 2 );
+      }
+    else
+      {
+      frame[i] = (char)v;
+      }
+    }
+  gdcm::Rescaler r;
+  r.SetIntercept( intercept );
+  r.SetSlope( slope );
+  r.SetPixelFormat( pf );
+  const gdcm::PixelFormat outpf = r.ComputeInterceptSlopePixelType();
+  std::vector<char> out( Size * Size * outpf.GetPixelSize() );
+
+  std::clock_t start = std::clock();
+  for( int i = 0; i < nframes; ++i )
+    {
+    if( !r.Rescale( &out[0], &frame[0], frame.size() ) ) return false;
+    }
+  Report( name, Elapsed(start), nframes, frame.size() );
+  return true;
+}
+
+static bool BenchmarkPalette(const char *name, unsigned short bitsample,
+  int nframes)
+{
+  gdcm::LookupTable lut;
+  lut.Allocate( bitsample );
+  const unsigned int nentries = bitsample == 8 ? 256 : 65536;
+  std::vector<char> table( nentries * bitsample / 8 );
+  for( size_t i = 0; i < table.size(); ++i )
+    {
+    table[i] = (char)(i * 7);
+    }
+  for( int type = gdcm::LookupTable::RED; type <= gdcm::LookupTable::BLUE; ++type )
+    {
+    // for 16 bits, a length of 0 means 65536 entries
+    lut.InitializeLUT( gdcm::LookupTable::LookupTableType(type),
+      (unsigned short)(nentries % 65536), 0, bitsample );
+    lut.SetLUT( gdcm::LookupTable::LookupTableType(type),
+      (const unsigned char*)&table[0], (unsigned int)table.size() );
+    }
+  gdcm::PixelFormat pf = bitsample == 8 ? gdcm::PixelFormat::UINT8 : gdcm::PixelFormat::UINT16;
+  const std::vector<char> frame = CreateFrame( pf );
+  std::vector<char> out( 3 * frame.size() );
+
+  std::clock_t start = std::clock();
+  for( int i = 0; i < nframes; ++i )
+    {
+    if( !lut.Decode( &out[0], out.size(), &frame[0], frame.size() ) ) return false;
+    }
+  Report( name, Elapsed(start), nframes, frame.size() );
+  return true;
+}
+
+// Throughput is reported on the packed data
+static bool BenchmarkPacked12(int nframes)
+{
+  std::vector<char> packed = CreateFrame( gdcm::PixelFormat::UINT16 );
+  packed.resize( Size * Size / 2 * 3 );
+  std::vector<char> unpacked( Size * Size * 2 );
+
+  std::clock_t start = std::clock();
+  for( int i = 0; i < nframes; ++i )
+    {
+    if( !gdcm::Unpacker12Bits::Unpack( &unpacked[0], &packed[0], packed.size() ) )
+      return false;
+    }
+  Report( "Unpack 12 bits         ", Elapsed(start), nframes, packed.size() );
+
+  start = std::clock();
+  for( int i = 0; i < nframes; ++i )
+    {
+    if( !gdcm::Unpacker12Bits::Pack( &packed[0], &unpacked[0], unpacked.size() ) )
+      return false;
+    }
+  Report( "Pack 12 bits           ", Elapsed(start), nframes, packed.size() );
+
+  gdcm::DataElement in( gdcm::Tag(0x7fe0,0x0010) );
+  in.SetByteValue( &packed[0], (uint32_t)packed.size() );
+  gdcm::RAWCodec codec;
+  const unsigned int dims[3] = { Size, Size, 1 };
+  codec.SetNumberOfDimensions( 2 );
+  codec.SetDimensions( dims );
+  codec.SetPhotometricInterpretation( gdcm::PhotometricInterpretation::MONOCHROME2 );
+  start = std::clock();
+  for( int i = 0; i < nframes; ++i )
+    {
+    // the codec switches to 16 bits allocated once unpacked
+    codec.SetPixelFormat( gdcm::PixelFormat::UINT12 );
+    gdcm::DataElement out;
+    if( !codec.Decode( in, out ) ) return false;
+    }
+  Report( "RAW 12 bits packed     ", Elapsed(start), nframes, packed.size() );
+  return true;
+}
+
+// Throughput is reported on the YBR_FULL frame
+static bool BenchmarkYBR(int nframes)
+{
+  gdcm::PixelFormat rgb = gdcm::PixelFormat::UINT8;
+  rgb.SetSamplesPerPixel( 3 );
+  const std::vector<char> frame = CreateFrame( rgb );
+  std::vector<char> out( frame.size() );
+
+  std::clock_t start = std::clock();
+  for( int i = 0; i < nframes; ++i )
+    {
+    const unsigned char *p = (const unsigned char*)&frame[0];
+    unsigned char *q = (unsigned char*)&out[0];
+    for( size_t j = 0; j < frame.size(); j += 3 )
+      {
+      const double ybr[3] = { (double)p[j], (double)p[j+1], (double)p[j+2] };
+      double pixel[3];
+      gdcm::ImageChangePhotometricInterpretation::YBR2RGB( pixel, ybr );
+      for( int c = 0; c < 3; ++c )
+        {
+        q[j+c] = (unsigned char)(pixel[c] < 0 ? 0 : (pixel[c] > 255 ? 255 : pixel[c]));
+        }
+      }
+    }
+  Report( "YBR -> RGB per pixel   ", Elapsed(start), nframes, frame.size() );
+
+  const gdcm::PixelKernels::InstructionSetType best =
+    gdcm::PixelKernels::GetInstructionSet();
+  gdcm::PixelKernels::SetInstructionSet( gdcm::PixelKernels::SCALAR );
+  start = std::clock();
+  for( int i = 0; i < nframes; ++i )
+    {
+    gdcm::PixelKernels::YBRToRGB8( &out[0], &frame[0], frame.size() / 3, false );
+    }
+  Report( "YBR -> RGB scalar      ", Elapsed(start), nframes, frame.size() );
+  gdcm::PixelKernels::SetInstructionSet( best );
+
+  start = std::clock();
+  for( int i = 0; i < nframes; ++i )
+    {
+    gdcm::PixelKernels::YBRToRGB8( &out[0], &frame[0], frame.size() / 3, false );
+    }
+  Report( "YBR -> RGB             ", Elapsed(start), nframes, frame.size() );
+
+  start = std::clock();
+  for( int i = 0; i < nframes; ++i )
+    {
+    gdcm::PixelKernels::RGBToYBR8( &out[0], &frame[0], frame.size() / 3, false );
+    }
+  Report( "RGB -> YBR             ", Elapsed(start), nframes, frame.size() );
+
+  gdcm::RAWCodec codec;
+  codec.SetPixelFormat( rgb );
+  codec.SetPhotometricInterpretation( gdcm::PhotometricInterpretation::YBR_FULL_422 );
+  start = std::clock();
+  for( int i = 0; i < nframes; ++i )
+    {
+    if( !codec.DecodeBytes( &frame[0], frame.size() / 3 * 2, &out[0], out.size() ) )
+      return false;
+    }
+  Report( "RAW YBR_FULL_422       ", Elapsed(start), nframes, frame.size() );
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  const int nframes = argc > 1 ? atoi(argv[1]) : 100;
+  if( nframes <= 0 )
+    {
+    std::cerr << argv[0] << " [number of frames]" << std::endl;
+    return 1;
+    }
+  gdcm::Trace::WarningOff();
+
+  gdcm::PixelFormat pf16 = gdcm::PixelFormat::UINT16;
+  gdcm::PixelFormat pf12 = gdcm::PixelFormat::UINT16;
+  pf12.SetBitsStored( 12 );
+  pf12.SetHighBit( 11 );
+  gdcm::PixelFormat spf12 = gdcm::PixelFormat::INT16;
+  spf12.SetBitsStored( 12 );
+  spf12.SetHighBit( 11 );
+  gdcm::PixelFormat spf16 = gdcm::PixelFormat::INT16;
+  gdcm::PixelFormat pf8 = gdcm::PixelFormat::UINT8;
+  gdcm::PixelFormat rgb = gdcm::PixelFormat::UINT8;
+  rgb.SetSamplesPerPixel( 3 );
+
+  bool b = true;
+  b = b && BenchmarkRAW( "RAW byte swap          ", pf16, true, false, nframes );
+  b = b && BenchmarkRAW( "RAW overlay cleanup    ", pf12, false, true, nframes );
+  b = b && BenchmarkRAW( "RAW signed cleanup     ", spf12, false, true, nframes );
+  b = b && BenchmarkRAW( "RAW swap + cleanup     ", pf12, true, true, nframes );
+  b = b && BenchmarkRLE( "RLE 16 bits            ", pf16,
+    gdcm::PhotometricInterpretation::MONOCHROME2, nframes );
+  b = b && BenchmarkRLE( "RLE RGB                ", rgb,
+    gdcm::PhotometricInterpretation::RGB, nframes );
+  // CT: Hounsfield Units
+  b = b && BenchmarkRescale( "Rescale 12 bits -> HU  ", pf12, -1024, 1, nframes );
+  b = b && BenchmarkRescale( "Rescale 16 bits -> HU  ", spf16, -1024, 1, nframes );
+  // PET/MR: floating point Rescale Slope
+  b = b && BenchmarkRescale( "Rescale 12 bits -> FP64", pf12, -1.5, 0.25, nframes );
+  b = b && BenchmarkRescale( "Rescale 16 bits -> FP64", pf16, -1.5, 0.25, nframes );
+  b = b && BenchmarkRescale( "Rescale 8 bits -> FP64 ", pf8, -1.5, 0.25, nframes );
+  b = b && BenchmarkPalette( "Palette 8 bits         ", 8, nframes );
+  b = b && BenchmarkPalette( "Palette 16 bits        ", 16, nframes );
+  b = b && BenchmarkPacked12( nframes );
+  b = b && BenchmarkYBR( nframes );
+
+  return b ? 0 : 1;
+}
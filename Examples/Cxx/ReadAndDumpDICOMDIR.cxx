@@ -20,7 +20,7 @@
 #include "gdcmReader.h"
 #include "gdcmMediaStorage.h"
 
-typedef std::set<gdcm::DataElement> DataElementSet;
+typedef gdcm::DataSet::DataElementSet DataElementSet;
 typedef DataElementSet::const_iterator ConstIterator;
 
 int main(int argc, char *argv [])
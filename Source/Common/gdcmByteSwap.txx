@@ -15,6 +15,7 @@
 #define GDCMBYTESWAP_TXX
 
 #include "gdcmByteSwap.h"
+#include "gdcmPixelKernels.h"
 #include <iostream>
 
 #include <stdlib.h> // abort
@@ -82,9 +83,22 @@ void ByteSwap<T>::SwapFromSwapCodeIntoSystem(T &a, SwapCode const &swapcode)
 template <class T>
 void ByteSwap<T>::SwapRange(T *p, unsigned int num)
 {
-  for(unsigned int i=0; i<num; i++)
+  // Swap reverses the bytes of each value: this is what the vectorized
+  // kernels do
+  if( sizeof(T) == 2 )
     {
-    ByteSwap<T>::Swap(p[i]);
+    PixelKernels::ByteSwap16(p, num);
+    }
+  else if( sizeof(T) == 4 )
+    {
+    PixelKernels::ByteSwap32(p, num);
+    }
+  else
+    {
+    for(unsigned int i=0; i<num; i++)
+      {
+      ByteSwap<T>::Swap(p[i]);
+      }
     }
 }
 
@@ -92,6 +106,15 @@ template <class T>
 void ByteSwap<T>::SwapRangeFromSwapCodeIntoSystem(T *p, SwapCode const &sc,
   std::streamoff num)
 {
+#ifdef GDCM_WORDS_BIGENDIAN
+  if( sc == SwapCode::LittleEndian && (unsigned int)num == num )
+#else
+  if( sc == SwapCode::BigEndian && (unsigned int)num == num )
+#endif
+    {
+    ByteSwap<T>::SwapRange(p, (unsigned int)num);
+    return;
+    }
   for( std::streamoff i=0; i<num; i++)
     {
     ByteSwap<T>::SwapFromSwapCodeIntoSystem(p[i], sc);
@@ -0,0 +1,68 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmLazyValueLoader.h"
+#include "gdcmSystem.h"
+#include "gdcmTrace.h"
+
+#include <fstream>
+
+namespace gdcm
+{
+
+// Slot in std::ios_base::pword used to attach a loader to a stream
+static int GetLazyValueLoaderIndex()
+{
+  static const int index = std::ios_base::xalloc();
+  return index;
+}
+
+bool LazyValueLoader::Open(const char *filename)
+{
+  if( !filename || !System::FileExists(filename) ) return false;
+  FileName = filename;
+  FileSize = System::FileSize(filename);
+  return true;
+}
+
+bool LazyValueLoader::Load(std::streamoff offset, char *buffer, size_t length) const
+{
+  assert( CanLoad( offset, length ) || length < Threshold );
+  std::ifstream is( FileName.c_str(), std::ios::binary );
+  if( !is.is_open() )
+    {
+    gdcmErrorMacro( "Could not re-open: " << FileName );
+    return false;
+    }
+  is.seekg( offset, std::ios::beg );
+  is.read( buffer, length );
+  if( (size_t)is.gcount() != length )
+    {
+    gdcmErrorMacro( "Could not load " << length << " bytes at offset "
+      << offset << " from: " << FileName );
+    return false;
+    }
+  return true;
+}
+
+void LazyValueLoader::Attach(std::istream &is, LazyValueLoader *loader)
+{
+  is.pword( GetLazyValueLoaderIndex() ) = loader;
+}
+
+LazyValueLoader *LazyValueLoader::GetLazyValueLoader(std::istream &is)
+{
+  return static_cast<LazyValueLoader*>( is.pword( GetLazyValueLoaderIndex() ) );
+}
+
+} // end namespace gdcm
@@ -0,0 +1,85 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#ifndef GDCMLAZYVALUELOADER_H
+#define GDCMLAZYVALUELOADER_H
+
+#include "gdcmObject.h"
+
+#include <string>
+#include <istream>
+
+namespace gdcm
+{
+/**
+ * \brief Load values from a file on demand
+ *
+ * \details While a file is being parsed, the Reader attaches a
+ * LazyValueLoader to its stream. Any value of GetThreshold() bytes or more
+ * is then not read: the ByteValue only records its offset in the file and
+ * keeps a reference on the loader. The bytes are read the first time they
+ * are accessed.
+ *
+ * The file is re-opened for each Load (no file descriptor is held between
+ * two loads), so that a large number of lazily read DataSet can be kept
+ * around, and concurrent Load are safe.
+ *
+ * \warning the file must not be modified or removed while values remain to
+ * be loaded.
+ *
+ * \see Reader::SetLazyLoadingThreshold
+ */
+class GDCM_EXPORT LazyValueLoader : public Object
+{
+public:
+  LazyValueLoader():FileSize(0),Threshold(0) {}
+
+  /// Record the file to load values from. Return false when the file does
+  /// not exist.
+  bool Open(const char *filename_native);
+
+  const char *GetFileName() const { return FileName.c_str(); }
+
+  /// Values shorter than threshold are read immediately
+  void SetThreshold(size_t threshold) { Threshold = threshold; }
+  size_t GetThreshold() const { return Threshold; }
+
+  /// Return whether a value of \param length bytes at \param offset can be
+  /// deferred (ie. it is large enough and fully contained in the file)
+  bool CanLoad(std::streamoff offset, size_t length) const {
+    return length >= Threshold && offset >= 0
+      && (size_t)offset <= FileSize && length <= FileSize - (size_t)offset;
+  }
+
+  /// Read \param length bytes at \param offset into \param buffer
+  bool Load(std::streamoff offset, char *buffer, size_t length) const;
+
+  /// Attach a loader to a stream (NULL to detach). The stream does not own
+  /// the loader.
+  static void Attach(std::istream &is, LazyValueLoader *loader);
+
+  /// Return the loader attached to a stream, or NULL
+  static LazyValueLoader *GetLazyValueLoader(std::istream &is);
+
+private:
+  LazyValueLoader(const LazyValueLoader&); // Not implemented
+  void operator=(const LazyValueLoader&); // Not implemented
+
+  std::string FileName;
+  size_t FileSize;
+  size_t Threshold;
+};
+
+} // end namespace gdcm
+
+#endif //GDCMLAZYVALUELOADER_H
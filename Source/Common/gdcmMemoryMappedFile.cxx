@@ -0,0 +1,191 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmMemoryMappedFile.h"
+#include "gdcmTrace.h"
+
+#include <streambuf>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(GDCM_HAVE_SYS_MMAN_H)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h> /* close */
+#endif
+
+namespace gdcm
+{
+
+// Slot in std::ios_base::pword pointing back to the mapping a stream reads
+// from. Cheaper than a dynamic_cast on the streambuf, which matters since
+// the parser asks for every data element.
+static int GetMemoryMappedFileIndex()
+{
+  static const int index = std::ios_base::xalloc();
+  return index;
+}
+
+/*
+ * Read-only streambuf over the mapping. The get area is the whole file, so
+ * underflow is never called before EOF, and seeking is simple pointer
+ * arithmetic.
+ */
+class MemoryMappedStreamBuf : public std::streambuf
+{
+public:
+  MemoryMappedStreamBuf(char *mem, size_t length)
+    {
+    setg(mem, mem, mem + length);
+    }
+  const char *GetCurrent() const { return gptr(); }
+  void Advance(int n) { gbump(n); }
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+    std::ios_base::openmode which = std::ios_base::in)
+    {
+    if( !(which & std::ios_base::in) ) return pos_type(off_type(-1));
+    char *p;
+    switch(dir)
+      {
+    case std::ios_base::beg:
+      p = eback() + off;
+      break;
+    case std::ios_base::cur:
+      p = gptr() + off;
+      break;
+    case std::ios_base::end:
+      p = egptr() + off;
+      break;
+    default:
+      return pos_type(off_type(-1));
+      }
+    if( p < eback() || p > egptr() ) return pos_type(off_type(-1));
+    setg(eback(), p, egptr());
+    return pos_type(off_type(p - eback()));
+    }
+  pos_type seekpos(pos_type pos,
+    std::ios_base::openmode which = std::ios_base::in)
+    {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+MemoryMappedFile::MemoryMappedFile():Data(0),Size(0),StreamBuf(0),Stream(0),Handle(0)
+{
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+  Close();
+}
+
+bool MemoryMappedFile::Open(const char *filename)
+{
+  Close();
+  if( !filename ) return false;
+#if defined(_WIN32)
+  HANDLE hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+    OPEN_EXISTING, FILE_ATTRIBUTE_READONLY, NULL);
+  if( hFile == INVALID_HANDLE_VALUE ) return false;
+  LARGE_INTEGER fsize;
+  if( !GetFileSizeEx(hFile, &fsize) || fsize.QuadPart == 0
+    || (ULONGLONG)fsize.QuadPart != (size_t)fsize.QuadPart )
+    {
+    CloseHandle(hFile);
+    return false;
+    }
+  HANDLE hMapping = CreateFileMapping(hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  CloseHandle(hFile); // the mapping keeps its own reference
+  if( !hMapping ) return false;
+  void *data = MapViewOfFile(hMapping, FILE_MAP_COPY, 0, 0, 0);
+  if( !data )
+    {
+    CloseHandle(hMapping);
+    return false;
+    }
+  Handle = hMapping;
+  Data = static_cast<char*>(data);
+  Size = (size_t)fsize.QuadPart;
+#elif defined(GDCM_HAVE_SYS_MMAN_H)
+  int fd = ::open(filename, O_RDONLY);
+  if( fd == -1 ) return false;
+  struct stat info;
+  if( ::fstat(fd, &info) == -1 || info.st_size == 0
+    || (off_t)(size_t)info.st_size != info.st_size )
+    {
+    ::close(fd);
+    return false;
+    }
+  const size_t size = (size_t)info.st_size;
+  // MAP_PRIVATE + PROT_WRITE: a caller modifying a value in place gets its
+  // own copy of the page, the file on disk is never touched.
+  void *data = ::mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd); // the mapping keeps its own reference
+  if( data == MAP_FAILED ) return false;
+  Data = static_cast<char*>(data);
+  Size = size;
+#else
+  gdcmDebugMacro( "No memory mapping support on this platform" );
+  return false;
+#endif
+  StreamBuf = new MemoryMappedStreamBuf(Data, Size);
+  Stream = new std::istream(StreamBuf);
+  Stream->pword( GetMemoryMappedFileIndex() ) = this;
+  return true;
+}
+
+void MemoryMappedFile::Close()
+{
+  delete Stream; Stream = 0;
+  delete StreamBuf; StreamBuf = 0;
+  if( !Data ) return;
+#if defined(_WIN32)
+  UnmapViewOfFile(Data);
+  CloseHandle(static_cast<HANDLE>(Handle));
+  Handle = 0;
+#elif defined(GDCM_HAVE_SYS_MMAN_H)
+  ::munmap(Data, Size);
+#endif
+  Data = 0;
+  Size = 0;
+}
+
+MemoryMappedFile *MemoryMappedFile::GetMemoryMappedFile(std::istream &is)
+{
+  MemoryMappedFile *mmf =
+    static_cast<MemoryMappedFile*>( is.pword( GetMemoryMappedFileIndex() ) );
+  // The streambuf of the stream may have been replaced:
+  if( mmf && is.rdbuf() == mmf->StreamBuf ) return mmf;
+  return 0;
+}
+
+const char *MemoryMappedFile::GetCurrentPointer(std::istream &is) const
+{
+  assert( is.rdbuf() == StreamBuf );
+  (void)is;
+  return StreamBuf->GetCurrent();
+}
+
+void MemoryMappedFile::Advance(std::istream &is, size_t n) const
+{
+  assert( is.rdbuf() == StreamBuf );
+  assert( n <= (size_t)(Data + Size - StreamBuf->GetCurrent()) );
+  (void)is;
+  StreamBuf->Advance( (int)n );
+}
+
+} // end namespace gdcm
@@ -0,0 +1,91 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#ifndef GDCMMEMORYMAPPEDFILE_H
+#define GDCMMEMORYMAPPEDFILE_H
+
+#include "gdcmObject.h"
+
+#include <istream>
+
+namespace gdcm
+{
+class MemoryMappedStreamBuf;
+/**
+ * \brief Read-only memory mapping of a whole file
+ *
+ * \details This class maps a file in the process address space (mmap on
+ * POSIX, MapViewOfFile on Win32) and exposes it as a std::istream, so that
+ * the regular parsing code can be used unchanged.
+ * Since this is a gdcm::Object, values may keep a reference to the mapping
+ * (see ByteValue) and point directly into the file image instead of holding
+ * a copy. The mapping is released once the last reference goes away.
+ *
+ * \note The mapping is private (copy-on-write): pages are never written back
+ * to the file.
+ *
+ * \see Reader::SetMemoryMappedFile
+ */
+class GDCM_EXPORT MemoryMappedFile : public Object
+{
+public:
+  MemoryMappedFile();
+  ~MemoryMappedFile();
+
+  /// Map the whole file. Return false when the file cannot be opened or
+  /// mapped (eg. empty file, address space exhausted).
+  bool Open(const char *filename_native);
+
+  /// Release the mapping
+  void Close();
+
+  /// Is a file currently mapped
+  bool IsOpen() const { return Data != 0; }
+
+  /// Return the start of the file image
+  const char *GetPointer() const { return Data; }
+
+  /// Return the size of the file image
+  size_t GetSize() const { return Size; }
+
+  /// Return a stream reading from the mapping
+  std::istream &GetStream() { return *Stream; }
+
+  /// Return the mapping a stream is reading from, or NULL when the stream is
+  /// not backed by a MemoryMappedFile
+  static MemoryMappedFile *GetMemoryMappedFile(std::istream &is);
+
+  /// Return the current position of the stream as a pointer in the mapping.
+  /// \precondition GetMemoryMappedFile(is) == this
+  const char *GetCurrentPointer(std::istream &is) const;
+
+  /// Move the current position of the stream n bytes forward, without going
+  /// through the std::istream interface.
+  /// \precondition GetMemoryMappedFile(is) == this, and n does not go past
+  /// the end of the mapping
+  void Advance(std::istream &is, size_t n) const;
+
+private:
+  MemoryMappedFile(const MemoryMappedFile&); // Not implemented
+  void operator=(const MemoryMappedFile&); // Not implemented
+
+  char *Data;
+  size_t Size;
+  MemoryMappedStreamBuf *StreamBuf;
+  std::istream *Stream;
+  void *Handle; // Win32 only
+};
+
+} // end namespace gdcm
+
+#endif //GDCMMEMORYMAPPEDFILE_H
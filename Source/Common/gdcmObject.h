@@ -19,6 +19,11 @@
 #include <assert.h>
 #include <iostream> // grrrr
 
+#if defined(_MSC_VER)
+#include <intrin.h> // _InterlockedIncrement
+#pragma intrinsic(_InterlockedIncrement, _InterlockedDecrement)
+#endif
+
 //namespace std { class ostream; }
 namespace gdcm
 {
@@ -31,6 +36,13 @@ template<class ObjectType> class SmartPointer;
  * \note main superclass for object that want to use SmartPointer
  * invasive ref counting system
  *
+ * \note Thread safety: the reference count is updated atomically, so
+ * SmartPointer to the same Object (eg. the Value shared by shallow copies of
+ * a DataElement) can be copied and released from different threads. This
+ * does not make the Object itself thread safe: an Object may be read from
+ * any number of threads through const methods, as long as no thread
+ * modifies it.
+ *
  * \see SmartPointer
  */
 class GDCM_EXPORT Object
@@ -70,13 +82,14 @@ public:
 protected:
   // For the purpose of the invasive SmartPointer implementation
   void Register() {
-    ReferenceCount++;
-    assert( ReferenceCount > 0 );
+    const long count = AtomicIncrement(ReferenceCount);
+    assert( count > 0 );
+    (void)count;
   }
   void UnRegister() {
     assert( ReferenceCount > 0 );
-    ReferenceCount--;
-    if(!ReferenceCount)
+    // Only one thread may see the count drop to zero
+    if( AtomicDecrement(ReferenceCount) == 0 )
       {
       delete this;
       }
@@ -87,7 +100,27 @@ public:
   virtual void Print(std::ostream &) const {}
 
 private:
-  long ReferenceCount;
+  static long AtomicIncrement(long volatile &v) {
+#if defined(_MSC_VER)
+    return _InterlockedIncrement(&v);
+#elif defined(__GNUC__)
+    return __sync_add_and_fetch(&v, 1);
+#else
+    // No atomic support known for this compiler: not thread safe
+    return ++v;
+#endif
+  }
+  static long AtomicDecrement(long volatile &v) {
+#if defined(_MSC_VER)
+    return _InterlockedDecrement(&v);
+#elif defined(__GNUC__)
+    return __sync_sub_and_fetch(&v, 1);
+#else
+    return --v;
+#endif
+  }
+
+  long volatile ReferenceCount;
 };
 
 //----------------------------------------------------------------------------
@@ -0,0 +1,1427 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmPixelKernels.h"
+
+#include <string.h> // memcpy
+
+// The x86 kernels are compiled with a per function target attribute, so that
+// the library does not require any special compiler flag and still runs on
+// processors without SSSE3 / AVX2.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#if defined(_MSC_VER)
+#define GDCM_PIXELKERNELS_X86
+#define GDCM_PIXELKERNELS_TARGET(x)
+#include <intrin.h>
+#elif defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define GDCM_PIXELKERNELS_X86
+#define GDCM_PIXELKERNELS_TARGET(x) __attribute__((target(x)))
+#endif
+#endif
+
+#if defined(GDCM_PIXELKERNELS_X86)
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define GDCM_PIXELKERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace gdcm
+{
+
+namespace
+{
+
+/*
+ * Parameters of ByteSwapAndCleanup16 (see ImageCodec)
+ */
+struct CleanupParameters
+{
+  bool ByteSwap;
+  bool Cleanup;
+  bool Sign;
+  // clamped to 16, so that every implementation shifts everything out
+  unsigned short Shift;
+  // pmask : to mask the 'unused bits' (may contain overlays)
+  uint16_t PMask;
+  // smask : to check the 'sign' when BitsStored != BitsAllocated
+  uint16_t SMask;
+  // nmask : to propagate sign bit on negative values
+  uint16_t NMask;
+};
+
+/*
+ * 8 bits color space conversion (see PixelKernels::YBRToRGB8): sample c of
+ * an output pixel is
+ *   clamp( (sum_k Matrix[c][k] * (in[k] - Offset[k]) + Bias[c]) >> 13 )
+ * Bias holds the rounding and the (scaled) output offset.
+ */
+struct ColorTransform
+{
+  short Matrix[3][3];
+  short Offset[3];
+  int Bias[3];
+};
+
+struct KernelTable
+{
+  void (*ByteSwap16)(void *, size_t);
+  void (*ByteSwap32)(void *, size_t);
+  void (*PlanarToInterleaved3)(char *, const char *, const char *, const char *, size_t);
+  void (*InterleavedToPlanar3)(char *, char *, char *, const char *, size_t);
+  void (*ByteSwapAndCleanup16)(void *, size_t, CleanupParameters const &);
+  void (*LinearTransform16)(void *, const void *, size_t, uint16_t, uint16_t);
+  void (*LinearTransform16ToDouble)(double *, const void *, size_t, bool, double, double);
+  void (*ApplyLookupTable8)(char *, const char *, size_t, const unsigned char *);
+  void (*Unpack12Bits)(char *, const char *, size_t);
+  void (*Pack12Bits)(char *, const char *, size_t);
+  void (*ColorTransform8)(char *, const char *, size_t, ColorTransform const &);
+  void (*UpsampleYBR422)(char *, const char *, size_t);
+};
+
+// Scalar reference
+
+void ByteSwap16Scalar(void *buffer, size_t n)
+{
+  char *p = (char*)buffer;
+  for( size_t i = 0; i < n; ++i, p += 2 )
+    {
+    uint16_t c;
+    memcpy( &c, p, 2 );
+    c = (uint16_t)((c >> 8) | (c << 8));
+    memcpy( p, &c, 2 );
+    }
+}
+
+void ByteSwap32Scalar(void *buffer, size_t n)
+{
+  char *p = (char*)buffer;
+  for( size_t i = 0; i < n; ++i, p += 4 )
+    {
+    uint32_t c;
+    memcpy( &c, p, 4 );
+    c = (c >> 24) | ((c >> 8) & 0x0000ff00u) | ((c << 8) & 0x00ff0000u) | (c << 24);
+    memcpy( p, &c, 4 );
+    }
+}
+
+void PlanarToInterleaved3Scalar(char *out,
+  const char *r, const char *g, const char *b, size_t n)
+{
+  for( size_t i = 0; i < n; ++i )
+    {
+    *out++ = *r++;
+    *out++ = *g++;
+    *out++ = *b++;
+    }
+}
+
+void InterleavedToPlanar3Scalar(char *r, char *g, char *b,
+  const char *in, size_t n)
+{
+  for( size_t i = 0; i < n; ++i )
+    {
+    *r++ = *in++;
+    *g++ = *in++;
+    *b++ = *in++;
+    }
+}
+
+void ByteSwapAndCleanup16Scalar(void *buffer, size_t n,
+  CleanupParameters const &p)
+{
+  char *q = (char*)buffer;
+  for( size_t i = 0; i < n; ++i, q += 2 )
+    {
+    uint16_t c;
+    memcpy( &c, q, 2 );
+    if( p.ByteSwap )
+      {
+      c = (uint16_t)((c >> 8) | (c << 8));
+      }
+    if( p.Cleanup )
+      {
+      c = (uint16_t)(p.Shift < 16 ? c >> p.Shift : 0);
+      if( p.Sign && (c & p.SMask) )
+        {
+        c = (uint16_t)(c | p.NMask);
+        }
+      else
+        {
+        c = c & p.PMask;
+        }
+      }
+    memcpy( q, &c, 2 );
+    }
+}
+
+// unsigned arithmetic, so that the computation wraps around modulo 2^16
+void LinearTransform16Scalar(void *out, const void *in, size_t n,
+  uint16_t slope, uint16_t intercept)
+{
+  const char *p = (const char*)in;
+  char *q = (char*)out;
+  for( size_t i = 0; i < n; ++i, p += 2, q += 2 )
+    {
+    uint16_t c;
+    memcpy( &c, p, 2 );
+    c = (uint16_t)((uint32_t)c * slope + intercept);
+    memcpy( q, &c, 2 );
+    }
+}
+
+void LinearTransform16ToDoubleScalar(double *out, const void *in, size_t n,
+  bool sign, double slope, double intercept)
+{
+  const char *p = (const char*)in;
+  if( sign )
+    {
+    for( size_t i = 0; i < n; ++i, p += 2 )
+      {
+      int16_t c;
+      memcpy( &c, p, 2 );
+      out[i] = slope * c + intercept;
+      }
+    }
+  else
+    {
+    for( size_t i = 0; i < n; ++i, p += 2 )
+      {
+      uint16_t c;
+      memcpy( &c, p, 2 );
+      out[i] = slope * c + intercept;
+      }
+    }
+}
+
+// Each pixel is a single 4 bytes copy, the extra byte is overwritten by the
+// next pixel
+void ApplyLookupTable8Scalar(char *out, const char *in, size_t n,
+  const unsigned char *rgbx)
+{
+  const unsigned char *idx = (const unsigned char*)in;
+  size_t i = 0;
+  for( ; i + 4 < n; i += 4, out += 12 )
+    {
+    memcpy( out, rgbx + 4 * idx[i], 4 );
+    memcpy( out + 3, rgbx + 4 * idx[i+1], 4 );
+    memcpy( out + 6, rgbx + 4 * idx[i+2], 4 );
+    memcpy( out + 9, rgbx + 4 * idx[i+3], 4 );
+    }
+  for( ; i < n; ++i, out += 3 )
+    {
+    memcpy( out, rgbx + 4 * idx[i], 3 );
+    }
+}
+
+// The output of a pair is written after its 3 bytes are read, which allows
+// the in place unpacking (in == out + n)
+void Unpack12BitsScalar(char *out, const char *in, size_t n)
+{
+  const unsigned char *p = (const unsigned char*)in;
+  unsigned char *q = (unsigned char*)out;
+  for( size_t i = 0; i < n; ++i, p += 3, q += 4 )
+    {
+    const unsigned char b0 = p[0], b1 = p[1], b2 = p[2];
+    const uint16_t s0 = (uint16_t)(((b1 & 0xf) << 8) + b0);
+    const uint16_t s1 = (uint16_t)((b1 >> 4) + (b2 << 4));
+    memcpy( q, &s0, 2 );
+    memcpy( q + 2, &s1, 2 );
+    }
+}
+
+void Pack12BitsScalar(char *out, const char *in, size_t n)
+{
+  const unsigned char *p = (const unsigned char*)in;
+  unsigned char *q = (unsigned char*)out;
+  for( size_t i = 0; i < n; ++i, p += 4, q += 3 )
+    {
+    uint16_t s0, s1;
+    memcpy( &s0, p, 2 );
+    memcpy( &s1, p + 2, 2 );
+    q[0] = (unsigned char)(s0 & 0xff);
+    q[1] = (unsigned char)((s0 >> 8) + ((s1 & 0xf) << 4));
+    q[2] = (unsigned char)(s1 >> 4);
+    }
+}
+
+// PS 3.3 C.7.6.3.1.2 equations (CCIR Recommendation 601-2), the coefficients
+// are scaled by 2^13. YBR_PARTIAL stores Y in [16,235] and CB, CR in [16,240].
+const ColorTransform YBRFullToRGB = {
+  { { 8192, 0, 11485 }, { 8192, -2819, -5850 }, { 8192, 14516, 0 } },
+  { 0, 128, 128 },
+  { 4096, 4096, 4096 }
+};
+
+const ColorTransform YBRPartialToRGB = {
+  { { 9539, 0, 13075 }, { 9539, -3209, -6660 }, { 9539, 16525, 0 } },
+  { 16, 128, 128 },
+  { 4096, 4096, 4096 }
+};
+
+const ColorTransform RGBToYBRFull = {
+  { { 2449, 4809, 934 }, { -1382, -2714, 4096 }, { 4096, -3430, -666 } },
+  { 0, 0, 0 },
+  { 4096, (128 << 13) + 4096, (128 << 13) + 4096 }
+};
+
+const ColorTransform RGBToYBRPartial = {
+  { { 2104, 4130, 802 }, { -1214, -2384, 3598 }, { 3598, -3013, -585 } },
+  { 0, 0, 0 },
+  { (16 << 13) + 4096, (128 << 13) + 4096, (128 << 13) + 4096 }
+};
+
+// All the samples of a pixel are read before it is written, out may be in
+void ColorTransform8Scalar(char *out, const char *in, size_t n,
+  ColorTransform const &ct)
+{
+  const unsigned char *p = (const unsigned char*)in;
+  unsigned char *q = (unsigned char*)out;
+  for( size_t i = 0; i < n; ++i, p += 3, q += 3 )
+    {
+    const int a0 = p[0] - ct.Offset[0];
+    const int a1 = p[1] - ct.Offset[1];
+    const int a2 = p[2] - ct.Offset[2];
+    for( int c = 0; c < 3; ++c )
+      {
+      const int v = (ct.Matrix[c][0] * a0 + ct.Matrix[c][1] * a1
+        + ct.Matrix[c][2] * a2 + ct.Bias[c]) >> 13;
+      q[c] = (unsigned char)(v < 0 ? 0 : (v > 255 ? 255 : v));
+      }
+    }
+}
+
+// Y0,Y1,CB,CR -> Y0,CB,CR,Y1,CB,CR. The output of a pair is written after its
+// 4 bytes are read, which allows the in place upsampling (in == out + 2n)
+void UpsampleYBR422Scalar(char *out, const char *in, size_t n)
+{
+  for( size_t i = 0; i < n; ++i, in += 4, out += 6 )
+    {
+    const char y0 = in[0], y1 = in[1], cb = in[2], cr = in[3];
+    out[0] = y0;
+    out[1] = cb;
+    out[2] = cr;
+    out[3] = y1;
+    out[4] = cb;
+    out[5] = cr;
+    }
+}
+
+const KernelTable ScalarKernels = {
+  ByteSwap16Scalar,
+  ByteSwap32Scalar,
+  PlanarToInterleaved3Scalar,
+  InterleavedToPlanar3Scalar,
+  ByteSwapAndCleanup16Scalar,
+  LinearTransform16Scalar,
+  LinearTransform16ToDoubleScalar,
+  ApplyLookupTable8Scalar,
+  Unpack12BitsScalar,
+  Pack12BitsScalar,
+  ColorTransform8Scalar,
+  UpsampleYBR422Scalar
+};
+
+#if defined(GDCM_PIXELKERNELS_X86)
+
+// pshufb masks: output vector j (48 bytes of interleaved pixels) is built
+// from the 16 R, G and B values of the planes (masks[3*j+c] for channel c)
+const unsigned char PlanarToInterleavedMasks[9][16] = {
+  { 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80, 0x05 },
+  { 0x80, 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80 },
+  { 0x80, 0x80, 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80 },
+  { 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0a, 0x80 },
+  { 0x05, 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0a },
+  { 0x80, 0x05, 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80 },
+  { 0x80, 0x0b, 0x80, 0x80, 0x0c, 0x80, 0x80, 0x0d, 0x80, 0x80, 0x0e, 0x80, 0x80, 0x0f, 0x80, 0x80 },
+  { 0x80, 0x80, 0x0b, 0x80, 0x80, 0x0c, 0x80, 0x80, 0x0d, 0x80, 0x80, 0x0e, 0x80, 0x80, 0x0f, 0x80 },
+  { 0x0a, 0x80, 0x80, 0x0b, 0x80, 0x80, 0x0c, 0x80, 0x80, 0x0d, 0x80, 0x80, 0x0e, 0x80, 0x80, 0x0f }
+};
+
+// pshufb masks: plane c is gathered from the three 16 bytes vectors of
+// interleaved pixels (masks[3*c+j] for input vector j)
+const unsigned char InterleavedToPlanarMasks[9][16] = {
+  { 0x00, 0x03, 0x06, 0x09, 0x0c, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02, 0x05, 0x08, 0x0b, 0x0e, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0x04, 0x07, 0x0a, 0x0d },
+  { 0x01, 0x04, 0x07, 0x0a, 0x0d, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x03, 0x06, 0x09, 0x0c, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02, 0x05, 0x08, 0x0b, 0x0e },
+  { 0x02, 0x05, 0x08, 0x0b, 0x0e, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0x04, 0x07, 0x0a, 0x0d, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x03, 0x06, 0x09, 0x0c, 0x0f }
+};
+
+// SSE2
+
+GDCM_PIXELKERNELS_TARGET("sse2")
+void ByteSwap16SSE2(void *buffer, size_t n)
+{
+  char *p = (char*)buffer;
+  const size_t nv = n / 8;
+  for( size_t i = 0; i < nv; ++i, p += 16 )
+    {
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    _mm_storeu_si128((__m128i*)p, v);
+    }
+  ByteSwap16Scalar(p, n - nv * 8);
+}
+
+GDCM_PIXELKERNELS_TARGET("sse2")
+void ByteSwap32SSE2(void *buffer, size_t n)
+{
+  char *p = (char*)buffer;
+  const size_t nv = n / 4;
+  for( size_t i = 0; i < nv; ++i, p += 16 )
+    {
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2,3,0,1));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2,3,0,1));
+    _mm_storeu_si128((__m128i*)p, v);
+    }
+  ByteSwap32Scalar(p, n - nv * 4);
+}
+
+GDCM_PIXELKERNELS_TARGET("sse2")
+void ByteSwapAndCleanup16SSE2(void *buffer, size_t n,
+  CleanupParameters const &p)
+{
+  char *q = (char*)buffer;
+  const size_t nv = n / 8;
+  const __m128i shift = _mm_cvtsi32_si128(p.Shift);
+  const __m128i pmask = _mm_set1_epi16((short)p.PMask);
+  const __m128i smask = _mm_set1_epi16((short)p.SMask);
+  const __m128i nmask = _mm_set1_epi16((short)p.NMask);
+  for( size_t i = 0; i < nv; ++i, q += 16 )
+    {
+    __m128i v = _mm_loadu_si128((const __m128i*)q);
+    if( p.ByteSwap )
+      {
+      v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+      }
+    if( p.Cleanup )
+      {
+      v = _mm_srl_epi16(v, shift);
+      if( p.Sign )
+        {
+        const __m128i s = _mm_cmpeq_epi16(_mm_and_si128(v, smask), smask);
+        v = _mm_or_si128(_mm_and_si128(s, _mm_or_si128(v, nmask)),
+          _mm_andnot_si128(s, _mm_and_si128(v, pmask)));
+        }
+      else
+        {
+        v = _mm_and_si128(v, pmask);
+        }
+      }
+    _mm_storeu_si128((__m128i*)q, v);
+    }
+  ByteSwapAndCleanup16Scalar(q, n - nv * 8, p);
+}
+
+GDCM_PIXELKERNELS_TARGET("sse2")
+void LinearTransform16SSE2(void *out, const void *in, size_t n,
+  uint16_t slope, uint16_t intercept)
+{
+  const char *p = (const char*)in;
+  char *q = (char*)out;
+  const size_t nv = n / 8;
+  const __m128i s = _mm_set1_epi16((short)slope);
+  const __m128i c = _mm_set1_epi16((short)intercept);
+  for( size_t i = 0; i < nv; ++i, p += 16, q += 16 )
+    {
+    const __m128i v = _mm_loadu_si128((const __m128i*)p);
+    _mm_storeu_si128((__m128i*)q, _mm_add_epi16(_mm_mullo_epi16(v, s), c));
+    }
+  LinearTransform16Scalar(q, p, n - nv * 8, slope, intercept);
+}
+
+GDCM_PIXELKERNELS_TARGET("sse2")
+void LinearTransform16ToDoubleSSE2(double *out, const void *in, size_t n,
+  bool sign, double slope, double intercept)
+{
+  const char *p = (const char*)in;
+  const size_t nv = n / 8;
+  const __m128d s = _mm_set1_pd(slope);
+  const __m128d c = _mm_set1_pd(intercept);
+  const __m128i zero = _mm_setzero_si128();
+  for( size_t i = 0; i < nv; ++i, p += 16, out += 8 )
+    {
+    const __m128i v = _mm_loadu_si128((const __m128i*)p);
+    __m128i v32[2];
+    if( sign )
+      {
+      // sign extension: duplicate the words and shift them back
+      v32[0] = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+      v32[1] = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+      }
+    else
+      {
+      v32[0] = _mm_unpacklo_epi16(v, zero);
+      v32[1] = _mm_unpackhi_epi16(v, zero);
+      }
+    for( int j = 0; j < 2; ++j )
+      {
+      const __m128d lo = _mm_cvtepi32_pd(v32[j]);
+      const __m128d hi = _mm_cvtepi32_pd(_mm_shuffle_epi32(v32[j], _MM_SHUFFLE(1,0,3,2)));
+      _mm_storeu_pd(out + 4 * j, _mm_add_pd(_mm_mul_pd(lo, s), c));
+      _mm_storeu_pd(out + 4 * j + 2, _mm_add_pd(_mm_mul_pd(hi, s), c));
+      }
+    }
+  LinearTransform16ToDoubleScalar(out, p, n - nv * 8, sign, slope, intercept);
+}
+
+// SSSE3
+
+GDCM_PIXELKERNELS_TARGET("ssse3")
+void ByteSwap16SSSE3(void *buffer, size_t n)
+{
+  char *p = (char*)buffer;
+  const size_t nv = n / 8;
+  const __m128i mask = _mm_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14);
+  for( size_t i = 0; i < nv; ++i, p += 16 )
+    {
+    const __m128i v = _mm_loadu_si128((const __m128i*)p);
+    _mm_storeu_si128((__m128i*)p, _mm_shuffle_epi8(v, mask));
+    }
+  ByteSwap16Scalar(p, n - nv * 8);
+}
+
+GDCM_PIXELKERNELS_TARGET("ssse3")
+void ByteSwap32SSSE3(void *buffer, size_t n)
+{
+  char *p = (char*)buffer;
+  const size_t nv = n / 4;
+  const __m128i mask = _mm_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+  for( size_t i = 0; i < nv; ++i, p += 16 )
+    {
+    const __m128i v = _mm_loadu_si128((const __m128i*)p);
+    _mm_storeu_si128((__m128i*)p, _mm_shuffle_epi8(v, mask));
+    }
+  ByteSwap32Scalar(p, n - nv * 4);
+}
+
+GDCM_PIXELKERNELS_TARGET("ssse3")
+void PlanarToInterleaved3SSSE3(char *out,
+  const char *r, const char *g, const char *b, size_t n)
+{
+  __m128i m[9];
+  for( int k = 0; k < 9; ++k )
+    {
+    m[k] = _mm_loadu_si128((const __m128i*)PlanarToInterleavedMasks[k]);
+    }
+  const size_t nv = n / 16;
+  for( size_t i = 0; i < nv; ++i, r += 16, g += 16, b += 16, out += 48 )
+    {
+    const __m128i vr = _mm_loadu_si128((const __m128i*)r);
+    const __m128i vg = _mm_loadu_si128((const __m128i*)g);
+    const __m128i vb = _mm_loadu_si128((const __m128i*)b);
+    for( int j = 0; j < 3; ++j )
+      {
+      const __m128i o = _mm_or_si128(
+        _mm_or_si128(_mm_shuffle_epi8(vr, m[3*j]), _mm_shuffle_epi8(vg, m[3*j+1])),
+        _mm_shuffle_epi8(vb, m[3*j+2]));
+      _mm_storeu_si128((__m128i*)(out + 16 * j), o);
+      }
+    }
+  PlanarToInterleaved3Scalar(out, r, g, b, n - nv * 16);
+}
+
+GDCM_PIXELKERNELS_TARGET("ssse3")
+void InterleavedToPlanar3SSSE3(char *r, char *g, char *b,
+  const char *in, size_t n)
+{
+  __m128i m[9];
+  for( int k = 0; k < 9; ++k )
+    {
+    m[k] = _mm_loadu_si128((const __m128i*)InterleavedToPlanarMasks[k]);
+    }
+  char *planes[3];
+  const size_t nv = n / 16;
+  for( size_t i = 0; i < nv; ++i, r += 16, g += 16, b += 16, in += 48 )
+    {
+    const __m128i v0 = _mm_loadu_si128((const __m128i*)in);
+    const __m128i v1 = _mm_loadu_si128((const __m128i*)(in + 16));
+    const __m128i v2 = _mm_loadu_si128((const __m128i*)(in + 32));
+    planes[0] = r; planes[1] = g; planes[2] = b;
+    for( int c = 0; c < 3; ++c )
+      {
+      const __m128i o = _mm_or_si128(
+        _mm_or_si128(_mm_shuffle_epi8(v0, m[3*c]), _mm_shuffle_epi8(v1, m[3*c+1])),
+        _mm_shuffle_epi8(v2, m[3*c+2]));
+      _mm_storeu_si128((__m128i*)planes[c], o);
+      }
+    }
+  InterleavedToPlanar3Scalar(r, g, b, in, n - nv * 16);
+}
+
+// Each 16 bits lane gets the two bytes holding its 12 bits: an even sample
+// is (b0 | b1 << 8) & 0xfff, an odd sample is (b1 | b2 << 8) >> 4. Even lanes
+// are multiplied by 16 (dropping the extra nibble) so that a single shift
+// right finishes both.
+GDCM_PIXELKERNELS_TARGET("ssse3")
+void Unpack12BitsSSSE3(char *out, const char *in, size_t n)
+{
+  const __m128i mask = _mm_setr_epi8(0,1,1,2,3,4,4,5,6,7,7,8,9,10,10,11);
+  const __m128i mul = _mm_setr_epi16(16,1,16,1,16,1,16,1);
+  size_t i = 0;
+  // 4 pairs per iteration, the 16 bytes load needs 6 pairs of input
+  for( ; i + 6 <= n; i += 4, in += 12, out += 16 )
+    {
+    const __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)in), mask);
+    _mm_storeu_si128((__m128i*)out, _mm_srli_epi16(_mm_mullo_epi16(v, mul), 4));
+    }
+  Unpack12BitsScalar(out, in, n - i);
+}
+
+// Per pair of words (s0, s1): byte 0 is s0, byte 1 is (s0 >> 8) + (s1 << 4)
+// and byte 2 is s1 >> 4. The 16 bytes store writes 4 bytes past the 12 bytes
+// of output, which are overwritten by the next iteration.
+GDCM_PIXELKERNELS_TARGET("ssse3")
+void Pack12BitsSSSE3(char *out, const char *in, size_t n)
+{
+  const __m128i m0 = _mm_setr_epi8(0,-1,-1,4,-1,-1,8,-1,-1,12,-1,-1,-1,-1,-1,-1);
+  const __m128i m1 = _mm_setr_epi8(-1,0,-1,-1,4,-1,-1,8,-1,-1,12,-1,-1,-1,-1,-1);
+  const __m128i m2 = _mm_setr_epi8(-1,-1,2,-1,-1,6,-1,-1,10,-1,-1,14,-1,-1,-1,-1);
+  const __m128i nibble = _mm_set1_epi32(0xf);
+  size_t i = 0;
+  for( ; i + 6 <= n; i += 4, in += 16, out += 12 )
+    {
+    const __m128i v = _mm_loadu_si128((const __m128i*)in);
+    const __m128i b1 = _mm_add_epi16(_mm_srli_epi16(v, 8),
+      _mm_slli_epi16(_mm_and_si128(_mm_srli_epi32(v, 16), nibble), 4));
+    const __m128i b2 = _mm_srli_epi16(v, 4);
+    const __m128i o = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v, m0),
+        _mm_shuffle_epi8(b1, m1)), _mm_shuffle_epi8(b2, m2));
+    _mm_storeu_si128((__m128i*)out, o);
+    }
+  Pack12BitsScalar(out, in, n - i);
+}
+
+// The two 16 bits coefficients of a pmaddwd pair
+inline int MaddPair(short lo, short hi)
+{
+  return (int)((unsigned int)(unsigned short)lo
+    | ((unsigned int)(unsigned short)hi << 16));
+}
+
+// Output sample c of 8 pixels: (a0,a1) and (a2,0) pairs are multiplied by
+// (m0,m1) and (m2,0) in 32 bits, then rounded, shifted and saturated to 16
+// bits
+GDCM_PIXELKERNELS_TARGET("ssse3")
+inline __m128i ColorTransformSampleSSSE3(__m128i a01lo, __m128i a01hi,
+  __m128i a2lo, __m128i a2hi, __m128i m01, __m128i m2, __m128i bias)
+{
+  const __m128i lo = _mm_add_epi32(_mm_add_epi32(
+      _mm_madd_epi16(a01lo, m01), _mm_madd_epi16(a2lo, m2)), bias);
+  const __m128i hi = _mm_add_epi32(_mm_add_epi32(
+      _mm_madd_epi16(a01hi, m01), _mm_madd_epi16(a2hi, m2)), bias);
+  return _mm_packs_epi32(_mm_srai_epi32(lo, 13), _mm_srai_epi32(hi, 13));
+}
+
+// 16 pixels per iteration: the samples are split into planes, transformed as
+// 16 bits lanes and interleaved back
+GDCM_PIXELKERNELS_TARGET("ssse3")
+void ColorTransform8SSSE3(char *out, const char *in, size_t n,
+  ColorTransform const &ct)
+{
+  __m128i ip[9], pi[9];
+  for( int k = 0; k < 9; ++k )
+    {
+    ip[k] = _mm_loadu_si128((const __m128i*)InterleavedToPlanarMasks[k]);
+    pi[k] = _mm_loadu_si128((const __m128i*)PlanarToInterleavedMasks[k]);
+    }
+  __m128i off[3], m01[3], m2[3], bias[3];
+  for( int c = 0; c < 3; ++c )
+    {
+    off[c] = _mm_set1_epi16(ct.Offset[c]);
+    m01[c] = _mm_set1_epi32(MaddPair(ct.Matrix[c][0], ct.Matrix[c][1]));
+    m2[c] = _mm_set1_epi32(MaddPair(ct.Matrix[c][2], 0));
+    bias[c] = _mm_set1_epi32(ct.Bias[c]);
+    }
+  const __m128i zero = _mm_setzero_si128();
+  const size_t nv = n / 16;
+  for( size_t i = 0; i < nv; ++i, in += 48, out += 48 )
+    {
+    const __m128i v0 = _mm_loadu_si128((const __m128i*)in);
+    const __m128i v1 = _mm_loadu_si128((const __m128i*)(in + 16));
+    const __m128i v2 = _mm_loadu_si128((const __m128i*)(in + 32));
+    __m128i p[3], s[3][2];
+    for( int c = 0; c < 3; ++c )
+      {
+      p[c] = _mm_or_si128(
+        _mm_or_si128(_mm_shuffle_epi8(v0, ip[3*c]), _mm_shuffle_epi8(v1, ip[3*c+1])),
+        _mm_shuffle_epi8(v2, ip[3*c+2]));
+      }
+    for( int h = 0; h < 2; ++h )
+      {
+      __m128i a[3];
+      for( int k = 0; k < 3; ++k )
+        {
+        a[k] = _mm_sub_epi16(h ? _mm_unpackhi_epi8(p[k], zero)
+          : _mm_unpacklo_epi8(p[k], zero), off[k]);
+        }
+      const __m128i a01lo = _mm_unpacklo_epi16(a[0], a[1]);
+      const __m128i a01hi = _mm_unpackhi_epi16(a[0], a[1]);
+      const __m128i a2lo = _mm_unpacklo_epi16(a[2], zero);
+      const __m128i a2hi = _mm_unpackhi_epi16(a[2], zero);
+      for( int c = 0; c < 3; ++c )
+        {
+        s[c][h] = ColorTransformSampleSSSE3(a01lo, a01hi, a2lo, a2hi,
+          m01[c], m2[c], bias[c]);
+        }
+      }
+    for( int c = 0; c < 3; ++c )
+      {
+      p[c] = _mm_packus_epi16(s[c][0], s[c][1]);
+      }
+    for( int j = 0; j < 3; ++j )
+      {
+      const __m128i o = _mm_or_si128(
+        _mm_or_si128(_mm_shuffle_epi8(p[0], pi[3*j]), _mm_shuffle_epi8(p[1], pi[3*j+1])),
+        _mm_shuffle_epi8(p[2], pi[3*j+2]));
+      _mm_storeu_si128((__m128i*)(out + 16 * j), o);
+      }
+    }
+  ColorTransform8Scalar(out, in, n - nv * 16, ct);
+}
+
+// 4 pairs (16 bytes) become 24 bytes, stored as 16 + 8 bytes. In place, the
+// stores never reach the input which has not been loaded yet.
+GDCM_PIXELKERNELS_TARGET("ssse3")
+void UpsampleYBR422SSSE3(char *out, const char *in, size_t n)
+{
+  const __m128i m0 = _mm_setr_epi8(0,2,3,1,2,3,4,6,7,5,6,7,8,10,11,9);
+  const __m128i m1 = _mm_setr_epi8(10,11,12,14,15,13,14,15,-1,-1,-1,-1,-1,-1,-1,-1);
+  size_t i = 0;
+  for( ; i + 4 <= n; i += 4, in += 16, out += 24 )
+    {
+    const __m128i v = _mm_loadu_si128((const __m128i*)in);
+    _mm_storeu_si128((__m128i*)out, _mm_shuffle_epi8(v, m0));
+    _mm_storel_epi64((__m128i*)(out + 16), _mm_shuffle_epi8(v, m1));
+    }
+  UpsampleYBR422Scalar(out, in, n - i);
+}
+
+// AVX2
+
+GDCM_PIXELKERNELS_TARGET("avx2")
+void ByteSwap16AVX2(void *buffer, size_t n)
+{
+  char *p = (char*)buffer;
+  const size_t nv = n / 16;
+  const __m256i mask = _mm256_setr_epi8(
+    1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14,
+    1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14);
+  for( size_t i = 0; i < nv; ++i, p += 32 )
+    {
+    const __m256i v = _mm256_loadu_si256((const __m256i*)p);
+    _mm256_storeu_si256((__m256i*)p, _mm256_shuffle_epi8(v, mask));
+    }
+  ByteSwap16Scalar(p, n - nv * 16);
+}
+
+GDCM_PIXELKERNELS_TARGET("avx2")
+void ByteSwap32AVX2(void *buffer, size_t n)
+{
+  char *p = (char*)buffer;
+  const size_t nv = n / 8;
+  const __m256i mask = _mm256_setr_epi8(
+    3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12,
+    3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+  for( size_t i = 0; i < nv; ++i, p += 32 )
+    {
+    const __m256i v = _mm256_loadu_si256((const __m256i*)p);
+    _mm256_storeu_si256((__m256i*)p, _mm256_shuffle_epi8(v, mask));
+    }
+  ByteSwap32Scalar(p, n - nv * 8);
+}
+
+GDCM_PIXELKERNELS_TARGET("avx2")
+void ByteSwapAndCleanup16AVX2(void *buffer, size_t n,
+  CleanupParameters const &p)
+{
+  char *q = (char*)buffer;
+  const size_t nv = n / 16;
+  const __m256i swap = _mm256_setr_epi8(
+    1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14,
+    1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14);
+  const __m128i shift = _mm_cvtsi32_si128(p.Shift);
+  const __m256i pmask = _mm256_set1_epi16((short)p.PMask);
+  const __m256i smask = _mm256_set1_epi16((short)p.SMask);
+  const __m256i nmask = _mm256_set1_epi16((short)p.NMask);
+  for( size_t i = 0; i < nv; ++i, q += 32 )
+    {
+    __m256i v = _mm256_loadu_si256((const __m256i*)q);
+    if( p.ByteSwap )
+      {
+      v = _mm256_shuffle_epi8(v, swap);
+      }
+    if( p.Cleanup )
+      {
+      v = _mm256_srl_epi16(v, shift);
+      if( p.Sign )
+        {
+        const __m256i s = _mm256_cmpeq_epi16(_mm256_and_si256(v, smask), smask);
+        v = _mm256_blendv_epi8(_mm256_and_si256(v, pmask),
+          _mm256_or_si256(v, nmask), s);
+        }
+      else
+        {
+        v = _mm256_and_si256(v, pmask);
+        }
+      }
+    _mm256_storeu_si256((__m256i*)q, v);
+    }
+  ByteSwapAndCleanup16Scalar(q, n - nv * 16, p);
+}
+
+GDCM_PIXELKERNELS_TARGET("avx2")
+void LinearTransform16AVX2(void *out, const void *in, size_t n,
+  uint16_t slope, uint16_t intercept)
+{
+  const char *p = (const char*)in;
+  char *q = (char*)out;
+  const size_t nv = n / 16;
+  const __m256i s = _mm256_set1_epi16((short)slope);
+  const __m256i c = _mm256_set1_epi16((short)intercept);
+  for( size_t i = 0; i < nv; ++i, p += 32, q += 32 )
+    {
+    const __m256i v = _mm256_loadu_si256((const __m256i*)p);
+    _mm256_storeu_si256((__m256i*)q, _mm256_add_epi16(_mm256_mullo_epi16(v, s), c));
+    }
+  LinearTransform16Scalar(q, p, n - nv * 16, slope, intercept);
+}
+
+GDCM_PIXELKERNELS_TARGET("avx2")
+void LinearTransform16ToDoubleAVX2(double *out, const void *in, size_t n,
+  bool sign, double slope, double intercept)
+{
+  const char *p = (const char*)in;
+  const size_t nv = n / 8;
+  const __m256d s = _mm256_set1_pd(slope);
+  const __m256d c = _mm256_set1_pd(intercept);
+  for( size_t i = 0; i < nv; ++i, p += 16, out += 8 )
+    {
+    const __m128i v = _mm_loadu_si128((const __m128i*)p);
+    const __m256i v32 = sign ? _mm256_cvtepi16_epi32(v) : _mm256_cvtepu16_epi32(v);
+    const __m256d lo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(v32));
+    const __m256d hi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(v32, 1));
+    _mm256_storeu_pd(out, _mm256_add_pd(_mm256_mul_pd(lo, s), c));
+    _mm256_storeu_pd(out + 4, _mm256_add_pd(_mm256_mul_pd(hi, s), c));
+    }
+  LinearTransform16ToDoubleScalar(out, p, n - nv * 8, sign, slope, intercept);
+}
+
+// Gather 8 R,G,B,x entries, drop the unused bytes within each 128 bits lane
+// and store the two lanes as 12 bytes each. The stores write 4 bytes past
+// the 24 bytes of output, which are overwritten by the next iteration.
+GDCM_PIXELKERNELS_TARGET("avx2")
+void ApplyLookupTable8AVX2(char *out, const char *in, size_t n,
+  const unsigned char *rgbx)
+{
+  const __m256i pack = _mm256_setr_epi8(
+    0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1,
+    0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1);
+  const int *table = (const int*)rgbx;
+  size_t i = 0;
+  for( ; i + 10 <= n; i += 8, in += 8, out += 24 )
+    {
+    const __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)in));
+    const __m256i v = _mm256_shuffle_epi8(_mm256_i32gather_epi32(table, idx, 4), pack);
+    _mm_storeu_si128((__m128i*)out, _mm256_castsi256_si128(v));
+    _mm_storeu_si128((__m128i*)(out + 12), _mm256_extracti128_si256(v, 1));
+    }
+  ApplyLookupTable8Scalar(out, in, n - i, rgbx);
+}
+
+// Same as SSSE3, on 12 bytes loaded into each 128 bits lane
+GDCM_PIXELKERNELS_TARGET("avx2")
+void Unpack12BitsAVX2(char *out, const char *in, size_t n)
+{
+  const __m256i mask = _mm256_setr_epi8(
+    0,1,1,2,3,4,4,5,6,7,7,8,9,10,10,11,
+    0,1,1,2,3,4,4,5,6,7,7,8,9,10,10,11);
+  const __m256i mul = _mm256_setr_epi16(16,1,16,1,16,1,16,1,16,1,16,1,16,1,16,1);
+  size_t i = 0;
+  // 8 pairs per iteration, the second 16 bytes load needs 10 pairs of input
+  for( ; i + 10 <= n; i += 8, in += 24, out += 32 )
+    {
+    const __m256i v = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)in)),
+      _mm_loadu_si128((const __m128i*)(in + 12)), 1);
+    const __m256i w = _mm256_shuffle_epi8(v, mask);
+    _mm256_storeu_si256((__m256i*)out, _mm256_srli_epi16(_mm256_mullo_epi16(w, mul), 4));
+    }
+  Unpack12BitsScalar(out, in, n - i);
+}
+
+// Same as SSSE3, with the 16 pixels of each plane in a single register: the
+// unpacking and packing within 128 bits lanes keep the pixels in order
+GDCM_PIXELKERNELS_TARGET("avx2")
+void ColorTransform8AVX2(char *out, const char *in, size_t n,
+  ColorTransform const &ct)
+{
+  __m128i ip[9], pi[9];
+  for( int k = 0; k < 9; ++k )
+    {
+    ip[k] = _mm_loadu_si128((const __m128i*)InterleavedToPlanarMasks[k]);
+    pi[k] = _mm_loadu_si128((const __m128i*)PlanarToInterleavedMasks[k]);
+    }
+  __m256i off[3], m01[3], m2[3], bias[3];
+  for( int c = 0; c < 3; ++c )
+    {
+    off[c] = _mm256_set1_epi16(ct.Offset[c]);
+    m01[c] = _mm256_set1_epi32(MaddPair(ct.Matrix[c][0], ct.Matrix[c][1]));
+    m2[c] = _mm256_set1_epi32(MaddPair(ct.Matrix[c][2], 0));
+    bias[c] = _mm256_set1_epi32(ct.Bias[c]);
+    }
+  const __m256i zero = _mm256_setzero_si256();
+  const size_t nv = n / 16;
+  for( size_t i = 0; i < nv; ++i, in += 48, out += 48 )
+    {
+    const __m128i v0 = _mm_loadu_si128((const __m128i*)in);
+    const __m128i v1 = _mm_loadu_si128((const __m128i*)(in + 16));
+    const __m128i v2 = _mm_loadu_si128((const __m128i*)(in + 32));
+    __m256i a[3];
+    for( int k = 0; k < 3; ++k )
+      {
+      const __m128i p = _mm_or_si128(
+        _mm_or_si128(_mm_shuffle_epi8(v0, ip[3*k]), _mm_shuffle_epi8(v1, ip[3*k+1])),
+        _mm_shuffle_epi8(v2, ip[3*k+2]));
+      a[k] = _mm256_sub_epi16(_mm256_cvtepu8_epi16(p), off[k]);
+      }
+    const __m256i a01lo = _mm256_unpacklo_epi16(a[0], a[1]);
+    const __m256i a01hi = _mm256_unpackhi_epi16(a[0], a[1]);
+    const __m256i a2lo = _mm256_unpacklo_epi16(a[2], zero);
+    const __m256i a2hi = _mm256_unpackhi_epi16(a[2], zero);
+    __m128i p[3];
+    for( int c = 0; c < 3; ++c )
+      {
+      const __m256i lo = _mm256_add_epi32(_mm256_add_epi32(
+          _mm256_madd_epi16(a01lo, m01[c]), _mm256_madd_epi16(a2lo, m2[c])), bias[c]);
+      const __m256i hi = _mm256_add_epi32(_mm256_add_epi32(
+          _mm256_madd_epi16(a01hi, m01[c]), _mm256_madd_epi16(a2hi, m2[c])), bias[c]);
+      const __m256i s = _mm256_packs_epi32(_mm256_srai_epi32(lo, 13),
+        _mm256_srai_epi32(hi, 13));
+      p[c] = _mm_packus_epi16(_mm256_castsi256_si128(s),
+        _mm256_extracti128_si256(s, 1));
+      }
+    for( int j = 0; j < 3; ++j )
+      {
+      const __m128i o = _mm_or_si128(
+        _mm_or_si128(_mm_shuffle_epi8(p[0], pi[3*j]), _mm_shuffle_epi8(p[1], pi[3*j+1])),
+        _mm_shuffle_epi8(p[2], pi[3*j+2]));
+      _mm_storeu_si128((__m128i*)(out + 16 * j), o);
+      }
+    }
+  ColorTransform8Scalar(out, in, n - nv * 16, ct);
+}
+
+const KernelTable SSE2Kernels = {
+  ByteSwap16SSE2,
+  ByteSwap32SSE2,
+  PlanarToInterleaved3Scalar,
+  InterleavedToPlanar3Scalar,
+  ByteSwapAndCleanup16SSE2,
+  LinearTransform16SSE2,
+  LinearTransform16ToDoubleSSE2,
+  ApplyLookupTable8Scalar,
+  Unpack12BitsScalar,
+  Pack12BitsScalar,
+  ColorTransform8Scalar,
+  UpsampleYBR422Scalar
+};
+
+const KernelTable SSSE3Kernels = {
+  ByteSwap16SSSE3,
+  ByteSwap32SSSE3,
+  PlanarToInterleaved3SSSE3,
+  InterleavedToPlanar3SSSE3,
+  ByteSwapAndCleanup16SSE2,
+  LinearTransform16SSE2,
+  LinearTransform16ToDoubleSSE2,
+  ApplyLookupTable8Scalar,
+  Unpack12BitsSSSE3,
+  Pack12BitsSSSE3,
+  ColorTransform8SSSE3,
+  UpsampleYBR422SSSE3
+};
+
+// Planar configuration shuffles, 12 bits packing and 4:2:2 upsampling do not
+// cross 128 bits lanes, keep SSSE3
+const KernelTable AVX2Kernels = {
+  ByteSwap16AVX2,
+  ByteSwap32AVX2,
+  PlanarToInterleaved3SSSE3,
+  InterleavedToPlanar3SSSE3,
+  ByteSwapAndCleanup16AVX2,
+  LinearTransform16AVX2,
+  LinearTransform16ToDoubleAVX2,
+  ApplyLookupTable8AVX2,
+  Unpack12BitsAVX2,
+  Pack12BitsSSSE3,
+  ColorTransform8AVX2,
+  UpsampleYBR422SSSE3
+};
+
+bool CPUSupports(PixelKernels::InstructionSetType is)
+{
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  const bool sse2 = (info[3] & (1 << 26)) != 0;
+  const bool ssse3 = (info[2] & (1 << 9)) != 0;
+  // AVX2 also requires the OS to save the ymm registers
+  bool avx2 = false;
+  if( (info[2] & (1 << 27)) && (info[2] & (1 << 28))
+    && (_xgetbv(0) & 0x6) == 0x6 )
+    {
+    __cpuidex(info, 7, 0);
+    avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+  __builtin_cpu_init();
+  const bool sse2 = __builtin_cpu_supports("sse2") != 0;
+  const bool ssse3 = __builtin_cpu_supports("ssse3") != 0;
+  const bool avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+  switch( is )
+    {
+  case PixelKernels::SSE2:
+    return sse2;
+  case PixelKernels::SSSE3:
+    return sse2 && ssse3;
+  case PixelKernels::AVX2:
+    return sse2 && ssse3 && avx2;
+  default:
+    return false;
+    }
+}
+
+#endif // GDCM_PIXELKERNELS_X86
+
+#if defined(GDCM_PIXELKERNELS_NEON)
+
+void ByteSwap16NEON(void *buffer, size_t n)
+{
+  uint8_t *p = (uint8_t*)buffer;
+  const size_t nv = n / 8;
+  for( size_t i = 0; i < nv; ++i, p += 16 )
+    {
+    vst1q_u8(p, vrev16q_u8(vld1q_u8(p)));
+    }
+  ByteSwap16Scalar(p, n - nv * 8);
+}
+
+void ByteSwap32NEON(void *buffer, size_t n)
+{
+  uint8_t *p = (uint8_t*)buffer;
+  const size_t nv = n / 4;
+  for( size_t i = 0; i < nv; ++i, p += 16 )
+    {
+    vst1q_u8(p, vrev32q_u8(vld1q_u8(p)));
+    }
+  ByteSwap32Scalar(p, n - nv * 4);
+}
+
+void PlanarToInterleaved3NEON(char *out,
+  const char *r, const char *g, const char *b, size_t n)
+{
+  const size_t nv = n / 16;
+  for( size_t i = 0; i < nv; ++i, r += 16, g += 16, b += 16, out += 48 )
+    {
+    uint8x16x3_t v;
+    v.val[0] = vld1q_u8((const uint8_t*)r);
+    v.val[1] = vld1q_u8((const uint8_t*)g);
+    v.val[2] = vld1q_u8((const uint8_t*)b);
+    vst3q_u8((uint8_t*)out, v);
+    }
+  PlanarToInterleaved3Scalar(out, r, g, b, n - nv * 16);
+}
+
+void InterleavedToPlanar3NEON(char *r, char *g, char *b,
+  const char *in, size_t n)
+{
+  const size_t nv = n / 16;
+  for( size_t i = 0; i < nv; ++i, r += 16, g += 16, b += 16, in += 48 )
+    {
+    const uint8x16x3_t v = vld3q_u8((const uint8_t*)in);
+    vst1q_u8((uint8_t*)r, v.val[0]);
+    vst1q_u8((uint8_t*)g, v.val[1]);
+    vst1q_u8((uint8_t*)b, v.val[2]);
+    }
+  InterleavedToPlanar3Scalar(r, g, b, in, n - nv * 16);
+}
+
+void ByteSwapAndCleanup16NEON(void *buffer, size_t n,
+  CleanupParameters const &p)
+{
+  uint8_t *q = (uint8_t*)buffer;
+  const size_t nv = n / 8;
+  const int16x8_t shift = vdupq_n_s16((int16_t)-(int)p.Shift);
+  const uint16x8_t pmask = vdupq_n_u16(p.PMask);
+  const uint16x8_t smask = vdupq_n_u16(p.SMask);
+  const uint16x8_t nmask = vdupq_n_u16(p.NMask);
+  for( size_t i = 0; i < nv; ++i, q += 16 )
+    {
+    uint8x16_t b = vld1q_u8(q);
+    if( p.ByteSwap )
+      {
+      b = vrev16q_u8(b);
+      }
+    uint16x8_t v = vreinterpretq_u16_u8(b);
+    if( p.Cleanup )
+      {
+      v = vshlq_u16(v, shift);
+      if( p.Sign )
+        {
+        const uint16x8_t s = vtstq_u16(v, smask);
+        v = vbslq_u16(s, vorrq_u16(v, nmask), vandq_u16(v, pmask));
+        }
+      else
+        {
+        v = vandq_u16(v, pmask);
+        }
+      }
+    vst1q_u8(q, vreinterpretq_u8_u16(v));
+    }
+  ByteSwapAndCleanup16Scalar(q, n - nv * 8, p);
+}
+
+void LinearTransform16NEON(void *out, const void *in, size_t n,
+  uint16_t slope, uint16_t intercept)
+{
+  const uint8_t *p = (const uint8_t*)in;
+  uint8_t *q = (uint8_t*)out;
+  const size_t nv = n / 8;
+  const uint16x8_t s = vdupq_n_u16(slope);
+  const uint16x8_t c = vdupq_n_u16(intercept);
+  for( size_t i = 0; i < nv; ++i, p += 16, q += 16 )
+    {
+    const uint16x8_t v = vreinterpretq_u16_u8(vld1q_u8(p));
+    vst1q_u8(q, vreinterpretq_u8_u16(vmlaq_u16(c, v, s)));
+    }
+  LinearTransform16Scalar(q, p, n - nv * 8, slope, intercept);
+}
+
+void Unpack12BitsNEON(char *out, const char *in, size_t n)
+{
+  const size_t nv = n / 8;
+  const uint16x8_t nibble = vdupq_n_u16(0xf);
+  for( size_t i = 0; i < nv; ++i, in += 24, out += 32 )
+    {
+    const uint8x8x3_t b = vld3_u8((const uint8_t*)in);
+    const uint16x8_t b1 = vmovl_u8(b.val[1]);
+    uint16x8x2_t s;
+    s.val[0] = vorrq_u16(vmovl_u8(b.val[0]), vshlq_n_u16(vandq_u16(b1, nibble), 8));
+    s.val[1] = vorrq_u16(vshrq_n_u16(b1, 4), vshlq_n_u16(vmovl_u8(b.val[2]), 4));
+    vst2q_u16((uint16_t*)out, s);
+    }
+  Unpack12BitsScalar(out, in, n - nv * 8);
+}
+
+void Pack12BitsNEON(char *out, const char *in, size_t n)
+{
+  const size_t nv = n / 8;
+  const uint16x8_t nibble = vdupq_n_u16(0xf);
+  for( size_t i = 0; i < nv; ++i, in += 32, out += 24 )
+    {
+    const uint16x8x2_t s = vld2q_u16((const uint16_t*)in);
+    uint8x8x3_t b;
+    b.val[0] = vmovn_u16(s.val[0]);
+    b.val[1] = vmovn_u16(vaddq_u16(vshrq_n_u16(s.val[0], 8),
+        vshlq_n_u16(vandq_u16(s.val[1], nibble), 4)));
+    b.val[2] = vmovn_u16(vshrq_n_u16(s.val[1], 4));
+    vst3_u8((uint8_t*)out, b);
+    }
+  Pack12BitsScalar(out, in, n - nv * 8);
+}
+
+// Output sample c of 8 pixels, computed in 32 bits then saturated to 8 bits
+inline uint8x8_t ColorTransformSampleNEON(const int16x8_t a[3],
+  ColorTransform const &ct, int c)
+{
+  const int32x4_t bias = vdupq_n_s32(ct.Bias[c]);
+  int32x4_t lo = vmlal_n_s16(bias, vget_low_s16(a[0]), ct.Matrix[c][0]);
+  lo = vmlal_n_s16(lo, vget_low_s16(a[1]), ct.Matrix[c][1]);
+  lo = vmlal_n_s16(lo, vget_low_s16(a[2]), ct.Matrix[c][2]);
+  int32x4_t hi = vmlal_n_s16(bias, vget_high_s16(a[0]), ct.Matrix[c][0]);
+  hi = vmlal_n_s16(hi, vget_high_s16(a[1]), ct.Matrix[c][1]);
+  hi = vmlal_n_s16(hi, vget_high_s16(a[2]), ct.Matrix[c][2]);
+  return vqmovun_s16(vcombine_s16(vqmovn_s32(vshrq_n_s32(lo, 13)),
+      vqmovn_s32(vshrq_n_s32(hi, 13))));
+}
+
+void ColorTransform8NEON(char *out, const char *in, size_t n,
+  ColorTransform const &ct)
+{
+  const size_t nv = n / 16;
+  for( size_t i = 0; i < nv; ++i, in += 48, out += 48 )
+    {
+    const uint8x16x3_t v = vld3q_u8((const uint8_t*)in);
+    int16x8_t lo[3], hi[3];
+    for( int k = 0; k < 3; ++k )
+      {
+      const int16x8_t off = vdupq_n_s16(ct.Offset[k]);
+      lo[k] = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(v.val[k]))), off);
+      hi[k] = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(v.val[k]))), off);
+      }
+    uint8x16x3_t o;
+    for( int c = 0; c < 3; ++c )
+      {
+      o.val[c] = vcombine_u8(ColorTransformSampleNEON(lo, ct, c),
+        ColorTransformSampleNEON(hi, ct, c));
+      }
+    vst3q_u8((uint8_t*)out, o);
+    }
+  ColorTransform8Scalar(out, in, n - nv * 16, ct);
+}
+
+// 8 pairs (32 bytes) become 48 bytes, see UpsampleYBR422SSSE3 for in place
+void UpsampleYBR422NEON(char *out, const char *in, size_t n)
+{
+  size_t i = 0;
+  for( ; i + 8 <= n; i += 8, in += 32, out += 48 )
+    {
+    const uint8x8x4_t v = vld4_u8((const uint8_t*)in);
+    const uint8x8x2_t y = vzip_u8(v.val[0], v.val[1]);
+    const uint8x8x2_t cb = vzip_u8(v.val[2], v.val[2]);
+    const uint8x8x2_t cr = vzip_u8(v.val[3], v.val[3]);
+    uint8x16x3_t o;
+    o.val[0] = vcombine_u8(y.val[0], y.val[1]);
+    o.val[1] = vcombine_u8(cb.val[0], cb.val[1]);
+    o.val[2] = vcombine_u8(cr.val[0], cr.val[1]);
+    vst3q_u8((uint8_t*)out, o);
+    }
+  UpsampleYBR422Scalar(out, in, n - i);
+}
+
+// 32 bits ARM has no double precision vectors, use the scalar conversion
+const KernelTable NEONKernels = {
+  ByteSwap16NEON,
+  ByteSwap32NEON,
+  PlanarToInterleaved3NEON,
+  InterleavedToPlanar3NEON,
+  ByteSwapAndCleanup16NEON,
+  LinearTransform16NEON,
+  LinearTransform16ToDoubleScalar,
+  ApplyLookupTable8Scalar,
+  Unpack12BitsNEON,
+  Pack12BitsNEON,
+  ColorTransform8NEON,
+  UpsampleYBR422NEON
+};
+
+#endif // GDCM_PIXELKERNELS_NEON
+
+const KernelTable *GetKernelTable(PixelKernels::InstructionSetType is)
+{
+  switch( is )
+    {
+#if defined(GDCM_PIXELKERNELS_X86)
+  case PixelKernels::SSE2:
+    return &SSE2Kernels;
+  case PixelKernels::SSSE3:
+    return &SSSE3Kernels;
+  case PixelKernels::AVX2:
+    return &AVX2Kernels;
+#endif
+#if defined(GDCM_PIXELKERNELS_NEON)
+  case PixelKernels::NEON:
+    return &NEONKernels;
+#endif
+  default:
+    return &ScalarKernels;
+    }
+}
+
+PixelKernels::InstructionSetType GetBestInstructionSet()
+{
+  const PixelKernels::InstructionSetType order[] = {
+    PixelKernels::AVX2,
+    PixelKernels::SSSE3,
+    PixelKernels::SSE2,
+    PixelKernels::NEON
+  };
+  for( size_t i = 0; i < sizeof(order) / sizeof(*order); ++i )
+    {
+    if( PixelKernels::IsInstructionSetSupported( order[i] ) ) return order[i];
+    }
+  return PixelKernels::SCALAR;
+}
+
+// Statically initialized to the scalar kernels, so that they can be used
+// before the dynamic initialization below selected the best ones.
+PixelKernels::InstructionSetType CurrentInstructionSet = PixelKernels::SCALAR;
+const KernelTable *CurrentKernels = &ScalarKernels;
+
+const bool Initialized =
+  PixelKernels::SetInstructionSet( GetBestInstructionSet() );
+
+} // end anonymous namespace
+
+PixelKernels::InstructionSetType PixelKernels::GetInstructionSet()
+{
+  (void)Initialized;
+  return CurrentInstructionSet;
+}
+
+bool PixelKernels::SetInstructionSet(InstructionSetType is)
+{
+  if( !IsInstructionSetSupported( is ) ) return false;
+  CurrentKernels = GetKernelTable( is );
+  CurrentInstructionSet = is;
+  return true;
+}
+
+bool PixelKernels::IsInstructionSetSupported(InstructionSetType is)
+{
+  switch( is )
+    {
+  case SCALAR:
+    return true;
+#if defined(GDCM_PIXELKERNELS_X86)
+  case SSE2:
+  case SSSE3:
+  case AVX2:
+    return CPUSupports( is );
+#endif
+#if defined(GDCM_PIXELKERNELS_NEON)
+  case NEON:
+    return true;
+#endif
+  default:
+    return false;
+    }
+}
+
+const char *PixelKernels::GetInstructionSetString(InstructionSetType is)
+{
+  switch( is )
+    {
+  case SCALAR:
+    return "SCALAR";
+  case SSE2:
+    return "SSE2";
+  case SSSE3:
+    return "SSSE3";
+  case AVX2:
+    return "AVX2";
+  case NEON:
+    return "NEON";
+    }
+  return 0;
+}
+
+void PixelKernels::ByteSwap16(void *buffer, size_t n)
+{
+  CurrentKernels->ByteSwap16(buffer, n);
+}
+
+void PixelKernels::ByteSwap32(void *buffer, size_t n)
+{
+  CurrentKernels->ByteSwap32(buffer, n);
+}
+
+void PixelKernels::PlanarToInterleaved3(char *out,
+  const char *r, const char *g, const char *b, size_t n)
+{
+  CurrentKernels->PlanarToInterleaved3(out, r, g, b, n);
+}
+
+void PixelKernels::InterleavedToPlanar3(char *r, char *g, char *b,
+  const char *in, size_t n)
+{
+  CurrentKernels->InterleavedToPlanar3(r, g, b, in, n);
+}
+
+void PixelKernels::ByteSwapAndCleanup16(void *buffer, size_t n, bool byteswap,
+  unsigned short bitsstored, unsigned short highbit, bool sign)
+{
+  CleanupParameters p;
+  p.ByteSwap = byteswap;
+  p.Cleanup = bitsstored < 16;
+  p.Sign = sign;
+  p.Shift = 0;
+  p.PMask = 0xffff;
+  p.SMask = 0;
+  p.NMask = 0;
+  if( p.Cleanup )
+    {
+    // Same masks as ImageCodec always computed, the shift may wrap around
+    // when HighBit >= BitsStored:
+    const unsigned short shift = (unsigned short)(bitsstored - highbit - 1);
+    p.Shift = shift < 16 ? shift : (unsigned short)16;
+    p.PMask = (uint16_t)(0xffff >> ( 16 - bitsstored ));
+    p.SMask = (uint16_t)(0x0001 << ( 16 - (16 - bitsstored + 1) ));
+    int16_t nmask = (int16_t)0x8000;
+    nmask = (int16_t)(nmask >> ( 16 - bitsstored - 1 ));
+    p.NMask = (uint16_t)nmask;
+    }
+  if( !p.ByteSwap && !p.Cleanup ) return;
+  CurrentKernels->ByteSwapAndCleanup16(buffer, n, p);
+}
+
+void PixelKernels::LinearTransform16(void *out, const void *in, size_t n,
+  int slope, int intercept)
+{
+  CurrentKernels->LinearTransform16(out, in, n,
+    (uint16_t)(unsigned int)slope, (uint16_t)(unsigned int)intercept);
+}
+
+void PixelKernels::LinearTransform16ToDouble(double *out, const void *in,
+  size_t n, bool sign, double slope, double intercept)
+{
+  CurrentKernels->LinearTransform16ToDouble(out, in, n, sign, slope, intercept);
+}
+
+void PixelKernels::ApplyLookupTable8(char *out, const char *in, size_t n,
+  const unsigned char *rgbx)
+{
+  CurrentKernels->ApplyLookupTable8(out, in, n, rgbx);
+}
+
+void PixelKernels::Unpack12Bits(char *out, const char *in, size_t n)
+{
+  CurrentKernels->Unpack12Bits(out, in, n);
+}
+
+void PixelKernels::Pack12Bits(char *out, const char *in, size_t n)
+{
+  CurrentKernels->Pack12Bits(out, in, n);
+}
+
+void PixelKernels::YBRToRGB8(char *out, const char *in, size_t n, bool partial)
+{
+  CurrentKernels->ColorTransform8(out, in, n,
+    partial ? YBRPartialToRGB : YBRFullToRGB);
+}
+
+void PixelKernels::RGBToYBR8(char *out, const char *in, size_t n, bool partial)
+{
+  CurrentKernels->ColorTransform8(out, in, n,
+    partial ? RGBToYBRPartial : RGBToYBRFull);
+}
+
+void PixelKernels::UpsampleYBR422(char *out, const char *in, size_t n)
+{
+  CurrentKernels->UpsampleYBR422(out, in, n);
+}
+
+} // end namespace gdcm
@@ -0,0 +1,126 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#ifndef GDCMPIXELKERNELS_H
+#define GDCMPIXELKERNELS_H
+
+#include "gdcmTypes.h"
+
+namespace gdcm
+{
+/**
+ * \brief Vectorized kernels for the pixel post-processing steps
+ *
+ * \details Byte swapping of 16/32 bits words, RGB planar configuration
+ * shuffles, the cleanup of the unused bits of 16 bits pixels, the linear
+ * transform of 16 bits pixels (Rescale Slope/Intercept), the 8 bits
+ * PALETTE COLOR lookup, the packing of 12 bits pixels and the 8 bits YBR
+ * color space conversions. The
+ * implementation is selected at runtime from the instruction sets the
+ * processor supports (SSE2, SSSE3, AVX2 on x86, NEON on ARM), with a scalar
+ * fallback. All the implementations produce the exact same output.
+ *
+ * Buffers do not need to be aligned.
+ *
+ * \see ImageCodec SwapperDoOp Rescaler LookupTable Unpacker12Bits
+ */
+class GDCM_EXPORT PixelKernels
+{
+public:
+  typedef enum {
+    SCALAR = 0,
+    SSE2,
+    SSSE3,
+    AVX2,
+    NEON
+  } InstructionSetType;
+
+  /// Return the instruction set currently used by the kernels
+  static InstructionSetType GetInstructionSet();
+
+  /// Force the instruction set used by the kernels (mostly useful for testing
+  /// and benchmarking). Return false if the processor does not support it.
+  /// \warning this is not thread safe, do not call while kernels are running
+  static bool SetInstructionSet(InstructionSetType is);
+
+  /// Return whether the processor (and this build) supports instruction set is
+  static bool IsInstructionSetSupported(InstructionSetType is);
+
+  static const char *GetInstructionSetString(InstructionSetType is);
+
+  /// Swap the bytes of n 16 bits words
+  static void ByteSwap16(void *buffer, size_t n);
+
+  /// Swap the bytes of n 32 bits words
+  static void ByteSwap32(void *buffer, size_t n);
+
+  /// Interleave n 8 bits RGB pixels stored as three planes (R,R..,G,G..,B,B..)
+  /// into out (R,G,B,R,G,B...). out must not overlap the planes.
+  static void PlanarToInterleaved3(char *out,
+    const char *r, const char *g, const char *b, size_t n);
+
+  /// Split n 8 bits RGB pixels (R,G,B,R,G,B...) into three planes. The planes
+  /// must not overlap in.
+  static void InterleavedToPlanar3(char *r, char *g, char *b,
+    const char *in, size_t n);
+
+  /// Process in place n 16 bits pixels: optionally swap their bytes, then when
+  /// bitsstored is less than 16 shift them right by (bitsstored - highbit - 1)
+  /// and clear the unused bits (or propagate the sign bit into them when
+  /// pixels are signed).
+  static void ByteSwapAndCleanup16(void *buffer, size_t n, bool byteswap,
+    unsigned short bitsstored, unsigned short highbit, bool sign);
+
+  /// Compute out = slope * in + intercept for n 16 bits integers, modulo 2^16.
+  /// The result is exact as long as it fits the (signed or unsigned) 16 bits
+  /// output type, whatever the signedness of in.
+  static void LinearTransform16(void *out, const void *in, size_t n,
+    int slope, int intercept);
+
+  /// Compute out = slope * in + intercept in double precision for n 16 bits
+  /// integers (signed when sign is true)
+  static void LinearTransform16ToDouble(double *out, const void *in, size_t n,
+    bool sign, double slope, double intercept);
+
+  /// Convert n 8 bits indexes into RGB pixels (3 bytes each in out). rgbx is
+  /// the lookup table with each of the 256 entries stored as R,G,B,(unused).
+  static void ApplyLookupTable8(char *out, const char *in, size_t n,
+    const unsigned char *rgbx);
+
+  /// Unpack n pairs of 12 bits pixels (3 bytes each) into 2n 16 bits words.
+  /// The unpacking can be done in place with the packed bytes at the end of
+  /// the output buffer (in == out + n), otherwise out must not overlap in.
+  static void Unpack12Bits(char *out, const char *in, size_t n);
+
+  /// Pack n pairs of 16 bits words holding 12 bits values into 3n bytes. out
+  /// may be in, otherwise it must not overlap in.
+  static void Pack12Bits(char *out, const char *in, size_t n);
+
+  /// Convert n 8 bits YBR pixels (Y,CB,CR interleaved) into RGB, in fixed
+  /// point arithmetic. partial selects the YBR_PARTIAL ranges (Y in [16,235])
+  /// instead of YBR_FULL. out may be in, otherwise it must not overlap in.
+  static void YBRToRGB8(char *out, const char *in, size_t n, bool partial);
+
+  /// Convert n 8 bits RGB pixels into YBR_FULL (or YBR_PARTIAL), see YBRToRGB8
+  static void RGBToYBR8(char *out, const char *in, size_t n, bool partial);
+
+  /// Upsample n pairs of 4:2:2 pixels (Y1,Y2,CB,CR) into 2n YBR pixels
+  /// (Y1,CB,CR,Y2,CB,CR). The upsampling can be done in place with the
+  /// subsampled bytes at the end of the output buffer (in == out + 2n),
+  /// otherwise out must not overlap in.
+  static void UpsampleYBR422(char *out, const char *in, size_t n);
+};
+
+} // end namespace gdcm
+
+#endif //GDCMPIXELKERNELS_H
@@ -28,6 +28,10 @@ namespace gdcm
  *   shared_ptr<Bla> b(new Bla);
  * }
  * \note
+ * Copying and releasing SmartPointer is thread safe (see Object), but a
+ * single SmartPointer instance must not be modified from one thread while
+ * being read from another.
+ * \note
  * Class partly based on post by Bill Hubauer:
  * http://groups.google.com/group/comp.lang.c++/msg/173ddc38a827a930
  * \see
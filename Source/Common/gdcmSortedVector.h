@@ -0,0 +1,129 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#ifndef GDCMSORTEDVECTOR_H
+#define GDCMSORTEDVECTOR_H
+
+#include "gdcmTypes.h"
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+namespace gdcm
+{
+/**
+ * \brief Sorted std::vector with a std::set like interface
+ *
+ * \details Elements are stored contiguously and kept sorted, lookup is a
+ * binary search. Insertion of an element greater than all the others is an
+ * append, which is the common case when parsing a DICOM file (elements are
+ * stored in ascending tag order).
+ *
+ * \warning Contrary to std::set, inserting or erasing an element invalidates
+ * all iterators. Only the subset of the std::set interface used by GDCM is
+ * implemented.
+ *
+ * \see DataSet
+ */
+template <typename T, typename TCompare = std::less<T> >
+class SortedVector
+{
+  typedef std::vector<T> VectorType;
+public:
+  typedef T key_type;
+  typedef T value_type;
+  typedef TCompare key_compare;
+  typedef TCompare value_compare;
+  typedef typename VectorType::size_type size_type;
+  typedef typename VectorType::difference_type difference_type;
+  typedef typename VectorType::const_reference reference;
+  typedef typename VectorType::const_reference const_reference;
+  // Same as std::set, elements cannot be modified through an iterator:
+  typedef typename VectorType::const_iterator iterator;
+  typedef typename VectorType::const_iterator const_iterator;
+  typedef typename VectorType::const_reverse_iterator reverse_iterator;
+  typedef typename VectorType::const_reverse_iterator const_reverse_iterator;
+
+  SortedVector() {}
+
+  const_iterator begin() const { return Internal.begin(); }
+  const_iterator end() const { return Internal.end(); }
+  const_reverse_iterator rbegin() const { return Internal.rbegin(); }
+  const_reverse_iterator rend() const { return Internal.rend(); }
+
+  bool empty() const { return Internal.empty(); }
+  size_type size() const { return Internal.size(); }
+  void clear() { Internal.clear(); }
+  void swap(SortedVector &other) { Internal.swap(other.Internal); }
+  void reserve(size_type n) { Internal.reserve(n); }
+
+  std::pair<iterator,bool> insert(const value_type &v) {
+    // Fast path: append
+    if( Internal.empty() || Compare(Internal.back(), v) )
+      {
+      Internal.push_back(v);
+      return std::make_pair(iterator(Internal.end() - 1), true);
+      }
+    typename VectorType::iterator it =
+      std::lower_bound(Internal.begin(), Internal.end(), v, Compare);
+    if( it != Internal.end() && !Compare(v, *it) )
+      return std::make_pair(iterator(it), false);
+    it = Internal.insert(it, v);
+    return std::make_pair(iterator(it), true);
+  }
+
+  iterator erase(const_iterator pos) {
+    typename VectorType::iterator it = Internal.begin() + (pos - begin());
+    return Internal.erase(it);
+  }
+  iterator erase(const_iterator first, const_iterator last) {
+    typename VectorType::iterator it1 = Internal.begin() + (first - begin());
+    typename VectorType::iterator it2 = Internal.begin() + (last - begin());
+    return Internal.erase(it1, it2);
+  }
+  size_type erase(const key_type &k) {
+    const_iterator it = find(k);
+    if( it == end() ) return 0;
+    erase(it);
+    return 1;
+  }
+
+  const_iterator find(const key_type &k) const {
+    const_iterator it = lower_bound(k);
+    if( it != end() && !Compare(k, *it) ) return it;
+    return end();
+  }
+  size_type count(const key_type &k) const {
+    return find(k) != end() ? 1 : 0;
+  }
+  const_iterator lower_bound(const key_type &k) const {
+    return std::lower_bound(Internal.begin(), Internal.end(), k, Compare);
+  }
+  const_iterator upper_bound(const key_type &k) const {
+    return std::upper_bound(Internal.begin(), Internal.end(), k, Compare);
+  }
+
+  bool operator==(const SortedVector &other) const {
+    return Internal == other.Internal;
+  }
+
+private:
+  VectorType Internal;
+  TCompare Compare;
+};
+
+} // end namespace gdcm
+
+#endif //GDCMSORTEDVECTOR_H
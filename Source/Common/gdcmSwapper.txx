@@ -75,6 +75,7 @@
 #endif
 
 #include "gdcmTag.h"
+#include "gdcmPixelKernels.h"
 
 
 namespace gdcm
@@ -122,6 +123,39 @@ namespace gdcm
 
   template <> inline void SwapperNoOp::SwapArray(uint8_t *, unsigned int ) {}
 
+  // Large arrays (Pixel Data, LUT...) go through the vectorized kernels
+  template <> inline void SwapperNoOp::SwapArray(uint16_t *array, unsigned int n)
+    {
+    if( n < 16 )
+      {
+      for(unsigned int i = 0; i < n; ++i) array[i] = bswap_16(array[i]);
+      }
+    else
+      {
+      PixelKernels::ByteSwap16(array, n);
+      }
+    }
+  template <> inline void SwapperNoOp::SwapArray(int16_t *array, unsigned int n)
+    {
+    SwapperNoOp::SwapArray<uint16_t>((uint16_t*)array,n);
+    }
+
+  template <> inline void SwapperNoOp::SwapArray(uint32_t *array, unsigned int n)
+    {
+    if( n < 16 )
+      {
+      for(unsigned int i = 0; i < n; ++i) array[i] = bswap_32(array[i]);
+      }
+    else
+      {
+      PixelKernels::ByteSwap32(array, n);
+      }
+    }
+  template <> inline void SwapperNoOp::SwapArray(int32_t *array, unsigned int n)
+    {
+    SwapperNoOp::SwapArray<uint32_t>((uint32_t*)array,n);
+    }
+
   template <> inline void SwapperNoOp::SwapArray(float *array, unsigned int n)
     {
     switch( sizeof(float) )
@@ -188,6 +222,39 @@ namespace gdcm
 
   template <> inline void SwapperDoOp::SwapArray(uint8_t *, size_t ) {}
 
+  // Large arrays (Pixel Data, LUT...) go through the vectorized kernels
+  template <> inline void SwapperDoOp::SwapArray(uint16_t *array, size_t n)
+    {
+    if( n < 16 )
+      {
+      for(size_t i = 0; i < n; ++i) array[i] = bswap_16(array[i]);
+      }
+    else
+      {
+      PixelKernels::ByteSwap16(array, n);
+      }
+    }
+  template <> inline void SwapperDoOp::SwapArray(int16_t *array, size_t n)
+    {
+    SwapperDoOp::SwapArray<uint16_t>((uint16_t*)array,n);
+    }
+
+  template <> inline void SwapperDoOp::SwapArray(uint32_t *array, size_t n)
+    {
+    if( n < 16 )
+      {
+      for(size_t i = 0; i < n; ++i) array[i] = bswap_32(array[i]);
+      }
+    else
+      {
+      PixelKernels::ByteSwap32(array, n);
+      }
+    }
+  template <> inline void SwapperDoOp::SwapArray(int32_t *array, size_t n)
+    {
+    SwapperDoOp::SwapArray<uint32_t>((uint32_t*)array,n);
+    }
+
   template <> inline void SwapperDoOp::SwapArray(float *array, size_t n)
     {
     switch( sizeof(float) )
@@ -28,19 +28,20 @@ namespace gdcm
  * private vendor, one would need to unpack 12bits Stored Pixel Value into a
  * more standard 16bits Stored Pixel Value.
  *
- * \see Rescaler
+ * \see Rescaler PixelKernels
  */
 class GDCM_EXPORT Unpacker12Bits
 {
 public:
   /// Pack an array of 16bits where all values are 12bits into a pack form. n
   /// is the length in bytes of array in, out will be a fake 8bits array of size
-  /// (n / 2) * 3
+  /// (n / 4) * 3. out can be in (packing in place).
   static bool Pack(char *out, const char *in, size_t n);
 
   /// Unpack an array of 'packed' 12bits data into a more conventional 16bits
   /// array. n is the length in bytes of array in, out will be a 16bits array of
-  /// size (n / 3) * 2
+  /// size (n / 3) * 2. To unpack in place, store the packed data at the end of
+  /// the output array: in == out + n / 3.
   static bool Unpack(char *out, const char *in, size_t n);
 };
 
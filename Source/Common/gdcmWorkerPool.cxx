@@ -0,0 +1,234 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmWorkerPool.h"
+#include "gdcmTrace.h"
+
+#include <vector>
+#include <exception>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#if defined(GDCM_HAVE_PTHREAD_H)
+#include <pthread.h>
+#endif
+#include <unistd.h> // sysconf
+#endif
+
+namespace gdcm
+{
+
+static void ExecuteJob(WorkerPool::Job &job, unsigned int index,
+  unsigned int worker)
+{
+  try
+    {
+    job.ExecuteOnWorker(index, worker);
+    }
+  catch(std::exception &ex)
+    {
+    (void)ex;
+    gdcmWarningMacro( "Job " << index << " failed: " << ex.what() );
+    }
+  catch(...)
+    {
+    gdcmWarningMacro( "Job " << index << " failed with unknown error" );
+    }
+}
+
+#if defined(_WIN32) || defined(GDCM_HAVE_PTHREAD_H)
+/*
+ * State shared by the workers and the calling thread. Workers pick the next
+ * index under the lock, the calling thread waits for Done[i] in order.
+ */
+class WorkerPoolInternals
+{
+public:
+  WorkerPoolInternals(WorkerPool::Job &job, unsigned int n):
+    J(job),N(n),Next(0),NextWorker(0),Done(n, 0)
+    {
+#if defined(_WIN32)
+    InitializeCriticalSection(&Lock);
+    DoneEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+#else
+    pthread_mutex_init(&Lock, NULL);
+    pthread_cond_init(&DoneCond, NULL);
+#endif
+    }
+  ~WorkerPoolInternals()
+    {
+#if defined(_WIN32)
+    CloseHandle(DoneEvent);
+    DeleteCriticalSection(&Lock);
+#else
+    pthread_cond_destroy(&DoneCond);
+    pthread_mutex_destroy(&Lock);
+#endif
+    }
+
+  void Acquire()
+    {
+#if defined(_WIN32)
+    EnterCriticalSection(&Lock);
+#else
+    pthread_mutex_lock(&Lock);
+#endif
+    }
+  void Release()
+    {
+#if defined(_WIN32)
+    LeaveCriticalSection(&Lock);
+#else
+    pthread_mutex_unlock(&Lock);
+#endif
+    }
+
+  void Work()
+    {
+    Acquire();
+    const unsigned int worker = NextWorker++;
+    Release();
+    for(;;)
+      {
+      Acquire();
+      const unsigned int index = Next < N ? Next++ : N;
+      Release();
+      if( index == N ) break;
+      ExecuteJob(J, index, worker);
+      Acquire();
+      Done[index] = 1;
+#if defined(_WIN32)
+      SetEvent(DoneEvent);
+#else
+      pthread_cond_signal(&DoneCond);
+#endif
+      Release();
+      }
+    }
+
+  void WaitFor(unsigned int index)
+    {
+    Acquire();
+    while( !Done[index] )
+      {
+#if defined(_WIN32)
+      Release();
+      WaitForSingleObject(DoneEvent, INFINITE);
+      Acquire();
+#else
+      pthread_cond_wait(&DoneCond, &Lock);
+#endif
+      }
+    Release();
+    }
+
+  WorkerPool::Job &J;
+  const unsigned int N;
+  unsigned int Next;
+  unsigned int NextWorker;
+  std::vector<char> Done;
+#if defined(_WIN32)
+  CRITICAL_SECTION Lock;
+  HANDLE DoneEvent;
+#else
+  pthread_mutex_t Lock;
+  pthread_cond_t DoneCond;
+#endif
+
+private:
+  WorkerPoolInternals(const WorkerPoolInternals&); // Not implemented
+  void operator=(const WorkerPoolInternals&); // Not implemented
+};
+
+#if defined(_WIN32)
+static DWORD WINAPI WorkerMain(LPVOID arg)
+#else
+static void *WorkerMain(void *arg)
+#endif
+{
+  static_cast<WorkerPoolInternals*>(arg)->Work();
+  return 0;
+}
+#endif
+
+unsigned int WorkerPool::GetNumberOfThreads() const
+{
+  return NumberOfThreads ? NumberOfThreads : GetNumberOfProcessors();
+}
+
+void WorkerPool::Run(Job &job, unsigned int n)
+{
+  unsigned int nthreads = GetNumberOfThreads();
+  if( nthreads > n ) nthreads = n;
+#if defined(_WIN32) || defined(GDCM_HAVE_PTHREAD_H)
+  if( nthreads > 1 )
+    {
+    WorkerPoolInternals internals(job, n);
+    unsigned int nstarted = 0;
+#if defined(_WIN32)
+    std::vector<HANDLE> threads(nthreads);
+    for( ; nstarted < nthreads; ++nstarted )
+      {
+      threads[nstarted] = CreateThread(NULL, 0, WorkerMain, &internals, 0, NULL);
+      if( !threads[nstarted] ) break;
+      }
+#else
+    std::vector<pthread_t> threads(nthreads);
+    for( ; nstarted < nthreads; ++nstarted )
+      {
+      if( pthread_create(&threads[nstarted], NULL, WorkerMain, &internals) ) break;
+      }
+#endif
+    if( nstarted )
+      {
+      for( unsigned int i = 0; i < n; ++i )
+        {
+        internals.WaitFor(i);
+        job.Finish(i);
+        }
+      for( unsigned int t = 0; t < nstarted; ++t )
+        {
+#if defined(_WIN32)
+        WaitForSingleObject(threads[t], INFINITE);
+        CloseHandle(threads[t]);
+#else
+        pthread_join(threads[t], NULL);
+#endif
+        }
+      return;
+      }
+    gdcmWarningMacro( "Could not start worker threads" );
+    }
+#endif
+  for( unsigned int i = 0; i < n; ++i )
+    {
+    ExecuteJob(job, i, 0);
+    job.Finish(i);
+    }
+}
+
+unsigned int WorkerPool::GetNumberOfProcessors()
+{
+  long n = 1;
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  n = (long)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+  n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  return n > 0 ? (unsigned int)n : 1;
+}
+
+} // end namespace gdcm
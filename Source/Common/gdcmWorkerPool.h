@@ -0,0 +1,80 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#ifndef GDCMWORKERPOOL_H
+#define GDCMWORKERPOOL_H
+
+#include "gdcmTypes.h"
+
+namespace gdcm
+{
+/**
+ * \brief Run independent jobs on a set of worker threads
+ *
+ * \details Run(job, n) calls job.Execute(i) for every i in [0, n) from
+ * GetNumberOfThreads() worker threads, and calls job.Finish(i) from the
+ * calling thread, in increasing order of i, as soon as Execute(i) and all
+ * the previous ones are done. Execute is where the work happens (it must
+ * only touch data private to index i), Finish is where results are merged
+ * in a deterministic order.
+ *
+ * With a single thread (or when GDCM is built without thread support), Run
+ * simply alternates Execute(i) and Finish(i) in the calling thread.
+ *
+ * Jobs holding a per-thread resource (eg. a network association) can
+ * override ExecuteOnWorker instead, which is also given the number of the
+ * worker thread it runs on.
+ *
+ * \note Threads only live for the duration of Run.
+ */
+class GDCM_EXPORT WorkerPool
+{
+public:
+  /// Work to be split among the workers
+  class GDCM_EXPORT Job
+  {
+  public:
+    virtual ~Job() {}
+    /// Called from a worker thread, concurrently for different indexes
+    virtual void Execute(unsigned int index) = 0;
+    /// Called from worker number worker, in [0, GetNumberOfThreads()). Two
+    /// calls with the same worker never run concurrently. Default is to call
+    /// Execute(index).
+    virtual void ExecuteOnWorker(unsigned int index, unsigned int worker)
+      { (void)worker; Execute(index); }
+    /// Called from the thread calling Run, in increasing index order.
+    /// Must not throw.
+    virtual void Finish(unsigned int index) { (void)index; }
+  };
+
+  WorkerPool():NumberOfThreads(1) {}
+
+  /// Number of worker threads. 0 means GetNumberOfProcessors()
+  void SetNumberOfThreads(unsigned int n) { NumberOfThreads = n; }
+  unsigned int GetNumberOfThreads() const;
+
+  /// Run the job on indexes [0, n). Returns when all Finish calls are done.
+  /// Exceptions thrown by Execute are reported as warnings and otherwise
+  /// ignored.
+  void Run(Job &job, unsigned int n);
+
+  /// Return the number of processors available (at least 1)
+  static unsigned int GetNumberOfProcessors();
+
+private:
+  unsigned int NumberOfThreads;
+};
+
+} // end namespace gdcm
+
+#endif //GDCMWORKERPOOL_H
@@ -138,8 +138,8 @@ bool ByteSwapFilter::ByteSwap()
       de.SetTag(
         Tag( SwapperDoOp::Swap( tag.GetGroup() ), SwapperDoOp::Swap( tag.GetElement() ) ) );
       copy.Insert( de );
-      DS.Remove( de.GetTag() );
       }
+    // DS is not modified while traversed: it is replaced as a whole
     DS = copy;
     }
 
@@ -32,6 +32,8 @@ namespace gdcm_ns
 #else
     assert( !l.IsUndefined() && !l.IsOdd() );
 #endif
+    // Modifying a value referencing a memory mapped file: copy it first
+    Materialize();
     // I cannot use reserve for now. I need to implement:
     // STL - vector<> and istream
     // http://groups.google.com/group/comp.lang.c++/msg/37ec052ed8283e74
@@ -52,12 +54,25 @@ namespace gdcm_ns
     // Keep the exact length
     Length = vl;
   }
+  void ByteValue::Load() {
+    assert( Loader && !View && !Length.IsOdd() );
+    SmartPointer<LazyValueLoader> loader = Loader;
+    Loader = 0;
+    Internal.resize( Length );
+    if( Length && !loader->Load( LoaderOffset, &Internal[0], Length ) )
+      {
+      // Keep the value zero-filled, as for a truncated file
+      gdcmErrorMacro( "Could not load value from: " << loader->GetFileName() );
+      std::fill( Internal.begin(), Internal.end(), (char)0 );
+      }
+  }
   void ByteValue::PrintASCII(std::ostream &os, VL maxlength ) const {
     VL length = std::min(maxlength, Length);
     // Special case for VR::UI, do not print the trailing \0
+    const char *p = GetPointer();
     if( length && length == Length )
       {
-      if( Internal[length-1] == 0 )
+      if( p[length-1] == 0 )
         {
         length = length - 1;
         }
@@ -65,8 +80,8 @@ namespace gdcm_ns
     // I cannot check IsPrintable some file contains \2 or \0 in a VR::LO element
     // See: acr_image_with_non_printable_in_0051_1010.acr
     //assert( IsPrintable(length) );
-    std::vector<char>::const_iterator it = Internal.begin();
-    for(; it != Internal.begin()+length; ++it)
+    const char *it = p;
+    for(; it != p+length; ++it)
       {
       const char &c = *it;
       if ( !( isprint((unsigned char)c) || isspace((unsigned char)c) ) ) os << ".";
@@ -76,13 +91,14 @@ namespace gdcm_ns
   void ByteValue::PrintHex(std::ostream &os, VL maxlength ) const {
     VL length = std::min(maxlength, Length);
     // WARNING: Internal.end() != Internal.begin()+Length
-    std::vector<char>::const_iterator it = Internal.begin();
+    const char *p = GetPointer();
+    const char *it = p;
     os << std::hex;
-    for(; it != Internal.begin()+length; ++it)
+    for(; it != p+length; ++it)
       {
       //const char &c = *it;
       uint8_t v = *it;
-      if( it != Internal.begin() ) os << "\\";
+      if( it != p ) os << "\\";
       os << std::setw( 2 ) << std::setfill( '0' ) << (uint16_t)v;
       //++it;
       //os << std::setw( 1 ) << std::setfill( '0' ) << (int)*it;
@@ -93,9 +109,9 @@ namespace gdcm_ns
   bool ByteValue::GetBuffer(char *buffer, unsigned long length) const {
     // SIEMENS_GBS_III-16-ACR_NEMA_1.acr has a weird pixel length
     // so we need an inequality
-    if( length <= Internal.size() )
+    if( length <= GetStorageSize() )
       {
-      memcpy(buffer, &Internal[0], length);
+      memcpy(buffer, GetPointer(), length);
       return true;
       }
     gdcmDebugMacro( "Could not handle length= " << length );
@@ -123,8 +139,8 @@ namespace gdcm_ns
     count1=count2=1;
     os << "<PersonName number = \"" << count1 << "\" >\n" ;
     os << "<SingleByte>\n<FamilyName> " ;
-    std::vector<char>::const_iterator it = Internal.begin();
-    for(; it != (Internal.begin() + Length); ++it)
+    const char *it = GetPointer();
+    for(; it != (GetPointer() + Length); ++it)
       {
       const char &c = *it;
       if ( c == '^' )
@@ -269,9 +285,9 @@ namespace gdcm_ns
 
     int count = 1;
     os << "<Value number = \"" << count << "\" >";
-    std::vector<char>::const_iterator it = Internal.begin();
+    const char *it = GetPointer();
 
-    for(; it != (Internal.begin() + Length); ++it)
+    for(; it != (GetPointer() + Length); ++it)
       {
       const char &c = *it;
       if ( c == '\\' )
@@ -305,13 +321,14 @@ namespace gdcm_ns
     //VL length = std::min(maxlength, Length);
     // WARNING: Internal.end() != Internal.begin()+Length
 
-    std::vector<char>::const_iterator it = Internal.begin();
+    const char *p = GetPointer();
+    const char *it = p;
     os << std::hex;
-    for(; it != Internal.begin() + Length; ++it)
+    for(; it != p + Length; ++it)
       {
       //const char &c = *it;
       uint8_t v = *it;
-      if( it != Internal.begin() ) os << "\\";
+      if( it != p ) os << "\\";
       os << std::setw( 2 ) << std::setfill( '0' ) << (uint16_t)v;
       //++it;
       //os << std::setw( 1 ) << std::setfill( '0' ) << (int)*it;
@@ -322,7 +339,8 @@ namespace gdcm_ns
   void ByteValue::Append(ByteValue const & bv)
     {
     //Internal.resize( Length + bv.Length );
-    Internal.insert( Internal.end(), bv.Internal.begin(), bv.Internal.end());
+    Materialize();
+    Internal.insert( Internal.end(), bv.GetPointer(), bv.GetPointer() + bv.GetStorageSize());
     Length += bv.Length;
     // post condition
     assert( Internal.size() % 2 == 0 && Internal.size() == Length );
@@ -17,11 +17,15 @@
 #include "gdcmValue.h"
 #include "gdcmTrace.h"
 #include "gdcmVL.h"
+#include "gdcmSmartPointer.h"
+#include "gdcmMemoryMappedFile.h"
+#include "gdcmLazyValueLoader.h"
 
 #include <vector>
 #include <iterator>
 #include <iomanip>
 #include <algorithm>
+#include <cstring> // memcmp
 
 namespace gdcm_ns
 {
@@ -31,12 +35,21 @@ using namespace gdcm;
 /**
  * \brief Class to represent binary value (array of bytes)
  * \note
+ * When read from a MemoryMappedFile (see Reader::SetMemoryMappedFile) a
+ * ByteValue does not own its bytes: it points directly into the file image
+ * and keeps a reference on the mapping. Values requiring a byte swap are
+ * still copied, and any modification (SetLength, Append, Fill...) first
+ * copies the bytes into private storage.
+ *
+ * When read lazily (see Reader::SetLazyLoadingThreshold) a ByteValue only
+ * records the position of its bytes in the file, they are loaded on first
+ * access (GetPointer, Write, ...). GetLength does not load the value.
  */
 class GDCM_EXPORT ByteValue : public Value
 {
 public:
   ByteValue(const char* array = 0, VL const &vl = 0):
-    Internal(array, array+vl),Length(vl) {
+    Internal(array, array+vl),Length(vl),View(0),LoaderOffset(0) {
       if( vl.IsOdd() )
         {
         gdcmDebugMacro( "Odd length" );
@@ -46,7 +59,7 @@ public:
   }
 
   /// \warning casting to uint32_t
-  ByteValue(std::vector<char> &v):Internal(v),Length((uint32_t)v.size()) {}
+  ByteValue(std::vector<char> &v):Internal(v),Length((uint32_t)v.size()),View(0),LoaderOffset(0) {}
   //ByteValue(std::ostringstream const &os) {
   //  (void)os;
   //   assert(0); // TODO
@@ -81,39 +94,61 @@ public:
   // Does a reallocation
   void SetLength(VL vl);
 
-  operator const std::vector<char>& () const { return Internal; }
+  /// \warning for a value referencing a memory mapped file, this copies the
+  /// bytes into private storage
+  operator const std::vector<char>& () const {
+    if( View || Loader ) const_cast<ByteValue*>(this)->Materialize();
+    return Internal;
+  }
 
   ByteValue &operator=(const ByteValue &val) {
     Internal = val.Internal;
     Length = val.Length;
+    View = val.View;
+    ViewOwner = val.ViewOwner;
+    Loader = val.Loader;
+    LoaderOffset = val.LoaderOffset;
     return *this;
     }
 
   bool operator==(const ByteValue &val) const {
     if( Length != val.Length )
       return false;
-    if( Internal == val.Internal )
-      return true;
-    return false;
+    const size_t size = GetStorageSize();
+    if( size != val.GetStorageSize() )
+      return false;
+    return size == 0 || memcmp(GetPointer(), val.GetPointer(), size) == 0;
     }
   bool operator==(const Value &val) const
     {
     const ByteValue &bv = dynamic_cast<const ByteValue&>(val);
-    return Length == bv.Length && Internal == bv.Internal;
+    return *this == bv;
     }
 
   void Append(ByteValue const & bv);
 
   void Clear() {
     Internal.clear();
+    View = 0;
+    ViewOwner = 0;
+    Loader = 0;
   }
   // Use that only if you understand what you are doing
   const char *GetPointer() const {
+    if(Loader) const_cast<ByteValue*>(this)->Load();
+    if(View) return View;
     if(!Internal.empty()) return &Internal[0];
     return 0;
   }
+  /// Return whether the bytes are referenced from a memory mapped file
+  /// instead of being owned by this ByteValue
+  bool IsMemoryMapped() const { return View != 0; }
+  /// Return false while the bytes of a lazily read value have not been
+  /// loaded from the file yet
+  bool IsLoaded() const { return Loader.GetPointer() == 0; }
   void Fill(char c) {
     //if( Internal.empty() ) return;
+    Materialize();
     std::vector<char>::iterator it = Internal.begin();
     for(; it != Internal.end(); ++it) *it = c;
   }
@@ -121,8 +156,16 @@ public:
   bool WriteBuffer(std::ostream &os) const {
     if( Length ) {
       //assert( Internal.size() <= Length );
-      assert( !(Internal.size() % 2) );
-      os.write(&Internal[0], Internal.size() );
+      assert( !(GetStorageSize() % 2) );
+      if( Loader )
+        {
+        // Do not keep the bytes of a lazily read value around
+        std::vector<char> copy;
+        if( !LoadCopy(copy) ) return false;
+        os.write(&copy[0], copy.size());
+        }
+      else
+        os.write(GetPointer(), GetStorageSize() );
       }
     return true;
   }
@@ -137,6 +180,40 @@ public:
       {
       if( readvalues )
         {
+        // Memory mapped file: simply reference the file image whenever the
+        // bytes can be used as-is
+        MemoryMappedFile *mmf;
+        if( !Length.IsOdd() && IsIdentitySwap<TSwap,TType>()
+          && (mmf = MemoryMappedFile::GetMemoryMappedFile(is)) != 0 )
+          {
+          const char *p = mmf->GetCurrentPointer(is);
+          if( (size_t)(mmf->GetPointer() + mmf->GetSize() - p) >= Length )
+            {
+            std::vector<char>().swap( Internal );
+            View = p;
+            ViewOwner = mmf;
+            is.seekg(Length, std::ios::cur);
+            return is;
+            }
+          }
+        // Lazy loading: only record where the bytes are
+        LazyValueLoader *loader;
+        if( !Length.IsOdd() && IsIdentitySwap<TSwap,TType>()
+          && (loader = LazyValueLoader::GetLazyValueLoader(is)) != 0 )
+          {
+          const std::streamoff offset = is.tellg();
+          if( loader->CanLoad(offset, Length) )
+            {
+            std::vector<char>().swap( Internal );
+            Loader = loader;
+            LoaderOffset = offset;
+            is.seekg(Length, std::ios::cur);
+            return is;
+            }
+          }
+        // Storage is not allocated when reading from a memory mapped file or
+        // lazily (see DataElement::SetValueFieldLength)
+        if( Internal.size() < Length ) SetLength( Length );
         is.read(&Internal[0], Length);
         assert( Internal.size() == Length || Internal.size() == Length + 1 );
         TSwap::SwapArray((TType*)&Internal[0], Internal.size() / sizeof(TType) );
@@ -157,12 +234,31 @@ public:
 
   template <typename TSwap, typename TType>
   std::ostream const &Write(std::ostream &os) const {
-    assert( !(Internal.size() % 2) );
-    if( !Internal.empty() ) {
-      //os.write(&Internal[0], Internal.size());
-      std::vector<char> copy = Internal;
-      TSwap::SwapArray((TType*)&copy[0], Internal.size() / sizeof(TType) );
-      os.write(&copy[0], copy.size());
+    const size_t size = GetStorageSize();
+    assert( !(size % 2) );
+    if( size ) {
+      if( Loader )
+        {
+        // Do not keep the bytes of a lazily read value around
+        std::vector<char> copy;
+        if( !LoadCopy(copy) )
+          {
+          os.setstate(std::ios::failbit);
+          return os;
+          }
+        TSwap::SwapArray((TType*)&copy[0], size / sizeof(TType) );
+        os.write(&copy[0], copy.size());
+        }
+      else if( IsIdentitySwap<TSwap,TType>() )
+        {
+        os.write(GetPointer(), size);
+        }
+      else
+        {
+        std::vector<char> copy(GetPointer(), GetPointer() + size);
+        TSwap::SwapArray((TType*)&copy[0], size / sizeof(TType) );
+        os.write(&copy[0], copy.size());
+        }
       }
     return os;
   }
@@ -180,10 +276,11 @@ public:
    */
   bool IsPrintable(VL length) const {
     assert( length <= Length );
+    const char *p = GetPointer();
     for(unsigned int i=0; i<length; i++)
       {
-      if ( i == (length-1) && Internal[i] == '\0') continue;
-      if ( !( isprint((unsigned char)Internal[i]) || isspace((unsigned char)Internal[i]) ) )
+      if ( i == (length-1) && p[i] == '\0') continue;
+      if ( !( isprint((unsigned char)p[i]) || isspace((unsigned char)p[i]) ) )
         {
         //gdcmWarningMacro( "Cannot print :" << i );
         return false;
@@ -200,18 +297,19 @@ protected:
   void Print(std::ostream &os) const {
   // This is perfectly valid to have a Length = 0 , so we cannot check
   // the length for printing
-  if( !Internal.empty() )
+  const char *p = GetPointer();
+  if( p )
     {
     if( IsPrintable(Length) )
       {
       // WARNING: Internal.end() != Internal.begin()+Length
       std::vector<char>::size_type length = Length;
-      if( Internal.back() == 0 ) --length;
-      std::copy(Internal.begin(), Internal.begin()+length,
+      if( p[GetStorageSize()-1] == 0 ) --length;
+      std::copy(p, p+length,
         std::ostream_iterator<char>(os));
       }
     else
-      os << "Loaded:" << Internal.size();
+      os << "Loaded:" << GetStorageSize();
     }
   else
     {
@@ -229,12 +327,52 @@ friend std::ostream& operator<<(std::ostream &os,const char c);
   }
 
 private:
+  /// Number of bytes available from GetPointer()
+  size_t GetStorageSize() const {
+    return (View || Loader) ? (size_t)Length : Internal.size();
+  }
+
+  /// Read the bytes of a lazily read value into Internal
+  void Load();
+
+  /// Read the bytes of a lazily read value into \param copy, leaving the
+  /// value itself untouched
+  bool LoadCopy(std::vector<char> &copy) const {
+    copy.resize(Length);
+    return Loader->Load(LoaderOffset, &copy[0], copy.size());
+  }
+
+  /// Copy the referenced file image bytes into Internal
+  void Materialize() {
+    if( Loader ) Load();
+    if( !View ) return;
+    Internal.assign( View, View + Length );
+    View = 0;
+    ViewOwner = 0;
+  }
+
+  /// Whether TSwap leaves an array of TType untouched on this platform
+  template <typename TSwap, typename TType>
+  static bool IsIdentitySwap() {
+    return sizeof(TType) == 1 || TSwap::Swap((uint16_t)0x0102) == 0x0102;
+  }
+
   std::vector<char> Internal;
 
   // WARNING Length IS NOT Internal.size() some *featured* DICOM
   // implementation define odd length, we always load them as even number
   // of byte, so we need to keep the right Length
   VL Length;
+
+  // When not NULL, the bytes live in a memory mapped file (kept alive by
+  // ViewOwner) and Internal is empty. A view always has an even Length.
+  const char *View;
+  SmartPointer<Object> ViewOwner;
+
+  // When not NULL, the bytes have not been read yet: they are LoaderOffset
+  // in the file of Loader, Internal is empty and Length is even.
+  SmartPointer<LazyValueLoader> Loader;
+  std::streamoff LoaderOffset;
 };
 
 } // end namespace gdcm_ns
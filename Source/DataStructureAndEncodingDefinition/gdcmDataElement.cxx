@@ -189,4 +189,15 @@ void DataElement::SetValueFieldLength( VL vl, bool readvalues )
     ValueField->SetLengthOnly(vl); // do not perform realloc
 }
 
+void DataElement::SetValueFieldLength( VL vl, bool readvalues, std::istream &is )
+{
+  // ByteValue::Read will reference the file image directly or defer the
+  // read (or allocate when it cannot)
+  if( readvalues && dynamic_cast<ByteValue*>(ValueField.GetPointer())
+    && ( MemoryMappedFile::GetMemoryMappedFile(is)
+      || LazyValueLoader::GetLazyValueLoader(is) ) )
+    readvalues = false;
+  SetValueFieldLength( vl, readvalues );
+}
+
 } // end namespace gdcm_ns
@@ -253,6 +253,9 @@ protected:
   ValuePtr ValueField;
 
   void SetValueFieldLength( VL vl, bool readvalues );
+  /// Same as above, but do not allocate a ByteValue that is about to be read
+  /// from a memory mapped file
+  void SetValueFieldLength( VL vl, bool readvalues, std::istream &is );
 };
 //-----------------------------------------------------------------------------
 inline std::ostream& operator<<(std::ostream &os, const DataElement &val)
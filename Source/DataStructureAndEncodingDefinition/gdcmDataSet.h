@@ -19,6 +19,7 @@
 #include "gdcmVR.h"
 #include "gdcmElement.h"
 #include "gdcmMediaStorage.h"
+#include "gdcmSortedVector.h"
 
 #include <set>
 #include <iterator>
@@ -51,12 +52,24 @@ class PrivateTag;
  *
  * \warning
  * a DataSet does not have a Transfer Syntax type, only a File does.
+ *
+ * \note
+ * A DataSet can be read concurrently through its const interface, see File
+ * for the complete thread safety contract.
+ *
+ * \note
+ * When GDCM is built with GDCM_DATASET_SORTED_VECTOR, DataElementSet is a
+ * SortedVector: Insert and Remove then invalidate iterators.
  */
 class GDCM_EXPORT DataSet
 {
   friend class CSAHeader;
 public:
+#ifdef GDCM_DATASET_SORTED_VECTOR
+  typedef SortedVector<DataElement> DataElementSet;
+#else
   typedef std::set<DataElement> DataElementSet;
+#endif
   typedef DataElementSet::const_iterator ConstIterator;
   typedef DataElementSet::iterator Iterator;
   typedef DataElementSet::size_type SizeType;
@@ -153,7 +166,9 @@ public:
 	{
 	  // detect loop:
 	  gdcmAssertAlwaysMacro( &*it != &de );
-	  DES.erase(it);
+	  // Same Tag, so same position: overwrite in place
+	  const_cast<DataElement&>(*it) = de;
+	  return;
 	}
     DES.insert(de);
   }
@@ -164,7 +179,8 @@ public:
     {
       // detect loop:
 	  gdcmAssertAlwaysMacro( &*it != &de );
-	  DES.erase(it);
+	  const_cast<DataElement&>(*it) = de;
+	  return;
     }
 	DES.insert(de);
   }
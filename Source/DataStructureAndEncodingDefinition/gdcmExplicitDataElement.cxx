@@ -14,6 +14,9 @@
 #include "gdcmExplicitDataElement.h"
 #include "gdcmSequenceOfItems.h"
 #include "gdcmSequenceOfFragments.h"
+#include "gdcmMemoryMappedFile.h"
+
+#include <cstring> // memcpy
 
 namespace gdcm_ns
 {
@@ -62,4 +65,64 @@ VL ExplicitDataElement::GetLength() const
 }
 
 
+//-----------------------------------------------------------------------------
+size_t ExplicitDataElement::DecodePreValue(const char *buffer, size_t length)
+{
+#ifdef GDCM_WORDS_BIGENDIAN
+  (void)buffer; (void)length;
+  return 0;
+#else
+  // Tag (4) + VR (2) + VL (2), or Tag (4) + VR (2) + reserved (2) + VL (4)
+  if( length < 8 ) return 0;
+  uint16_t tag[2];
+  memcpy( tag, buffer, sizeof(tag) );
+  // Item / delimitation items have their own handling:
+  if( tag[0] == 0xfffe ) return 0;
+#ifdef GDCM_SUPPORT_BROKEN_IMPLEMENTATION
+  // DigitexAlpha_no_7FE0.dcm
+  if( tag[0] == 0x00ff && tag[1] == 0x4aa5 ) return 0;
+#endif
+#ifdef ELSCINT1_01F7_1070
+  if( tag[0] == 0x01f7 && tag[1] == 0x1070 ) return 0;
+#endif
+  const VR::VRType vr = VR::GetVRTypeFromFile( buffer + 4 );
+  if( vr == VR::INVALID ) return 0;
+  size_t n;
+  if( vr & VR::VL32 )
+    {
+    // Non zero reserved bytes are reported by VR::Read
+    if( length < 12 || buffer[6] != 0 || buffer[7] != 0 ) return 0;
+    uint32_t vl;
+    memcpy( &vl, buffer + 8, sizeof(vl) );
+    ValueLengthField = vl;
+    n = 12;
+    }
+  else
+    {
+    uint16_t vl;
+    memcpy( &vl, buffer + 6, sizeof(vl) );
+#ifdef GDCM_SUPPORT_BROKEN_IMPLEMENTATION
+    // HACK for SIEMENS Leonardo
+    if( vl == 0x0006 && vr == VR::UL && tag[0] == 0x0009 ) return 0;
+#endif
+    ValueLengthField = vl;
+    n = 8;
+    }
+  TagField = Tag( tag[0], tag[1] );
+  VRField = vr;
+  return n;
+#endif
+}
+
+bool ExplicitDataElement::ReadPreValueFromMemory(std::istream &is, SwapperNoOp *)
+{
+  const MemoryMappedFile *mmf = MemoryMappedFile::GetMemoryMappedFile(is);
+  if( !mmf || !is.good() ) return false;
+  const char *p = mmf->GetCurrentPointer(is);
+  const size_t n = DecodePreValue( p, (size_t)(mmf->GetPointer() + mmf->GetSize() - p) );
+  if( !n ) return false;
+  mmf->Advance(is, n);
+  return true;
+}
+
 } // end namespace gdcm_ns
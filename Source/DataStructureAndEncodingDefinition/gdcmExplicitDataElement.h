@@ -15,6 +15,7 @@
 #define GDCMEXPLICITDATAELEMENT_H
 
 #include "gdcmDataElement.h"
+#include "gdcmSwapper.h"
 
 namespace gdcm_ns
 {
@@ -41,6 +42,19 @@ public:
 
   template <typename TSwap>
   const std::ostream &Write(std::ostream &os) const;
+
+  /// Fast path of ReadPreValue<SwapperNoOp> (Explicit VR Little Endian):
+  /// decode Tag, VR and VL directly from a contiguous buffer.
+  /// Return the number of bytes decoded (8 or 12), or 0 when the regular
+  /// ReadPreValue must be used instead: buffer too short, delimitation items,
+  /// invalid VR, known broken encodings, or big endian host.
+  size_t DecodePreValue(const char *buffer, size_t length);
+
+private:
+  // Use DecodePreValue when the stream reads from a MemoryMappedFile
+  bool ReadPreValueFromMemory(std::istream &is, SwapperNoOp *);
+  template <typename TSwap>
+  bool ReadPreValueFromMemory(std::istream &, TSwap *) { return false; }
 };
 
 } // end namespace gdcm_ns
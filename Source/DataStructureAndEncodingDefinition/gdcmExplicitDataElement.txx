@@ -36,6 +36,10 @@ std::istream &ExplicitDataElement::Read(std::istream &is)
 template <typename TSwap>
 std::istream &ExplicitDataElement::ReadPreValue(std::istream &is)
 {
+  if( ReadPreValueFromMemory(is, (TSwap*)0) )
+    {
+    return is;
+    }
   TagField.Read<TSwap>(is);
   // See PS 3.5, Data Element Structure With Explicit VR
   // Read Tag
@@ -239,7 +243,7 @@ std::istream &ExplicitDataElement::ReadValue(std::istream &is, bool readvalues)
     ValueField = new ByteValue;
     }
   // We have the length we should be able to read the value
-  this->SetValueFieldLength( ValueLengthField, readvalues );
+  this->SetValueFieldLength( ValueLengthField, readvalues, is );
 #if defined(GDCM_SUPPORT_BROKEN_IMPLEMENTATION) && 0
   // PHILIPS_Intera-16-MONO2-Uncompress.dcm
   if( TagField == Tag(0x2001,0xe05f)
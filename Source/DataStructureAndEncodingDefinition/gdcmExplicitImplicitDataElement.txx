@@ -400,7 +400,7 @@ std::istream &ExplicitImplicitDataElement::ReadValue(std::istream &is, bool read
     ValueField = new ByteValue;
     }
   // We have the length we should be able to read the value
-  this->SetValueFieldLength( ValueLengthField, readvalues );
+  this->SetValueFieldLength( ValueLengthField, readvalues, is );
 #if defined(GDCM_SUPPORT_BROKEN_IMPLEMENTATION) && 0
   // PHILIPS_Intera-16-MONO2-Uncompress.dcm
   if( TagField == Tag(0x2001,0xe05f)
@@ -28,6 +28,14 @@ namespace gdcm_ns
  * of the File. Files are identified by a unique File ID and may by written,
  * read and/or deleted.
  *
+ * \note Thread safety: a File (and its DataSet) that is no longer modified
+ * can be read concurrently from any number of threads through its const
+ * interface, and DataElement can be copied (shallow copy of the shared
+ * Value) from those threads. Values not yet loaded when the File was read
+ * lazily (Reader::SetLazyLoadingThreshold), and memory mapped values
+ * accessed as a std::vector, are filled on first access: touch them once
+ * (eg. ByteValue::GetPointer) before sharing the File.
+ *
  * \see Reader Writer
  */
 class GDCM_EXPORT File : public Object
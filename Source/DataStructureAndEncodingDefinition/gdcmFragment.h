@@ -97,7 +97,8 @@ public:
     const Tag seqDelItem(0xfffe,0xe0dd);
     // Self
     SmartPointer<ByteValue> bv = new ByteValue;
-    bv->SetLength(ValueLengthField);
+    ValueField = bv;
+    this->SetValueFieldLength(ValueLengthField, true, is);
     if( !bv->Read<TSwap>(is) )
       {
       // Fragment is incomplete, but is a itemStart, let's try to push it anyway...
@@ -152,7 +153,8 @@ public:
 
     // Self
     SmartPointer<ByteValue> bv = new ByteValue;
-    bv->SetLength(ValueLengthField);
+    ValueField = bv;
+    this->SetValueFieldLength(ValueLengthField, true, is);
     if( !bv->Read<TSwap>(is) )
       {
       // Fragment is incomplete, but is a itemStart, let's try to push it anyway...
@@ -216,7 +216,7 @@ std::istream &ImplicitDataElement::ReadValue(std::istream &is, bool readvalues)
     }
 #endif
   // We have the length we should be able to read the value
-  this->SetValueFieldLength( ValueLengthField, readvalues );
+  this->SetValueFieldLength( ValueLengthField, readvalues, is );
   bool failed;
 #ifdef GDCM_WORDS_BIGENDIAN
   VR vrfield = GetVRFromTag( TagField );
@@ -19,6 +19,7 @@
 
 #include "gdcmDeflateStream.h"
 #include "gdcmSystem.h"
+#include "gdcmLazyValueLoader.h"
 
 #include "gdcmExplicitDataElement.h"
 #include "gdcmImplicitDataElement.h"
@@ -39,6 +40,7 @@ Reader::Reader():F(new File)
 {
   Stream = NULL;
   Ifstream = NULL;
+  LazyLoadingThreshold = 0;
 }
 
 Reader::~Reader()
@@ -330,6 +332,30 @@ bool Reader::ReadSelectedPrivateTags( std::set<PrivateTag> const & selectedPTags
   return InternalReadCommon(caller);
 }
 
+/*
+ * Detach the LazyValueLoader from the stream whatever the way out of the
+ * read: the stream only keeps a raw pointer to it
+ */
+class LazyValueLoaderAttacher
+{
+public:
+  LazyValueLoaderAttacher(std::istream &is):IS(is),Attached(false) {}
+  ~LazyValueLoaderAttacher()
+    {
+    if( Attached ) LazyValueLoader::Attach( IS, NULL );
+    }
+  void Attach(LazyValueLoader *loader)
+    {
+    LazyValueLoader::Attach( IS, loader );
+    Attached = true;
+    }
+private:
+  LazyValueLoaderAttacher(const LazyValueLoaderAttacher&); // Not implemented
+  void operator=(const LazyValueLoaderAttacher&); // Not implemented
+  std::istream &IS;
+  bool Attached;
+};
+
 template <typename T_Caller>
 bool Reader::InternalReadCommon(const T_Caller &caller)
 {
@@ -340,6 +366,20 @@ bool Reader::InternalReadCommon(const T_Caller &caller)
     }
   bool success = true;
 
+  // Let ByteValue::Read defer large values. The attacher is destroyed before
+  // the loader.
+  SmartPointer<LazyValueLoader> loader;
+  LazyValueLoaderAttacher attacher( *Stream );
+  if( LazyLoadingThreshold && Ifstream && Stream == Ifstream )
+    {
+    loader = new LazyValueLoader;
+    if( loader->Open( FileName.c_str() ) )
+      {
+      loader->SetThreshold( LazyLoadingThreshold );
+      attacher.Attach( loader );
+      }
+    }
+
   try
     {
     std::istream &is = *Stream;
@@ -821,12 +861,15 @@ bool Reader::CanRead() const
 
 void Reader::SetFileName(const char *filename)
 {
+  MappedFile = NULL;
+  FileName.clear();
   if(Ifstream) delete Ifstream;
   Ifstream = new std::ifstream();
   Ifstream->open(filename, std::ios::binary);
   if( Ifstream->is_open() )
     {
     Stream = Ifstream;
+    FileName = filename;
     assert( Stream && *Stream );
     }
   else
@@ -837,6 +880,22 @@ void Reader::SetFileName(const char *filename)
     }
 }
 
+void Reader::SetMemoryMappedFile(const char *filename)
+{
+  SmartPointer<MemoryMappedFile> mmf = new MemoryMappedFile;
+  if( !mmf->Open( filename ) )
+    {
+    gdcmDebugMacro( "Could not map: " << (filename ? filename : "") );
+    SetFileName( filename );
+    return;
+    }
+  if(Ifstream) delete Ifstream;
+  Ifstream = NULL;
+  FileName.clear();
+  MappedFile = mmf;
+  Stream = &MappedFile->GetStream();
+}
+
 size_t Reader::GetStreamCurrentPosition() const
 {
   return static_cast<size_t>(GetStreamPtr()->tellg());
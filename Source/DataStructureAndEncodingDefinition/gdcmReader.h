@@ -15,6 +15,7 @@
 #define GDCMREADER_H
 
 #include "gdcmFile.h"
+#include "gdcmMemoryMappedFile.h"
 
 #include <fstream>
 
@@ -63,9 +64,30 @@ public:
   /// See SetStream if you are dealing with different std::istream object
   void SetFileName(const char *filename_native);
 
+  /// Set the filename to open using a memory mapping of the whole file. In
+  /// this mode values are not copied: each ByteValue points directly into
+  /// the file image (see ByteValue::IsMemoryMapped), only the pages actually
+  /// accessed are ever loaded. The mapping is released when the last value
+  /// referencing it is destroyed.
+  /// When the file cannot be mapped this falls back to SetFileName.
+  /// \warning the file must not be truncated or modified while mapped
+  void SetMemoryMappedFile(const char *filename_native);
+
+  /// Enable lazy loading of values: any value of \param threshold bytes or
+  /// more (Pixel Data, Overlay Data, large private blobs...) is not read,
+  /// only its position in the file is recorded. Its bytes are loaded from
+  /// the file on first access (see ByteValue::IsLoaded).
+  /// 0 (default) disables lazy loading. Only applies when reading with
+  /// SetFileName, and to values that do not require a byte swap.
+  /// \warning the file must not be modified or removed while values remain
+  /// to be loaded.
+  void SetLazyLoadingThreshold(size_t threshold) { LazyLoadingThreshold = threshold; }
+  size_t GetLazyLoadingThreshold() const { return LazyLoadingThreshold; }
+
   /// Set the open-ed stream directly
   void SetStream(std::istream &input_stream) {
     Stream = &input_stream;
+    FileName.clear();
   }
 
   /// Set/Get File
@@ -120,6 +142,9 @@ private:
   TransferSyntax GuessTransferSyntax();
   std::istream *Stream;
   std::ifstream *Ifstream;
+  SmartPointer<MemoryMappedFile> MappedFile;
+  std::string FileName;
+  size_t LazyLoadingThreshold;
 };
 
 /**
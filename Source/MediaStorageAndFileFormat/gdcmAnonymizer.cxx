@@ -269,28 +269,28 @@ static bool Anonymizer_RemoveRetired(File const &file, DataSet &ds)
   static const Global &g = GlobalInstance;
   static const Dicts &dicts = g.GetDicts();
   static const Dict &pubdict = dicts.GetPublicDict();
+  // Erasing invalidates iterators (see DataSet::DataElementSet), so only
+  // collect the tags to remove while traversing:
+  std::vector<Tag> toremove;
   DataSet::Iterator it = ds.Begin();
   for( ; it != ds.End(); )
     {
     const DataElement &de1 = *it;
-    // std::set::erase invalidate iterator, so we need to make a copy first:
-    DataSet::Iterator dup = it;
     ++it;
     if( de1.GetTag().IsPublic() )
       {
       const DictEntry &entry = pubdict.GetDictEntry( de1.GetTag() );
       if( entry.GetRetired() )
         {
-        ds.GetDES().erase(dup);
+        toremove.push_back( de1.GetTag() );
         }
       }
     else
       {
-      const DataElement &de = *dup;
-      VR vr = DataSetHelper::ComputeVR(file, ds, de.GetTag() );
+      VR vr = DataSetHelper::ComputeVR(file, ds, de1.GetTag() );
       if( vr.Compatible(VR::SQ) )
         {
-        SmartPointer<SequenceOfItems> sq = de.GetValueAsSQ();
+        SmartPointer<SequenceOfItems> sq = de1.GetValueAsSQ();
         if( sq )
           {
           SequenceOfItems::SizeType n = sq->GetNumberOfItems();
@@ -300,7 +300,7 @@ static bool Anonymizer_RemoveRetired(File const &file, DataSet &ds)
             DataSet &nested = item.GetNestedDataSet();
             Anonymizer_RemoveRetired( file, nested );
             }
-          DataElement de_dup = *dup;
+          DataElement de_dup = de1;
           de_dup.SetValue( *sq );
           de_dup.SetVLToUndefined(); // FIXME
           ds.Replace( de_dup );
@@ -308,6 +308,10 @@ static bool Anonymizer_RemoveRetired(File const &file, DataSet &ds)
         }
       }
     }
+  for( std::vector<Tag>::const_iterator t = toremove.begin(); t != toremove.end(); ++t )
+    {
+    ds.Remove( *t );
+    }
   return true;
 }
 
@@ -319,24 +323,24 @@ bool Anonymizer::RemoveRetired()
 
 static bool Anonymizer_RemoveGroupLength(File const &file, DataSet &ds)
 {
+  // Erasing invalidates iterators (see DataSet::DataElementSet), so only
+  // collect the tags to remove while traversing:
+  std::vector<Tag> toremove;
   DataSet::Iterator it = ds.Begin();
   for( ; it != ds.End(); )
     {
     const DataElement &de1 = *it;
-    // std::set::erase invalidate iterator, so we need to make a copy first:
-    DataSet::Iterator dup = it;
     ++it;
     if( de1.GetTag().IsGroupLength() )
       {
-      ds.GetDES().erase(dup);
+      toremove.push_back( de1.GetTag() );
       }
     else
       {
-      const DataElement &de = *dup;
-      VR vr = DataSetHelper::ComputeVR(file, ds, de.GetTag() );
+      VR vr = DataSetHelper::ComputeVR(file, ds, de1.GetTag() );
       if( vr.Compatible(VR::SQ) )
         {
-        SmartPointer<SequenceOfItems> sq = de.GetValueAsSQ();
+        SmartPointer<SequenceOfItems> sq = de1.GetValueAsSQ();
         if( sq )
           {
           SequenceOfItems::SizeType n = sq->GetNumberOfItems();
@@ -346,7 +350,7 @@ static bool Anonymizer_RemoveGroupLength(File const &file, DataSet &ds)
             DataSet &nested = item.GetNestedDataSet();
             Anonymizer_RemoveGroupLength( file, nested );
             }
-          DataElement de_dup = *dup;
+          DataElement de_dup = de1;
           de_dup.SetValue( *sq );
           de_dup.SetVLToUndefined(); // FIXME
           ds.Replace( de_dup );
@@ -354,6 +358,10 @@ static bool Anonymizer_RemoveGroupLength(File const &file, DataSet &ds)
         }
       }
     }
+  for( std::vector<Tag>::const_iterator t = toremove.begin(); t != toremove.end(); ++t )
+    {
+    ds.Remove( *t );
+    }
   return true;
 }
 
@@ -365,24 +373,24 @@ bool Anonymizer::RemoveGroupLength()
 
 static bool Anonymizer_RemovePrivateTags(File const &file, DataSet &ds)
 {
+  // Erasing invalidates iterators (see DataSet::DataElementSet), so only
+  // collect the tags to remove while traversing:
+  std::vector<Tag> toremove;
   DataSet::Iterator it = ds.Begin();
   for( ; it != ds.End(); )
     {
     const DataElement &de1 = *it;
-      // std::set::erase invalidate iterator, so we need to make a copy first:
-      DataSet::Iterator dup = it;
-      ++it;
+    ++it;
     if( de1.GetTag().IsPrivate() )
       {
-      ds.GetDES().erase(dup);
+      toremove.push_back( de1.GetTag() );
       }
     else
       {
-      const DataElement &de = *dup;
-      VR vr = DataSetHelper::ComputeVR(file, ds, de.GetTag() );
+      VR vr = DataSetHelper::ComputeVR(file, ds, de1.GetTag() );
       if( vr.Compatible(VR::SQ) )
         {
-        SmartPointer<SequenceOfItems> sq = de.GetValueAsSQ();
+        SmartPointer<SequenceOfItems> sq = de1.GetValueAsSQ();
         if( sq )
           {
           SequenceOfItems::SizeType n = sq->GetNumberOfItems();
@@ -392,7 +400,7 @@ static bool Anonymizer_RemovePrivateTags(File const &file, DataSet &ds)
             DataSet &nested = item.GetNestedDataSet();
             Anonymizer_RemovePrivateTags( file, nested );
             }
-          DataElement de_dup = *dup;
+          DataElement de_dup = de1;
           de_dup.SetValue( *sq );
           de_dup.SetVLToUndefined(); // FIXME
           ds.Replace( de_dup );
@@ -400,6 +408,10 @@ static bool Anonymizer_RemovePrivateTags(File const &file, DataSet &ds)
         }
       }
     }
+  for( std::vector<Tag>::const_iterator t = toremove.begin(); t != toremove.end(); ++t )
+    {
+    ds.Remove( *t );
+    }
   return true;
 }
 
@@ -20,6 +20,7 @@
 #include "gdcmJPEGLSCodec.h"
 #include "gdcmJPEG2000Codec.h"
 #include "gdcmRLECodec.h"
+#include "gdcmWorkerPool.h"
 
 #include <cstring>
 
@@ -53,7 +54,8 @@ Bitmap::Bitmap():
   PixelData(),
   LUT(new LookupTable),
   NeedByteSwap(false),
-  LossyFlag(false)
+  LossyFlag(false),
+  NumberOfThreads(1)
 {}
 
 Bitmap::~Bitmap() {}
@@ -381,10 +383,7 @@ bool Bitmap::TryJPEGCodec(char *buffer, bool &lossyflag) const
       PixelFormat pf = GetPixelFormat(); // PixelFormat::UINT8;
       codec.SetPixelFormat( pf );
 
-      std::stringstream ss;
-      ss.write( bv2.GetPointer(), bv2.GetLength() );
-      bool b = codec.GetHeaderInfo( ss, ts2 );
-      //bool b = codec.GetHeaderInfo( bv2.GetPointer(), bv2.GetLength() , ts2 );
+      bool b = codec.GetHeaderInfo( bv2.GetPointer(), bv2.GetLength() , ts2 );
       if(!b) return false;
       assert( b );
       lossyflag = codec.IsLossy();
@@ -524,6 +523,20 @@ bool Bitmap::TryPVRGCodec(char *buffer, bool &lossyflag) const
   PVRGCodec codec;
   if( codec.CanDecode( ts ) )
     {
+    // Only reached when IJG could not read the JPEG header: PVRG cannot
+    // probe a header on its own, so the Pixel Data is decoded even when
+    // only the lossy flag is requested (buffer == NULL). Do not bother
+    // with a first fragment which is not JPEG at all (no SOI marker):
+    const SequenceOfFragments *sf = PixelData.GetSequenceOfFragments();
+    if( !sf || !sf->GetNumberOfFragments() ) return false;
+    const ByteValue *bv = sf->GetFragment(0).GetByteValue();
+    if( !bv || bv->GetLength() < 2
+      || (unsigned char)bv->GetPointer()[0] != 0xFF
+      || (unsigned char)bv->GetPointer()[1] != 0xD8 )
+      {
+      return false;
+      }
+
     codec.SetPixelFormat( GetPixelFormat() );
     //codec.SetBufferLength( len );
     //codec.SetNumberOfDimensions( GetNumberOfDimensions() );
@@ -609,10 +622,7 @@ bool Bitmap::TryJPEGLSCodec(char *buffer, bool &lossyflag) const
       const Fragment &frag = sf->GetFragment(0);
       const ByteValue &bv2 = dynamic_cast<const ByteValue&>(frag.GetValue());
 
-      std::stringstream ss;
-      ss.write( bv2.GetPointer(), bv2.GetLength() );
-      bool b = codec.GetHeaderInfo( ss, ts2 );
-      //bool b = codec.GetHeaderInfo( bv2.GetPointer(), bv2.GetLength() , ts2 );
+      bool b = codec.GetHeaderInfo( bv2.GetPointer(), bv2.GetLength() , ts2 );
       if( !b ) return false;
       lossyflag = codec.IsLossy();
       // we need to know the actual pixeltype after ::Read
@@ -644,17 +654,9 @@ bool Bitmap::TryJPEGLSCodec(char *buffer, bool &lossyflag) const
     codec.SetPhotometricInterpretation( GetPhotometricInterpretation() );
     codec.SetNeedOverlayCleanup( AreOverlaysInPixelData() );
     codec.SetDimensions( GetDimensions() );
-    DataElement out;
-    bool r = codec.Decode(PixelData, out);
+    // Decode the frames straight into the user buffer
+    bool r = codec.Decode(PixelData, buffer, len);
     if( !r ) return false;
-    const ByteValue *outbv = out.GetByteValue();
-    assert( outbv );
-    unsigned long check = outbv->GetLength();  // FIXME
-    (void)check;
-    assert( len <= outbv->GetLength() );
-    // DermaColorLossLess.dcm has a len of 63531, but DICOM will give us: 63532 ...
-    assert( len <= outbv->GetLength() );
-    if(buffer) memcpy(buffer, outbv->GetPointer(), len /*outbv->GetLength()*/ );  // FIXME
 
     //assert( codec.IsLossy() == ts.IsLossy() );
     lossyflag = codec.IsLossy();
@@ -847,6 +849,21 @@ bool Bitmap::TryRLECodec(char *buffer, bool &lossyflag ) const
   const TransferSyntax &ts = GetTransferSyntax();
 
   RLECodec codec;
+  if(!buffer)
+    {
+    if( codec.CanDecode( ts ) ) // short path
+      {
+      TransferSyntax ts2;
+      const SequenceOfFragments *sf = PixelData.GetSequenceOfFragments();
+      if( !sf || !sf->GetNumberOfFragments() ) return false;
+      const ByteValue *bv2 = sf->GetFragment(0).GetByteValue();
+      if( !bv2 || !codec.GetHeaderInfo( bv2->GetPointer(), bv2->GetLength(), ts2 ) )
+        return false;
+      lossyflag = false;
+      return true;
+      }
+    return false;
+    }
   if( codec.CanDecode( ts ) )
     {
     //assert( sf->GetNumberOfFragments() == 1 );
@@ -880,9 +897,315 @@ bool Bitmap::GetBuffer(char *buffer) const
   return GetBufferInternal(buffer, dummy);
 }
 
+/*
+ * A copy of a Bitmap restricted to one of its frames, so that the regular
+ * Try*Codec code path can decode it
+ */
+class FrameBitmap : public Bitmap
+{
+public:
+  FrameBitmap(Bitmap const &b):Bitmap(b),
+    OverlaysInPixelData(b.AreOverlaysInPixelData())
+    {
+    SetNumberOfDimensions( 2 );
+    SetNumberOfThreads( 1 );
+    }
+  bool AreOverlaysInPixelData() const { return OverlaysInPixelData; }
+private:
+  bool OverlaysInPixelData;
+};
+
+static inline uint32_t ReadLittleEndian32(const char *p)
+{
+  const unsigned char *u = (const unsigned char*)p;
+  return (uint32_t)u[0] | ((uint32_t)u[1] << 8)
+    | ((uint32_t)u[2] << 16) | ((uint32_t)u[3] << 24);
+}
+
+/*
+ * The Basic Offset Table gives the offset of the first fragment item of each
+ * frame, relative to the first fragment item. Find the fragments [first,
+ * last) of frame. Only the item lengths are needed, so the fragments are not
+ * loaded (see Reader::SetLazyLoadingThreshold).
+ */
+static bool FindFrameFragmentsWithOffsetTable(SequenceOfFragments const &sf,
+  unsigned int frame, unsigned int nframes, size_t &first, size_t &last)
+{
+  const ByteValue *table = sf.GetTable().GetByteValue();
+  if( !table || table->GetLength() != 4 * nframes ) return false;
+  const char *p = table->GetPointer();
+  const uint64_t begin = ReadLittleEndian32( p + 4 * frame );
+  const bool lastframe = frame + 1 == nframes;
+  const uint64_t end = lastframe ? 0 : ReadLittleEndian32( p + 4 * (frame + 1) );
+  if( !lastframe && end <= begin ) return false;
+
+  const size_t nfrags = sf.GetNumberOfFragments();
+  first = last = nfrags;
+  uint64_t pos = 0;
+  for( size_t i = 0; i < nfrags; ++i )
+    {
+    if( pos == begin ) first = i;
+    if( !lastframe && pos == end ) { last = i; break; }
+    pos += 8 + (uint32_t)sf.GetFragment(i).GetVL();
+    }
+  if( first == nfrags ) return false;
+  return lastframe || last != nfrags;
+}
+
+/*
+ * Whether the fragment starts a JPEG / JPEG-LS (SOI marker) or JPEG 2000
+ * (SOC marker or JP2 signature box) codestream
+ */
+static bool IsCodestreamStart(Fragment const &frag)
+{
+  const ByteValue *bv = frag.GetByteValue();
+  if( !bv || bv->GetLength() < 12 ) return false;
+  const unsigned char *p = (const unsigned char*)bv->GetPointer();
+  if( p[0] == 0xff && ( p[1] == 0xd8 || p[1] == 0x4f ) ) return true;
+  static const unsigned char jp2[] = { 0x0, 0x0, 0x0, 0x0c, 'j', 'P', ' ', ' ' };
+  return memcmp( p, jp2, sizeof(jp2) ) == 0;
+}
+
+/*
+ * Without a Basic Offset Table, a frame spans from a fragment starting a
+ * codestream to the next one.
+ */
+static bool FindFrameFragmentsWithScan(SequenceOfFragments const &sf,
+  unsigned int frame, unsigned int nframes, size_t &first, size_t &last)
+{
+  std::vector<size_t> starts;
+  const size_t nfrags = sf.GetNumberOfFragments();
+  for( size_t i = 0; i < nfrags; ++i )
+    {
+    if( IsCodestreamStart( sf.GetFragment(i) ) ) starts.push_back( i );
+    }
+  if( starts.size() != nframes || starts[0] != 0 ) return false;
+  first = starts[frame];
+  last = frame + 1 < nframes ? starts[frame + 1] : nfrags;
+  return true;
+}
+
+/*
+ * Set de to the Pixel Data of a single frame
+ */
+bool Bitmap::GetFrameDataElement(unsigned int frame, DataElement &de) const
+{
+  const unsigned int nframes = GetDimension(2);
+  if( const ByteValue *bv = PixelData.GetByteValue() )
+    {
+    // Packed pixels (12 bits, single bit...) do not start on a byte
+    // boundary for every frame
+    if( PF.GetBitsAllocated() % 8 != 0 ) return false;
+    const unsigned long framelen = GetBufferLength() / nframes;
+    if( bv->GetLength() < (uint64_t)(frame + 1) * framelen ) return false;
+    de.SetByteValue( bv->GetPointer() + (size_t)frame * framelen, framelen );
+    return true;
+    }
+
+  const SequenceOfFragments *sf = PixelData.GetSequenceOfFragments();
+  if( !sf ) return false;
+  size_t first, last;
+  if( sf->GetNumberOfFragments() == nframes )
+    {
+    first = frame;
+    last = frame + 1;
+    }
+  else if( !FindFrameFragmentsWithOffsetTable( *sf, frame, nframes, first, last )
+    && !FindFrameFragmentsWithScan( *sf, frame, nframes, first, last ) )
+    {
+    return false;
+    }
+  SmartPointer<SequenceOfFragments> framesf = new SequenceOfFragments;
+  for( size_t i = first; i < last; ++i )
+    {
+    framesf->AddFragment( sf->GetFragment(i) );
+    }
+  de.SetValue( *framesf );
+  return true;
+}
+
+bool Bitmap::GetFrameBuffer(unsigned int frame, char *buffer) const
+{
+  if( !buffer || IsEmpty() ) return false;
+  const unsigned int nframes = GetNumberOfDimensions() == 3 ? GetDimension(2) : 1;
+  if( frame >= nframes ) return false;
+  if( nframes == 1 ) return GetBuffer( buffer );
+  const unsigned long len = GetBufferLength();
+  if( len % nframes ) return false;
+  const unsigned long framelen = len / nframes;
+
+  FrameBitmap fb( *this );
+  if( GetFrameDataElement( frame, fb.GetDataElement() ) )
+    {
+    // The codec may correct the pixel format, in which case the frame does
+    // not have the expected layout
+    if( fb.GetBuffer( buffer ) && fb.GetPixelFormat() == GetPixelFormat() )
+      return true;
+    gdcmDebugMacro( "Could not decode frame #" << frame << " on its own" );
+    }
+
+  std::vector<char> all( len );
+  if( !GetBuffer( &all[0] ) ) return false;
+  memcpy( buffer, &all[0] + (size_t)frame * framelen, framelen );
+  return true;
+}
+
+/*
+ * Decode the frames of an encapsulated multi-frame image from the worker
+ * threads: each frame gets its own clone of the codec, configured as a 2D
+ * image. JPEG-LS, JPEG 2000 and RLE frames are decoded straight into their
+ * slice of the output buffer; JPEG frames are decoded into a temporary value
+ * and then copied there.
+ */
+class BitmapFrameDecodeJob : public WorkerPool::Job
+{
+public:
+  BitmapFrameDecodeJob(Bitmap const &bitmap, ImageCodec const &prototype,
+    char *buffer, unsigned long framelen):B(bitmap),Prototype(prototype),
+    Buffer(buffer),FrameLen(framelen),
+    Frames(bitmap.GetDimension(2), FRAME_FAILED) {}
+
+  void Execute(unsigned int frame)
+    {
+    const SequenceOfFragments *sf = B.GetDataElement().GetSequenceOfFragments();
+    assert( sf );
+    const Fragment &frag = sf->GetFragment(frame);
+
+    ImageCodec *codec = Prototype.Clone();
+    const unsigned int dims[3] = { B.GetDimension(0), B.GetDimension(1), 1 };
+    codec->SetNumberOfDimensions( 2 );
+    codec->SetDimensions( dims );
+    codec->SetPlanarConfiguration( B.GetPlanarConfiguration() );
+    codec->SetPhotometricInterpretation( B.GetPhotometricInterpretation() );
+    codec->SetPixelFormat( B.GetPixelFormat() );
+    codec->SetNeedOverlayCleanup( B.AreOverlaysInPixelData() );
+
+    const ByteValue *bv = frag.GetByteValue();
+    if( !bv )
+      {
+      delete codec;
+      return;
+      }
+    char *framebuffer = Buffer + (size_t)frame * FrameLen;
+    bool decoded;
+    if( JPEGLSCodec *jpegls = dynamic_cast<JPEGLSCodec*>(codec) )
+      {
+      decoded = jpegls->DecodeFrame( bv->GetPointer(), bv->GetLength(), framebuffer, FrameLen );
+      }
+    else if( JPEG2000Codec *j2k = dynamic_cast<JPEG2000Codec*>(codec) )
+      {
+      decoded = j2k->DecodeFrame( bv->GetPointer(), bv->GetLength(), framebuffer, FrameLen );
+      }
+    else if( RLECodec *rle = dynamic_cast<RLECodec*>(codec) )
+      {
+      decoded = rle->DecodeFrame( bv->GetPointer(), bv->GetLength(), framebuffer, FrameLen );
+      }
+    else
+      {
+      // The JPEG codec only decodes through streams: copy its output
+      SmartPointer<SequenceOfFragments> onefrag = new SequenceOfFragments;
+      onefrag->AddFragment( frag );
+      DataElement in( B.GetDataElement().GetTag() );
+      in.SetVR( VR::OB );
+      in.SetValue( *onefrag );
+      DataElement out;
+      const ByteValue *outbv = 0;
+      if( codec->Decode( in, out ) ) outbv = out.GetByteValue();
+      decoded = outbv && outbv->GetLength() >= FrameLen;
+      if( decoded ) memcpy( framebuffer, outbv->GetPointer(), FrameLen );
+      }
+    if( decoded && !ChangesPixelFormat( *codec, B.GetPixelFormat() ) )
+      {
+      Frames[frame] = codec->IsLossy() ? FRAME_LOSSY : FRAME_LOSSLESS;
+      }
+    delete codec;
+    }
+
+  /// Return false if any frame could not be decoded
+  bool GetSuccess(bool &lossy) const
+    {
+    lossy = false;
+    for( size_t i = 0; i < Frames.size(); ++i )
+      {
+      if( Frames[i] == FRAME_FAILED ) return false;
+      if( Frames[i] == FRAME_LOSSY ) lossy = true;
+      }
+    return true;
+    }
+
+private:
+  // Whether the serial code path would update the Bitmap pixel format after
+  // this decode (see TryJPEGCodec / TryJPEG2000Codec); such files are left
+  // to it.
+  static bool ChangesPixelFormat(ImageCodec const &codec, PixelFormat const &pf)
+    {
+    const PixelFormat &cpf = codec.GetPixelFormat();
+    if( dynamic_cast<const JPEGCodec*>(&codec) )
+      return cpf != pf;
+    if( dynamic_cast<const JPEG2000Codec*>(&codec) )
+      return cpf.GetBitsAllocated() == pf.GetBitsAllocated()
+        && cpf.GetPixelRepresentation() == pf.GetPixelRepresentation()
+        && cpf.GetSamplesPerPixel() == pf.GetSamplesPerPixel()
+        && cpf.GetBitsStored() < pf.GetBitsStored();
+    return false;
+    }
+
+  typedef enum {
+    FRAME_FAILED = 0,
+    FRAME_LOSSLESS,
+    FRAME_LOSSY
+  } FrameStatus;
+  Bitmap const &B;
+  ImageCodec const &Prototype;
+  char *Buffer;
+  unsigned long FrameLen;
+  std::vector<FrameStatus> Frames; // written by Execute(i) only
+};
+
+/*
+ * Only handle the simple, common layout: one fragment per frame, decoded by
+ * JPEG, JPEG-LS, JPEG 2000 or RLE. Anything unusual (fragmented frames,
+ * pixel format fixups, lossy data declared lossless...) returns false and is
+ * decoded again by the serial code path, which knows how to deal with it.
+ */
+bool Bitmap::TryFrameParallelDecode(char *buffer, bool &lossyflag) const
+{
+  if( !buffer || NumberOfThreads == 1 ) return false;
+  if( GetNumberOfDimensions() != 3 || GetDimension(2) < 2 ) return false;
+  const SequenceOfFragments *sf = PixelData.GetSequenceOfFragments();
+  if( !sf || sf->GetNumberOfFragments() != GetDimension(2) ) return false;
+
+  const TransferSyntax &ts = GetTransferSyntax();
+  JPEGCodec jpeg;
+  JPEGLSCodec jpegls;
+  JPEG2000Codec j2k;
+  RLECodec rle;
+  const ImageCodec *prototype = 0;
+  if( jpeg.CanDecode( ts ) ) prototype = &jpeg;
+  else if( j2k.CanDecode( ts ) ) prototype = &j2k;
+  else if( jpegls.CanDecode( ts ) ) prototype = &jpegls;
+  else if( rle.CanDecode( ts ) ) prototype = &rle;
+  if( !prototype ) return false;
+
+  const unsigned long len = GetBufferLength();
+  if( len % GetDimension(2) ) return false;
+  BitmapFrameDecodeJob job(*this, *prototype, buffer, len / GetDimension(2));
+  WorkerPool pool;
+  pool.SetNumberOfThreads( NumberOfThreads );
+  pool.Run( job, GetDimension(2) );
+
+  bool lossy;
+  if( !job.GetSuccess( lossy ) ) return false;
+  // Let the serial path report EVIL files:
+  if( lossy && !ts.IsLossy() ) return false;
+  lossyflag = lossy;
+  return true;
+}
+
 bool Bitmap::GetBufferInternal(char *buffer, bool &lossyflag) const
 {
   bool success = false;
+  if( !success ) success = TryFrameParallelDecode(buffer, lossyflag);
   if( !success ) success = TryRAWCodec(buffer, lossyflag);
   if( !success ) success = TryJPEGCodec(buffer, lossyflag);
   if( !success ) success = TryPVRGCodec(buffer, lossyflag); // AFTER IJG trial !
@@ -952,6 +1275,8 @@ void Bitmap::Print(std::ostream &os) const
     os << "PhotometricInterpretation: " << PI << "\n";
     os << "PlanarConfiguration: " << PlanarConfiguration << "\n";
     os << "TransferSyntax: " << TS << "\n";
+    if( NumberOfThreads != 1 )
+      os << "NumberOfThreads: " << NumberOfThreads << "\n";
     }
 }
 
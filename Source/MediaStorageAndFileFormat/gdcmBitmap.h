@@ -131,12 +131,25 @@ public:
   /// Acces the raw data
   bool GetBuffer(char *buffer) const;
 
+  /// Acces the raw data of a single frame (0-based). \p buffer must be
+  /// GetBufferLength() / GetDimension(2) bytes long. When the fragments of
+  /// the frame can be located (one fragment per frame, Basic Offset Table or
+  /// a scan for the start of each codestream) only this frame is decoded,
+  /// otherwise the whole image is decoded and the frame copied out.
+  bool GetFrameBuffer(unsigned int frame, char *buffer) const;
+
   /// Return whether or not the image was compressed using a lossy compressor or not
   bool IsLossy() const;
 
   /// Specifically set that the image was compressed using a lossy compression mechanism
   void SetLossyFlag(bool f) { LossyFlag = f; }
 
+  /// Number of threads used by GetBuffer to decode the frames of an
+  /// encapsulated multi-frame image (one fragment per frame). 0 means one
+  /// thread per processor. Default is 1 (no threading).
+  void SetNumberOfThreads(unsigned int n) { NumberOfThreads = n; }
+  unsigned int GetNumberOfThreads() const { return NumberOfThreads; }
+
 protected:
   bool TryRAWCodec(char *buffer, bool &lossyflag) const;
   bool TryJPEGCodec(char *buffer, bool &lossyflag) const;
@@ -145,6 +158,8 @@ protected:
   bool TryJPEGLSCodec(char *buffer, bool &lossyflag) const;
   bool TryJPEG2000Codec(char *buffer, bool &lossyflag) const;
   bool TryRLECodec(char *buffer, bool &lossyflag) const;
+  bool TryFrameParallelDecode(char *buffer, bool &lossyflag) const;
+  bool GetFrameDataElement(unsigned int frame, DataElement &de) const;
 
   bool TryJPEGCodec2(std::ostream &os) const;
   bool TryJPEG2000Codec2(std::ostream &os) const;
@@ -174,6 +189,7 @@ protected:
   // I believe the following 3 ivars can be derived from TS ...
   bool NeedByteSwap;
   bool LossyFlag;
+  unsigned int NumberOfThreads;
 
 private:
   bool GetBufferInternal(char *buffer, bool &lossyflag) const;
@@ -1055,4 +1055,9 @@ void DICOMDIRGenerator::SetDescriptor( const char *d )
   Internals->FileSetID = d;
 }
 
+void DICOMDIRGenerator::SetIndexFileName( const char *filename )
+{
+  Internals->scanner.SetIndexFileName( filename );
+}
+
 } // end namespace gdcm
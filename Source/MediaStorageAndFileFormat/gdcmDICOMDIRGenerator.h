@@ -71,6 +71,11 @@ public:
   /// \warning this need to be a valid VR::CS value
   void SetDescriptor( const char *d );
 
+  /// Set the persistent index used when scanning the files, see
+  /// Scanner::SetIndexFileName. Regenerating the DICOMDIR of a file-set then
+  /// only reads the files added or modified since the last Generate.
+  void SetIndexFileName( const char *filename );
+
   /// Main function to generate the DICOMDIR
   bool Generate();
 
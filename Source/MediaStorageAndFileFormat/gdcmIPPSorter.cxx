@@ -59,6 +59,7 @@ bool IPPSorter::Sort(std::vector<std::string> const & filenames)
   scanner.AddTag( tiop );
   scanner.AddTag( tframe );
   scanner.AddTag( tgantry );
+  scanner.SetIndexFileName( IndexFileName.c_str() );
   bool b = scanner.Scan( filenames );
   if( !b )
     {
@@ -93,12 +93,19 @@ public:
   /// \li ZSpacing could not be computed (Z-Spacing is not constant, or ZTolerance is too low)
   double GetZSpacing() const { return ZSpacing; }
 
+  /// Persistent index of the Image Position (Patient) and Image Orientation
+  /// (Patient) of the files, see Scanner::SetIndexFileName. Sorting the same
+  /// series again only reads the files modified since the last Sort.
+  void SetIndexFileName(const char *filename) { IndexFileName = filename ? filename : ""; }
+  const char *GetIndexFileName() const { return IndexFileName.c_str(); }
+
 protected:
   bool ComputeZSpacing;
   bool DropDuplicatePositions;
   double ZSpacing;
   double ZTolerance;
   double DirCosTolerance;
+  std::string IndexFileName;
 
 private:
   bool ComputeSpacing(std::vector<std::string> const & filenames);
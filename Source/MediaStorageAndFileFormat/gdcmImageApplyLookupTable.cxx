@@ -38,15 +38,11 @@ bool ImageApplyLookupTable::Apply()
   v.resize( len );
   char *p = &v[0];
   image.GetBuffer( p );
-  std::stringstream is;
-  if( !is.write( p, len ) )
-    {
-    gdcmErrorMacro( "Could not write to stringstream" );
-    return false;
-    }
 
   DataElement &de = Output->GetDataElement();
 #if 0
+  std::stringstream is;
+  is.write( p, len );
   std::ostringstream os;
   lut.Decode(is, os);
   const std::string str = os.str();
@@ -16,6 +16,7 @@
 #include "gdcmSequenceOfItems.h"
 #include "gdcmFragment.h"
 #include "gdcmRAWCodec.h"
+#include "gdcmByteValue.h"
 
 namespace gdcm
 {
@@ -93,13 +94,68 @@ bool ImageChangePhotometricInterpretation::ChangeMonochrome()
   return success;
 }
 
+bool ImageChangePhotometricInterpretation::ChangeColorSpace()
+{
+  const Bitmap &image = *Input;
+  const PhotometricInterpretation &pi = image.GetPhotometricInterpretation();
+  if( pi == PI )
+    {
+    return true;
+    }
+  // The equations are only defined for 8 bits samples
+  const PixelFormat &pf = image.GetPixelFormat();
+  if( pf.GetBitsAllocated() != 8 || pf.GetSamplesPerPixel() != 3 )
+    {
+    return false;
+    }
+
+  RAWCodec ic;
+  ic.SetPixelFormat( pf );
+  ic.SetPhotometricInterpretation( pi );
+
+  // Decode straight into the output value, then convert it in place
+  const unsigned long len = image.GetBufferLength();
+  SmartPointer<ByteValue> bv = new ByteValue;
+  bv->SetLength( (VL::Type)len );
+  char *buffer = const_cast<char*>(bv->GetPointer());
+  if( !len || !image.GetBuffer( buffer ) )
+    {
+    return false;
+    }
+  if( image.GetPlanarConfiguration() )
+    {
+    const unsigned int *dims = image.GetDimensions();
+    const size_t framelen = (size_t)dims[0] * dims[1] * 3;
+    std::vector<char> scratch;
+    for( size_t f = 0; f + framelen <= len; f += framelen )
+      {
+      ic.DoPlanarConfiguration( buffer + f, framelen, scratch );
+      }
+    }
+  const bool b = PI == PhotometricInterpretation::RGB
+    ? ic.DoYBRToRGB( buffer, len ) : ic.DoRGBToYBR( buffer, len );
+  if( !b )
+    {
+    return false;
+    }
+
+  DataElement &de = Output->GetDataElement();
+  de.SetValue( *bv );
+  Output->SetPhotometricInterpretation( PI );
+  Output->SetPlanarConfiguration( 0 );
+  if( !Input->GetTransferSyntax().IsImplicit() )
+    {
+    Output->SetTransferSyntax( TransferSyntax::ExplicitVRLittleEndian );
+    }
+  return true;
+}
+
 bool ImageChangePhotometricInterpretation::Change()
 {
   // PS 3.3 - 2008 C.7.6.3.1.2 Photometric Interpretation
   Output = Input;
   if( PI == PhotometricInterpretation::YBR_FULL )
     {
-    assert( Input->GetPhotometricInterpretation() == PhotometricInterpretation::RGB );
     /*
     In the case where Bits Allocated (0028,0100) has a value of 8 then the following equations convert
     between RGB and YCBCR Photometric Interpretation.
@@ -108,7 +164,7 @@ bool ImageChangePhotometricInterpretation::Change()
     CR = + .5000R - .4187G - .0813B + 128
     Note: The above is based on CCIR Recommendation 601-2 dated 1990.
     */
-    return false;
+    return ChangeColorSpace();
     }
   else if( PI == PhotometricInterpretation::RGB )
     {
@@ -119,7 +175,7 @@ bool ImageChangePhotometricInterpretation::Change()
      * 1.0000e+00   -3.4411e-01   -7.1410e-01
      * 1.0000e+00    1.7720e+00   -1.3458e-04
      */
-    return false;
+    return ChangeColorSpace();
     }
   else if( PI == PhotometricInterpretation::MONOCHROME1 || PI == PhotometricInterpretation::MONOCHROME2 )
     {
@@ -36,6 +36,9 @@ public:
   const PhotometricInterpretation &GetPhotometricInterpretation() const { return PI; }
 
   /// Change
+  /// Supported conversions: MONOCHROME1 <-> MONOCHROME2, and for 8 bits pixels
+  /// YBR_FULL, YBR_FULL_422, YBR_PARTIAL_422 -> RGB and RGB -> YBR_FULL. The
+  /// Output pixels are interleaved (Planar Configuration 0).
   bool Change();
 
   /// colorspace converstion (based on CCIR Recommendation 601-2)
@@ -46,6 +49,7 @@ public:
 
 protected:
   bool ChangeMonochrome();
+  bool ChangeColorSpace();
 
 private:
   PhotometricInterpretation PI;
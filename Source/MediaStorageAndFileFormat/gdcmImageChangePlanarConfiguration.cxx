@@ -15,6 +15,7 @@
 #include "gdcmSequenceOfFragments.h"
 #include "gdcmSequenceOfItems.h"
 #include "gdcmFragment.h"
+#include "gdcmPixelKernels.h"
 
 namespace gdcm
 {
@@ -68,7 +69,7 @@ bool ImageChangePlanarConfiguration::Change()
       const char *b = frame + size + size;
 
       char *framecopy = copy + z * framesize;
-      ImageChangePlanarConfiguration::RGBPlanesToRGBPixels(framecopy, r, g, b, size);
+      PixelKernels::PlanarToInterleaved3(framecopy, r, g, b, size);
       }
     }
   else // User requested to do PlanarConfiguration == 1
@@ -82,7 +83,7 @@ bool ImageChangePlanarConfiguration::Change()
       char *g = framecopy + size;
       char *b = framecopy + size + size;
 
-      ImageChangePlanarConfiguration::RGBPixelsToRGBPlanes(r, g, b, frame, size);
+      PixelKernels::InterleavedToPlanar3(r, g, b, frame, size);
       }
     }
   delete[] p;
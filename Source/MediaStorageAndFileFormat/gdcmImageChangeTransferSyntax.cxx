@@ -115,6 +115,7 @@ bool ImageChangeTransferSyntax::TryRLECodec(const DataElement &pixelde, Bitmap c
   const TransferSyntax &ts = GetTransferSyntax();
 
   RLECodec codec;
+  codec.SetNumberOfThreads( NumberOfThreads );
   if( codec.CanCode( ts ) )
     {
     codec.SetDimensions( input.GetDimensions() );
@@ -264,6 +265,7 @@ bool ImageChangeTransferSyntax::TryJPEG2000Codec(const DataElement &pixelde, Bit
   const TransferSyntax &ts = GetTransferSyntax();
 
   JPEG2000Codec j2kcodec;
+  j2kcodec.SetNumberOfThreads( NumberOfThreads );
   ImageCodec *codec = &j2kcodec;
   JPEG2000Codec *usercodec = dynamic_cast<JPEG2000Codec*>(UserCodec);
   if( usercodec && usercodec->CanCode( ts ) )
@@ -39,7 +39,7 @@ class ImageCodec;
 class GDCM_EXPORT ImageChangeTransferSyntax : public ImageToImageFilter
 {
 public:
-  ImageChangeTransferSyntax():TS(TransferSyntax::TS_END),Force(false),CompressIconImage(false),UserCodec(0) {}
+  ImageChangeTransferSyntax():TS(TransferSyntax::TS_END),Force(false),CompressIconImage(false),NumberOfThreads(1),UserCodec(0) {}
   ~ImageChangeTransferSyntax() {}
 
   /// Set target Transfer Syntax
@@ -67,6 +67,12 @@ public:
   /// that UserCodec->CanCode( TransferSyntax )
   void SetUserCodec(ImageCodec *ic) { UserCodec = ic; }
 
+  /// Number of threads used by the codecs able to encode several frames
+  /// concurrently (currently JPEG 2000 and RLE). 0 means one thread per processor.
+  /// Default is 1. A UserCodec keeps its own setting.
+  void SetNumberOfThreads(unsigned int n) { NumberOfThreads = n; }
+  unsigned int GetNumberOfThreads() const { return NumberOfThreads; }
+
 protected:
   bool TryJPEGCodec(const DataElement &pixelde, Bitmap const &input, Bitmap &output);
   bool TryJPEG2000Codec(const DataElement &pixelde, Bitmap const &input, Bitmap &output);
@@ -78,6 +84,7 @@ private:
   TransferSyntax TS;
   bool Force;
   bool CompressIconImage;
+  unsigned int NumberOfThreads;
 
   ImageCodec *UserCodec;
 };
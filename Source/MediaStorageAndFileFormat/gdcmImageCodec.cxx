@@ -14,6 +14,7 @@
 #include "gdcmImageCodec.h"
 #include "gdcmJPEGCodec.h"
 #include "gdcmByteSwap.txx"
+#include "gdcmPixelKernels.h"
 #include "gdcmTrace.h"
 
 #include <iostream>
@@ -57,6 +58,45 @@ bool ImageCodec::GetHeaderInfo(std::istream &, TransferSyntax &)
   return false;
 }
 
+/*
+ * Read only, seekable view of a memory buffer (no copy)
+ */
+class MemoryReadBuf : public std::streambuf
+{
+public:
+  MemoryReadBuf(const char *data, size_t len)
+    {
+    char *p = const_cast<char*>(data);
+    setg(p, p, p + len);
+    }
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+    std::ios_base::openmode which = std::ios_base::in)
+    {
+    if( !(which & std::ios_base::in) ) return pos_type(off_type(-1));
+    off_type base = 0;
+    if( dir == std::ios_base::cur ) base = gptr() - eback();
+    else if( dir == std::ios_base::end ) base = egptr() - eback();
+    const off_type pos = base + off;
+    if( pos < 0 || pos > egptr() - eback() ) return pos_type(off_type(-1));
+    setg(eback(), eback() + pos, egptr());
+    return pos_type(pos);
+    }
+  pos_type seekpos(pos_type pos,
+    std::ios_base::openmode which = std::ios_base::in)
+    {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+bool ImageCodec::GetHeaderInfo(const char *data, size_t len, TransferSyntax &ts)
+{
+  if( !data ) return false;
+  MemoryReadBuf buf( data, len );
+  std::istream is( &buf );
+  return GetHeaderInfo( is, ts );
+}
+
 void ImageCodec::SetLossyFlag(bool l)
 {
   LossyFlag = l;
@@ -94,208 +134,104 @@ void ImageCodec::SetPhotometricInterpretation(
   PI = pi;
 }
 
-bool ImageCodec::DoByteSwap(std::istream &is, std::ostream &os)
+// PS 3.3 C.7.6.3.1.2: the YBR equations are defined for 8 bits samples
+static bool IsColor8(PixelFormat const &pf, size_t len)
 {
-  // FIXME: Do some stupid work:
-  std::streampos start = is.tellg();
-  assert( 0 - start == 0 );
-  is.seekg( 0, std::ios::end);
-  size_t buf_size = (size_t)is.tellg();
-  //assert(buf_size < INT_MAX);
-  char *dummy_buffer = new char[(unsigned int)buf_size];
-  is.seekg(start, std::ios::beg);
-  is.read( dummy_buffer, buf_size);
-  is.seekg(start, std::ios::beg); // reset
-  //SwapCode sc = is.GetSwapCode();
+  return pf.GetBitsAllocated() == 8 && pf.GetSamplesPerPixel() == 3
+    && len % 3 == 0;
+}
 
-  assert( !(buf_size % 2) );
-#ifdef GDCM_WORDS_BIGENDIAN
-  if( PF.GetBitsAllocated() == 16 )
-    {
-    ByteSwap<uint16_t>::SwapRangeFromSwapCodeIntoSystem((uint16_t*)
-      dummy_buffer, SwapCode::LittleEndian, buf_size/2);
-    }
-#else
-  // GE_DLX-8-MONO2-PrivateSyntax.dcm is 8bits
-  //  assert( PF.GetBitsAllocated() == 16 );
-  if ( PF.GetBitsAllocated() == 16 )
+bool ImageCodec::DoYBRToRGB(char *buffer, size_t len)
+{
+  bool partial;
+  switch( PI )
     {
-    ByteSwap<uint16_t>::SwapRangeFromSwapCodeIntoSystem((uint16_t*)
-      dummy_buffer, SwapCode::BigEndian, buf_size/2);
+  case PhotometricInterpretation::YBR_FULL:
+  case PhotometricInterpretation::YBR_FULL_422:
+    partial = false;
+    break;
+  case PhotometricInterpretation::YBR_PARTIAL_422:
+  case PhotometricInterpretation::YBR_PARTIAL_420:
+    partial = true;
+    break;
+  default:
+    return false;
     }
-#endif
-  os.write(dummy_buffer, buf_size);
-  delete[] dummy_buffer;
+  if( !IsColor8(PF, len) ) return false;
+  PixelKernels::YBRToRGB8(buffer, buffer, len / 3, partial);
   return true;
 }
 
-bool ImageCodec::DoYBR(std::istream &is, std::ostream &os)
+bool ImageCodec::DoRGBToYBR(char *buffer, size_t len)
 {
-  // FIXME: Do some stupid work:
-  std::streampos start = is.tellg();
-  assert( 0 - start == 0 );
-  is.seekg( 0, std::ios::end);
-  size_t buf_size = (size_t)is.tellg();
-  //assert(buf_size < INT_MAX);
-  char *dummy_buffer = new char[(unsigned int)buf_size];
-  is.seekg(start, std::ios::beg);
-  is.read( dummy_buffer, buf_size);
-  is.seekg(start, std::ios::beg); // reset
-  //SwapCode sc = is.GetSwapCode();
-
-  // Code is coming from:
-  // http://lestourtereaux.free.fr/papers/data/yuvrgb.pdf
-  assert( !(buf_size % 3) );
-  unsigned long size = (unsigned long)buf_size/3;
-  //assert(buf_size < INT_MAX);
-  unsigned char *copy = new unsigned char[ (unsigned int)buf_size ];
-  memmove( copy, dummy_buffer, (size_t)buf_size);
-assert(0); // Do not use this code !
-  // FIXME FIXME FIXME
-  // The following is bogus: we are doing two operation at once:
-  // Planar configuration AND YBR... doh !
-  const unsigned char *a = copy + 0;
-  const unsigned char *b = copy + size;
-  const unsigned char *c = copy + size + size;
-  int R, G, B;
-
-  unsigned char *p = (unsigned char*)dummy_buffer;
-  for (unsigned long j = 0; j < size; ++j)
-    {
-    R = 38142 *(*a-16) + 52298 *(*c -128);
-    G = 38142 *(*a-16) - 26640 *(*c -128) - 12845 *(*b -128);
-    B = 38142 *(*a-16) + 66093 *(*b -128);
-
-    R = (R+16384)>>15;
-    G = (G+16384)>>15;
-    B = (B+16384)>>15;
-
-    if (R < 0)   R = 0;
-    if (G < 0)   G = 0;
-    if (B < 0)   B = 0;
-    if (R > 255) R = 255;
-    if (G > 255) G = 255;
-    if (B > 255) B = 255;
-
-    *(p++) = (unsigned char)R;
-    *(p++) = (unsigned char)G;
-    *(p++) = (unsigned char)B;
-    a++;
-    b++;
-    c++;
-    }
-  delete[] copy;
-
-  os.write(dummy_buffer, buf_size);
-  delete[] dummy_buffer;
+  if( PI != PhotometricInterpretation::RGB || !IsColor8(PF, len) ) return false;
+  PixelKernels::RGBToYBR8(buffer, buffer, len / 3, false);
   return true;
 }
 
-bool ImageCodec::DoPlanarConfiguration(std::istream &is, std::ostream &os)
+bool ImageCodec::DoUpsampleYBR422(char *buffer, size_t len)
 {
-  // FIXME: Do some stupid work:
-  std::streampos start = is.tellg();
-  assert( 0 - start == 0 );
-  is.seekg( 0, std::ios::end);
-  size_t buf_size = (size_t)is.tellg();
-  //assert(buf_size < INT_MAX);
-  char *dummy_buffer = new char[(unsigned int)buf_size];
-  is.seekg(start, std::ios::beg);
-  is.read( dummy_buffer, buf_size);
-  is.seekg(start, std::ios::beg); // reset
-  //SwapCode sc = is.GetSwapCode();
-
-  // US-RGB-8-epicard.dcm
-  //assert( image.GetNumberOfDimensions() == 3 );
-  assert( buf_size % 3 == 0 );
-  unsigned long size = (unsigned long)buf_size/3;
-  char *copy = new char[ (unsigned int)buf_size ];
-  //memmove( copy, dummy_buffer, buf_size);
-
-  const char *r = dummy_buffer /*copy*/;
-  const char *g = dummy_buffer /*copy*/ + size;
-  const char *b = dummy_buffer /*copy*/ + size + size;
-
-  char *p = copy /*dummy_buffer*/;
-  for (unsigned long j = 0; j < size; ++j)
-    {
-    *(p++) = *(r++);
-    *(p++) = *(g++);
-    *(p++) = *(b++);
-    }
-  delete[] dummy_buffer /*copy*/;
-
-  os.write(copy /*dummy_buffer*/, buf_size);
-  delete[] copy;
+  // Two pixels (6 bytes) are stored as Y1,Y2,CB,CR
+  if( !IsColor8(PF, len) || len % 6 ) return false;
+  const size_t n = len / 6;
+  PixelKernels::UpsampleYBR422(buffer, buffer + 2 * n, n);
   return true;
 }
 
-bool ImageCodec::DoSimpleCopy(std::istream &is, std::ostream &os)
+bool ImageCodec::DoPlanarConfiguration(char *buffer, size_t len,
+  std::vector<char> &scratch)
 {
-#if 1
-  std::streampos start = is.tellg();
-  assert( 0 - start == 0 );
-  is.seekg( 0, std::ios::end);
-  size_t buf_size = (size_t)is.tellg();
-  //assert(buf_size < INT_MAX);
-  char *dummy_buffer = new char[(unsigned int)buf_size];
-  is.seekg(start, std::ios::beg);
-  is.read( dummy_buffer, buf_size);
-  is.seekg(start, std::ios::beg); // reset
-  os.write( dummy_buffer, buf_size);
-  delete[] dummy_buffer ;
-#else
-  // This code is ideal but is failing on an RLE image...need to figure out
-  // what is wrong to reactivate this code.
-  os.rdbuf( is.rdbuf() );
-#endif
-
+  // US-RGB-8-epicard.dcm
+  assert( len % 3 == 0 );
+  const size_t size = len / 3;
+  scratch.assign( buffer, buffer + len );
+
+  const char *r = &scratch[0];
+  const char *g = r + size;
+  const char *b = r + size + size;
+  PixelKernels::PlanarToInterleaved3(buffer, r, g, b, size);
   return true;
 }
 
-bool ImageCodec::DoPaddedCompositePixelCode(std::istream &is, std::ostream &os)
+bool ImageCodec::DoPaddedCompositePixelCode(char *buffer, size_t len,
+  std::vector<char> &scratch)
 {
-  // FIXME: Do some stupid work:
-  std::streampos start = is.tellg();
-  assert( 0 - start == 0 );
-  is.seekg( 0, std::ios::end);
-  size_t buf_size = (size_t)is.tellg();
-  //assert(buf_size < INT_MAX);
-  char *dummy_buffer = new char[(unsigned int)buf_size];
-  is.seekg(start, std::ios::beg);
-  is.read( dummy_buffer, buf_size);
-  is.seekg(start, std::ios::beg); // reset
-  //SwapCode sc = is.GetSwapCode();
-
-  assert( !(buf_size % 2) );
+  // D_CLUNIE_CT2_RLE.dcm: the most significant bytes of all the pixels come
+  // first, then the next ones...
+  scratch.assign( buffer, buffer + len );
+  const char *in = &scratch[0];
+  char *p = buffer;
   if( GetPixelFormat().GetBitsAllocated() == 16 )
     {
-    for(size_t i = 0; i < buf_size/2; ++i)
+    assert( !(len % 2) );
+    const size_t n = len / 2;
+    for(size_t i = 0; i < n; ++i)
       {
 #ifdef GDCM_WORDS_BIGENDIAN
-      os.write( dummy_buffer+i, 1 );
-      os.write( dummy_buffer+i+buf_size/2, 1 );
+      *(p++) = in[i];
+      *(p++) = in[i+n];
 #else
-      os.write( dummy_buffer+i+buf_size/2, 1 );
-      os.write( dummy_buffer+i, 1 );
+      *(p++) = in[i+n];
+      *(p++) = in[i];
 #endif
       }
     }
   else if( GetPixelFormat().GetBitsAllocated() == 32 )
     {
-  assert( !(buf_size % 4) );
-    for(size_t i = 0; i < buf_size/4; ++i)
+    assert( !(len % 4) );
+    const size_t n = len / 4;
+    for(size_t i = 0; i < n; ++i)
       {
 #ifdef GDCM_WORDS_BIGENDIAN
-      os.write( dummy_buffer+i, 1 );
-      os.write( dummy_buffer+i+1*buf_size/4, 1 );
-      os.write( dummy_buffer+i+2*buf_size/4, 1 );
-      os.write( dummy_buffer+i+3*buf_size/4, 1 );
+      *(p++) = in[i];
+      *(p++) = in[i+1*n];
+      *(p++) = in[i+2*n];
+      *(p++) = in[i+3*n];
 #else
-      os.write( dummy_buffer+i+3*buf_size/4, 1 );
-      os.write( dummy_buffer+i+2*buf_size/4, 1 );
-      os.write( dummy_buffer+i+1*buf_size/4, 1 );
-      os.write( dummy_buffer+i, 1 );
+      *(p++) = in[i+3*n];
+      *(p++) = in[i+2*n];
+      *(p++) = in[i+1*n];
+      *(p++) = in[i];
 #endif
       }
     }
@@ -303,7 +239,6 @@ bool ImageCodec::DoPaddedCompositePixelCode(std::istream &is, std::ostream &os)
     {
     return false;
     }
-  delete[] dummy_buffer;
   return true;
 }
 
@@ -375,86 +310,16 @@ bool ImageCodec::DoInvertMonochrome(std::istream &is, std::ostream &os)
   return true;
 }
 
-struct ApplyMask
+// Byte swap and/or cleanup the unused bits of 16 bits pixels, in a single
+// pass
+bool ImageCodec::DoByteSwapAndOverlayCleanup(char *buffer, size_t len,
+  bool byteswap, bool cleanup)
 {
-  uint16_t operator()(uint16_t c) const {
-    return (uint16_t)((c >> (BitsStored - HighBit - 1)) & pmask);
-  }
-  unsigned short BitsStored;
-  unsigned short HighBit;
-  uint16_t pmask;
-};
-
-// Cleanup the unused bits
-bool ImageCodec::DoOverlayCleanup(std::istream &is, std::ostream &os)
-{
-  assert( PF.GetBitsAllocated() > 8 );
-  if( PF.GetBitsAllocated() == 16 )
-    {
-    // pmask : to mask the 'unused bits' (may contain overlays)
-    uint16_t pmask = 0xffff;
-    pmask = (uint16_t)(pmask >> ( PF.GetBitsAllocated() - PF.GetBitsStored() ));
-
-    if( PF.GetPixelRepresentation() )
-      {
-      // smask : to check the 'sign' when BitsStored != BitsAllocated
-      uint16_t smask = 0x0001;
-      smask = (uint16_t)(
-        smask << ( 16 - (PF.GetBitsAllocated() - PF.GetBitsStored() + 1) ));
-      // nmask : to propagate sign bit on negative values
-      int16_t nmask = (int16_t)0x8000;
-      nmask = (int16_t)(nmask >> ( PF.GetBitsAllocated() - PF.GetBitsStored() - 1 ));
-
-      uint16_t c;
-      while( is.read((char*)&c,2) )
-        {
-        c = (uint16_t)(c >> (PF.GetBitsStored() - PF.GetHighBit() - 1));
-        if ( c & smask )
-          {
-          c = (uint16_t)(c | nmask);
-          }
-        else
-          {
-          c = c & pmask;
-          }
-        os.write((char*)&c, 2 );
-        }
-      }
-    else // Pixel are unsigned
-      {
-#if 1
-      uint16_t c;
-      while( is.read((char*)&c,2) )
-        {
-        c = (uint16_t)(
-          (c >> (PF.GetBitsStored() - PF.GetHighBit() - 1)) & pmask);
-        os.write((char*)&c, 2 );
-        }
-      //os.rdbuf( is.rdbuf() );
-#else
-      //std::ostreambuf_iterator<char> end_of_stream_iterator;
-      //std::ostreambuf_iterator<char> out_iter(os.rdbuf());
-      //while( out_iter != end_of_stream_iterator )
-      //  {
-      //  *out_iter =
-      //    (*out_iter >> (PF.GetBitsStored() - PF.GetHighBit() - 1)) & pmask;
-      //  }
-      std::istreambuf_iterator<int> it_in(is);
-      std::istreambuf_iterator<int> eos;
-      std::ostreambuf_iterator<int> it_out(os);
-      ApplyMask am;
-      am.BitsStored = PF.GetBitsStored();
-      am.HighBit = PF.GetHighBit();
-      am.pmask = pmask;
-
-      std::transform(it_in, eos, it_out, am);
-#endif
-      }
-    }
-  else
-    {
-    assert(0); // TODO
-    }
+  if( PF.GetBitsAllocated() != 16 ) return false;
+  assert( !(len % 2) );
+  PixelKernels::ByteSwapAndCleanup16(buffer, len / 2, byteswap,
+    cleanup ? PF.GetBitsStored() : (unsigned short)16, PF.GetHighBit(),
+    PF.GetPixelRepresentation() != 0);
   return true;
 }
 
@@ -464,32 +329,28 @@ bool ImageCodec::Decode(DataElement const &, DataElement &)
 }
 
 bool ImageCodec::DecodeByStreams(std::istream &is, std::ostream &os)
+{
+  // Read the input once, post-process it in place and write it once
+  std::streampos start = is.tellg();
+  assert( 0 - start == 0 );
+  is.seekg( 0, std::ios::end);
+  size_t buf_size = (size_t)is.tellg();
+  std::vector<char> buffer( buf_size );
+  is.seekg(start, std::ios::beg);
+  if( buf_size ) is.read( &buffer[0], buf_size );
+  is.seekg(start, std::ios::beg); // reset
+
+  if( !DecodeInPlace( buf_size ? &buffer[0] : 0, buf_size ) )
+    return false;
+  if( buf_size ) os.write( &buffer[0], buf_size );
+  return true;
+}
+
+bool ImageCodec::DecodeInPlace(char *buffer, size_t len)
 {
   assert( PlanarConfiguration == 0 || PlanarConfiguration == 1);
   assert( PI != PhotometricInterpretation::UNKNOWN );
-  std::stringstream bs_os; // ByteSwap
-  std::stringstream pcpc_os; // Padded Composite Pixel Code
-  std::stringstream pi_os; // PhotometricInterpretation
-  std::stringstream pl_os; // PlanarConf
-  std::istream *cur_is = &is;
-
-  // First thing do the byte swap:
-  if( NeedByteSwap )
-    {
-    // MR_GE_with_Private_Compressed_Icon_0009_1110.dcm
-    DoByteSwap(*cur_is,bs_os);
-    cur_is = &bs_os;
-    }
-  if ( RequestPaddedCompositePixelCode )
-    {
-    // D_CLUNIE_CT2_RLE.dcm
-    DoPaddedCompositePixelCode(*cur_is,pcpc_os);
-    cur_is = &pcpc_os;
-    }
 
-  // Second thing do palette color.
-  // This way PALETTE COLOR will be applied before we do
-  // Planar Configuration
   switch(PI)
     {
   case PhotometricInterpretation::MONOCHROME2:
@@ -502,8 +363,8 @@ bool ImageCodec::DecodeByStreams(std::istream &is, std::ostream &os)
     //cur_is = &pi_os;
     break;
   case PhotometricInterpretation::YBR_FULL:
-    //DoYBR(*cur_is,pi_os);
-    //cur_is = &pi_os;
+    // The conversion to RGB is left to the application, see
+    // ImageChangePhotometricInterpretation
     {
       const JPEGCodec *c = dynamic_cast<const JPEGCodec*>(this);
       if( c )
@@ -521,16 +382,10 @@ bool ImageCodec::DecodeByStreams(std::istream &is, std::ostream &os)
     // Nothing needs to be done
     break;
   case PhotometricInterpretation::YBR_FULL_422:
-      {
-      // US-GE-4AICL142.dcm
-      // Hopefully it has been done by the JPEG decoder itself...
-      const JPEGCodec *c = dynamic_cast<const JPEGCodec*>(this);
-      if( !c )
-        {
-        gdcmErrorMacro( "YBR_FULL_422 is not implemented in GDCM. Image will be displayed incorrectly" );
-        //this->SetPhotometricInterpretation( PhotometricInterpretation::RGB );
-        }
-      }
+  case PhotometricInterpretation::YBR_PARTIAL_422:
+    // US-GE-4AICL142.dcm
+    // The chroma has already been upsampled: by the JPEG decoder itself, or
+    // by RAWCodec (see DoUpsampleYBR422)
     break;
   case PhotometricInterpretation::YBR_ICT:
     break;
@@ -542,36 +397,44 @@ bool ImageCodec::DecodeByStreams(std::istream &is, std::ostream &os)
     assert(0);
     }
 
-  if( /*PlanarConfiguration ||*/ RequestPlanarConfiguration )
-    {
-    DoPlanarConfiguration(*cur_is,pl_os);
-    cur_is = &pl_os;
-    }
-
+  const bool is16 = PF.GetBitsAllocated() == 16;
+  // MR_GE_with_Private_Compressed_Icon_0009_1110.dcm
+  bool byteswap = NeedByteSwap && is16;
   // Do the overlay cleanup (cleanup the unused bits)
-  // must be the last operation (duh!)
-  if ( PF.GetBitsAllocated() != PF.GetBitsStored()
-    && PF.GetBitsAllocated() != 8 )
+  // Technically we should only run this operation if the image declares it has overlay AND
+  // there is no (0x60xx,0x3000) element, for example:
+  // - XA_GE_JPEG_02_with_Overlays.dcm
+  // - SIEMENS_GBS_III-16-ACR_NEMA_1.acr
+  // Sigh, I finally found someone not declaring that unused bits where not zero:
+  // gdcmConformanceTests/dcm4chee_unusedbits_not_zero.dcm
+  const bool cleanup = NeedOverlayCleanup && is16
+    && PF.GetBitsAllocated() != PF.GetBitsStored();
+
+  if ( RequestPaddedCompositePixelCode || RequestPlanarConfiguration )
     {
-    // Technically we should only run this operation if the image declares it has overlay AND
-    // there is no (0x60xx,0x3000) element, for example:
-    // - XA_GE_JPEG_02_with_Overlays.dcm
-    // - SIEMENS_GBS_III-16-ACR_NEMA_1.acr
-    // Sigh, I finally found someone not declaring that unused bits where not zero:
-    // gdcmConformanceTests/dcm4chee_unusedbits_not_zero.dcm
-    if( NeedOverlayCleanup )
-      DoOverlayCleanup(*cur_is,os);
-    else
+    std::vector<char> scratch;
+    // The byte swap applies to the input layout, do it before reordering
+    if( byteswap )
+      {
+      DoByteSwapAndOverlayCleanup(buffer, len, true, false);
+      byteswap = false;
+      }
+    // D_CLUNIE_CT2_RLE.dcm
+    if ( RequestPaddedCompositePixelCode
+      && !DoPaddedCompositePixelCode(buffer, len, scratch) )
       {
-      // Once the issue with IMAGES/JPLY/RG3_JPLY aka gdcmData/D_CLUNIE_RG3_JPLY.dcm is solved the previous
-      // code will be replace with a simple call to:
-      DoSimpleCopy(*cur_is,os);
+      return false;
+      }
+    if( /*PlanarConfiguration ||*/ RequestPlanarConfiguration )
+      {
+      DoPlanarConfiguration(buffer, len, scratch);
       }
     }
-  else
+
+  // The overlay cleanup must be the last operation (duh!)
+  if( byteswap || cleanup )
     {
-    assert( PF.GetBitsAllocated() == PF.GetBitsStored() );
-    DoSimpleCopy(*cur_is,os);
+    DoByteSwapAndOverlayCleanup(buffer, len, byteswap, cleanup);
     }
 
   return true;
@@ -20,6 +20,8 @@
 #include "gdcmSmartPointer.h"
 #include "gdcmPixelFormat.h"
 
+#include <vector>
+
 namespace gdcm
 {
 
@@ -41,11 +43,23 @@ public:
   bool GetLossyFlag() const;
 
   virtual bool GetHeaderInfo(std::istream &is_, TransferSyntax &ts);
+  /// Probe the header found at the start of the (first fragment) data of
+  /// length len, without decoding nor copying the pixels. On success
+  /// IsLossy(), GetPixelFormat() (and for most codecs the dimensions) describe
+  /// the encapsulated stream and ts is set to the matching Transfer Syntax.
+  /// The default implementation reads from the memory in place through
+  /// GetHeaderInfo(std::istream&)
+  virtual bool GetHeaderInfo(const char *data, size_t len, TransferSyntax &ts);
 
   virtual ImageCodec * Clone() const = 0;
 
 protected:
   bool DecodeByStreams(std::istream &is_, std::ostream &os);
+  /// Post-process decoded pixels in place: byte swap, padded composite pixel
+  /// code, planar configuration and overlay cleanup, as requested. The
+  /// element wise transforms are fused in a single pass over \p buffer, only
+  /// the reorderings need a (single) copy of the input.
+  bool DecodeInPlace(char *buffer, size_t len);
   virtual bool IsValid(PhotometricInterpretation const &pi);
 public:
 
@@ -134,12 +148,17 @@ protected:
   unsigned int NumberOfDimensions;
   bool LossyFlag;
 
-  bool DoOverlayCleanup(std::istream &is_, std::ostream &os);
-  bool DoByteSwap(std::istream &is_, std::ostream &os);
-  bool DoYBR(std::istream &is_, std::ostream &os);
-  bool DoPlanarConfiguration(std::istream &is_, std::ostream &os);
-  bool DoSimpleCopy(std::istream &is_, std::ostream &os);
-  bool DoPaddedCompositePixelCode(std::istream &is_, std::ostream &os);
+  bool DoByteSwapAndOverlayCleanup(char *buffer, size_t len, bool byteswap, bool cleanup);
+  /// Convert in place 8 bits YBR_FULL (YBR_FULL_422, YBR_PARTIAL_422,
+  /// YBR_PARTIAL_420 once upsampled) interleaved pixels into RGB
+  bool DoYBRToRGB(char *buffer, size_t len);
+  /// Convert in place 8 bits RGB interleaved pixels into YBR_FULL
+  bool DoRGBToYBR(char *buffer, size_t len);
+  /// Upsample in place 8 bits 4:2:2 pixels: the len * 2 / 3 bytes stored at
+  /// the end of buffer become len bytes of YBR pixels
+  bool DoUpsampleYBR422(char *buffer, size_t len);
+  bool DoPlanarConfiguration(char *buffer, size_t len, std::vector<char> &scratch);
+  bool DoPaddedCompositePixelCode(char *buffer, size_t len, std::vector<char> &scratch);
   bool DoInvertMonochrome(std::istream &is_, std::ostream &os);
 
   //template <typename T>
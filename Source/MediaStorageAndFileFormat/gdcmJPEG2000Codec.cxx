@@ -17,6 +17,7 @@
 #include "gdcmDataElement.h"
 #include "gdcmSequenceOfFragments.h"
 #include "gdcmSwapper.h"
+#include "gdcmWorkerPool.h"
 
 #include <cstring>
 #include <numeric>
@@ -212,13 +213,14 @@ inline int int_ceildivpow2(int a, int b) {
 class JPEG2000Internals
 {
 public:
-  JPEG2000Internals()
+  JPEG2000Internals():nthreads(1)
     {
     memset(&coder_param, 0, sizeof(coder_param));
     opj_set_default_encoder_parameters(&coder_param);
     }
 
   opj_cparameters coder_param;
+  unsigned int nthreads;
 };
 
 void JPEG2000Codec::SetRate(unsigned int idx, double rate)
@@ -269,6 +271,16 @@ void JPEG2000Codec::SetReversible(bool res)
   Internals->coder_param.irreversible = !res;
 }
 
+void JPEG2000Codec::SetNumberOfThreads(unsigned int n)
+{
+  Internals->nthreads = n;
+}
+
+unsigned int JPEG2000Codec::GetNumberOfThreads() const
+{
+  return Internals->nthreads;
+}
+
 JPEG2000Codec::JPEG2000Codec()
 {
   Internals = new JPEG2000Internals;
@@ -419,7 +431,8 @@ static inline bool check_comp_valid(opj_image_t *image)
     return !invalid;
 }
 
-std::pair<char *, size_t> JPEG2000Codec::DecodeByStreamsCommon(char *dummy_buffer, size_t buf_size)
+std::pair<char *, size_t> JPEG2000Codec::DecodeByStreamsCommon(char *dummy_buffer, size_t buf_size,
+  char *out, size_t outlen)
 {
   opj_dparameters_t parameters;  /* decompression parameters */
 #if OPENJPEG_MAJOR_VERSION == 1
@@ -638,7 +651,27 @@ std::pair<char *, size_t> JPEG2000Codec::DecodeByStreamsCommon(char *dummy_buffe
 
   // Copy buffer
   unsigned long len = Dimensions[0]*Dimensions[1] * (PF.GetBitsAllocated() / 8) * image->numcomps;
-  char *raw = new char[len];
+  bool fits = !out || len == outlen;
+  // The samples of a component declared with another precision would not
+  // fit in the frame either (the whole image is left to the caller then)
+  for (unsigned int compno = 0; out && compno < (unsigned int)image->numcomps; compno++)
+    {
+    const unsigned int prec = (unsigned int)image->comps[compno].prec;
+    const unsigned int bytes = prec <= 8 ? 1 : prec <= 16 ? 2 : 4;
+    if( bytes * 8 != PF.GetBitsAllocated() ) fits = false;
+    }
+  if( !fits )
+    {
+    gdcmDebugMacro( "JPEG 2000 frame length is " << len << " instead of " << outlen );
+#if OPENJPEG_MAJOR_VERSION == 1
+    opj_destroy_decompress(dinfo);
+#elif OPENJPEG_MAJOR_VERSION == 2
+    opj_destroy_codec(dinfo);
+#endif // OPENJPEG_MAJOR_VERSION == 1
+    opj_image_destroy(image);
+    return std::make_pair<char*,size_t>(0,0);
+    }
+  char *raw = out ? out : new char[len];
   //assert( len == fsrc->len );
   for (unsigned int compno = 0; compno < (unsigned int)image->numcomps; compno++)
     {
@@ -737,6 +770,15 @@ std::pair<char *, size_t> JPEG2000Codec::DecodeByStreamsCommon(char *dummy_buffe
   return std::make_pair(raw,len);
 }
 
+bool JPEG2000Codec::DecodeFrame(const char *in, size_t inlen, char *out, size_t outlen)
+{
+  if( !in || !inlen || !out ) return false;
+  // The codestream is only read from
+  std::pair<char*,size_t> raw_len =
+    this->DecodeByStreamsCommon(const_cast<char*>(in), inlen, out, outlen);
+  return raw_len.first == out && raw_len.second == outlen;
+}
+
 bool JPEG2000Codec::DecodeByStreams(std::istream &is, std::ostream &os)
 {
   // FIXME: Do some stupid work:
@@ -1131,6 +1173,58 @@ bool JPEG2000Codec::CodeFrameIntoBuffer(char * outdata, size_t outlen, size_t &
   return success;
 }
 
+/*
+ * Encode the frames from the worker threads (each call to
+ * CodeFrameIntoBuffer uses its own OpenJPEG codec and buffers), and append
+ * the fragments from the thread calling Code, in frame order.
+ */
+class JPEG2000CodeJob : public WorkerPool::Job
+{
+public:
+  JPEG2000CodeJob(JPEG2000Codec &codec, const char *input, size_t image_len,
+    size_t outlen, SequenceOfFragments &sq, unsigned int nframes):Codec(codec),
+    Input(input),ImageLen(image_len),OutLen(outlen),SQ(sq),Frames(nframes),
+    Success(true) {}
+
+  void Execute(unsigned int frame)
+    {
+    std::vector<char> rgbyteCompressed;
+    rgbyteCompressed.resize(OutLen);
+
+    size_t cbyteCompressed;
+    const bool b = Codec.CodeFrameIntoBuffer((char*)&rgbyteCompressed[0], rgbyteCompressed.size(), cbyteCompressed, Input + frame * ImageLen, ImageLen );
+    if( !b ) return;
+    assert( cbyteCompressed <= rgbyteCompressed.size() ); // default alloc would be bogus
+    // Only keep the compressed bytes until Finish:
+    Frames[frame].assign( rgbyteCompressed.begin(), rgbyteCompressed.begin() + cbyteCompressed );
+    }
+
+  void Finish(unsigned int frame)
+    {
+    std::vector<char> &compressed = Frames[frame];
+    if( !Success || compressed.empty() )
+      {
+      Success = false;
+      return;
+      }
+    Fragment frag;
+    frag.SetByteValue( &compressed[0], (uint32_t)compressed.size() );
+    SQ.AddFragment( frag );
+    std::vector<char>().swap( compressed );
+    }
+
+  bool GetSuccess() const { return Success; }
+
+private:
+  JPEG2000Codec &Codec;
+  const char *Input;
+  const size_t ImageLen;
+  const size_t OutLen;
+  SequenceOfFragments &SQ;
+  std::vector< std::vector<char> > Frames;
+  bool Success;
+};
+
 // Compress into JPEG
 bool JPEG2000Codec::Code(DataElement const &in, DataElement &out)
 {
@@ -1147,24 +1241,12 @@ bool JPEG2000Codec::Code(DataElement const &in, DataElement &out)
   const char *input = bv->GetPointer();
   unsigned long len = bv->GetLength();
   unsigned long image_len = len / dims[2];
-  size_t inputlength = image_len;
-
-  for(unsigned int dim = 0; dim < dims[2]; ++dim)
-    {
-    const char *inputdata = input + dim * image_len;
-
-    std::vector<char> rgbyteCompressed;
-    rgbyteCompressed.resize(image_width * image_height * 4);
-
-    size_t cbyteCompressed;
-    const bool b = this->CodeFrameIntoBuffer((char*)&rgbyteCompressed[0], rgbyteCompressed.size(), cbyteCompressed, inputdata, inputlength );
-    if( !b ) return false;
 
-    Fragment frag;
-    assert( cbyteCompressed <= rgbyteCompressed.size() ); // default alloc would be bogus
-    frag.SetByteValue( &rgbyteCompressed[0], (uint32_t)cbyteCompressed );
-    sq->AddFragment( frag );
-    }
+  JPEG2000CodeJob job(*this, input, image_len, image_width * image_height * 4, *sq, dims[2]);
+  WorkerPool pool;
+  pool.SetNumberOfThreads( Internals->nthreads );
+  pool.Run( job, dims[2] );
+  if( !job.GetSuccess() ) return false;
 
   assert( sq->GetNumberOfFragments() == dims[2] );
   out.SetValue( *sq );
@@ -1663,6 +1745,7 @@ bool JPEG2000Codec::DecodeExtent(
 ImageCodec * JPEG2000Codec::Clone() const
 {
   JPEG2000Codec * copy = new JPEG2000Codec;
+  copy->SetNumberOfThreads( GetNumberOfThreads() );
   return copy;
 }
 
@@ -31,6 +31,7 @@ class GDCM_EXPORT JPEG2000Codec : public ImageCodec
 {
 friend class ImageRegionReader;
   friend class Bitmap;
+  friend class JPEG2000CodeJob;
 public:
   JPEG2000Codec();
   ~JPEG2000Codec();
@@ -42,8 +43,14 @@ public:
   bool Code(DataElement const &in, DataElement &out);
 
   virtual bool GetHeaderInfo(std::istream &is, TransferSyntax &ts);
+  /// Only the main header of the codestream is read, tiles are not decoded
+  virtual bool GetHeaderInfo(const char * dummy_buffer, size_t len, TransferSyntax &ts);
   virtual ImageCodec * Clone() const;
 
+  /// Decode one JPEG 2000 frame (codestream) of inlen bytes straight into
+  /// out, which must be exactly the size of the decoded frame.
+  bool DecodeFrame(const char *in, size_t inlen, char *out, size_t outlen);
+
   // JPEG-2000 / OpenJPEG specific way of encoding lossy-ness
   // ref: http://www.openjpeg.org/index.php?menu=doc#encoder
   void SetRate(unsigned int idx, double rate);
@@ -58,6 +65,11 @@ public:
 
   void SetReversible(bool res);
 
+  /// Number of frames encoded concurrently by Code (default: 1). 0 means
+  /// one thread per processor. Fragments are always in frame order.
+  void SetNumberOfThreads(unsigned int n);
+  unsigned int GetNumberOfThreads() const;
+
 protected:
   bool DecodeExtent(
     char *buffer,
@@ -77,9 +89,11 @@ protected:
   bool StopEncode( std::ostream & );
 
 private:
-  std::pair<char *, size_t> DecodeByStreamsCommon(char *dummy_buffer, size_t buf_size);
+  /// Decode into out when set (of outlen bytes), into a new[] buffer
+  /// otherwise
+  std::pair<char *, size_t> DecodeByStreamsCommon(char *dummy_buffer, size_t buf_size,
+    char *out = NULL, size_t outlen = 0);
   bool CodeFrameIntoBuffer(char * outdata, size_t outlen, size_t & complen, const char * indata, size_t inlen );
-  bool GetHeaderInfo(const char * dummy_buffer, size_t len, TransferSyntax &ts);
   JPEG2000Internals *Internals;
 };
 
@@ -55,6 +55,7 @@ public:
   bool Code(DataElement const &in, DataElement &out);
 
   virtual bool GetHeaderInfo(std::istream &is, TransferSyntax &ts);
+  using ImageCodec::GetHeaderInfo;
   virtual ImageCodec * Clone() const;
 
   //void SetReversible(bool res);
@@ -49,23 +49,26 @@ bool JPEGLSCodec::GetLossless() const
 
 bool JPEGLSCodec::GetHeaderInfo(std::istream &is, TransferSyntax &ts)
 {
-#ifndef GDCM_USE_JPEGLS
-  return false;
-#else
   is.seekg( 0, std::ios::end);
   size_t buf_size = (size_t)is.tellg();
-  //assert(buf_size < INT_MAX);
-  char *dummy_buffer = new char[(unsigned int)buf_size];
+  std::vector<char> dummy_buffer( buf_size );
   is.seekg(0, std::ios::beg);
-  is.read( dummy_buffer, buf_size);
+  if( buf_size ) is.read( &dummy_buffer[0], buf_size);
+  return GetHeaderInfo( buf_size ? &dummy_buffer[0] : 0, buf_size, ts );
+}
 
+bool JPEGLSCodec::GetHeaderInfo(const char *data, size_t len, TransferSyntax &ts)
+{
+#ifndef GDCM_USE_JPEGLS
+  (void)data; (void)len; (void)ts;
+  return false;
+#else
+  if( !data ) return false;
   JlsParameters metadata = {};
-  //assert(buf_size < INT_MAX);
-  if (JpegLsReadHeader(dummy_buffer, (unsigned int)buf_size, &metadata) != OK)
+  if (JpegLsReadHeader(data, len, &metadata) != OK)
     {
     return false;
     }
-  delete[] dummy_buffer;
 
   // $1 = {width = 512, height = 512, bitspersample = 8, components = 1, allowedlossyerror = 0, ilv = ILV_NONE, colorTransform = 0, custom = {MAXVAL = 0, T1 = 0, T2 = 0, T3 = 0, RESET = 0}}
 
@@ -149,10 +152,30 @@ bool JPEGLSCodec::CanCode(TransferSyntax const &ts) const
 #endif
 }
 
-bool JPEGLSCodec::DecodeByStreamsCommon(char *buffer, size_t totalLen, std::vector<unsigned char> &rgbyteOut)
+#ifdef GDCM_USE_JPEGLS
+/// Length of a decoded frame, as described by its JPEG-LS header
+static size_t GetFrameLength(JlsParameters const &params)
 {
-  const BYTE* pbyteCompressed = (const BYTE*)buffer;
-  size_t cbyteCompressed = totalLen;
+  return (size_t)params.height * params.width
+    * ((params.bitspersample + 7) / 8) * params.components;
+}
+#endif
+
+bool JPEGLSCodec::DecodeFrame(const char *in, size_t inlen, char *out, size_t outlen)
+{
+#ifndef GDCM_USE_JPEGLS
+  (void)in; (void)inlen; (void)out; (void)outlen;
+  return false;
+#else
+  if( !in || !out ) return false;
+  const BYTE* pbyteCompressed = (const BYTE*)in;
+  // Skip the padding after the EOI marker
+  size_t cbyteCompressed = inlen;
+  while( cbyteCompressed > 0 && pbyteCompressed[cbyteCompressed-1] != 0xd9 )
+    {
+    cbyteCompressed--;
+    }
+  if( !cbyteCompressed ) cbyteCompressed = inlen;
 
   JlsParameters params = {};
   if(JpegLsReadHeader(pbyteCompressed, cbyteCompressed, &params) != OK )
@@ -164,9 +187,14 @@ bool JPEGLSCodec::DecodeByStreamsCommon(char *buffer, size_t totalLen, std::vect
   // allowedlossyerror == 0 => Lossless
   LossyFlag = params.allowedlossyerror!= 0;
 
-  rgbyteOut.resize(params.height *params.width * ((params.bitspersample + 7) / 8) * params.components);
+  if( GetFrameLength(params) != outlen )
+    {
+    gdcmDebugMacro( "JPEG-LS frame length is " << GetFrameLength(params)
+      << " instead of " << outlen );
+    return false;
+    }
 
-  JLS_ERROR result = JpegLsDecode(&rgbyteOut[0], rgbyteOut.size(), pbyteCompressed, cbyteCompressed, &params);
+  JLS_ERROR result = JpegLsDecode(out, outlen, pbyteCompressed, cbyteCompressed, &params);
 
   if (result != OK)
     {
@@ -175,92 +203,120 @@ bool JPEGLSCodec::DecodeByStreamsCommon(char *buffer, size_t totalLen, std::vect
     }
 
   return true;
+#endif
 }
 
-bool JPEGLSCodec::Decode(DataElement const &in, DataElement &out)
+bool JPEGLSCodec::DecodeByStreamsCommon(char *buffer, size_t totalLen, std::vector<unsigned char> &rgbyteOut)
 {
 #ifndef GDCM_USE_JPEGLS
+  (void)buffer; (void)totalLen; (void)rgbyteOut;
   return false;
 #else
-  if( NumberOfDimensions == 2 )
+  JlsParameters params = {};
+  if( !buffer || JpegLsReadHeader(buffer, totalLen, &params) != OK )
     {
-    const SequenceOfFragments *sf = in.GetSequenceOfFragments();
-    assert( sf );
-    unsigned long totalLen = sf->ComputeByteLength();
-    char *buffer = new char[totalLen];
-    sf->GetBuffer(buffer, totalLen);
-
-    std::vector<BYTE> rgbyteOut;
-    bool b = DecodeByStreamsCommon(buffer, totalLen, rgbyteOut);
-    if( !b ) return false;
-    delete[] buffer;
-
-    out = in;
+    gdcmDebugMacro( "Could not parse JPEG-LS header" );
+    return false;
+    }
+  rgbyteOut.resize( GetFrameLength(params) );
+  return !rgbyteOut.empty()
+    && DecodeFrame(buffer, totalLen, (char*)&rgbyteOut[0], rgbyteOut.size());
+#endif
+}
 
-    out.SetByteValue( (char*)&rgbyteOut[0], (uint32_t)rgbyteOut.size() );
-    return true;
+bool JPEGLSCodec::Decode(DataElement const &in, char *out, size_t outlen)
+{
+  const SequenceOfFragments *sf = in.GetSequenceOfFragments();
+  if( !sf || !out ) return false;
+  if( NumberOfDimensions == 2 )
+    {
+    if( sf->GetNumberOfFragments() == 1 )
+      {
+      const ByteValue *bv = sf->GetFragment(0).GetByteValue();
+      return bv && DecodeFrame(bv->GetPointer(), bv->GetLength(), out, outlen);
+      }
+    // The JPEG-LS frame was split across several fragments
+    std::vector<char> frame( sf->ComputeByteLength() );
+    if( frame.empty() || !sf->GetBuffer(&frame[0], (unsigned long)frame.size()) )
+      return false;
+    return DecodeFrame(&frame[0], frame.size(), out, outlen);
     }
   else if( NumberOfDimensions == 3 )
     {
-    const SequenceOfFragments *sf = in.GetSequenceOfFragments();
-    assert( sf );
-    gdcmAssertAlwaysMacro( sf->GetNumberOfFragments() == Dimensions[2] );
-    std::stringstream os;
-    for(unsigned int i = 0; i < sf->GetNumberOfFragments(); ++i)
+    const size_t nframes = sf->GetNumberOfFragments();
+    if( nframes != Dimensions[2] )
       {
-      const Fragment &frag = sf->GetFragment(i);
-      if( frag.IsEmpty() ) return false;
-      const ByteValue *bv = frag.GetByteValue();
-      assert( bv );
-      size_t totalLen = bv->GetLength();
-      char *mybuffer = new char[totalLen];
-
-      bv->GetBuffer(mybuffer, bv->GetLength());
-
-      const BYTE* pbyteCompressed = (const BYTE*)mybuffer;
-      while( totalLen > 0 && pbyteCompressed[totalLen-1] != 0xd9 )
-        {
-        totalLen--;
-        }
-      // what if 0xd9 is never found ?
-      assert( totalLen > 0 && pbyteCompressed[totalLen-1] == 0xd9 );
-
-      size_t cbyteCompressed = totalLen;
-
-      JlsParameters params = {};
-      if( JpegLsReadHeader(pbyteCompressed, cbyteCompressed, &params) != OK )
-        {
-        gdcmDebugMacro( "Could not parse JPEG-LS header" );
-        return false;
-        }
-
-      // allowedlossyerror == 0 => Lossless
-      LossyFlag = params.allowedlossyerror!= 0;
-
-      std::vector<BYTE> rgbyteOut;
-      rgbyteOut.resize(params.height *params.width * ((params.bitspersample + 7) / 8) * params.components);
-
-      JLS_ERROR result = JpegLsDecode(&rgbyteOut[0], rgbyteOut.size(), pbyteCompressed, cbyteCompressed, &params);
-      bool r = true;
-
-      delete[] mybuffer;
-      if (result != OK)
+      gdcmErrorMacro( "Invalid number of fragments: " << nframes << " should be: " << Dimensions[2] );
+      return false;
+      }
+    if( outlen % nframes ) return false;
+    const size_t framelen = outlen / nframes;
+    bool lossy = false;
+    for(unsigned int i = 0; i < nframes; ++i)
+      {
+      const ByteValue *bv = sf->GetFragment(i).GetByteValue();
+      if( !bv || !DecodeFrame(bv->GetPointer(), bv->GetLength(), out + i * framelen, framelen) )
         {
+        gdcmDebugMacro( "JPEG-LS pb with frag: " << i );
         return false;
         }
-      os.write( (char*)&rgbyteOut[0], rgbyteOut.size() );
-
-      if(!r) return false;
-      assert( r == true );
+      lossy = lossy || LossyFlag;
       }
-    std::string str = os.str();
-    assert( str.size() );
-    out.SetByteValue( &str[0], (uint32_t)str.size() );
-
+    LossyFlag = lossy;
     return true;
     }
   return false;
+}
 
+bool JPEGLSCodec::Decode(DataElement const &in, DataElement &out)
+{
+#ifndef GDCM_USE_JPEGLS
+  return false;
+#else
+  const SequenceOfFragments *sf = in.GetSequenceOfFragments();
+  if( !sf || !sf->GetNumberOfFragments() ) return false;
+  const char *first;
+  size_t firstlen;
+  std::vector<char> frame;
+  if( NumberOfDimensions == 2 && sf->GetNumberOfFragments() > 1 )
+    {
+    // The JPEG-LS frame was split across several fragments
+    frame.resize( sf->ComputeByteLength() );
+    if( frame.empty() || !sf->GetBuffer(&frame[0], (unsigned long)frame.size()) )
+      return false;
+    first = &frame[0];
+    firstlen = frame.size();
+    }
+  else
+    {
+    const ByteValue *bv = sf->GetFragment(0).GetByteValue();
+    if( !bv ) return false;
+    first = bv->GetPointer();
+    firstlen = bv->GetLength();
+    }
+  // The output length is the one of the frames, as described by the first
+  // JPEG-LS header
+  JlsParameters params = {};
+  if( JpegLsReadHeader(first, firstlen, &params) != OK )
+    {
+    gdcmDebugMacro( "Could not parse JPEG-LS header" );
+    return false;
+    }
+  size_t len = GetFrameLength(params);
+  if( NumberOfDimensions == 3 ) len *= sf->GetNumberOfFragments();
+  if( !len ) return false;
+
+  // Decode into the storage of the output value
+  SmartPointer<ByteValue> outbv = new ByteValue;
+  outbv->SetLength( (VL::Type)(len + len % 2) );
+  char *buffer = const_cast<char*>(outbv->GetPointer());
+  const bool b = NumberOfDimensions == 2
+    ? DecodeFrame(first, firstlen, buffer, len)
+    : Decode(in, buffer, len);
+  if( !b ) return false;
+  out = in;
+  out.SetValue( *outbv );
+  return true;
 #endif
 }
 
@@ -421,6 +477,10 @@ bool JPEGLSCodec::DecodeExtent(
   assert( pf.GetBitsAllocated() % 8 == 0 );
   assert( pf != PixelFormat::SINGLEBIT );
   assert( pf != PixelFormat::UINT12 && pf != PixelFormat::INT12 );
+  // A region made of whole frames is decoded in place
+  const bool wholeframe = xmin == 0 && xmax + 1 == dimensions[0]
+    && ymin == 0 && ymax + 1 == dimensions[1];
+  const size_t framelen = (size_t)dimensions[0] * dimensions[1] * pf.GetPixelSize();
 
   if( NumberOfDimensions == 2 )
     {
@@ -445,6 +505,9 @@ bool JPEGLSCodec::DecodeExtent(
     assert( zmin == zmax );
     assert( zmin == 0 );
 
+    if( wholeframe )
+      return DecodeFrame(dummy_buffer, buf_size, buffer, framelen);
+
     std::vector <unsigned char> outv;
     bool b = DecodeByStreamsCommon(dummy_buffer, buf_size, outv);
     if( !b ) return false;
@@ -502,12 +565,19 @@ bool JPEGLSCodec::DecodeExtent(
       is.seekg( 8, std::ios::cur );
 
       const size_t buf_size = offsets[z];
-      char *dummy_buffer = new char[ buf_size ];
+      std::vector<char> vdummybuffer( buf_size );
+      char *dummy_buffer = buf_size ? &vdummybuffer[0] : 0;
       is.read( dummy_buffer, buf_size );
 
+      if( wholeframe )
+        {
+        if( !DecodeFrame(dummy_buffer, buf_size, buffer + (z - zmin) * framelen, framelen) )
+          return false;
+        continue;
+        }
+
       std::vector <unsigned char> outv;
       bool b = DecodeByStreamsCommon(dummy_buffer, buf_size, outv);
-      delete[] dummy_buffer;
 
       if( !b ) return false;
 
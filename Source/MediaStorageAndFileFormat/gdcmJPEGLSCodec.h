@@ -43,11 +43,22 @@ public:
   bool Decode(DataElement const &in, char* outBuffer, size_t inBufferLength,
               uint32_t inXMin, uint32_t inXMax, uint32_t inYMin,
               uint32_t inYMax, uint32_t inZMin, uint32_t inZMax);
+  /// Decode the Pixel Data in straight into out of outlen bytes: a 2D image
+  /// may be split across several fragments, otherwise each fragment holds
+  /// one frame of outlen / Dimensions[2] bytes
+  bool Decode(DataElement const &in, char *out, size_t outlen);
   bool Code(DataElement const &in, DataElement &out);
 
   bool GetHeaderInfo(std::istream &is, TransferSyntax &ts);
+  /// Only the JPEG-LS markers before the scan data are parsed
+  bool GetHeaderInfo(const char *data, size_t len, TransferSyntax &ts);
   virtual ImageCodec * Clone() const;
 
+  /// Decode one JPEG-LS frame (codestream) of inlen bytes into out, which
+  /// must be exactly the size of the decoded frame. Padding after the EOI
+  /// marker is ignored.
+  bool DecodeFrame(const char *in, size_t inlen, char *out, size_t outlen);
+
   void SetLossless(bool l);
   bool GetLossless() const;
 
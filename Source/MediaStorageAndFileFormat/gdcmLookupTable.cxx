@@ -12,6 +12,7 @@
 
 =========================================================================*/
 #include "gdcmLookupTable.h"
+#include "gdcmPixelKernels.h"
 #include <vector>
 #include <set>
 
@@ -450,47 +451,19 @@ void LookupTable::Encode(std::istream &is, std::ostream &os)
 void LookupTable::Decode(std::istream &is, std::ostream &os) const
 {
   assert( Initialized() );
-  if ( BitSample == 8 )
-    {
-    unsigned char idx;
-    unsigned char rgb[3];
-    while( !is.eof() )
-      {
-      is.read( (char*)(&idx), 1);
-      if( is.eof() || !is.good() ) break;
-      if( IncompleteLUT )
-        {
-        assert( idx < Internal->Length[RED] );
-        assert( idx < Internal->Length[GREEN] );
-        assert( idx < Internal->Length[BLUE] );
-        }
-      rgb[RED]   = Internal->RGB[3*idx+RED];
-      rgb[GREEN] = Internal->RGB[3*idx+GREEN];
-      rgb[BLUE]  = Internal->RGB[3*idx+BLUE];
-      os.write((char*)rgb, 3 );
-      }
-    }
-  else if ( BitSample == 16 )
+  if ( BitSample != 8 && BitSample != 16 ) return;
+  // Decode by chunks using the buffer version:
+  const size_t indexsize = BitSample / 8;
+  std::vector<char> in( 65536 );
+  std::vector<char> out( 3 * in.size() );
+  while( is )
     {
-    // gdcmData/NM-PAL-16-PixRep1.dcm
-    const uint16_t *rgb16 = (uint16_t*)&Internal->RGB[0];
-    while( !is.eof() )
-      {
-      unsigned short idx;
-      unsigned short rgb[3];
-      is.read( (char*)(&idx), 2);
-      if( is.eof() || !is.good() ) break;
-      if( IncompleteLUT )
-        {
-        assert( idx < Internal->Length[RED] );
-        assert( idx < Internal->Length[GREEN] );
-        assert( idx < Internal->Length[BLUE] );
-        }
-      rgb[RED]   = rgb16[3*idx+RED];
-      rgb[GREEN] = rgb16[3*idx+GREEN];
-      rgb[BLUE]  = rgb16[3*idx+BLUE];
-      os.write((char*)rgb, 3*2);
-      }
+    is.read( &in[0], in.size() );
+    // gdcmData/NM-PAL-16-PixRep1.dcm: drop an incomplete trailing index
+    const size_t len = ((size_t)is.gcount() / indexsize) * indexsize;
+    if( !len ) break;
+    Decode( &out[0], out.size(), &in[0], len );
+    os.write( &out[0], 3 * len );
     }
 }
 
@@ -509,41 +482,55 @@ bool LookupTable::Decode(char *output, size_t outlen, const char *input, size_t
     }
   if ( BitSample == 8 )
     {
-    const unsigned char * end = (unsigned char*)input + inlen;
-    unsigned char * rgb = (unsigned char*)output;
-    for( unsigned char * idx = (unsigned char*)input; idx != end; ++idx )
+#ifndef NDEBUG
+    if( IncompleteLUT )
       {
-      if( IncompleteLUT )
+      const unsigned char * end = (unsigned char*)input + inlen;
+      for( unsigned char * idx = (unsigned char*)input; idx != end; ++idx )
         {
         assert( *idx < Internal->Length[RED] );
         assert( *idx < Internal->Length[GREEN] );
         assert( *idx < Internal->Length[BLUE] );
         }
-      rgb[RED]   = Internal->RGB[3 * *idx+RED];
-      rgb[GREEN] = Internal->RGB[3 * *idx+GREEN];
-      rgb[BLUE]  = Internal->RGB[3 * *idx+BLUE];
-      rgb += 3;
       }
+#endif
+    // Store each entry on 4 bytes, so that a pixel is a single load
+    unsigned char rgbx[256 * 4];
+    for( unsigned int i = 0; i < 256; ++i )
+      {
+      rgbx[4*i+RED]   = Internal->RGB[3*i+RED];
+      rgbx[4*i+GREEN] = Internal->RGB[3*i+GREEN];
+      rgbx[4*i+BLUE]  = Internal->RGB[3*i+BLUE];
+      rgbx[4*i+3]     = 0;
+      }
+    PixelKernels::ApplyLookupTable8(output, input, inlen, rgbx);
     success = true;
     }
   else if ( BitSample == 16 )
     {
-    const uint16_t *rgb16 = (uint16_t*)&Internal->RGB[0];
     assert( inlen % 2 == 0 );
-    const uint16_t * end = (uint16_t*)(input + inlen);
-    uint16_t * rgb = (uint16_t*)output;
-    for( uint16_t * idx = (uint16_t*)input; idx != end; ++idx )
+    const size_t n = inlen / 2;
+#ifndef NDEBUG
+    if( IncompleteLUT )
       {
-      if( IncompleteLUT )
+      for( size_t i = 0; i < n; ++i )
         {
-        assert( *idx < Internal->Length[RED] );
-        assert( *idx < Internal->Length[GREEN] );
-        assert( *idx < Internal->Length[BLUE] );
+        uint16_t idx;
+        memcpy( &idx, input + 2 * i, 2 );
+        assert( idx < Internal->Length[RED] );
+        assert( idx < Internal->Length[GREEN] );
+        assert( idx < Internal->Length[BLUE] );
         }
-      rgb[RED]   = rgb16[3 * *idx+RED];
-      rgb[GREEN] = rgb16[3 * *idx+GREEN];
-      rgb[BLUE]  = rgb16[3 * *idx+BLUE];
-      rgb += 3;
+      }
+#endif
+    // R,G,B are stored next to each other (6 bytes) for each of the 65536
+    // entries
+    const unsigned char *rgb16 = &Internal->RGB[0];
+    for( size_t i = 0; i < n; ++i, output += 6 )
+      {
+      uint16_t idx;
+      memcpy( &idx, input + 2 * i, 2 );
+      memcpy( output, rgb16 + 6 * (size_t)idx, 6 );
       }
     success = true;
     }
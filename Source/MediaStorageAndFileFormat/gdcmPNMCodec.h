@@ -38,6 +38,7 @@ public:
   void SetBufferLength(unsigned long l) { BufferLength = l; }
 
   bool GetHeaderInfo(std::istream &is, TransferSyntax &ts);
+  using ImageCodec::GetHeaderInfo;
   virtual ImageCodec * Clone() const;
 
   bool Read(const char *filename, DataElement &out) const;
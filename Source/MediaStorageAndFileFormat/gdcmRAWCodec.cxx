@@ -20,6 +20,8 @@
 
 #include <limits>
 #include <sstream>
+#include <vector>
+#include <algorithm>
 
 #include <cstring>
 
@@ -66,9 +68,31 @@ bool RAWCodec::Code(DataElement const &in, DataElement &out)
   return true;
 }
 
+// 8 bits YBR_FULL_422 / YBR_PARTIAL_422 pixels stored with their chroma
+// subsampled: inlen is (at least) 2/3 of the full length
+static bool IsSubsampledYBR422(ImageCodec const &codec, size_t inlen,
+  size_t fulllen)
+{
+  const PhotometricInterpretation &pi = codec.GetPhotometricInterpretation();
+  const PixelFormat &pf = codec.GetPixelFormat();
+  return ( pi == PhotometricInterpretation::YBR_FULL_422
+      || pi == PhotometricInterpretation::YBR_PARTIAL_422 )
+    && pf.GetBitsAllocated() == 8 && pf.GetSamplesPerPixel() == 3
+    && !codec.GetPlanarConfiguration()
+    && fulllen % 6 == 0 && inlen < fulllen && fulllen / 3 * 2 <= inlen;
+}
+
 bool RAWCodec::DecodeBytes(const char* inBytes, size_t inBufferLength,
                            char* outBytes, size_t inOutBufferLength)
 {
+  if( IsSubsampledYBR422(*this, inBufferLength, inOutBufferLength) )
+    {
+    // Upsample in place, from the end of the output buffer
+    const size_t subsampledlen = inOutBufferLength / 3 * 2;
+    memcpy(outBytes + inOutBufferLength - subsampledlen, inBytes, subsampledlen);
+    if( !DoUpsampleYBR422(outBytes, inOutBufferLength) ) return false;
+    return DecodeInPlace(outBytes, inOutBufferLength);
+    }
   // First let's see if we can do a fast-path:
   if( !NeedByteSwap &&
     !RequestPaddedCompositePixelCode &&
@@ -104,23 +128,37 @@ bool RAWCodec::DecodeBytes(const char* inBytes, size_t inBufferLength,
   // else
   assert( inBytes );
   assert( outBytes );
-  std::stringstream is;
-  is.write(inBytes, inBufferLength);
-  std::stringstream os;
-  bool r = DecodeByStreams(is, os);
+  const bool unpack12 = this->GetPixelFormat() == PixelFormat::UINT12 ||
+    this->GetPixelFormat() == PixelFormat::INT12;
+  if( !unpack12 && inBufferLength == inOutBufferLength )
+    {
+    // Post-process directly in the output buffer
+    memcpy(outBytes, inBytes, inBufferLength);
+    return DecodeInPlace(outBytes, inOutBufferLength);
+    }
+  // Ignore the padding of an odd number of packed bytes
+  const size_t packedlen = inOutBufferLength / 4 * 3;
+  if( unpack12 && inOutBufferLength % 4 == 0 && packedlen <= inBufferLength )
+    {
+    // Unpack in place, from the end of the output buffer
+    char *packed = outBytes + packedlen / 3;
+    memcpy(packed, inBytes, packedlen);
+    if( !DecodeInPlace(packed, packedlen) ) return false;
+    Unpacker12Bits::Unpack(outBytes, packed, packedlen);
+    this->GetPixelFormat().SetBitsAllocated( 16 );
+    return true;
+    }
+  std::vector<char> buffer(inBytes, inBytes + inBufferLength);
+  if( buffer.empty() ) return false;
+  bool r = DecodeInPlace(&buffer[0], buffer.size());
   assert( r );
   if(!r) return false;
 
-  std::string str = os.str();
-  //std::string::size_type check = str.size();//unused
-
-  
-  if( this->GetPixelFormat() == PixelFormat::UINT12 ||
-      this->GetPixelFormat() == PixelFormat::INT12 )
+  if( unpack12 )
     {
-    size_t len = str.size() * 16 / 12;
+    size_t len = buffer.size() * 16 / 12;
     char * copy = new char[len];
-    bool b = Unpacker12Bits::Unpack(copy, &str[0], str.size() ); (void)b;
+    bool b = Unpacker12Bits::Unpack(copy, &buffer[0], buffer.size() ); (void)b;
     assert( b );
     assert (len == inOutBufferLength);
     assert(inOutBufferLength == len);
@@ -135,7 +173,7 @@ bool RAWCodec::DecodeBytes(const char* inBytes, size_t inBufferLength,
     // DermaColorLossLess.dcm
     //assert (check == inOutBufferLength || check == inOutBufferLength + 1);
     // problem with: SIEMENS_GBS_III-16-ACR_NEMA_1.acr
-    memcpy(outBytes, str.c_str(), inOutBufferLength);
+    memcpy(outBytes, &buffer[0], std::min(buffer.size(), inOutBufferLength));
     }
 
   return r;
@@ -159,39 +197,54 @@ bool RAWCodec::Decode(DataElement const &in, DataElement &out)
   // else
   const ByteValue *bv = in.GetByteValue();
   assert( bv );
-  std::stringstream is;
-  is.write(bv->GetPointer(), bv->GetLength());
-  std::stringstream os;
-  bool r = DecodeByStreams(is, os);
-  if(!r) return false;
-  assert( r );
-
-  std::string str = os.str();
-  //std::string::size_type check = str.size();
+  const size_t len = bv->GetLength();
 
   out = in;
 
-  if( this->GetPixelFormat() == PixelFormat::UINT12 ||
+  const size_t fulllen = (size_t)Dimensions[0] * Dimensions[1]
+    * (Dimensions[2] ? Dimensions[2] : 1) * 3;
+  if( IsSubsampledYBR422(*this, len, fulllen) )
+    {
+    const size_t subsampledlen = fulllen / 3 * 2;
+    SmartPointer<ByteValue> outbv = new ByteValue;
+    outbv->SetLength( (VL::Type)fulllen );
+    char *full = const_cast<char*>(outbv->GetPointer());
+    memcpy(full + fulllen - subsampledlen, bv->GetPointer(), subsampledlen);
+    if( !DoUpsampleYBR422(full, fulllen) || !DecodeInPlace(full, fulllen) )
+      return false;
+    out.SetValue( *outbv );
+    }
+  else if( this->GetPixelFormat() == PixelFormat::UINT12 ||
     this->GetPixelFormat() == PixelFormat::INT12 )
     {
-    size_t len = str.size() * 16 / 12;
-    char * copy = new char[len];//why use an array, and not a vector?
-    bool b = Unpacker12Bits::Unpack(copy, &str[0], str.size() );
-    assert( b );
-    (void)b;
-    VL::Type lenSize = (VL::Type)len;
-    out.SetByteValue( copy, lenSize );
-    delete[] copy;
+    // Ignore the padding of an odd number of packed bytes
+    const size_t packedlen = len - len % 3;
+    if( !packedlen ) return false;
+    // Unpack in place in the output value: the packed bytes are first copied
+    // at its end
+    const size_t unpacked_len = packedlen / 3 * 4;
+    SmartPointer<ByteValue> outbv = new ByteValue;
+    outbv->SetLength( (VL::Type)unpacked_len );
+    char *unpacked = const_cast<char*>(outbv->GetPointer());
+    char *packed = unpacked + packedlen / 3;
+    memcpy(packed, bv->GetPointer(), packedlen);
+    if( !DecodeInPlace(packed, packedlen) ) return false;
+    Unpacker12Bits::Unpack(unpacked, packed, packedlen);
+    out.SetValue( *outbv );
 
     this->GetPixelFormat().SetBitsAllocated( 16 );
     }
   else
     {
-      VL::Type strSize = (VL::Type) str.size();
-    out.SetByteValue( &str[0], strSize);
+    // Post-process the copy owned by the output value, before anyone else
+    // can see it
+    SmartPointer<ByteValue> outbv = new ByteValue( bv->GetPointer(), (VL::Type)len );
+    if( len && !DecodeInPlace(const_cast<char*>(outbv->GetPointer()), len) )
+      return false;
+    out.SetValue( *outbv );
     }
 
-  return r;
+  return true;
 }
 
 bool RAWCodec::DecodeByStreams(std::istream &is, std::ostream &os)
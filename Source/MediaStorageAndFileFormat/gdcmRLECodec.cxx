@@ -19,6 +19,8 @@
 #include "gdcmSequenceOfFragments.h"
 #include "gdcmSmartPointer.h"
 #include "gdcmSwapper.h"
+#include "gdcmPixelKernels.h"
+#include "gdcmWorkerPool.h"
 
 #include <vector>
 #include <algorithm> // req C++11
@@ -50,19 +52,15 @@ public:
 class RLEFrame
 {
 public:
-  void Read(std::istream &is)
+  /// Read the RLE Header (64 bytes) at the start of an RLE frame
+  bool Read(const char *in, size_t inlen)
     {
-    // read Header (64 bytes)
-    is.read((char*)(&Header), sizeof(uint32_t)*16);
+    if( !in || inlen < sizeof(Header) ) return false;
     assert( sizeof(uint32_t)*16 == 64 );
     assert( sizeof(RLEHeader) == 64 );
+    memcpy(&Header, in, sizeof(Header));
     SwapperNoOp::SwapArray((uint32_t*)&Header,16);
-    uint32_t numSegments = Header.NumSegments;
-    if( numSegments >= 1 )
-      {
-      assert( Header.Offset[0] == 64 );
-      }
-    // We just check that we are indeed at the proper position start+64
+    return Header.NumSegments <= 15;
     }
   void Print(std::ostream &os)
     {
@@ -76,7 +74,9 @@ public:
 class RLEInternals
 {
 public:
+  RLEInternals():NumberOfThreads(1) {}
   RLEFrame Frame;
+  unsigned int NumberOfThreads;
   std::vector<uint32_t> SegmentLength;
 };
 
@@ -92,6 +92,16 @@ RLECodec::~RLECodec()
   delete Internals;
 }
 
+void RLECodec::SetNumberOfThreads(unsigned int n)
+{
+  Internals->NumberOfThreads = n;
+}
+
+unsigned int RLECodec::GetNumberOfThreads() const
+{
+  return Internals->NumberOfThreads;
+}
+
 bool RLECodec::CanDecode(TransferSyntax const &ts) const
 {
   return ts == TransferSyntax::RLELossless;
@@ -262,58 +272,235 @@ ptrdiff_t rle_encode(char *output, size_t outputlength, const char *input, size_
   return pout - output;
 }
 
-template <typename T>
-bool DoInvertPlanarConfiguration(T *output, const T *input, uint32_t inputlength)
-{
-  const T *r = input+0;
-  const T *g = input+1;
-  const T *b = input+2;
-  uint32_t length = (inputlength / 3) * 3; // remove the 0 padding
-  assert( length == inputlength || length == inputlength - 1 );
-  assert( length % 3 == 0 );
-  uint32_t plane_length = length / 3;
-  T *pout = output;
-  // copy red plane:
-  while( pout != output + plane_length * 1 )
-    {
-    *pout++ = *r;
-    r += 3;
-    }
-  assert( r == input + length );
-  // copy green plane:
-  assert( pout == output + plane_length );
-  while( pout != output + plane_length * 2 )
-    {
-    *pout++ = *g;
-    g += 3;
-    }
-  assert( g == input + length + 1);
-  // copy blue plane:
-  assert( pout == output + 2*plane_length );
-  while( pout != output + plane_length * 3 )
-    {
-    *pout++ = *b;
-    b += 3;
-    }
-  assert( b == input + length + 2);
-  assert ( pout = output + length );
+/*
+ * Decode the RLE Segment [input, input + inputlength) into outputlength bytes
+ * stored every stride bytes from output (G.3.2). A Literal Run cut by the end
+ * of the input is completed with 0 (ALOKA_SSD-8-MONO2-RLE-SQ.dcm). Return
+ * false when the input ends before outputlength bytes have been decoded.
+ */
+static bool rle_decode(char *output, size_t outputlength, size_t stride,
+  const char *input, size_t inputlength)
+{
+  const char *pin = input;
+  const char *end = input + inputlength;
+  size_t numOutBytes = 0;
+  while( numOutBytes < outputlength )
+    {
+    if( pin == end ) return false;
+    const signed char byte = (signed char)*pin++;
+    if( byte >= 0 /*&& byte <= 127*/ )
+      {
+      // Literal Run: output the next byte+1 bytes
+      const size_t runlength = (size_t)byte + 1;
+      const size_t count = std::min(runlength, outputlength - numOutBytes);
+      const size_t avail = std::min(count, (size_t)(end - pin));
+      char *pout = output + numOutBytes * stride;
+      if( stride == 1 )
+        {
+        memcpy(pout, pin, avail);
+        memset(pout + avail, 0, count - avail);
+        }
+      else
+        {
+        for( size_t i = 0; i < avail; ++i, pout += stride ) *pout = pin[i];
+        for( size_t i = avail; i < count; ++i, pout += stride ) *pout = 0;
+        }
+      pin += std::min(runlength, (size_t)(end - pin));
+      numOutBytes += count;
+      }
+    else if( byte != -128 )
+      {
+      // Replicate Run: output the next byte -byte+1 times
+      if( pin == end ) return false;
+      const char value = *pin++;
+      const size_t count = std::min((size_t)(1 - byte), outputlength - numOutBytes);
+      char *pout = output + numOutBytes * stride;
+      if( stride == 1 )
+        {
+        memset(pout, value, count);
+        }
+      else
+        {
+        for( size_t i = 0; i < count; ++i, pout += stride ) *pout = value;
+        }
+      numOutBytes += count;
+      }
+    // else byte == -128: output nothing
+    }
   return true;
 }
 
+// Copy every S-th byte of input into output (n bytes)
+template <unsigned int S>
+static void GatherBytes(char *output, const char *input, size_t n)
+{
+  for( size_t i = 0; i < n; ++i )
+    {
+    output[i] = input[S * i];
+    }
+}
+
+static void GatherBytes(char *output, const char *input, size_t n, size_t stride)
+{
+  switch( stride )
+    {
+  case 2: GatherBytes<2>(output, input, n); break;
+  case 3: GatherBytes<3>(output, input, n); break;
+  case 4: GatherBytes<4>(output, input, n); break;
+  case 6: GatherBytes<6>(output, input, n); break;
+  case 12: GatherBytes<12>(output, input, n); break;
+  default:
+    for( size_t i = 0; i < n; ++i, input += stride )
+      {
+      output[i] = *input;
+      }
+    }
+}
+
+/*
+ * Reorder the frames so that each RLE Segment is contiguous: one byte of one
+ * component of all the pixels, the most significant byte first (padded
+ * composite pixel code and planar configuration)
+ */
+class RLESegmentsJob : public WorkerPool::Job
+{
+public:
+  RLESegmentsJob(char *output, const char *input, unsigned long image_len,
+    unsigned int numsegments, unsigned int bytespersample, bool interleaved):
+    Output(output),Input(input),ImageLen(image_len),NumSegments(numsegments),
+    BytesPerSample(bytespersample),Interleaved(interleaved) {}
+
+  void Execute(unsigned int frame)
+    {
+    const size_t input_seg_length = ImageLen / NumSegments;
+    const char *ptr_img = Input + frame * ImageLen;
+    char *out = Output + frame * ImageLen;
+    if( Interleaved && BytesPerSample == 1 )
+      {
+      PixelKernels::InterleavedToPlanar3(out, out + input_seg_length,
+        out + 2 * input_seg_length, ptr_img, input_seg_length);
+      return;
+      }
+    const size_t stride = Interleaved ? 3 * BytesPerSample : BytesPerSample;
+    for(unsigned int seg = 0; seg < NumSegments; ++seg )
+      {
+      const unsigned int component = seg / BytesPerSample;
+#ifdef GDCM_WORDS_BIGENDIAN
+      const unsigned int byte = seg % BytesPerSample;
+#else
+      const unsigned int byte = BytesPerSample - 1 - seg % BytesPerSample;
+#endif
+      const char *src = ptr_img + byte + (Interleaved
+        ? component * BytesPerSample : component * input_seg_length * BytesPerSample);
+      GatherBytes(out + seg * input_seg_length, src, input_seg_length, stride);
+      }
+    }
+
+private:
+  char *Output;
+  const char *Input;
+  const unsigned long ImageLen;
+  const unsigned int NumSegments;
+  const unsigned int BytesPerSample;
+  const bool Interleaved;
+};
+
+/*
+ * Encode the RLE Segments of the frames from the worker threads: segment s
+ * of frame f is job f * NumSegments + s, and is compressed into its own
+ * buffer. The RLE frames are assembled from the thread calling Code, in
+ * frame order.
+ */
+class RLECodeJob : public WorkerPool::Job
+{
+public:
+  RLECodeJob(const char *segments, unsigned long image_len, const unsigned int dims[3],
+    unsigned int numsegments, unsigned int nframes, SequenceOfFragments &sq):
+    Input(segments),ImageLen(image_len),Dims(dims),NumSegments(numsegments),
+    SQ(sq),Segments(nframes * numsegments),Success(true) {}
+
+  void Execute(unsigned int index)
+    {
+    // lets' try a simple scheme where each Segments is given an equal portion
+    // of the input image.
+    const size_t input_seg_length = ImageLen / NumSegments;
+    const char *ptr = Input + (size_t)(index / NumSegments) * ImageLen
+      + (index % NumSegments) * input_seg_length;
+
+    // Do not cross row boundary. A row of n bytes never takes more than
+    // n + n / 128 + 1 bytes once compressed.
+    const size_t rowlength = input_seg_length / Dims[1];
+    std::vector<char> outbuf( rowlength + rowlength / 128 + 1 );
+    std::vector<char> &data = Segments[index];
+    for(unsigned int y = 0; y < Dims[1]; ++y)
+      {
+      ptrdiff_t llength = rle_encode(&outbuf[0], outbuf.size(), ptr + y*Dims[0], rowlength);
+      if( llength < 0 )
+        {
+        data.clear();
+        return;
+        }
+      assert( llength );
+      data.insert( data.end(), outbuf.begin(), outbuf.begin() + llength );
+      }
+    }
+
+  void Finish(unsigned int index)
+    {
+    if( !Success ) return;
+    if( Segments[index].empty() )
+      {
+      gdcmErrorMacro( "RLE compressor error" );
+      Success = false;
+      return;
+      }
+    if( index % NumSegments != NumSegments - 1 ) return;
+
+    // All the segments of the frame are done: create the RLE frame
+    std::vector<char> *segments = &Segments[index + 1 - NumSegments];
+    RLEHeader header = { static_cast<uint32_t> ( NumSegments ), { 64 } };
+    // there cannot be any space in between the end of the RLE header and the start
+    // of the first RLE segment
+    size_t framelen = sizeof(header);
+    for(unsigned int seg = 0; seg < NumSegments; ++seg )
+      {
+      header.Offset[1+seg] = (uint32_t)(header.Offset[seg] + segments[seg].size());
+      framelen += segments[seg].size();
+      }
+    header.Offset[NumSegments] = 0;
+    std::vector<char> str( framelen );
+    memcpy(&str[0], &header, sizeof(header));
+    char *p = &str[0] + sizeof(header);
+    for(unsigned int seg = 0; seg < NumSegments; ++seg )
+      {
+      memcpy(p, &segments[seg][0], segments[seg].size());
+      p += segments[seg].size();
+      std::vector<char>().swap( segments[seg] );
+      }
+    Fragment frag;
+    //frag.SetTag( itemStart );
+    frag.SetByteValue( &str[0], (VL::Type)str.size() );
+    SQ.AddFragment( frag );
+    }
+
+  bool GetSuccess() const { return Success; }
+
+private:
+  const char *Input;
+  const unsigned long ImageLen;
+  const unsigned int *Dims;
+  const unsigned int NumSegments;
+  SequenceOfFragments &SQ;
+  std::vector< std::vector<char> > Segments;
+  bool Success;
+};
 
 bool RLECodec::Code(DataElement const &in, DataElement &out)
 {
   const unsigned int *dims = this->GetDimensions();
-  const unsigned int n = 256*256;
-  char *outbuf;
-  // At most we are encoding a single row at a time, so we would be very unlucky
-  // if the row *after* compression would not fit in 256*256 bytes...
-  char small_buffer[n];
-  outbuf = small_buffer;
 
   // Create a Sequence Of Fragments:
   SmartPointer<SequenceOfFragments> sq = new SequenceOfFragments;
-  const Tag itemStart(0xfffe, 0xe000);
   //sq->GetTable().SetTag( itemStart );
   // FIXME  ? Is this compulsary ?
   //const char dummy[4] = {};
@@ -325,24 +512,6 @@ bool RLECodec::Code(DataElement const &in, DataElement &out)
   unsigned long bvl = bv->GetLength();
   unsigned long image_len = bvl / dims[2];
 
-  // If 16bits, need to do the padded composite...
-  char *buffer = 0;
-  // if rgb (3 comp) need to the planar configuration
-  char *bufferrgb = 0;
-  if( GetPixelFormat().GetBitsAllocated() > 8 )
-    {
-    //RequestPaddedCompositePixelCode = true;
-    buffer = new char [ image_len ];
-    }
-
-  if ( GetPhotometricInterpretation() == PhotometricInterpretation::RGB
-    || GetPhotometricInterpretation() == PhotometricInterpretation::YBR_FULL
-    || GetPhotometricInterpretation() == PhotometricInterpretation::YBR_RCT
-    || GetPhotometricInterpretation() == PhotometricInterpretation::YBR_FULL_422 )
-    {
-    bufferrgb = new char [ image_len ];
-    }
-
   unsigned int MaxNumSegments = 1;
   if( GetPixelFormat().GetBitsAllocated() == 8 )
     {
@@ -358,10 +527,9 @@ bool RLECodec::Code(DataElement const &in, DataElement &out)
     }
   else
     {
-    delete[] buffer;
-    delete[] bufferrgb;
     return false;
     }
+  const unsigned int bytesPerSample = MaxNumSegments;
 
   if( GetPhotometricInterpretation() == PhotometricInterpretation::RGB
     || GetPhotometricInterpretation() == PhotometricInterpretation::YBR_FULL
@@ -377,163 +545,38 @@ bool RLECodec::Code(DataElement const &in, DataElement &out)
     {
     assert( MaxNumSegments % 3 == 0 );
     }
-
-  RLEHeader header = { static_cast<uint32_t> ( MaxNumSegments ), { 64 } };
-  // there cannot be any space in between the end of the RLE header and the start
-  // of the first RLE segment
-  //
-  // Create a RLE Frame for each frame:
-  for(unsigned int dim = 0; dim < dims[2]; ++dim)
-    {
-    // Within each frame, create the RLE Segments:
-    // lets' try a simple scheme where each Segments is given an equal portion
-    // of the input image.
-    const char *ptr_img = input + dim * image_len;
-    if( GetPlanarConfiguration() == 0 && GetPixelFormat().GetSamplesPerPixel() == 3 )
+  assert( image_len % MaxNumSegments == 0 );
+  assert( (image_len / MaxNumSegments) % dims[1] == 0 );
+
+  const bool interleaved = GetPlanarConfiguration() == 0
+    && GetPixelFormat().GetSamplesPerPixel() == 3 && MaxNumSegments % 3 == 0;
+  WorkerPool pool;
+  pool.SetNumberOfThreads( Internals->NumberOfThreads );
+  // Unless the segments can be read directly from the input, reorder a few
+  // frames at a time (while they are still in cache)
+  const bool reorder = interleaved || bytesPerSample > 1;
+  const unsigned int batch = reorder
+    ? std::min(dims[2], 2 * pool.GetNumberOfThreads()) : dims[2];
+  std::vector<char> segments;
+  if( reorder ) segments.resize( (size_t)batch * image_len );
+  for(unsigned int first = 0; first < dims[2]; first += batch)
+    {
+    const unsigned int nframes = std::min(batch, dims[2] - first);
+    const char *ptr_img = input + (size_t)first * image_len;
+    if( reorder )
       {
-      if( GetPixelFormat().GetBitsAllocated() == 8 )
-        {
-        DoInvertPlanarConfiguration<char>(bufferrgb, ptr_img, (uint32_t)(image_len / sizeof(char)));
-        }
-      else /* ( GetPixelFormat().GetBitsAllocated() == 16 ) */
-        {
-        assert( GetPixelFormat().GetBitsAllocated() == 16 );
-        // should not happen right ?
-        DoInvertPlanarConfiguration<short>((short*)bufferrgb, (short*)ptr_img, (uint32_t)(image_len / sizeof(short)));
-        }
-      ptr_img = bufferrgb;
+      RLESegmentsJob segmentsjob(&segments[0], ptr_img, image_len,
+        MaxNumSegments, bytesPerSample, interleaved);
+      pool.Run( segmentsjob, nframes );
+      ptr_img = &segments[0];
       }
-    if( GetPixelFormat().GetBitsAllocated() == 32 )
-      {
-      assert( !(image_len % 4) );
-      //assert( image_len % 3 == 0 );
-      unsigned int div = GetPixelFormat().GetSamplesPerPixel();
-      for(unsigned int j = 0; j < div; ++j)
-        {
-        unsigned long iimage_len = image_len / div;
-        char *ibuffer = buffer + j * iimage_len;
-        const char *iptr_img = ptr_img + j * iimage_len;
-        assert( iimage_len % 4 == 0 );
-        for(unsigned long i = 0; i < iimage_len/4; ++i)
-          {
-#ifdef GDCM_WORDS_BIGENDIAN
-          ibuffer[i] = iptr_img[4*i+0];
-#else
-          ibuffer[i] = iptr_img[4*i+3];
-#endif
-          }
-        for(unsigned long i = 0; i < iimage_len/4; ++i)
-          {
-#ifdef GDCM_WORDS_BIGENDIAN
-          ibuffer[i+iimage_len/4] = iptr_img[4*i+1];
-#else
-          ibuffer[i+iimage_len/4] = iptr_img[4*i+2];
-#endif
-          }
-        for(unsigned long i = 0; i < iimage_len/4; ++i)
-          {
-#ifdef GDCM_WORDS_BIGENDIAN
-          ibuffer[i+2*iimage_len/4] = iptr_img[4*i+2];
-#else
-          ibuffer[i+2*iimage_len/4] = iptr_img[4*i+1];
-#endif
-          }
-        for(unsigned long i = 0; i < iimage_len/4; ++i)
-          {
-#ifdef GDCM_WORDS_BIGENDIAN
-          ibuffer[i+3*iimage_len/4] = iptr_img[4*i+3];
-#else
-          ibuffer[i+3*iimage_len/4] = iptr_img[4*i+0];
-#endif
-          }
-        }
-      ptr_img = buffer;
-      }
-    else if( GetPixelFormat().GetBitsAllocated() == 16 )
-      {
-      assert( !(image_len % 2) );
-      //assert( image_len % 3 == 0 );
-      unsigned int div = GetPixelFormat().GetSamplesPerPixel();
-      for(unsigned int j = 0; j < div; ++j)
-        {
-        unsigned long iimage_len = image_len / div;
-        char *ibuffer = buffer + j * iimage_len;
-        const char *iptr_img = ptr_img + j * iimage_len;
-        assert( iimage_len % 2 == 0 );
-        for(unsigned long i = 0; i < iimage_len/2; ++i)
-          {
-#ifdef GDCM_WORDS_BIGENDIAN
-          ibuffer[i] = iptr_img[2*i];
-#else
-          ibuffer[i] = iptr_img[2*i+1];
-#endif
-          }
-        for(unsigned long i = 0; i < iimage_len/2; ++i)
-          {
-#ifdef GDCM_WORDS_BIGENDIAN
-          ibuffer[i+iimage_len/2] = iptr_img[2*i+1];
-#else
-          ibuffer[i+iimage_len/2] = iptr_img[2*i];
-#endif
-          }
-        }
-      ptr_img = buffer;
-      }
-    assert( image_len % MaxNumSegments == 0 );
-    const size_t input_seg_length = image_len / MaxNumSegments;
-    std::string datastr;
-    for(unsigned int seg = 0; seg < MaxNumSegments; ++seg )
-      {
-      size_t partition = input_seg_length;
-      const char *ptr = ptr_img + seg * input_seg_length;
-      assert( ptr < ptr_img + image_len );
-      if( seg == MaxNumSegments - 1 )
-        {
-        partition += image_len % MaxNumSegments;
-        assert( (MaxNumSegments-1) * input_seg_length + partition == (size_t)image_len );
-        }
-      assert( partition == input_seg_length );
-
-      std::stringstream data;
-      assert( partition % dims[1] == 0 );
-      size_t length = 0;
-      // Do not cross row boundary:
-      for(unsigned int y = 0; y < dims[1]; ++y)
-        {
-        ptrdiff_t llength = rle_encode(outbuf, n, ptr + y*dims[0], partition / dims[1] /*image_len*/);
-        if( llength < 0 )
-          {
-          gdcmErrorMacro( "RLE compressor error" );
-          delete[] buffer;
-          delete[] bufferrgb;
-          return false;
-          }
-        assert( llength );
-        data.write((char*)outbuf, llength);
-        length += llength;
-        }
-      // update header
-      header.Offset[1+seg] = (uint32_t)(header.Offset[seg] + length);
-
-      assert( data.str().size() == length );
-      datastr += data.str();
-      }
-    header.Offset[MaxNumSegments] = 0;
-    std::stringstream os;
-    //header.Print( std::cout );
-    os.write((char*)&header,sizeof(header));
-    std::string str = os.str() + datastr;
-    assert( str.size() );
-    Fragment frag;
-    //frag.SetTag( itemStart );
-    VL::Type strSize = (VL::Type)str.size();
-    frag.SetByteValue( &str[0], strSize );
-    sq->AddFragment( frag );
+    RLECodeJob job(ptr_img, image_len, dims, MaxNumSegments, nframes, *sq);
+    pool.Run( job, nframes * MaxNumSegments );
+    if( !job.GetSuccess() ) return false;
     }
-  out.SetValue( *sq );
 
-  delete[] buffer;
-  delete[] bufferrgb;
+  assert( sq->GetNumberOfFragments() == dims[2] );
+  out.SetValue( *sq );
 
   return true;
 }
@@ -551,76 +594,111 @@ bool RLECodec::Code(DataElement const &in, DataElement &out)
 // Endif
 // Endloop
 
-size_t RLECodec::DecodeFragment(Fragment const & frag, char *buffer, size_t llen)
+bool RLECodec::DecodeFrame(const char *in, size_t inlen, char *out, size_t outlen)
 {
+  RLEFrame frame;
+  if( !frame.Read(in, inlen) )
+    {
+    gdcmErrorMacro( "Invalid RLE Header" );
+    return false;
+    }
+  const PixelFormat &pf = GetPixelFormat();
+  const size_t bytesPerSample = pf.GetBitsAllocated() / 8;
+  const size_t samplesPerPixel = pf.GetSamplesPerPixel();
+  const size_t numSegments = frame.Header.NumSegments;
+  if( (bytesPerSample != 1 && bytesPerSample != 2 && bytesPerSample != 4)
+    || (samplesPerPixel != 1 && samplesPerPixel != 3)
+    || numSegments != bytesPerSample * samplesPerPixel
+    || outlen % numSegments )
+    {
+    gdcmErrorMacro( "Invalid number of RLE Segments: " << numSegments );
+    return false;
+    }
+  // Each RLE Segment stores one byte of one component of all the pixels, the
+  // most significant byte first (G.2). Decode each of them straight to its
+  // final position: this takes care of the Padded Composite Pixel Code.
+  // A footnote:
+  // RLE *by definition* with more than one component will have applied the
+  // Planar Configuration because it simply does not make sense to do it
+  // otherwise. So implicitely RLE is indeed PlanarConfiguration == 1. However
+  // when the image says: "hey I am PlanarConfiguration = 0 AND RLE", then
+  // interleave the components so that people don't get lost
+  // Because GDCM internally set PlanarConfiguration == 0 by default, even if
+  // the Attribute is not sent, it will still default to 0 and we will be
+  // consistent with ourselves...
+  const bool planar = samplesPerPixel == 3 && GetPlanarConfiguration() == 1;
+  const size_t length = outlen / numSegments;
+  const size_t stride = planar ? bytesPerSample : bytesPerSample * samplesPerPixel;
+  for(size_t i = 0; i < numSegments; ++i)
+    {
+    // The segments may not be contiguous (ACUSON-24-YBR_FULL-RLE.dcm,
+    // D_CLUNIE_CT1_RLE.dcm): always start from the offset in the RLE Header
+    const size_t offset = frame.Header.Offset[i];
+    if( offset < sizeof(RLEHeader) || offset >= inlen )
+      {
+      gdcmErrorMacro( "Invalid RLE Segment offset: " << offset );
+      return false;
+      }
+    const size_t component = i / bytesPerSample;
+#ifdef GDCM_WORDS_BIGENDIAN
+    const size_t byte = i % bytesPerSample;
+#else
+    const size_t byte = bytesPerSample - 1 - i % bytesPerSample;
+#endif
+    char *segment = out + byte + component * (planar ? length * bytesPerSample : bytesPerSample);
+    if( !rle_decode(segment, length, stride, in + offset, inlen - offset) )
+      {
+      gdcmErrorMacro( "Could not decode" );
+      return false;
+      }
+    }
+
+  return DecodeInPlace(out, outlen);
+}
 
-  std::stringstream is;
-  const ByteValue &bv = dynamic_cast<const ByteValue&>(frag.GetValue());
-  size_t bv_len = bv.GetLength();
-  char *mybuffer = new char[bv_len];
-  bv.GetBuffer(mybuffer, bv.GetLength());
-  is.write(mybuffer, bv.GetLength());
-  delete[] mybuffer;
-  std::stringstream os;
-  SetLength( (unsigned long)llen );
+bool RLECodec::DecodeFragment(Fragment const & frag, char *buffer, size_t llen)
+{
+  const ByteValue *bv = frag.GetByteValue();
+  if( !bv ) return false;
 #if !defined(NDEBUG)
   const unsigned int * const dimensions = this->GetDimensions();
   const PixelFormat & pf = this->GetPixelFormat();
   assert( llen == dimensions[0] * dimensions[1] * pf.GetPixelSize() );
 #endif
-  bool r = DecodeByStreams(is, os);
-  (void)r; //warning removal
-  std::streampos p = is.tellg();
-  // http://groups.google.com/group/microsoft.public.vc.stl/browse_thread/thread/96740930d0e4e6b8
-  if( !!is )
-    {
-    // Indeed the length of the RLE stream has been padded with a \0
-    // which is discarded
-    std::streamoff check = bv.GetLength() - p;
-    // check == 2 for gdcmDataExtra/gdcmSampleData/US_DataSet/GE_US/2929J686-breaker
-    //assert( check == 0 || check == 1 || check == 2 );
-    if( check ) gdcmDebugMacro( "tiny offset detected in between RLE segments: " << check );
-    }
-  else
-    {
-    // ALOKA_SSD-8-MONO2-RLE-SQ.dcm
-    gdcmWarningMacro( "Bad RLE stream" );
-    }
-  std::string::size_type check = os.str().size();
-  // If the following assert fail expect big troubles:
-  memcpy(buffer, os.str().c_str(), check);
-//  pos += check;
-  return check;
+  // Decode directly from the fragment memory (possibly memory mapped)
+  return DecodeFrame(bv->GetPointer(), bv->GetLength(), buffer, llen);
 }
 
 bool RLECodec::Decode(DataElement const &in, DataElement &out)
 {
+  const SequenceOfFragments *sf = in.GetSequenceOfFragments();
+  if( !sf ) return false;
   if( NumberOfDimensions == 2 )
     {
+    const unsigned long len = GetBufferLength();
+    // Decode into the storage of the output value
+    SmartPointer<ByteValue> outbv = new ByteValue;
+    outbv->SetLength( (VL::Type)(len + len % 2) );
+    char *buffer = const_cast<char*>(outbv->GetPointer());
+    if( sf->GetNumberOfFragments() == 1 )
+      {
+      if( !DecodeFragment(sf->GetFragment(0), buffer, len) ) return false;
+      }
+    else
+      {
+      // The RLE frame was split across several fragments
+      std::vector<char> frame( sf->ComputeByteLength() );
+      if( frame.empty() || !sf->GetBuffer(&frame[0], (unsigned long)frame.size()) )
+        return false;
+      if( !DecodeFrame(&frame[0], frame.size(), buffer, len) ) return false;
+      }
     out = in;
-    const SequenceOfFragments *sf = in.GetSequenceOfFragments();
-    if( !sf ) return false;
-    unsigned long len = GetBufferLength();
-    std::stringstream is;
-    sf->WriteBuffer( is );
-    SetLength( len );
-    std::stringstream os;
-    bool r = DecodeByStreams(is, os);
-    assert( r ); (void)r; //warning removal
-    std::string str = os.str();
-    std::string::size_type check = str.size();
-    assert( check == len );
-    VL::Type checkCast = (VL::Type)check;
-    out.SetByteValue( &str[0], checkCast );
+    out.SetValue( *outbv );
     return true;
     }
   else if ( NumberOfDimensions == 3 )
     {
-    out = in;
-    const SequenceOfFragments *sf = in.GetSequenceOfFragments();
-    if( !sf ) return false;
     const unsigned long len = GetBufferLength();
-    unsigned long pos = 0;
     // Each RLE Frame store a 2D frame. len is the 3d length
     const size_t nframes = sf->GetNumberOfFragments();
     const size_t zdim = Dimensions[2];
@@ -629,27 +707,21 @@ bool RLECodec::Decode(DataElement const &in, DataElement &out)
       gdcmErrorMacro( "Invalid number of fragments: " << nframes << " should be: " << zdim  );
       return false;
     }
-    char *buffer = new char[len];
+    SmartPointer<ByteValue> outbv = new ByteValue;
+    outbv->SetLength( (VL::Type)(len + len % 2) );
+    char *buffer = const_cast<char*>(outbv->GetPointer());
     const std::size_t llen = len / nframes;
-    // assert( GetNumberOfDimensions() == 2
-    //      || GetDimension(2) == sf->GetNumberOfFragments() );
-    bool corruption = false;
     for(unsigned int i = 0; i < nframes; ++i)
       {
-      const Fragment &frag = sf->GetFragment(i);
-      const size_t check = DecodeFragment(frag, buffer + pos, llen); (void)check;
-      if( check != llen )
-      {
+      if( !DecodeFragment(sf->GetFragment(i), buffer + i * llen, llen) )
+        {
         gdcmDebugMacro( "RLE pb with frag: " << i );
-        corruption = true;
-      }
-      pos += (unsigned long)llen;
+        return false;
+        }
       }
-    if( !corruption )
-      assert( pos == len );
-    out.SetByteValue( buffer, (uint32_t)len );
-    delete[] buffer;
-    return !corruption;
+    out = in;
+    out.SetValue( *outbv );
+    return true;
     }
   return false;
 }
@@ -662,7 +734,6 @@ bool RLECodec::DecodeExtent(
   std::istream & is
 )
 {
-  std::stringstream tmpos;
   BasicOffsetTable bot;
   bot.Read<SwapperNoOp>( is );
   //std::cout << bot << std::endl;
@@ -674,7 +745,6 @@ bool RLECodec::DecodeExtent(
   assert( pf != PixelFormat::UINT12 && pf != PixelFormat::INT12 );
 
   // skip
-  std::stringstream os;
   Fragment frag;
   for( unsigned int z = 0; z < zmin; ++z )
     {
@@ -682,61 +752,38 @@ bool RLECodec::DecodeExtent(
     std::streamoff off = frag.GetVL();
     is.seekg( off, std::ios::cur );
     }
+
+  const unsigned int rowsize = xmax - xmin + 1;
+  const unsigned int colsize = ymax - ymin + 1;
+  const unsigned int bytesPerPixel = pf.GetPixelSize();
+  const size_t framelen = (size_t)dimensions[0] * dimensions[1] * bytesPerPixel;
+  // A region made of whole frames is decoded in place
+  const bool wholeframe = xmin == 0 && xmax + 1 == dimensions[0]
+    && ymin == 0 && ymax + 1 == dimensions[1];
+  std::vector<char> in;
+  std::vector<char> frame;
+  if( !wholeframe ) frame.resize( framelen );
   for( unsigned int z = zmin; z <= zmax; ++z )
     {
     frag.ReadPreValue<SwapperNoOp>(is);
-    std::streampos start = is.tellg();
-
-    SetLength( dimensions[0] * dimensions[1] * pf.GetPixelSize() );
-    const bool r = DecodeByStreams(is, os); (void)r;
-    assert( r );
-
-    // handle DICOM padding
-    std::streampos end = is.tellg();
-    size_t numberOfReadBytes = (size_t)(end - start);
-    if( numberOfReadBytes > frag.GetVL() )
-      {
-      // Special handling for ALOKA_SSD-8-MONO2-RLE-SQ.dcm
-      size_t diff = numberOfReadBytes - frag.GetVL();
-      assert( diff == 1 );
-      os.seekp( 0 - (int)diff, std::ios::cur );
-      os.put( 0 );
-      end = (size_t)end - 1;
-      }
-    assert( end - start == frag.GetVL() || (size_t)(end - start) + 1 == frag.GetVL() );
-    // sync is (rle16loo.dcm)
-    if( (end - start) % 2 == 1 )
+    in.resize( frag.GetVL() );
+    if( in.empty() || !is.read( &in[0], in.size() ) )
       {
-      is.get();
+      gdcmErrorMacro( "Could not read RLE fragment: " << z );
+      return false;
       }
-    } // for each z
-
-  os.seekg(0, std::ios::beg );
-  assert( os.good() );
-  std::istream *theStream = &os;
-
-  unsigned int rowsize = xmax - xmin + 1;
-  unsigned int colsize = ymax - ymin + 1;
-  unsigned int bytesPerPixel = pf.GetPixelSize();
+    char *out = wholeframe ? buffer + (z - zmin) * framelen : &frame[0];
+    if( !DecodeFrame( &in[0], in.size(), out, framelen ) ) return false;
+    if( wholeframe ) continue;
 
-  std::vector<char> buffer1;
-  buffer1.resize( rowsize*bytesPerPixel );
-  char *tmpBuffer1 = &buffer1[0];
-  unsigned int y, z;
-  std::streamoff theOffset;
-  for (z = zmin; z <= zmax; ++z)
-    {
-    for (y = ymin; y <= ymax; ++y)
+    for (unsigned int y = ymin; y <= ymax; ++y)
       {
-      theStream->seekg(std::ios::beg);
-      theOffset = 0 + ((z-zmin)*dimensions[1]*dimensions[0] + y*dimensions[0] + xmin)*bytesPerPixel;
-      theStream->seekg(theOffset);
-      theStream->read(tmpBuffer1, rowsize*bytesPerPixel);
+      const size_t theOffset = ((size_t)y*dimensions[0] + xmin)*bytesPerPixel;
       memcpy(&(buffer[((z-zmin)*rowsize*colsize +
             (y-ymin)*rowsize)*bytesPerPixel]),
-        tmpBuffer1, rowsize*bytesPerPixel);
+        &frame[theOffset], rowsize*bytesPerPixel);
       }
-    }
+    } // for each z
   return true;
 }
 
@@ -747,102 +794,21 @@ bool RLECodec::DecodeByStreamsCommon(std::istream &, std::ostream &)
 
 bool RLECodec::DecodeByStreams(std::istream &is, std::ostream &os)
 {
+  // Read the remaining of the stream (one RLE frame) and decode it at once
   std::streampos start = is.tellg();
-  // FIXME: Do some stupid work:
-  char dummy_buffer[256];
-  std::stringstream tmpos;
-
-  RLEFrame &frame = Internals->Frame;
-  frame.Read(is);
-  unsigned long numSegments = frame.Header.NumSegments;
+  is.seekg( 0, std::ios::end );
+  const size_t inlen = (size_t)(is.tellg() - start);
+  is.seekg( start, std::ios::beg );
+  std::vector<char> in( inlen );
+  if( inlen && !is.read( &in[0], inlen ) ) return false;
 
-  unsigned long numberOfReadBytes = 0;
-
-  unsigned long length = Length;
+  const unsigned long length = Length;
   assert( length );
-  // Special case:
-  assert( GetPixelFormat().GetBitsAllocated() == 32 ||
-          GetPixelFormat().GetBitsAllocated() == 16 ||
-          GetPixelFormat().GetBitsAllocated() == 8 );
-  if( GetPixelFormat().GetBitsAllocated() > 8 )
-    {
-    RequestPaddedCompositePixelCode = true;
-    }
-
-  assert( GetPixelFormat().GetSamplesPerPixel() == 3 || GetPixelFormat().GetSamplesPerPixel() == 1 );
-  // A footnote:
-  // RLE *by definition* with more than one component will have applied the
-  // Planar Configuration because it simply does not make sense to do it
-  // otherwise. So implicitely RLE is indeed PlanarConfiguration == 1. However
-  // when the image says: "hey I am PlanarConfiguration = 0 AND RLE", then
-  // apply the PlanarConfiguration internally so that people don't get lost
-  // Because GDCM internally set PlanarConfiguration == 0 by default, even if
-  // the Attribute is not sent, it will still default to 0 and we will be
-  // consistent with ourselves...
-  if( GetPixelFormat().GetSamplesPerPixel() == 3 && GetPlanarConfiguration() == 0 )
-    {
-    RequestPlanarConfiguration = true;
-    }
-  length /= numSegments;
-  for(unsigned long i = 0; i<numSegments; ++i)
-    {
-    numberOfReadBytes = 0;
-    std::streampos pos = is.tellg() - start;
-    if ( frame.Header.Offset[i] - pos != 0 )
-      {
-      // ACUSON-24-YBR_FULL-RLE.dcm
-      // D_CLUNIE_CT1_RLE.dcm
-      // This should be at most the \0 padding
-      //gdcmWarningMacro( "RLE Header says: " << frame.Header.Offset[i] <<
-      //   " when it should says: " << pos << std::endl );
-      std::streamoff check = frame.Header.Offset[i] - pos;//should it be a streampos or a uint32? mmr
-      // check == 2 for gdcmDataExtra/gdcmSampleData/US_DataSet/GE_US/2929J686-breaker
-      //assert( check == 1 || check == 2);
-      (void)check; //warning removal
-      is.seekg( frame.Header.Offset[i] + start, std::ios::beg );
-      }
-
-    unsigned long numOutBytes = 0;
-    signed char byte;
-
-    // FIXME: ALOKA_SSD-8-MONO2-RLE-SQ.dcm I think the RLE decoder is off by
-    // one, we are reading in 128001 byte, while only 128000 are present
-    while( numOutBytes < length )
-      {
-      is.read((char*)&byte, 1);
-      if( !is.good() )
-      {
-        gdcmErrorMacro( "Could not decode" );
-        return false;
-      }
-      numberOfReadBytes++;
-      if( byte >= 0 /*&& byte <= 127*/ ) /* 2nd is always true */
-        {
-        is.read( dummy_buffer, byte+1 );
-        //assert( is.good() ); // impossible because ALOKA_SSD-8-MONO2-RLE-SQ.dc
-        numberOfReadBytes += byte+1;
-        numOutBytes += byte+ 1;
-        tmpos.write( dummy_buffer, byte+1 );
-        }
-      else if( byte <= -1 && byte >= -127 )
-        {
-        char nextByte;
-        is.read( &nextByte, 1);
-        numberOfReadBytes += 1;
-        memset(dummy_buffer, nextByte, -byte + 1);
-        numOutBytes += -byte + 1;
-        tmpos.write( dummy_buffer, -byte+1 );
-        }
-      else /* byte == -128 */
-        {
-        assert( byte == -128 );
-        }
-      //assert( numberOfReadBytes + frame.Header.Offset[i] - is.tellg() + start == 0);
-      }
-    assert( numOutBytes == length );
-    }
-
-  return ImageCodec::DecodeByStreams(tmpos,os);
+  std::vector<char> out( length );
+  if( !length || !DecodeFrame( inlen ? &in[0] : 0, inlen, &out[0], length ) )
+    return false;
+  os.write( &out[0], length );
+  return true;
 }
 
 bool RLECodec::GetHeaderInfo(std::istream &is, TransferSyntax &ts)
@@ -852,9 +818,20 @@ bool RLECodec::GetHeaderInfo(std::istream &is, TransferSyntax &ts)
   return true;
 }
 
+bool RLECodec::GetHeaderInfo(const char *data, size_t len, TransferSyntax &ts)
+{
+  RLEFrame frame;
+  if( !frame.Read( data, len ) || !frame.Header.NumSegments ) return false;
+  LossyFlag = false;
+  ts = TransferSyntax::RLELossless;
+  return true;
+}
+
 ImageCodec * RLECodec::Clone() const
 {
-  return new RLECodec;
+  RLECodec *copy = new RLECodec;
+  copy->SetNumberOfThreads( GetNumberOfThreads() );
+  return copy;
 }
 
 bool RLECodec::StartEncode( std::ostream & )
@@ -47,8 +47,21 @@ public:
 
   bool Code(DataElement const &in, DataElement &out);
   bool GetHeaderInfo(std::istream &is, TransferSyntax &ts);
+  /// Only check the RLE Header (first 64 bytes) of the frame
+  bool GetHeaderInfo(const char *data, size_t len, TransferSyntax &ts);
   virtual ImageCodec * Clone() const;
 
+  /// Decode one RLE frame (RLE Header followed by its RLE Segments) of inlen
+  /// bytes straight into out, which must hold the outlen bytes of the
+  /// uncompressed frame. No intermediate copy of the frame is made.
+  bool DecodeFrame(const char *in, size_t inlen, char *out, size_t outlen);
+
+  /// Number of threads used by Code to compress the RLE Segments of all the
+  /// frames concurrently (default: 1). 0 means one thread per processor. The
+  /// output does not depend on the number of threads.
+  void SetNumberOfThreads(unsigned int n);
+  unsigned int GetNumberOfThreads() const;
+
 protected:
   bool DecodeExtent(
     char *buffer,
@@ -79,7 +92,7 @@ private:
   RLEInternals *Internals;
   unsigned long Length;
   unsigned long BufferLength;
-  size_t DecodeFragment(Fragment const & frag, char *buffer, size_t llen);
+  bool DecodeFragment(Fragment const & frag, char *buffer, size_t llen);
 };
 
 } // end namespace gdcm
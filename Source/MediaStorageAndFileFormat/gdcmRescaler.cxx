@@ -12,7 +12,9 @@
 
 =========================================================================*/
 #include "gdcmRescaler.h"
+#include "gdcmPixelKernels.h"
 #include <limits>
+#include <vector>
 #include <algorithm> // std::max
 #include <stdlib.h> // abort
 #include <string.h> // memcpy
@@ -42,6 +44,68 @@ void RescaleFunction(TOut *out, const TIn *in, double intercept, double slope, s
     }
 }
 
+// For Stored Pixel Values of 12 bits or less, compute the output of every
+// possible value once and use a lookup table, this avoids the double to
+// integer conversion of each pixel. Values outside of the range declared by
+// the Pixel Format (garbage in the unused bits) are computed.
+// Floating point output is not worth it: the direct computation vectorizes.
+template <typename TOut, typename TIn>
+void RescaleFunction(TOut *out, const TIn *in, double intercept, double slope, size_t size,
+  const PixelFormat &pf)
+{
+  if( std::numeric_limits<TIn>::is_integer && std::numeric_limits<TOut>::is_integer
+    && sizeof(TIn) <= 2 && pf.GetBitsStored() <= 12 )
+    {
+    const int min = (int)pf.GetMin();
+    const size_t tablesize = (size_t)(pf.GetMax() - pf.GetMin() + 1);
+    const size_t n = size / sizeof(TIn);
+    // Only worth it when the table is small compared to the image:
+    if( n >= 4 * tablesize )
+      {
+      std::vector<TOut> lut( tablesize );
+      for( size_t i = 0; i != tablesize; ++i )
+        {
+        const TIn value = (TIn)(min + (int)i);
+        lut[i] = (TOut)(slope * value + intercept);
+        }
+      for( size_t i = 0; i != n; ++i )
+        {
+        const size_t index = (size_t)(unsigned int)((int)in[i] - min);
+        out[i] = index < tablesize ? lut[index] : (TOut)(slope * in[i] + intercept);
+        }
+      return;
+      }
+    }
+  RescaleFunction<TOut,TIn>(out,in,intercept,slope,size);
+}
+
+// 16 bits Stored Pixel Values are handled by the vectorized kernels. An
+// integer transform into a 16 bits type (e.g. CT Hounsfield Units) is computed
+// modulo 2^16, which is exact since the output type can hold the result.
+template <typename TIn>
+static bool RescaleFunction16(char *out, const TIn *in, double intercept, double slope,
+  PixelFormat::ScalarType output, size_t size)
+{
+  if( sizeof(TIn) != 2 || !std::numeric_limits<TIn>::is_integer ) return false;
+  if( output == PixelFormat::UINT16 || output == PixelFormat::INT16 )
+    {
+    if( !(fabs(slope) < 65536 && fabs(intercept) < 65536)
+      || slope != (int)slope || intercept != (int)intercept )
+      {
+      return false;
+      }
+    PixelKernels::LinearTransform16(out, in, size / 2, (int)slope, (int)intercept);
+    return true;
+    }
+  if( output == PixelFormat::FLOAT64 )
+    {
+    PixelKernels::LinearTransform16ToDouble((double*)out, in, size / 2,
+      std::numeric_limits<TIn>::is_signed, slope, intercept);
+    return true;
+    }
+  return false;
+}
+
 // no such thing as partial specialization of function in c++
 // so instead use this trick:
 template<typename TOut, typename TIn>
@@ -213,34 +277,38 @@ void Rescaler::RescaleFunctionIntoBestFit(char *out, const TIn *in, size_t n)
     {
     output = TargetScalarType;
     }
+  if( RescaleFunction16<TIn>(out, in, intercept, slope, output, n) )
+    {
+    return;
+    }
   switch(output)
     {
   case PixelFormat::SINGLEBIT:
     assert(0);
     break;
   case PixelFormat::UINT8:
-    RescaleFunction<uint8_t,TIn>((uint8_t*)out,in,intercept,slope,n);
+    RescaleFunction<uint8_t,TIn>((uint8_t*)out,in,intercept,slope,n,PF);
     break;
   case PixelFormat::INT8:
-    RescaleFunction<int8_t,TIn>((int8_t*)out,in,intercept,slope,n);
+    RescaleFunction<int8_t,TIn>((int8_t*)out,in,intercept,slope,n,PF);
     break;
   case PixelFormat::UINT16:
-    RescaleFunction<uint16_t,TIn>((uint16_t*)out,in,intercept,slope,n);
+    RescaleFunction<uint16_t,TIn>((uint16_t*)out,in,intercept,slope,n,PF);
     break;
   case PixelFormat::INT16:
-    RescaleFunction<int16_t,TIn>((int16_t*)out,in,intercept,slope,n);
+    RescaleFunction<int16_t,TIn>((int16_t*)out,in,intercept,slope,n,PF);
     break;
   case PixelFormat::UINT32:
-    RescaleFunction<uint32_t,TIn>((uint32_t*)out,in,intercept,slope,n);
+    RescaleFunction<uint32_t,TIn>((uint32_t*)out,in,intercept,slope,n,PF);
     break;
   case PixelFormat::INT32:
-    RescaleFunction<int32_t,TIn>((int32_t*)out,in,intercept,slope,n);
+    RescaleFunction<int32_t,TIn>((int32_t*)out,in,intercept,slope,n,PF);
     break;
   case PixelFormat::FLOAT32:
-    RescaleFunction<float,TIn>((float*)out,in,intercept,slope,n);
+    RescaleFunction<float,TIn>((float*)out,in,intercept,slope,n,PF);
     break;
   case PixelFormat::FLOAT64:
-    RescaleFunction<double,TIn>((double*)out,in,intercept,slope,n);
+    RescaleFunction<double,TIn>((double*)out,in,intercept,slope,n,PF);
     break;
   default:
     assert(0);
@@ -254,6 +322,14 @@ void Rescaler::InverseRescaleFunctionIntoBestFit(char *out, const TIn *in, size_
   const double intercept = Intercept;
   const double slope = Slope;
   PixelFormat output = ComputePixelTypeFromMinMax();
+  // Integer 16 bits to 16 bits with a slope of 1 (see RescaleFunction16):
+  if( sizeof(TIn) == 2 && std::numeric_limits<TIn>::is_integer
+    && slope == 1 && fabs(intercept) < 65536 && intercept == (int)intercept
+    && (output == PixelFormat::UINT16 || output == PixelFormat::INT16) )
+    {
+    PixelKernels::LinearTransform16(out, in, n / 2, 1, -(int)intercept);
+    return;
+    }
   switch(output)
     {
   case PixelFormat::SINGLEBIT:
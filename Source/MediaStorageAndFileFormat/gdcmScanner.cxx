@@ -20,12 +20,349 @@
 #include "gdcmStringFilter.h"
 #include "gdcmProgressEvent.h"
 #include "gdcmFileNameEvent.h"
+#include "gdcmWorkerPool.h"
+#include "gdcmSystem.h"
+#include "gdcmUIDGenerator.h"
 
 #include <algorithm> // std::find
+#include <fstream>
+#include <cstdio> // rename
 
 namespace gdcm
 {
 
+/*
+ * On disk index of a previous Scan (see Scanner::SetIndexFileName). Binary
+ * layout, in native byte order:
+ *   "GDCMSIX1" uint32(0x01020304)
+ *   uint32 ntags, ntags * (uint16 group, uint16 element)
+ *   uint32 nstrings, nstrings * (uint32 length, chars)
+ *   uint32 nfiles, nfiles * (uint32 length, chars, uint64 size, int64 mtime,
+ *     uint8 readable, uint32 nvalues, nvalues * (uint32 tag, uint32 string))
+ * where tag and string are indexes in the tag and string tables.
+ */
+class ScannerIndex
+{
+public:
+  struct Entry
+    {
+    uint64_t Size;
+    int64_t Time;
+    bool Readable;
+    std::vector< std::pair<uint32_t, uint32_t> > Values;
+    };
+
+  /// Load an index, return false when the file is missing, invalid, or was
+  /// created for a different set of tags
+  bool Load(const char *filename, std::set<Tag> const &tags)
+    {
+    bool ret;
+    try
+      {
+      ret = InternalLoad( filename, tags );
+      }
+    catch( ... )
+      {
+      ret = false;
+      }
+    if( !ret )
+      {
+      Tags.clear();
+      Strings.clear();
+      Entries.clear();
+      }
+    return ret;
+    }
+  static bool Save(const char *filename, Scanner const &s,
+    std::vector<uint64_t> const &sizes, std::vector<int64_t> const &times,
+    std::set<Tag> const &tags);
+
+  /// Return the values stored for an unmodified file, or NULL
+  const Entry *Find(const std::string &filename, uint64_t size, int64_t time) const
+    {
+    std::map<std::string, Entry>::const_iterator it = Entries.find( filename );
+    if( it != Entries.end() && it->second.Size == size && it->second.Time == time )
+      return &it->second;
+    return NULL;
+    }
+
+  void GetValues(const Entry &e, std::vector< std::pair<Tag, std::string> > &values) const
+    {
+    values.clear();
+    for( size_t i = 0; i < e.Values.size(); ++i )
+      {
+      values.push_back( std::make_pair( Tags[ e.Values[i].first ], Strings[ e.Values[i].second ] ) );
+      }
+    }
+
+private:
+  template <typename T> static bool ReadRaw(std::istream &is, T &v)
+    {
+    return (bool)is.read( reinterpret_cast<char*>(&v), sizeof(v) );
+    }
+  template <typename T> static void WriteRaw(std::ostream &os, T const &v)
+    {
+    os.write( reinterpret_cast<const char*>(&v), sizeof(v) );
+    }
+  // Counts are read from the file: never allocate for more items than there
+  // are bytes left, each item taking at least itemsize bytes
+  static bool CheckCount(std::istream &is, uint64_t length, uint32_t count, size_t itemsize)
+    {
+    const std::streamoff pos = is.tellg();
+    return pos >= 0 && (uint64_t)pos <= length
+      && (uint64_t)count * itemsize <= length - (uint64_t)pos;
+    }
+  static bool ReadString(std::istream &is, uint64_t length, std::string &s)
+    {
+    uint32_t len;
+    if( !ReadRaw(is, len) || !CheckCount(is, length, len, 1) ) return false;
+    s.resize( len );
+    return len == 0 || (bool)is.read( &s[0], len );
+    }
+  static void WriteString(std::ostream &os, const char *s, uint32_t len)
+    {
+    WriteRaw(os, len);
+    os.write( s, len );
+    }
+
+  bool InternalLoad(const char *filename, std::set<Tag> const &tags);
+
+  std::vector<Tag> Tags;
+  std::vector<std::string> Strings;
+  std::map<std::string, Entry> Entries;
+};
+
+static const char ScannerIndexMagic[] = "GDCMSIX1";
+static const uint32_t ScannerIndexByteOrder = 0x01020304;
+
+bool ScannerIndex::InternalLoad(const char *filename, std::set<Tag> const &tags)
+{
+  std::ifstream is( filename, std::ios::binary );
+  if( !is.is_open() ) return false;
+  const uint64_t length = (uint64_t)System::FileSize( filename );
+  char magic[8];
+  uint32_t byteorder;
+  if( !is.read( magic, 8 ) || memcmp( magic, ScannerIndexMagic, 8 ) != 0
+    || !ReadRaw(is, byteorder) || byteorder != ScannerIndexByteOrder )
+    {
+    gdcmWarningMacro( "Not a Scanner index: " << filename );
+    return false;
+    }
+  uint32_t n;
+  if( !ReadRaw(is, n) || n != tags.size() ) return false;
+  Tags.resize( n );
+  for( uint32_t i = 0; i < n; ++i )
+    {
+    uint16_t group, element;
+    if( !ReadRaw(is, group) || !ReadRaw(is, element) ) return false;
+    Tags[i] = Tag(group, element);
+    }
+  // The index is only valid for the exact same set of tags
+  if( !std::equal( Tags.begin(), Tags.end(), tags.begin() ) ) return false;
+  if( !ReadRaw(is, n) || !CheckCount(is, length, n, sizeof(uint32_t)) ) return false;
+  Strings.resize( n );
+  for( uint32_t i = 0; i < n; ++i )
+    {
+    if( !ReadString(is, length, Strings[i]) ) return false;
+    }
+  if( !ReadRaw(is, n) ) return false;
+  std::string path;
+  for( uint32_t i = 0; i < n; ++i )
+    {
+    Entry e;
+    uint8_t readable;
+    uint32_t nvalues;
+    if( !ReadString(is, length, path) || !ReadRaw(is, e.Size) || !ReadRaw(is, e.Time)
+      || !ReadRaw(is, readable) || !ReadRaw(is, nvalues)
+      || !CheckCount(is, length, nvalues, 2 * sizeof(uint32_t)) ) return false;
+    e.Readable = readable != 0;
+    e.Values.resize( nvalues );
+    for( uint32_t j = 0; j < nvalues; ++j )
+      {
+      if( !ReadRaw(is, e.Values[j].first) || !ReadRaw(is, e.Values[j].second)
+        || e.Values[j].first >= Tags.size() || e.Values[j].second >= Strings.size() )
+        return false;
+      }
+    Entries[ path ] = e;
+    }
+  return true;
+}
+
+bool ScannerIndex::Save(const char *filename, Scanner const &s,
+  std::vector<uint64_t> const &sizes, std::vector<int64_t> const &times,
+  std::set<Tag> const &tags)
+{
+  // Write to a temporary file first, so that an interrupted Scan does not
+  // leave a truncated index behind. Its name is unique so that concurrent
+  // Scans sharing an index do not write to the same file.
+  UIDGenerator uid;
+  const std::string tmpfilename = std::string(filename) + "." + uid.Generate() + ".tmp";
+  {
+  std::ofstream os( tmpfilename.c_str(), std::ios::binary );
+  if( !os.is_open() )
+    {
+    gdcmWarningMacro( "Could not write Scanner index: " << tmpfilename );
+    return false;
+    }
+  os.write( ScannerIndexMagic, 8 );
+  WriteRaw(os, ScannerIndexByteOrder);
+  WriteRaw(os, (uint32_t)tags.size());
+  std::map<Tag, uint32_t> tagindexes;
+  for( std::set<Tag>::const_iterator it = tags.begin(); it != tags.end(); ++it )
+    {
+    const uint32_t index = (uint32_t)tagindexes.size();
+    tagindexes[ *it ] = index;
+    WriteRaw(os, it->GetGroup());
+    WriteRaw(os, it->GetElement());
+    }
+  // Values are unique in the Scanner, use their address as key:
+  Scanner::ValuesType const &values = s.GetValues();
+  std::map<const char*, uint32_t> stringindexes;
+  WriteRaw(os, (uint32_t)values.size());
+  for( Scanner::ValuesType::const_iterator it = values.begin(); it != values.end(); ++it )
+    {
+    const uint32_t index = (uint32_t)stringindexes.size();
+    stringindexes[ it->c_str() ] = index;
+    WriteString(os, it->c_str(), (uint32_t)it->size());
+    }
+  Directory::FilenamesType const &filenames = s.GetFilenames();
+  WriteRaw(os, (uint32_t)filenames.size());
+  for( size_t i = 0; i < filenames.size(); ++i )
+    {
+    const char *fn = filenames[i].c_str();
+    const bool readable = s.IsKey( fn );
+    WriteString(os, fn, (uint32_t)filenames[i].size());
+    WriteRaw(os, sizes[i]);
+    WriteRaw(os, times[i]);
+    WriteRaw(os, (uint8_t)(readable ? 1 : 0));
+    Scanner::TagToValue const &ttv = s.GetMapping( fn );
+    WriteRaw(os, (uint32_t)(readable ? ttv.size() : 0));
+    if( !readable ) continue;
+    for( Scanner::TagToValue::const_iterator it = ttv.begin(); it != ttv.end(); ++it )
+      {
+      WriteRaw(os, tagindexes[ it->first ]);
+      WriteRaw(os, stringindexes[ it->second ]);
+      }
+    }
+  if( !os )
+    {
+    gdcmWarningMacro( "Could not write Scanner index: " << tmpfilename );
+    os.close();
+    System::RemoveFile( tmpfilename.c_str() );
+    return false;
+    }
+  }
+  System::RemoveFile( filename ); // rename does not overwrite on Win32
+  if( std::rename( tmpfilename.c_str(), filename ) != 0 )
+    {
+    gdcmWarningMacro( "Could not write Scanner index: " << filename );
+    System::RemoveFile( tmpfilename.c_str() );
+    return false;
+    }
+  return true;
+}
+
+/*
+ * Read the files from the worker threads, and store the values and invoke
+ * the events from the thread calling Scan, in the order of the filenames.
+ */
+class ScannerJob : public WorkerPool::Job
+{
+public:
+  typedef std::vector< std::pair<Tag, std::string> > ValuesType;
+  ScannerJob(Scanner &s, Tag const &last, const ScannerIndex *index):S(s),
+    Last(last),Index(index),Read(s.Filenames.size()),
+    Values(s.Filenames.size()),Progress(0),
+    ProgressTick(1. / (double)s.Filenames.size())
+    {
+    if( !S.IndexFileName.empty() )
+      {
+      Sizes.resize( s.Filenames.size() );
+      Times.resize( s.Filenames.size() );
+      }
+    }
+
+  void Execute(unsigned int index)
+    {
+    const char *filename = S.Filenames[index].c_str();
+    assert( filename );
+    if( !Sizes.empty() )
+      {
+      Sizes[index] = System::FileSize( filename );
+      Times[index] = System::FileTime( filename );
+      const ScannerIndex::Entry *e =
+        Index ? Index->Find( filename, Sizes[index], Times[index] ) : NULL;
+      if( e )
+        {
+        // Unmodified since the last Scan
+        Index->GetValues( *e, Values[index] );
+        Read[index] = e->Readable;
+        return;
+        }
+      }
+    Reader reader;
+    reader.SetFileName( filename );
+    bool read = false;
+    try
+      {
+      // Start reading all tags, including the 'last' one:
+      read = reader.ReadUpToTag(Last, S.SkipTags);
+      }
+    catch(std::exception & ex)
+      {
+      (void)ex;
+      gdcmWarningMacro( "Failed to read:" << filename << " with ex:" << ex.what() );
+      }
+    catch(...)
+      {
+      gdcmWarningMacro( "Failed to read:" << filename  << " with unknown error" );
+      }
+    if( read )
+      {
+      StringFilter sf;
+      sf.SetFile( reader.GetFile() );
+      S.ReadValues(sf, Values[index]);
+      }
+    Read[index] = read;
+    }
+
+  void Finish(unsigned int index)
+    {
+    const char *filename = S.Filenames[index].c_str();
+    if( Read[index] )
+      {
+      // Keep the mapping:
+      S.StoreValues(filename, Values[index]);
+      ValuesType().swap( Values[index] );
+      }
+    // Update progress
+    Progress += ProgressTick;
+    ProgressEvent pe;
+    pe.SetProgress( Progress );
+    S.InvokeEvent( pe );
+    // For outside application tell which file is being processed:
+    FileNameEvent fe( filename );
+    S.InvokeEvent( fe );
+    }
+
+  double GetProgress() const { return Progress; }
+
+  bool SaveIndex() const
+    {
+    return ScannerIndex::Save( S.IndexFileName.c_str(), S, Sizes, Times, S.Tags );
+    }
+
+private:
+  Scanner &S;
+  const Tag Last;
+  const ScannerIndex *Index;
+  std::vector<uint64_t> Sizes;
+  std::vector<int64_t> Times;
+  std::vector<char> Read;
+  std::vector<ValuesType> Values;
+  double Progress;
+  const double ProgressTick;
+};
 
 Scanner::~Scanner()
 {
@@ -124,46 +461,20 @@ bool Scanner::Scan( Directory::FilenamesType const & filenames )
       if( last < privatelast ) last = privatelast;
       }
 
-    StringFilter sf;
-    Directory::FilenamesType::const_iterator it = Filenames.begin();
-    const double progresstick = 1. / (double)Filenames.size();
+    ScannerIndex index;
+    const bool hasindex = !IndexFileName.empty()
+      && index.Load( IndexFileName.c_str(), Tags );
+
     Progress = 0;
-    for(; it != Filenames.end(); ++it)
+    ScannerJob job(*this, last, hasindex ? &index : NULL);
+    WorkerPool pool;
+    pool.SetNumberOfThreads( NumberOfThreads );
+    pool.Run( job, (unsigned int)Filenames.size() );
+    Progress = job.GetProgress();
+
+    if( !IndexFileName.empty() )
       {
-      Reader reader;
-      const char *filename = it->c_str();
-      assert( filename );
-      reader.SetFileName( filename );
-      bool read = false;
-      try
-        {
-        // Start reading all tags, including the 'last' one:
-        read = reader.ReadUpToTag(last, SkipTags);
-        }
-      catch(std::exception & ex)
-        {
-        (void)ex;
-        gdcmWarningMacro( "Failed to read:" << filename << " with ex:" << ex.what() );
-        }
-      catch(...)
-        {
-        gdcmWarningMacro( "Failed to read:" << filename  << " with unknown error" );
-        }
-      if( read )
-        {
-        // Keep the mapping:
-        sf.SetFile( reader.GetFile() );
-        Scanner::ProcessPublicTag(sf, filename);
-        //Scanner::ProcessPrivateTag(sf, filename);
-        }
-      // Update progress
-      Progress += progresstick;
-      ProgressEvent pe;
-      pe.SetProgress( Progress );
-      this->InvokeEvent( pe );
-      // For outside application tell which file is being processed:
-      FileNameEvent fe( filename );
-      this->InvokeEvent( fe );
+      job.SaveIndex();
       }
     }
 
@@ -352,9 +663,29 @@ Directory::FilenamesType Scanner::GetOrderedValues(Tag const &t) const
 }
 
 void Scanner::ProcessPublicTag(StringFilter &sf, const char *filename)
+{
+  std::vector< std::pair<Tag, std::string> > values;
+  ReadValues(sf, values);
+  StoreValues(filename, values);
+}
+
+void Scanner::StoreValues(const char *filename, std::vector< std::pair<Tag, std::string> > const &values)
 {
   assert( filename );
   TagToValue &mapping = Mappings[filename];
+  std::vector< std::pair<Tag, std::string> >::const_iterator it = values.begin();
+  for( ; it != values.end(); ++it )
+    {
+    // Store the potentially new value:
+    const char *value = Values.insert( it->second ).first->c_str();
+    assert( value );
+    mapping.insert(
+      TagToValue::value_type(it->first, value));
+    }
+}
+
+void Scanner::ReadValues(StringFilter &sf, std::vector< std::pair<Tag, std::string> > &values) const
+{
   const File& file = sf.GetFile();
 
   const FileMetaInformation & header = file.GetHeader();
@@ -376,14 +707,7 @@ void Scanner::ProcessPublicTag(StringFilter &sf, const char *filename)
         //  s.resize( std::min( s.size(), strlen( s.c_str() ) ) );
         //  }
         std::string s = sf.ToString(de.GetTag());
-
-        // Store the potentially new value:
-        Values.insert( s );
-        assert( Values.find( s ) != Values.end() );
-        const char *value = Values.find( s )->c_str();
-        assert( value );
-        mapping.insert(
-          TagToValue::value_type(*tag, value));
+        values.push_back( std::make_pair(*tag, s) );
         }
       }
     else
@@ -400,14 +724,7 @@ void Scanner::ProcessPublicTag(StringFilter &sf, const char *filename)
         //  s.resize( std::min( s.size(), strlen( s.c_str() ) ) );
         //  }
         std::string s = sf.ToString(de.GetTag());
-
-        // Store the potentially new value:
-        Values.insert( s );
-        assert( Values.find( s ) != Values.end() );
-        const char *value = Values.find( s )->c_str();
-        assert( value );
-        mapping.insert(
-          TagToValue::value_type(*tag, value));
+        values.push_back( std::make_pair(*tag, s) );
         }
       }
     } // end for
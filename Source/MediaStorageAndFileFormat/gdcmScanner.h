@@ -23,6 +23,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <string.h> // strcmp
 
@@ -47,6 +48,10 @@ class StringFilter;
  * std::string. Then the address of the cstring underlying the std::string is
  * used in the std::map.
  *
+ * Files can be read from several threads (see SetNumberOfThreads), the
+ * result and the order of the events are identical to a single threaded
+ * scan.
+ *
  * This class implement the Subject/Observer pattern trigger the following events:
  * \li ProgressEvent
  * \li StartEvent
@@ -56,7 +61,7 @@ class GDCM_EXPORT Scanner : public Subject
 {
   friend std::ostream& operator<<(std::ostream &_os, const Scanner &s);
 public:
-  Scanner():Values(),Filenames(),Mappings() {}
+  Scanner():Values(),Filenames(),Mappings(),NumberOfThreads(1) {}
   ~Scanner();
 
   /// struct to map a filename to a value
@@ -81,6 +86,21 @@ public:
   void AddSkipTag( Tag const & t );
   void ClearSkipTags();
 
+  /// Number of threads reading files concurrently during Scan (default 1).
+  /// 0 means one thread per processor.
+  void SetNumberOfThreads(unsigned int n) { NumberOfThreads = n; }
+  unsigned int GetNumberOfThreads() const { return NumberOfThreads; }
+
+  /// Persistent index of the scanned values. When set, Scan first loads the
+  /// index (if it exists and was created for the same set of tags), only
+  /// reads the files that are new or whose size or modification time
+  /// changed, and then overwrites the index with the result of the scan.
+  /// \warning use one index per set of files and tags: the index only
+  /// keeps the files of the last Scan. Modification times have a one second
+  /// resolution.
+  void SetIndexFileName(const char *filename) { IndexFileName = filename ? filename : ""; }
+  const char *GetIndexFileName() const { return IndexFileName.c_str(); }
+
   /// Start the scan !
   bool Scan( Directory::FilenamesType const & filenames );
 
@@ -156,6 +176,10 @@ public:
 
 protected:
   void ProcessPublicTag(StringFilter &sf, const char *filename);
+  /// Read the values of the requested Tags from the file held by \param sf
+  void ReadValues(StringFilter &sf, std::vector< std::pair<Tag, std::string> > &values) const;
+  /// Store the values read from \param filename
+  void StoreValues(const char *filename, std::vector< std::pair<Tag, std::string> > const &values);
 private:
   // struct to store all uniq tags in ascending order:
   typedef std::set< Tag > TagsType;
@@ -170,6 +194,9 @@ private:
   MappingType Mappings;
 
   double Progress;
+  unsigned int NumberOfThreads;
+  std::string IndexFileName;
+  friend class ScannerJob;
 };
 //-----------------------------------------------------------------------------
 inline std::ostream& operator<<(std::ostream &os, const Scanner &s)
@@ -27,6 +27,7 @@ this file defines the messages for the cecho action
 #include "gdcmPresentationContextRQ.h"
 #include "gdcmCommandDataSet.h"
 #include "gdcmULConnection.h"
+#include "gdcmPDataTFPDU.h"
 
 namespace gdcm{
 namespace network{
@@ -81,5 +82,61 @@ std::vector<PresentationDataValue>  CEchoRSP::ConstructPDVByDataSet(const DataSe
   return thePDV;
 }
 
+std::vector<PresentationDataValue> CEchoRSP::ConstructPDV(const ULConnection &, const BaseRootQuery* inRootQuery)
+{
+  // A response answers a given request (its Message ID and presentation
+  // context), which this signature does not provide
+  (void)inRootQuery;
+  gdcmErrorMacro( "C-ECHO-RSP can only be built from the C-ECHO-RQ it answers" );
+  return std::vector<PresentationDataValue>();
+}
+
+std::vector<PresentationDataValue> CEchoRSP::ConstructPDV(const DataSet* inDataSet,
+  const BasePDU* inPDU)
+{
+  CommandDataSet ds;
+  PresentationContextRQ pc( UIDs::VerificationSOPClass );
+  ds.Insert( pc.GetAbstractSyntax().GetAsDataElement() );
+  {
+  Attribute<0x0,0x100> at = { 32816 };
+  ds.Insert( at.GetAsDataElement() );
+  }
+  {
+  // Message ID Being Responded To
+  Attribute<0x0,0x110> msgid = { 0 };
+  msgid.SetFromDataSet( *inDataSet );
+  Attribute<0x0,0x120> at = { 0 };
+  at.SetValue( msgid.GetValue() );
+  ds.Insert( at.GetAsDataElement() );
+  }
+  {
+  Attribute<0x0,0x800> at = { 257 };
+  ds.Insert( at.GetAsDataElement() );
+  }
+  {
+  Attribute<0x0,0x900> at = { 0 };
+  ds.Insert( at.GetAsDataElement() );
+  }
+  {
+  Attribute<0x0,0x0> at = { 0 };
+  unsigned int glen = ds.GetLength<ImplicitDataElement>();
+  assert( (glen % 2) == 0 );
+  at.SetValue( glen );
+  ds.Insert( at.GetAsDataElement() );
+  }
+
+  // answer on the presentation context of the request
+  const PDataTFPDU* theDataPDU = dynamic_cast<const PDataTFPDU*>(inPDU);
+  assert( theDataPDU );
+  PresentationDataValue thePDV;
+  thePDV.SetPresentationContextID(
+    theDataPDU->GetPresentationDataValue(0).GetPresentationContextID() );
+  thePDV.SetDataSet(ds);
+  thePDV.SetMessageHeader(3);
+  std::vector<PresentationDataValue> thePDVs;
+  thePDVs.push_back(thePDV);
+  return thePDVs;
+}
+
 }//namespace network
 }//namespace gdcm
@@ -24,6 +24,7 @@ namespace gdcm{
   namespace network{
 
 class ULConnection;
+class BasePDU;
 
 /**
  * \brief CEchoRQ
@@ -40,8 +41,12 @@ class CEchoRQ : public BaseCompositeMessage {
  * this file defines the messages for the cecho action
  */
     class CEchoRSP : public BaseCompositeMessage {
+      /// Always fails (no PDV): use the overload taking the request instead
+      std::vector<PresentationDataValue> ConstructPDV(const ULConnection &inConnection, const BaseRootQuery* inRootQuery);//to fulfill the virtual contract
     public:
       std::vector<PresentationDataValue> ConstructPDVByDataSet(const DataSet* inDataSet);
+      /// Response to the C-ECHO-RQ inDataSet, received in the PDU inPC
+      std::vector<PresentationDataValue> ConstructPDV(const DataSet* inDataSet, const BasePDU* inPC);
     };
   }
 }
@@ -77,7 +77,9 @@ std::vector<PresentationDataValue> CFindRQ::ConstructPDV(
   ds.Insert( at.GetAsDataElement() );
   }
   {
-  Attribute<0x0,0x110> at = { 1 };
+  // Responses are matched by Message ID when several C-FIND are outstanding
+  Attribute<0x0,0x110> at = { 0 };
+  at.SetValue( inConnection.GetNextMessageID() );
   ds.Insert( at.GetAsDataElement() );
   }
   {
@@ -184,11 +184,11 @@ const DataSet* inDataSet = &file.GetDataSet();
   Attribute<0x0,0x100> at = { 1 };
   ds.Insert( at.GetAsDataElement() );
   }
-static uint32_t messageid = 1;
   {
+  // Numbered per association, so that concurrent associations do not share
+  // a counter
   Attribute<0x0,0x110> at = { 0 };
-  at.SetValue( (unsigned short)messageid++ );
-  assert( messageid < std::numeric_limits<uint32_t>::max());
+  at.SetValue( inConnection.GetNextMessageID() );
   ds.Insert( at.GetAsDataElement() );
   }
   {
@@ -218,14 +218,7 @@ if( !writeDataSet )
   // now let's chunk'ate the dataset:
 {
   std::stringstream ss;
-#if 0
-  inDataSet->Write<ImplicitDataElement,SwapperNoOp>( ss );
-#else
-  DataSetWriter writer;
-  writer.SetStream( ss );
-  writer.SetFile( file );
-  writer.Write();
-#endif
+  WriteDataSet( ss, file );
 
   std::string ds_copy = ss.str();
   // E: 0006:0308 DUL Illegal PDU Length 16390.  Max expected 16384
@@ -263,6 +256,14 @@ if( !writeDataSet )
 
 }
 
+bool CStoreRQ::WriteDataSet(std::ostream &os, const File& file)
+{
+  DataSetWriter writer;
+  writer.SetStream( os );
+  writer.SetFile( file );
+  return writer.Write();
+}
+
 //private hack
 std::vector<PresentationDataValue> CStoreRQ::ConstructPDV(
 const ULConnection &inConnection, const BaseRootQuery* inRootQuery)
@@ -283,7 +284,8 @@ std::vector<PresentationDataValue>  CStoreRSP::ConstructPDV(const ULConnection &
   return thePDVs;
 }
 
-std::vector<PresentationDataValue> CStoreRSP::ConstructPDV(const DataSet* inDataSet, const BasePDU* inPDU){
+std::vector<PresentationDataValue> CStoreRSP::ConstructPDV(const DataSet* inDataSet, const BasePDU* inPDU,
+  uint16_t inStatus){
   std::vector<PresentationDataValue> thePDVs;
 
 ///should be passed the received dataset, ie, the cstorerq, so that
@@ -319,6 +321,7 @@ std::vector<PresentationDataValue> CStoreRSP::ConstructPDV(const DataSet* inData
     }
     {
     Attribute<0x0,0x900> at = { 0 };
+    at.SetValue( inStatus );
     ds.Insert( at.GetAsDataElement() );
     }
     {
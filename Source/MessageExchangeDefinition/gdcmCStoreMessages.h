@@ -33,6 +33,10 @@ class CStoreRQ : public BaseCompositeMessage {
     public:
       std::vector<PresentationDataValue> ConstructPDV(const ULConnection &inConnection,
         const File& file,  bool writeDataSet = true );
+
+      /// Serialize the data set of file, as sent after the command (see
+      /// ConstructPDV with writeDataSet = false)
+      static bool WriteDataSet(std::ostream &os, const File& file);
     };
 
 /**
@@ -42,7 +46,9 @@ class CStoreRQ : public BaseCompositeMessage {
     class CStoreRSP : public BaseCompositeMessage {
       std::vector<PresentationDataValue> ConstructPDV(const ULConnection &inConnection, const BaseRootQuery* inRootQuery);//to fulfill the virtual contract
     public:
-      std::vector<PresentationDataValue> ConstructPDV(const DataSet* inDataSet, const BasePDU* inPC);
+      /// inStatus is the Status (0000,0900) of the response, 0 for success
+      std::vector<PresentationDataValue> ConstructPDV(const DataSet* inDataSet, const BasePDU* inPC,
+        uint16_t inStatus = 0);
     };
   }
 }
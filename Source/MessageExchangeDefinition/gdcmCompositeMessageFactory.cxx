@@ -39,15 +39,21 @@ namespace network {
     CEchoRQ theEchoRQ;
     return theEchoRQ.ConstructPDV(inConnection,NULL);
     }
+  std::vector<PresentationDataValue> CompositeMessageFactory::ConstructCEchoRSP(const DataSet *inDataSet, const BasePDU* inPDU)
+    {
+    CEchoRSP theEchoRSP;
+    return theEchoRSP.ConstructPDV(inDataSet, inPDU);
+    }
 
   std::vector<PresentationDataValue> CompositeMessageFactory::ConstructCStoreRQ(const ULConnection& inConnection, const File &file, bool writeDataSet /*= true*/ )
     {
     CStoreRQ theStoreRQ;
     return theStoreRQ.ConstructPDV( inConnection, file, writeDataSet );
     }
-  std::vector<PresentationDataValue> CompositeMessageFactory::ConstructCStoreRSP(const DataSet *inDataSet, const BasePDU* inPDU) {
+  std::vector<PresentationDataValue> CompositeMessageFactory::ConstructCStoreRSP(const DataSet *inDataSet, const BasePDU* inPDU,
+    uint16_t inStatus) {
     CStoreRSP theStoreRSP;
-    return theStoreRSP.ConstructPDV(inDataSet, inPDU);
+    return theStoreRSP.ConstructPDV(inDataSet, inPDU, inStatus);
   }
   std::vector<PresentationDataValue> CompositeMessageFactory::ConstructCFindRQ(const ULConnection& inConnection, const BaseRootQuery* inRootQuery) {
     CFindRQ theFindRQ;
@@ -42,9 +42,11 @@ class CompositeMessageFactory
       //easily placed into the appropriate pdatapdu in the pdufactory,
       //this approach without a base class (but done internally) is useful.
       static std::vector<PresentationDataValue> ConstructCEchoRQ(const ULConnection& inConnection);
+      static std::vector<PresentationDataValue> ConstructCEchoRSP(const DataSet *inDataSet, const BasePDU* inPC);
 
       static std::vector<PresentationDataValue> ConstructCStoreRQ(const ULConnection& inConnection,const File &file, bool writeDataSet = true );
-      static std::vector<PresentationDataValue> ConstructCStoreRSP(const DataSet *inDataSet, const BasePDU* inPC);
+      static std::vector<PresentationDataValue> ConstructCStoreRSP(const DataSet *inDataSet, const BasePDU* inPC,
+        uint16_t inStatus = 0);
 
       static  std::vector<PresentationDataValue> ConstructCFindRQ(const ULConnection& inConnection, const BaseRootQuery* inRootQuery);
 
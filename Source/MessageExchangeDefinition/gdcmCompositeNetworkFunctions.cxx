@@ -37,6 +37,7 @@
 #include "gdcmULWritingCallback.h"
 #include "gdcmULBasicCallback.h"
 #include "gdcmPresentationContextGenerator.h"
+#include "gdcmWorkerPool.h"
 
 namespace gdcm
 {
@@ -202,6 +203,8 @@ bool CompositeNetworkFunctions::CMove( const char *remote, uint16_t portno,
 
   network::ULWritingCallback theCallback;
   theCallback.SetDirectory(outputdir);
+  // write the received datasets to disk as they arrive
+  theCallback.SetIncremental(true);
   bool ret = theManager.SendMove( query, &theCallback );
   if( !ret ) return false;
 
@@ -339,6 +342,99 @@ public:
   virtual void ShowDataSet(Subject *, const Event &) {}
 };
 
+// Status (0000,0900) of a C-STORE-RSP
+static uint16_t GetStoreStatus(const DataSet &ds, const std::string &filename)
+{
+  assert ( ds.FindDataElement(Tag(0x0, 0x0900)) );
+  DataElement const & de = ds.GetDataElement(Tag(0x0,0x0900));
+  Attribute<0x0,0x0900> at;
+  at.SetFromDataElement( de );
+  // PS 3.4 - 2011
+  // Table W.4-1 C-STORE RESPONSE STATUS VALUES
+  const uint16_t theVal = at.GetValue();
+  switch( theVal )
+    {
+  case 0x0:
+    gdcmDebugMacro( "C-Store of file " << filename << " was successful." );
+    break;
+  case 0xA700:
+  case 0xA900:
+  case 0xC000:
+      {
+      // TODO: value from 0901 ?
+      gdcmErrorMacro( "C-Store of file " << filename << " was a failure." );
+      Attribute<0x0,0x0902> errormsg;
+      errormsg.SetFromDataSet( ds );
+      const char *themsg = errormsg.GetValue();
+      assert( themsg ); (void)themsg;
+      gdcmErrorMacro( "Response Status: " << themsg );
+      }
+    break;
+  default:
+    if( (theVal & 0xF000) == 0xB000 ) // Warning: the file was stored anyway
+      {
+      gdcmWarningMacro( "C-Store of file " << filename << " returned warning: " << theVal );
+      }
+    else
+      {
+      gdcmErrorMacro( "Unhandle error code: " << theVal );
+      }
+    }
+  return theVal;
+}
+
+// Record the status of the C-STORE of one file, -1 until its response is in
+class StoreCallback : public network::ULConnectionCallback
+{
+public:
+  StoreCallback():Status(-1),Filename(NULL) {}
+  void HandleDataSet(const DataSet &) {}
+  void HandleResponse(const DataSet &ds)
+    {
+    assert( Filename );
+    Status = GetStoreStatus( ds, *Filename );
+    DataSetHandled();
+    }
+  int Status;
+  const std::string *Filename;
+};
+
+// C-STORE a single file on an established association, the status goes to
+// theCallback. With async the response is not waited for (see
+// ULConnectionManager::SendStoreAsync). Return false when the association
+// cannot be used anymore (a file that cannot be read is not sent, its status
+// stays -1).
+static bool StoreFile(network::ULConnectionManager &theManager,
+  const std::string &filename, StoreCallback &theCallback, bool async = false)
+{
+  theCallback.Filename = &filename;
+  Reader reader;
+  reader.SetMemoryMappedFile( filename.c_str() );
+  gdcmDebugMacro( "Processing: " << filename );
+  if( !reader.Read() )
+    {
+    gdcmErrorMacro( "Could not read: " << filename );
+    return true;
+    }
+  const File &file = reader.GetFile();
+  if( async )
+    {
+    return theManager.SendStoreAsync( file, &theCallback ) != 0;
+    }
+  theManager.SendStore( file, &theCallback );
+  if( theCallback.Status < 0 )
+    {
+    gdcmErrorMacro( "Could not C-STORE: " << filename );
+    return false;
+    }
+  return true;
+}
+
+static bool IsStoreSuccess(uint16_t status)
+{
+  return status == 0x0 || (status & 0xF000) == 0xB000;
+}
+
 bool CompositeNetworkFunctions::CStore( const char *remote, uint16_t portno,
   const Directory::FilenamesType& filenames,
   const char *aetitle, const char *call)
@@ -385,53 +481,15 @@ bool CompositeNetworkFunctions::CStore( const char *remote, uint16_t portno,
       const std::string & filename = files[i];
       fn = filename.c_str();
       assert( fn && *fn ); (void)fn;
-      Reader reader;
-      reader.SetFileName( filename.c_str() );
-      gdcmDebugMacro( "Processing: " << filename );
-      if( !reader.Read() )
+      StoreCallback theCallback;
+      if( !StoreFile( theManager, filename, theCallback ) || theCallback.Status < 0 )
         {
-        gdcmErrorMacro( "Could not read: " << filename );
+        theManager.BreakConnection(-1);
         return false;
         }
-      const File &file = reader.GetFile();
-      std::vector<DataSet> theDataSets;
-      theDataSets = theManager.SendStore( file );
-      if( theDataSets.empty() )
+      if( !IsStoreSuccess( (uint16_t)theCallback.Status ) )
         {
-        gdcmErrorMacro( "Could not C-STORE: " << filename );
-        return false;
-        }
-      assert( theDataSets.size() == 1 );
-      const DataSet &ds = theDataSets[0];
-      assert ( ds.FindDataElement(Tag(0x0, 0x0900)) );
-      DataElement const & de = ds.GetDataElement(Tag(0x0,0x0900));
-      Attribute<0x0,0x0900> at;
-      at.SetFromDataElement( de );
-      // PS 3.4 - 2011
-      // Table W.4-1 C-STORE RESPONSE STATUS VALUES
-      const uint16_t theVal = at.GetValue();
-      switch( theVal )
-        {
-      case 0x0:
-        gdcmDebugMacro( "C-Store of file " << filename << " was successful." );
-        break;
-      case 0xA700:
-      case 0xA900:
-      case 0xC000:
-          {
-          // TODO: value from 0901 ?
-          gdcmErrorMacro( "C-Store of file " << filename << " was a failure." );
-          Attribute<0x0,0x0902> errormsg;
-          errormsg.SetFromDataSet( ds );
-          const char *themsg = errormsg.GetValue();
-          assert( themsg ); (void)themsg;
-          gdcmErrorMacro( "Response Status: " << themsg );
-          ret = false; // at least one file was not sent correctly
-          }
-        break;
-      default:
-        gdcmErrorMacro( "Unhandle error code: " << theVal );
-        gdcmAssertAlwaysMacro( 0 );
+        ret = false; // at least one file was not sent correctly
         }
       theManager.InvokeEvent( IterationEvent() );
       }
@@ -456,4 +514,156 @@ bool CompositeNetworkFunctions::CStore( const char *remote, uint16_t portno,
   return ret;
 }
 
+// Wall clock time in seconds
+static double GetSeconds()
+{
+  char date[22];
+  time_t t = 0;
+  long microseconds = 0;
+  if( !System::GetCurrentDateTime(date)
+    || !System::ParseDateTime(t, microseconds, date) ) return 0;
+  return (double)t + (double)microseconds * 1e-6;
+}
+
+/*
+ * Each worker of the pool owns one association, so that a worker takes the
+ * next file from the queue as soon as its association is free again (or, when
+ * asynchronous operations were negotiated, as soon as there is room in its
+ * window of outstanding operations). An association that stops answering is
+ * not used anymore: the files its worker picks afterward are reported as not
+ * sent. A file that cannot be read is only reported as not sent itself.
+ */
+class CStoreJob : public WorkerPool::Job
+{
+public:
+  CStoreJob(const Directory::FilenamesType &filenames,
+    std::vector< SmartPointer<network::ULConnectionManager> > &managers):
+    Filenames(filenames),Managers(managers),Lost(managers.size(), 0),
+    Callbacks(filenames.size()) {}
+
+  void Execute(unsigned int index) { ExecuteOnWorker(index, 0); }
+  void ExecuteOnWorker(unsigned int index, unsigned int worker)
+    {
+    assert( worker < Managers.size() );
+    if( Lost[worker] ) return;
+    network::ULConnectionManager &theManager = *Managers[worker];
+    const std::string &filename = Filenames[index];
+    try
+      {
+      const bool async = theManager.GetMaximumNumberOperationsInvoked() != 1;
+      if( !StoreFile( theManager, filename, Callbacks[index], async ) )
+        {
+        Lost[worker] = 1;
+        }
+      }
+    catch ( Exception &e )
+      {
+      // The presentation context was refused: nothing was sent, the
+      // association is still usable
+      (void)e;
+      gdcmErrorMacro( "C-Store of file " << filename << " was unsuccessful: " << e.what() );
+      }
+    catch (...)
+      {
+      gdcmErrorMacro( "C-Store of file " << filename << " was unsuccessful." );
+      Lost[worker] = 1;
+      }
+    }
+
+  const Directory::FilenamesType &Filenames;
+  std::vector< SmartPointer<network::ULConnectionManager> > &Managers;
+  std::vector<char> Lost; // per worker
+  std::vector<StoreCallback> Callbacks;
+};
+
+bool CompositeNetworkFunctions::CStore( const char *remote, uint16_t portno,
+  const Directory::FilenamesType& filenames,
+  unsigned int nassociations, StoreReport *report,
+  const char *aetitle, const char *call, uint16_t maxoperations)
+{
+  if( !remote ) return false;
+  if( !aetitle )
+    {
+    aetitle = "GDCMSCU";
+    }
+  if( !call )
+    {
+    call = "ANY-SCP";
+    }
+  const double start = GetSeconds();
+  if( report )
+    {
+    report->Statuses.assign( filenames.size(), -1 );
+    report->NumberOfAssociations = 0;
+    report->NumberOfBytes = 0;
+    report->Seconds = 0;
+    }
+  if( filenames.empty() ) return true;
+
+  PresentationContextGenerator generator;
+  if( !generator.GenerateFromFilenames(filenames) )
+    {
+    gdcmErrorMacro( "Failed to generate pres context." );
+    return false;
+    }
+
+  // Associations are set up one after the other from the calling thread, no
+  // point in having more of them than files
+  if( !nassociations ) nassociations = WorkerPool::GetNumberOfProcessors();
+  if( nassociations > filenames.size() ) nassociations = (unsigned int)filenames.size();
+  std::vector< SmartPointer<network::ULConnectionManager> > managers;
+  for( unsigned int i = 0; i < nassociations; ++i )
+    {
+    SmartPointer<network::ULConnectionManager> ps = new network::ULConnectionManager;
+    ps->SetMaximumNumberOperationsInvoked( maxoperations );
+    if( !ps->EstablishConnection(aetitle, call, remote, 0,
+        portno, 1000, generator.GetPresentationContexts() ))
+      {
+      gdcmWarningMacro( "Failed to establish association " << i << "." );
+      continue;
+      }
+    managers.push_back( ps );
+    }
+  if( managers.empty() )
+    {
+    gdcmErrorMacro( "Failed to establish connection." );
+    return false;
+    }
+
+  CStoreJob job( filenames, managers );
+  WorkerPool pool;
+  pool.SetNumberOfThreads( (unsigned int)managers.size() );
+  pool.Run( job, (unsigned int)filenames.size() );
+
+  for( size_t i = 0; i < managers.size(); ++i )
+    {
+    // the responses of the last (asynchronous) C-STORE are still to come
+    managers[i]->WaitForResponses();
+    managers[i]->BreakConnection(-1);//wait for a while for the connection to break, ie, infinite
+    }
+
+  bool ret = true;
+  uint64_t nbytes = 0;
+  std::vector<int> statuses( filenames.size() );
+  for( size_t i = 0; i < filenames.size(); ++i )
+    {
+    statuses[i] = job.Callbacks[i].Status;
+    if( statuses[i] < 0 || !IsStoreSuccess( (uint16_t)statuses[i] ) )
+      ret = false;
+    else
+      nbytes += System::FileSize( filenames[i].c_str() );
+    }
+  const double seconds = GetSeconds() - start;
+  gdcmDebugMacro( "C-Store of " << nbytes << " bytes over " << managers.size()
+    << " associations took " << seconds << "s" );
+  if( report )
+    {
+    report->Statuses = statuses;
+    report->NumberOfAssociations = (unsigned int)managers.size();
+    report->NumberOfBytes = nbytes;
+    report->Seconds = seconds;
+    }
+  return ret;
+}
+
 } // end namespace gdcm
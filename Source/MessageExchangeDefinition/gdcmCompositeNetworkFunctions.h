@@ -117,6 +117,35 @@ public:
   static bool CStore( const char *remote, uint16_t portno,
     const Directory::FilenamesType & filenames,
     const char *aetitle = NULL, const char *call = NULL);
+
+  /// Outcome of a C-STORE over several associations
+  struct StoreReport
+    {
+    /// For each file, the Status (0000,0900) of its C-STORE-RSP, or -1 when
+    /// the file could not be read or sent
+    std::vector<int> Statuses;
+    /// Number of associations actually established
+    unsigned int NumberOfAssociations;
+    /// Number of file bytes successfully stored
+    uint64_t NumberOfBytes;
+    /// Wall clock time of the whole transfer, association set up included
+    double Seconds;
+    };
+
+  /// Same as above, but the files are sent over nassociations concurrent
+  /// associations (0 means one per processor), each one taking the next file
+  /// to send from a shared queue as soon as its previous C-STORE-RSP is in.
+  /// Associations the remote server refuses are simply not used.
+  /// \param report when not NULL, receive the per-file status and throughput
+  /// \param maxoperations number of C-STORE each association may have
+  /// outstanding (Asynchronous Operations Window, 0 for no limit). The remote
+  /// server may accept less, default is to wait for each response.
+  /// \return true if it worked for all files
+  static bool CStore( const char *remote, uint16_t portno,
+    const Directory::FilenamesType & filenames,
+    unsigned int nassociations, StoreReport *report,
+    const char *aetitle = NULL, const char *call = NULL,
+    uint16_t maxoperations = 1);
 };
 
 } // end namespace gdcm
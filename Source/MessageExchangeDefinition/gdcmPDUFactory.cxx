@@ -162,6 +162,22 @@ std::vector<BasePDU*> PDUFactory::CreateCEchoPDU(const ULConnection& inConnectio
   return outVector;
 }
 
+std::vector<BasePDU*> PDUFactory::CreateCEchoRSPPDU(const DataSet *inDataSet,
+  const BasePDU* inPDU)
+{
+  std::vector<PresentationDataValue> pdv =
+    CompositeMessageFactory::ConstructCEchoRSP(inDataSet, inPDU);
+  std::vector<PresentationDataValue>::iterator pdvItor;
+  std::vector<BasePDU*> outVector;
+  for (pdvItor = pdv.begin(); pdvItor < pdv.end(); pdvItor++)
+    {
+    PDataTFPDU* thePDataTFPDU = new PDataTFPDU();
+    thePDataTFPDU->AddPresentationDataValue( *pdvItor );
+    outVector.push_back(thePDataTFPDU);
+    }
+  return outVector;
+}
+
 std::vector<BasePDU*> PDUFactory::CreateCMovePDU(const ULConnection&
   inConnection, const BaseRootQuery* inRootQuery)
 {
@@ -195,10 +211,10 @@ std::vector<BasePDU*> PDUFactory::CreateCStoreRQPDU(const ULConnection& inConnec
 }
 
 std::vector<BasePDU*> PDUFactory::CreateCStoreRSPPDU(const DataSet* inDataSet,
-  const BasePDU* inPDU)
+  const BasePDU* inPDU, uint16_t inStatus)
 {
   std::vector<PresentationDataValue> pdv =
-    CompositeMessageFactory::ConstructCStoreRSP(inDataSet, inPDU );
+    CompositeMessageFactory::ConstructCStoreRSP(inDataSet, inPDU, inStatus );
   std::vector<PresentationDataValue>::iterator pdvItor;
   std::vector<BasePDU*> outVector;
   for (pdvItor = pdv.begin(); pdvItor < pdv.end(); pdvItor++)
@@ -356,5 +372,28 @@ std::vector<PresentationDataValue> PDUFactory::GetPDVs(const std::vector<BasePDU
     }
   return outPDVs;
 }
+
+bool PDUFactory::ReadDataSetInto(std::istream &is, std::ostream &os, BasePDU* &outPDU)
+{
+  outPDU = NULL;
+  bool last = false;
+  while( !last )
+    {
+    uint8_t itemtype = 0x0;
+    is.read( (char*)&itemtype, 1 );
+    if( !is ) return false;
+    if( itemtype != 0x4 )
+      {
+      outPDU = ConstructPDU(itemtype);
+      return false;
+      }
+    PDataTFPDU thePDataTFPDU;
+    thePDataTFPDU.ReadInto( is, os );
+    if( !is ) return false;
+    last = thePDataTFPDU.IsLastFragment();
+    }
+  return true;
+}
+
 } // end namespace network
 } // end namespace gdcm
@@ -35,7 +35,7 @@ namespace gdcm{
  * appropriate PDU. This way, the event loop doesn't have to know about all
  * the different PDU types.
  */
-  class PDUFactory {
+  class GDCM_EXPORT PDUFactory {
       public:
       static BasePDU* ConstructPDU(uint8_t itemtype);//eventually needs to be smartpointer'd
       static EEventID DetermineEventByPDU(const BasePDU* inPDU);
@@ -48,8 +48,10 @@ namespace gdcm{
       //the connection is necessary to construct the stream of PDVs that will
       //be then placed into the vector of PDUs
       static std::vector<BasePDU*> CreateCEchoPDU(const ULConnection& inConnection);
+      static std::vector<BasePDU*> CreateCEchoRSPPDU(const DataSet *inDataSet, const BasePDU* inPC);
       static std::vector<BasePDU*> CreateCStoreRQPDU(const ULConnection& inConnection, const File &file, bool writeDataSet = true );
-      static std::vector<BasePDU*> CreateCStoreRSPPDU(const DataSet *inDataSet, const BasePDU* inPC);
+      static std::vector<BasePDU*> CreateCStoreRSPPDU(const DataSet *inDataSet, const BasePDU* inPC,
+        uint16_t inStatus = 0);
       static std::vector<BasePDU*> CreateCFindPDU(const ULConnection& inConnection, const BaseRootQuery* inRootQuery);
       static std::vector<BasePDU*> CreateCMovePDU(const ULConnection& inConnection, const BaseRootQuery* inRootQuery);
 
@@ -65,6 +67,13 @@ namespace gdcm{
       //all operations have these as the payload of the data sending operation
       //however, echo does not have a dataset in the pdv.
       static std::vector<PresentationDataValue> GetPDVs(const std::vector<BasePDU*> & inDataPDUs);
+
+      //read the data pdus of a dataset from is, writing the blobs of their pdvs
+      //into os as they come, so that only one pdu is ever held in memory.
+      //returns true once the last fragment has been written. Otherwise, if the
+      //transfer was interrupted by another pdu (ie, an abort), outPDU is that pdu
+      //(not read yet, to be deleted by the caller), or NULL on read error.
+      static bool ReadDataSetInto(std::istream &is, std::ostream &os, BasePDU* &outPDU);
     };
   }
 }
@@ -56,9 +56,6 @@ std::istream &PDataTFPDU::Read(std::istream &is)
 
 std::istream &PDataTFPDU::ReadInto(std::istream &is, std::ostream &os)
 {
-  uint8_t itemtype = 0;
-  is.read( (char*)&itemtype, sizeof(ItemType) );
-  assert( itemtype == ItemType );
   uint8_t reserved2 = 0;
   is.read( (char*)&reserved2, sizeof(Reserved2) );
   uint32_t itemlength = ItemLength;
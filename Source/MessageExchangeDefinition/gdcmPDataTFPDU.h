@@ -35,6 +35,9 @@ class GDCM_EXPORT PDataTFPDU : public BasePDU
 public:
   PDataTFPDU();
   std::istream &Read(std::istream &is);
+  /// Same as Read, except that the PDV blobs are written to os as they are
+  /// read (the PDU type has already been read from is)
+  std::istream &ReadInto(std::istream &is, std::ostream &os);
   const std::ostream &Write(std::ostream &os) const;
 
   /// \internal Compute Size
@@ -58,8 +61,6 @@ public:
   void Print(std::ostream &os) const;
   bool IsLastFragment() const;
 
-protected:
-  std::istream &ReadInto(std::istream &is, std::ostream &os);
 private:
   static const uint8_t ItemType; // PDUType ?
   static const uint8_t Reserved2;
@@ -0,0 +1,135 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmPDataTFStreamBuf.h"
+#include "gdcmSwapper.h"
+#include "gdcmSubject.h"
+#include "gdcmProgressEvent.h"
+
+#include <ostream>
+#include <cstring>
+
+namespace gdcm
+{
+namespace network
+{
+
+PDataTFStreamBuf::PDataTFStreamBuf(std::ostream &os, uint8_t prescontid,
+  uint32_t maxpdusize):OStream(os),PresentationContextID(prescontid),
+  BytesSent(0),ProgressSubject(NULL),TotalLength(0),Failed(false)
+{
+  assert( prescontid );
+  // E: 0006:0308 DUL Illegal PDU Length 16390.  Max expected 16384
+  // The PDU Length does not include the PDU header, but does include the
+  // PDV Item Length (4 bytes), Presentation Context ID and Message Control
+  // Header.
+  if( maxpdusize <= 6 ) maxpdusize = 16384;
+  Buffer.resize( maxpdusize - 6 );
+  setp( &Buffer[0], &Buffer[0] + Buffer.size() );
+}
+
+PDataTFStreamBuf::~PDataTFStreamBuf()
+{
+}
+
+bool PDataTFStreamBuf::SendPDU(const char *data, size_t len, bool last)
+{
+  assert( len && len <= Buffer.size() );
+  char header[12];
+  header[0] = 0x04; // P-DATA-TF PDU Type
+  header[1] = 0x00;
+  uint32_t pdulength = (uint32_t)len + 6;
+  SwapperDoOp::SwapArray(&pdulength,1);
+  memcpy( header + 2, &pdulength, sizeof(pdulength) );
+  uint32_t itemlength = (uint32_t)len + 2;
+  SwapperDoOp::SwapArray(&itemlength,1);
+  memcpy( header + 6, &itemlength, sizeof(itemlength) );
+  header[10] = (char)PresentationContextID;
+  // E.2 MESSAGE CONTROL HEADER ENCODING: data set, last fragment or not
+  header[11] = last ? 0x2 : 0x0;
+
+  OStream.write( header, sizeof(header) );
+  OStream.write( data, len );
+  OStream.flush();
+  BytesSent += len;
+
+  if( ProgressSubject && TotalLength )
+    {
+    ProgressEvent pe;
+    pe.SetProgress( BytesSent < TotalLength ? (double)BytesSent / (double)TotalLength : 1. );
+    ProgressSubject->InvokeEvent( pe );
+    }
+  if( !OStream.good() ) Failed = true;
+  return !Failed;
+}
+
+bool PDataTFStreamBuf::SendPending()
+{
+  const size_t len = pptr() - pbase();
+  setp( &Buffer[0], &Buffer[0] + Buffer.size() );
+  return SendPDU( &Buffer[0], len, false );
+}
+
+PDataTFStreamBuf::int_type PDataTFStreamBuf::overflow(int_type c)
+{
+  if( traits_type::eq_int_type( c, traits_type::eof() ) )
+    return traits_type::not_eof( c );
+  // The buffer is only sent once more data comes in, so that the last
+  // fragment is always the one sent by Finish
+  if( Failed || !SendPending() )
+    return traits_type::eof();
+  *pptr() = traits_type::to_char_type( c );
+  pbump( 1 );
+  return c;
+}
+
+std::streamsize PDataTFStreamBuf::xsputn(const char *s, std::streamsize n)
+{
+  if( Failed ) return 0;
+  const size_t maxlen = Buffer.size();
+  std::streamsize ret = n;
+  while( n > 0 )
+    {
+    if( pptr() == pbase() && (size_t)n > maxlen )
+      {
+      // More than one PDU worth of data: send it straight from s
+      if( !SendPDU( s, maxlen, false ) ) return ret - n;
+      s += maxlen;
+      n -= maxlen;
+      continue;
+      }
+    if( pptr() == epptr() && !SendPending() ) return ret - n;
+    const size_t avail = epptr() - pptr();
+    const size_t len = (size_t)n < avail ? (size_t)n : avail;
+    memcpy( pptr(), s, len );
+    pbump( (int)len );
+    s += len;
+    n -= len;
+    }
+  return ret;
+}
+
+bool PDataTFStreamBuf::Finish()
+{
+  if( Failed ) return false;
+  const size_t len = pptr() - pbase();
+  if( len )
+    {
+    setp( &Buffer[0], &Buffer[0] + Buffer.size() );
+    SendPDU( &Buffer[0], len, true );
+    }
+  return !Failed;
+}
+
+} // end namespace network
+} // end namespace gdcm
@@ -0,0 +1,86 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#ifndef GDCMPDATATFSTREAMBUF_H
+#define GDCMPDATATFSTREAMBUF_H
+
+#include "gdcmTypes.h"
+
+#include <streambuf>
+#include <vector>
+
+namespace gdcm
+{
+class Subject;
+namespace network
+{
+
+/**
+ * \brief PDataTFStreamBuf
+ * std::streambuf cutting whatever is written into it into P-DATA-TF PDUs
+ * (one PDV each) sent to an output stream as soon as they are full.
+ *
+ * \details This is used to send a data set without staging it in memory:
+ * the memory used is bounded by one PDU whatever the size of the data set.
+ * Large writes (eg. the Pixel Data of a memory mapped file) are sent
+ * straight from the caller buffer without any copy.
+ * The last fragment is only known once Finish is called, which sends the
+ * pending bytes with the last fragment bit set.
+ */
+class GDCM_EXPORT PDataTFStreamBuf : public std::streambuf
+{
+public:
+  /// Send the PDUs to os, for the presentation context prescontid.
+  /// maxpdusize is the maximum PDU length accepted by the peer.
+  PDataTFStreamBuf(std::ostream &os, uint8_t prescontid, uint32_t maxpdusize);
+  ~PDataTFStreamBuf();
+
+  /// Invoke a ProgressEvent on s after each PDU, as the fraction of
+  /// totallength bytes sent so far
+  void SetProgress(Subject *s, size_t totallength) {
+    ProgressSubject = s;
+    TotalLength = totallength;
+  }
+
+  /// Send the pending bytes as the last fragment of the data set. Return
+  /// false if any PDU could not be written.
+  bool Finish();
+
+  /// Return the number of data set bytes sent so far
+  size_t GetNumberOfBytesSent() const { return BytesSent; }
+
+protected:
+  int_type overflow(int_type c);
+  std::streamsize xsputn(const char *s, std::streamsize n);
+
+private:
+  PDataTFStreamBuf(const PDataTFStreamBuf&); // Not implemented
+  void operator=(const PDataTFStreamBuf&); // Not implemented
+
+  bool SendPDU(const char *data, size_t len, bool last);
+  bool SendPending();
+
+  std::ostream &OStream;
+  uint8_t PresentationContextID;
+  std::vector<char> Buffer;
+  size_t BytesSent;
+  Subject *ProgressSubject;
+  size_t TotalLength;
+  bool Failed;
+};
+
+} // end namespace network
+
+} // end namespace gdcm
+
+#endif //GDCMPDATATFSTREAMBUF_H
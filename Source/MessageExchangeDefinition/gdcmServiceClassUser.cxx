@@ -232,8 +232,10 @@ bool ServiceClassUser::SendEcho()
 bool ServiceClassUser::SendStore(const char *filename)
 {
   if( !filename ) return false;
+  // Values of a memory mapped file are not copied, the data set is sent
+  // straight from the file image
   Reader reader;
-  reader.SetFileName( filename );
+  reader.SetMemoryMappedFile( filename );
   bool b = reader.Read();
   if( !b )
     {
@@ -260,7 +262,7 @@ bool ServiceClassUser::SendStore(File const &file)
   std::vector<BasePDU*> theDataPDU;
   try
     {
-    theDataPDU = PDUFactory::CreateCStoreRQPDU(*mConnection, file);
+    theDataPDU = PDUFactory::CreateCStoreRQPDU(*mConnection, file, false);
     }
   catch ( std::exception &ex )
     {
@@ -273,6 +275,7 @@ bool ServiceClassUser::SendStore(File const &file)
   network::ULConnectionCallback* inCallback = &theCallback;
 
   ULEvent theEvent(ePDATArequest, theDataPDU);
+  theEvent.SetFile( &file );
   EStateID stateid = RunEventLoop(theEvent, mConnection, inCallback, false);
   assert( stateid == eSta6TransferReady ); (void)stateid;
   std::vector<DataSet> const &theDataSets = theCallback.GetResponses();
@@ -414,6 +417,8 @@ bool ServiceClassUser::SendMove(const BaseRootQuery* query, const char *outputdi
   ULConnection* mConnection = Internals->mConnection;
   network::ULWritingCallback theCallback;
   theCallback.SetDirectory(outputdir);
+  // write the received datasets to disk as they arrive
+  theCallback.SetIncremental(true);
   network::ULConnectionCallback* inCallback = &theCallback;
 
   std::vector<BasePDU*> theDataPDU = PDUFactory::CreateCMovePDU( *mConnection, query );
@@ -672,42 +677,70 @@ EStateID ServiceClassUser::RunEventLoop(network::ULEvent& currentEvent,
                 std::vector<BasePDU*> theData;
                 BasePDU* thePDU;//outside the loop for the do/while stopping condition
                 bool interrupted = false;
-                do {
-                  uint8_t itemtype = 0x0;
-                  is.read( (char*)&itemtype, 1 );
-                  //what happens if nothing's read?
-                  thePDU = PDUFactory::ConstructPDU(itemtype);
-                  if (itemtype != 0x4 && thePDU != NULL){ //ie, not a pdatapdu
-                    std::vector<BasePDU*> interruptingPDUs;
-                    interruptingPDUs.push_back(thePDU);
-                    currentEvent.SetEvent(PDUFactory::DetermineEventByPDU(interruptingPDUs[0]));
-                    currentEvent.SetPDU(interruptingPDUs);
-                    interrupted= true;
-                    break;
-                  }
-                  if (thePDU != NULL){
-                    // FIXME: How do I find out how many PData we are receiving ?
-                    // This is needed for proper progress report
-                    thePDU->Read(is);
-                    theData.push_back(thePDU);
-                  } else{
-                    break;
+                //incremental mode: the callback may want the cstore dataset written
+                //into a stream as it arrives, rather than concatenated in memory
+                std::ostream *theSpool = NULL;
+                if (theCommandCode == 1 && inCallback){
+                  TransferSyntax theCStoreTS = TransferSyntax::GetTSType(
+                    inWhichConnection->GetCStoreTransferSyntax().GetName() );
+                  theSpool = inCallback->BeginDataSet(theRSP, theCStoreTS);
+                }
+                if (theSpool){
+                  BasePDU* interruptingPDU = NULL;
+                  const bool complete = PDUFactory::ReadDataSetInto(is, *theSpool, interruptingPDU);
+                  inCallback->EndDataSet(complete);
+                  if (!complete){
+                    interrupted = true;
+                    if (interruptingPDU != NULL){
+                      std::vector<BasePDU*> interruptingPDUs;
+                      interruptingPDUs.push_back(interruptingPDU);
+                      currentEvent.SetEvent(PDUFactory::DetermineEventByPDU(interruptingPDUs[0]));
+                      currentEvent.SetPDU(interruptingPDUs);
+                    } else {
+                      gdcmErrorMacro( "Could not receive the C-STORE dataset" );
+                      theState = eStaDoesNotExist;
+                    }
                   }
-                  //!!!need to handle incoming PDUs that are not data, ie, an abort
-                } while(!thePDU->IsLastFragment());
-                if (!interrupted){//ie, if the remote server didn't hang up
-                  DataSet theCompleteFindResponse =
-                    PresentationDataValue::ConcatenatePDVBlobs(PDUFactory::GetPDVs(theData));
-                  //note that it's the responsibility of the event to delete the PDU in theFindRSP
-                  for (size_t i = 0; i < theData.size(); i++)
-                    {
-                    delete theData[i];
+                } else {
+                  do {
+                    uint8_t itemtype = 0x0;
+                    is.read( (char*)&itemtype, 1 );
+                    //what happens if nothing's read?
+                    thePDU = PDUFactory::ConstructPDU(itemtype);
+                    if (itemtype != 0x4 && thePDU != NULL){ //ie, not a pdatapdu
+                      std::vector<BasePDU*> interruptingPDUs;
+                      interruptingPDUs.push_back(thePDU);
+                      currentEvent.SetEvent(PDUFactory::DetermineEventByPDU(interruptingPDUs[0]));
+                      currentEvent.SetPDU(interruptingPDUs);
+                      interrupted= true;
+                      break;
                     }
-                  //outDataSet.push_back(theCompleteFindResponse);
-                  if (inCallback)
-                    {
-                    inCallback->HandleDataSet(theCompleteFindResponse);
+                    if (thePDU != NULL){
+                      // FIXME: How do I find out how many PData we are receiving ?
+                      // This is needed for proper progress report
+                      thePDU->Read(is);
+                      theData.push_back(thePDU);
+                    } else{
+                      break;
                     }
+                    //!!!need to handle incoming PDUs that are not data, ie, an abort
+                  } while(!thePDU->IsLastFragment());
+                }
+                if (!interrupted){//ie, if the remote server didn't hang up
+                  if (!theSpool){//already written by the callback otherwise
+                    DataSet theCompleteFindResponse =
+                      PresentationDataValue::ConcatenatePDVBlobs(PDUFactory::GetPDVs(theData));
+                    //note that it's the responsibility of the event to delete the PDU in theFindRSP
+                    for (size_t i = 0; i < theData.size(); i++)
+                      {
+                      delete theData[i];
+                      }
+                    //outDataSet.push_back(theCompleteFindResponse);
+                    if (inCallback)
+                      {
+                      inCallback->HandleDataSet(theCompleteFindResponse);
+                      }
+                  }
                   //  DataSetEvent dse( &theCompleteFindResponse );
                   //  this->InvokeEvent( dse );
 
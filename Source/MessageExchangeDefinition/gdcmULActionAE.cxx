@@ -30,9 +30,12 @@ each class have its own file for the sake of brevity of the number of files.
 #include "gdcmAAssociateRQPDU.h"
 #include "gdcmAAssociateACPDU.h"
 #include "gdcmAAssociateRJPDU.h"
+#include "gdcmAsynchronousOperationsWindowSub.h"
 
 #include <socket++/echo.h>//for setting up the local socket
 
+#include <algorithm>
+
 namespace gdcm
 {
 namespace network
@@ -79,6 +82,20 @@ EStateID ULActionAE2::PerformAction(Subject *, ULEvent& , ULConnection& inConnec
     thePDU.AddPresentationContext(*itor);
     }
 
+  // Propose asynchronous operations, only ours: we never perform operations
+  // invoked by the peer while ours are outstanding
+  const uint16_t maxops = inConnection.GetMaximumNumberOperationsInvoked();
+  if( maxops != 1 )
+    {
+    AsynchronousOperationsWindowSub aows;
+    aows.SetMaximumNumberOperationsInvoked( maxops );
+    aows.SetMaximumNumberOperationsPerformed( 1 );
+    UserInformation ui;
+    ui = thePDU.GetUserInformation();
+    ui.SetAsynchronousOperationsWindowSub( aows );
+    thePDU.SetUserInformation( ui );
+    }
+
   thePDU.Write(*inConnection.GetProtocol());
   inConnection.GetProtocol()->flush();
 
@@ -103,6 +120,21 @@ EStateID ULActionAE3::PerformAction(Subject *, ULEvent& inEvent, ULConnection& i
   uint32_t maxpdu = acpdu->GetUserInformation().GetMaximumLengthSub().GetMaximumLength();
   inConnection.SetMaxPDUSize(maxpdu);
 
+  // PS 3.7 D.3.3.3.2: without an Asynchronous Operations Window in the
+  // A-ASSOCIATE-AC operations are synchronous. Otherwise the peer returns at
+  // most what was proposed, 0 meaning no limit on its side
+  const AsynchronousOperationsWindowSub *aows =
+    acpdu->GetUserInformation().GetAsynchronousOperationsWindowSub();
+  uint16_t maxops = 1;
+  if( aows )
+    {
+    const uint16_t proposed = inConnection.GetMaximumNumberOperationsInvoked();
+    const uint16_t accepted = aows->GetMaximumNumberOperationsInvoked();
+    maxops = accepted == 0 ? proposed
+      : proposed == 0 ? accepted : std::min( proposed, accepted );
+    }
+  inConnection.SetMaximumNumberOperationsInvoked( maxops );
+
   // once again duplicate AAssociateACPDU vs ULConnection
   for( unsigned int index = 0; index < acpdu->GetNumberOfPresentationContextAC(); index++ ){
     PresentationContextAC const &pc = acpdu->GetPresentationContextAC(index);
@@ -176,6 +208,7 @@ EStateID ULActionAE6::PerformAction(Subject *, ULEvent& inEvent, ULConnection& i
     AAssociateACPDU acpdu;
 
     assert( rqpdu->GetNumberOfPresentationContext() );
+    inConnection.GetAcceptedPresentationContexts().clear();
     for( unsigned int index = 0; index < rqpdu->GetNumberOfPresentationContext(); index++ )
       {
       // FIXME / HARDCODED We only ever accept Little Endian
@@ -228,6 +261,11 @@ EStateID ULActionAE6::PerformAction(Subject *, ULEvent& inEvent, ULConnection& i
       pcac1.SetPresentationContextID( id );
       pcac1.SetReason( result );
       acpdu.AddPresentationContextAC( pcac1 );
+      if( !result )
+        {
+        // so that the transfer syntax of each context can be looked up
+        inConnection.AddAcceptedPresentationContext( pcac1 );
+        }
     }
     assert( acpdu.GetNumberOfPresentationContextAC() );
 
@@ -26,12 +26,14 @@ each class have its own file for the sake of brevity of the number of files.
 #include "gdcmULActionDT.h"
 #include "gdcmARTIMTimer.h"
 #include "gdcmPDataTFPDU.h"
-
-#include "gdcmPDataTFPDU.h"
+#include "gdcmPDataTFStreamBuf.h"
+#include "gdcmCStoreMessages.h"
 #include "gdcmAttribute.h"
 #include "gdcmProgressEvent.h"
 #include "gdcmFile.h"
 #include "gdcmDataSet.h"
+#include "gdcmExplicitDataElement.h"
+#include "gdcmImplicitDataElement.h"
 #include "gdcmAReleaseRPPDU.h"
 #include "gdcmAAssociateRQPDU.h"
 #include "gdcmAAssociateACPDU.h"
@@ -114,6 +116,8 @@ static void process_input(iosockinet& sio)
     int i = 0;
     do
       {
+      sio.read( (char*)&itemtype, 1 );
+      assert( itemtype == 0x4 );
       PDataTFPDU pdata2;
       pdata2.ReadInto( sio, out );
       //pdata2.Print( std::cout );
@@ -178,6 +182,10 @@ EStateID ULActionDT1::PerformAction(Subject *s, ULEvent& inEvent, ULConnection&
 {
   std::vector<BasePDU*> theDataPDUs = inEvent.GetPDUs();
   std::vector<BasePDU*>::const_iterator itor = theDataPDUs.begin();
+  std::istream * pStream = inEvent.GetIStream();
+  const File * pFile = inEvent.GetFile();
+  // when a data set follows, progress is reported while sending it
+  const bool hasDataSet = pStream != NULL || pFile != NULL;
   //they can all be sent at once because of the structure in 3.8 7.6-- pdata
   //does not wait for a response.
   double Progress = 0;
@@ -191,10 +199,13 @@ EStateID ULActionDT1::PerformAction(Subject *s, ULEvent& inEvent, ULConnection&
       throw Exception("Data sending event PDU malformed.");
       }
     dataPDU->Write(*inConnection.GetProtocol());
+    if( !hasDataSet )
+      {
       Progress += progresstick;
       ProgressEvent pe;
       pe.SetProgress( Progress );
       s->InvokeEvent( pe );
+      }
 
     //if( !inConnection.GetProtocol()->good() );
     //  {
@@ -204,56 +215,44 @@ EStateID ULActionDT1::PerformAction(Subject *s, ULEvent& inEvent, ULConnection&
     inConnection.GetProtocol()->flush();
   }
 
-  std::istream * pStream = inEvent.GetIStream() ;
-  if ( pStream )
+  if ( hasDataSet )
     {
     PDataTFPDU* dataPDU = dynamic_cast<PDataTFPDU*>(theDataPDUs[0]);
     if (dataPDU == NULL)
       {
       throw Exception("Data sending event PDU malformed.");
       }
+    // Cut the data set into P-DATA-TF PDUs as it is read (or serialized),
+    // only one PDU is ever held in memory
     uint8_t prescontid = dataPDU->GetPresentationDataValue(0).GetPresentationContextID();
-    size_t maxpdu = 16378;
-    maxpdu = inConnection.GetMaxPDUSize() - 6;
-    pStream->seekg( 0, std::ios::beg );
-    pStream->seekg( 0, std::ios::end );
-    std::streampos len = pStream->tellg();
-    char * contents = new char [maxpdu];
-    std::streampos cur = inEvent.GetDataSetPos() ;
-    pStream->seekg( cur );
-    PresentationDataValue thePDV;
-    PDataTFPDU basePDU ;
-    while( cur < len )
+    PDataTFStreamBuf pdatabuf( *inConnection.GetProtocol(), prescontid,
+      inConnection.GetMaxPDUSize() );
+    std::ostream pdataos( &pdatabuf );
+    if( pStream )
       {
-      size_t remaining = std::min( maxpdu , (size_t)(len - cur) );
-      pStream->read( contents, remaining );
-      std::string sub( contents, remaining );
-      std::string UIDString;
-      thePDV.SetPresentationContextID( prescontid );
-      thePDV.SetBlob( sub );
-
-      if( remaining == maxpdu )
-        thePDV.SetMessageHeader( 0 );
-      else
-        thePDV.SetMessageHeader( 2 );
-
-      cur += remaining;
-      basePDU = PDataTFPDU();
-      basePDU.AddPresentationDataValue( thePDV );
-      basePDU.Write(*inConnection.GetProtocol());
-      Progress += progresstick;
-      ProgressEvent pe;
-      pe.SetProgress( Progress );
-      s->InvokeEvent( pe );
-
-      //if( !inConnection.GetProtocol()->good() );
-      //  {
-      //  throw new Exception("Protocol is not good.");
-      //  return eStaDoesNotExist;
-      //  }
-      inConnection.GetProtocol()->flush();
+      pStream->seekg( 0, std::ios::end );
+      std::streampos len = pStream->tellg();
+      std::streampos cur = inEvent.GetDataSetPos();
+      pStream->seekg( cur );
+      if( cur < len )
+        {
+        pdatabuf.SetProgress( s, (size_t)(len - cur) );
+        pdataos << pStream->rdbuf();
+        }
+      }
+    else
+      {
+      const DataSet &ds = pFile->GetDataSet();
+      const VL dslen =
+        pFile->GetHeader().GetDataSetTransferSyntax().IsImplicit() ?
+        ds.GetLength<ImplicitDataElement>() : ds.GetLength<ExplicitDataElement>();
+      pdatabuf.SetProgress( s, dslen );
+      CStoreRQ::WriteDataSet( pdataos, *pFile );
+      }
+    if( !pdatabuf.Finish() )
+      {
+      gdcmErrorMacro( "Could not send the data set" );
       }
-    delete [] contents ;
     }
   // When doing a C-MOVE we recevie the Requested DataSet over
   // another chanel (technically this is send to an SCP)
@@ -30,6 +30,8 @@ ULConnection::ULConnection(const ULConnectionInfo& inConnectInfo)
   mSocket = NULL;
   mEcho = NULL;
   mInfo = inConnectInfo;
+  mMessageID = 1;
+  mMaxOperationsInvoked = 1;
 
   TransferSyntaxSub ts1;
   ts1.SetNameFromUID( UIDs::ImplicitVRLittleEndianDefaultTransferSyntaxforDICOM );
@@ -96,6 +98,13 @@ uint32_t ULConnection::GetMaxPDUSize() const
   return mMaxPDUSize;
 }
 
+uint16_t ULConnection::GetNextMessageID() const
+{
+  const uint16_t id = mMessageID++;
+  if( !mMessageID ) mMessageID = 1; // 0 is never used
+  return id;
+}
+
 std::vector<PresentationContextRQ> const &
 ULConnection::GetPresentationContexts() const
 {
@@ -164,6 +173,9 @@ bool ULConnection::InitializeConnection()
     //make sure to convert timeouts to platform appropriate values.
     (*p)->recvtimeout((int)GetTimer().GetTimeout());
     (*p)->sendtimeout((int)GetTimer().GetTimeout());
+    // a request often ends with a small PDU, do not wait for the previous
+    // one to be acknowledged before sending it
+    (*p)->tcpnodelay(true);
     if (mEcho != NULL)
       {
       delete mEcho;
@@ -262,6 +274,52 @@ bool ULConnection::InitializeIncomingConnection()
   return true;
 }
 
+bool ULConnection::InitializeIncomingConnection(sockinetbuf &inListener)
+{
+  if (mEcho != NULL)
+    {
+    delete mEcho;
+    mEcho = NULL;
+    }
+  if (mSocket != NULL)
+    {
+    delete mSocket;
+    mSocket = NULL;
+    }
+  try
+    {
+    mSocket = new iosockinet(inListener.accept());
+    }
+  catch (sockerr& ex)
+    {
+    //eg. another thread accepted it first on a non blocking listener
+    (void)ex;  //to avoid unreferenced variable warning on release
+    gdcmDebugMacro( "No incoming connection: " << ex.what() );
+    SetState(eStaDoesNotExist);
+    return false;
+    }
+  try
+    {
+    // the listener may be non blocking, and some systems pass that on
+    mSocket->rdbuf()->nbio(false);
+    const int timeout = (int)GetTimer().GetTimeout();
+    if (timeout > 0)
+      {
+      mSocket->rdbuf()->recvtimeout(timeout);
+      mSocket->rdbuf()->sendtimeout(timeout);
+      }
+    // responses are small and sent one at a time, do not delay them
+    mSocket->rdbuf()->tcpnodelay(true);
+    }
+  catch (sockerr& ex)
+    {
+    (void)ex;  //to avoid unreferenced variable warning on release
+    gdcmWarningMacro( "Unable to set up incoming connection: " << ex.what() );
+    }
+  SetState(eSta2Open);
+  return true;
+}
+
 void ULConnection::StopProtocol()
 {
   if (mEcho != NULL)
@@ -27,6 +27,7 @@
 #include "gdcmPresentationContext.h"
 
 class iosockinet;
+class sockinetbuf;
 class echo;
 namespace gdcm{
   namespace network{
@@ -77,11 +78,16 @@ class GDCM_EXPORT ULConnection
 
       TransferSyntaxSub cstorets;
 
+      // Message ID (0000,0110) of the next request sent on this association
+      mutable uint16_t mMessageID;
+
+      uint16_t mMaxOperationsInvoked;
+
       friend class ULActionAE6;
       void SetCStoreTransferSyntax( TransferSyntaxSub const & ts );
-      friend class ULConnectionManager;
-      TransferSyntaxSub const & GetCStoreTransferSyntax( ) const;
     public:
+      /// Transfer Syntax accepted for the incoming C-STORE (SCP side)
+      TransferSyntaxSub const & GetCStoreTransferSyntax( ) const;
 
       ULConnection(const ULConnectionInfo& inUserInformation);
       //destructors are virtual to prevent memory leaks by inherited classes
@@ -104,6 +110,18 @@ class GDCM_EXPORT ULConnection
       void SetMaxPDUSize(uint32_t inSize);
       uint32_t GetMaxPDUSize() const;
 
+      /// Return a Message ID (0000,0110) not yet used on this association.
+      /// Each association has its own numbering, starting at 1.
+      uint16_t GetNextMessageID() const;
+
+      /// Number of operations that may be outstanding on this association
+      /// (PS 3.7 D.3.3.3 Asynchronous Operations Window). Before the
+      /// association is established this is the number proposed to the peer,
+      /// afterward the number it accepted. 1 (the default) means synchronous
+      /// operations, 0 unlimited.
+      void SetMaximumNumberOperationsInvoked(uint16_t n) { mMaxOperationsInvoked = n; }
+      uint16_t GetMaximumNumberOperationsInvoked() const { return mMaxOperationsInvoked; }
+
       const PresentationContextAC *GetPresentationContextACByID(uint8_t id) const;
       const PresentationContextRQ *GetPresentationContextRQByID(uint8_t id) const;
 
@@ -129,6 +147,12 @@ class GDCM_EXPORT ULConnection
 
       /// used to establish scp connections
       bool InitializeIncomingConnection();
+
+      /// used by a server: take over the next connection pending on
+      /// inListener, a socket it is listening on. The timeout of the ARTIM
+      /// timer applies to the socket reads and writes.
+      /// Return false if no connection was pending.
+      bool InitializeIncomingConnection(sockinetbuf &inListener);
 private:
   ULConnection(const ULConnection&);  // Not implemented.
   void operator=(const ULConnection&);  // Not implemented.
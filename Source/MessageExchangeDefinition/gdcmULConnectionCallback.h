@@ -20,9 +20,12 @@
 
 #include "gdcmTypes.h" //to be able to export the class
 
+#include <iosfwd>
+
 namespace gdcm 
 {
   class DataSet;
+  class TransferSyntax;
   namespace network
   {
     ///When a dataset comes back from a query/move/etc, the result can either be
@@ -48,6 +51,27 @@ namespace gdcm
       virtual void HandleDataSet(const DataSet& inDataSet) = 0;
       virtual void HandleResponse(const DataSet& inDataSet) = 0;
 
+      ///Return false to refuse the dataset of the incoming C-STORE described by
+      ///inCommand: it is then read and discarded, and the C-STORE-RSP reports a
+      ///failure. Called before BeginDataSet. The default accepts any dataset.
+      virtual bool AcceptDataSet(const DataSet& inCommand) {
+        (void)inCommand;
+        return true;
+      }
+
+      ///Incremental receive mode: return the stream the dataset of the incoming
+      ///C-STORE described by inCommand (encoded in ts) is written into, fragment
+      ///after fragment, as it arrives over the network. The default (NULL) receives
+      ///the dataset in memory and passes it to HandleDataSet instead.
+      virtual std::ostream *BeginDataSet(const DataSet& inCommand, const TransferSyntax& ts) {
+        (void)inCommand; (void)ts;
+        return NULL;
+      }
+      ///Called once the dataset has been written into the stream returned by
+      ///BeginDataSet. success is false if the transfer was interrupted.
+      ///Return false if the dataset could not be stored.
+      virtual bool EndDataSet(bool success) { return success; }
+
       bool DataSetHandles() const { return mHandledDataSet; }
       void ResetHandledDataSet() { mHandledDataSet = false; }
 
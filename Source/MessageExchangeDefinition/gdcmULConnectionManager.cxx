@@ -45,6 +45,7 @@ ULConnectionManager::ULConnectionManager()
 {
   mConnection = NULL;
   mSecondaryConnection = NULL;
+  mMaxOperationsInvoked = 1;
 }
 
 ULConnectionManager::~ULConnectionManager()
@@ -85,6 +86,8 @@ bool ULConnectionManager::EstablishConnection(const std::string& inAETitle,
     delete mConnection;
     }
   mConnection = new ULConnection(connectInfo);
+  mConnection->SetMaximumNumberOperationsInvoked(mMaxOperationsInvoked);
+  mOperations.Clear();
 
   mConnection->GetTimer().SetTimeout(inTimeout);
 
@@ -416,13 +419,15 @@ void ULConnectionManager::SendStore(const File & file, ULConnectionCallback* inC
     {
     return;
     }
-  bool writeDataSet = pStream == NULL ;
-  std::vector<BasePDU*> theDataPDU = PDUFactory::CreateCStoreRQPDU(*mConnection, file, writeDataSet);
+  // Only the command is built here, the data set is streamed (from pStream
+  // or serialized from file) while sending, one PDU at a time
+  std::vector<BasePDU*> theDataPDU = PDUFactory::CreateCStoreRQPDU(*mConnection, file, false);
   const DataSet* inDataSet = &file.GetDataSet();
   DataSetEvent dse( inDataSet );
   this->InvokeEvent( dse );
 
   ULEvent theEvent(ePDATArequest, theDataPDU, pStream, dataSetOffset );
+  if( !pStream ) theEvent.SetFile( &file );
   EStateID theState = RunEventLoop(theEvent, mConnection, inCallback, false);
   assert( theState == eSta6TransferReady || theState == eStaDoesNotExist ); (void)theState;
 }
@@ -535,11 +540,116 @@ void ULConnectionManager::SendNDelete		(const BaseQuery* inQuery, ULConnectionCa
   RunEventLoop(theEvent, mConnection, inCallback, false);
 }
 
+uint16_t ULConnectionManager::GetMaximumNumberOperationsInvoked() const
+{
+  if (mConnection == NULL)
+    {
+    return mMaxOperationsInvoked;
+    }
+  return mConnection->GetMaximumNumberOperationsInvoked();
+}
+
+// Message ID (0000,0110) of the request held in the command PDV of the
+// first PDU
+static uint16_t GetMessageID(std::vector<BasePDU*> const & inPDUs)
+{
+  if (inPDUs.empty()) return 0;
+  std::vector<BasePDU*> theCommandPDU(1, inPDUs[0]);
+  std::vector<PresentationDataValue> thePDVs = PDUFactory::GetPDVs(theCommandPDU);
+  if (thePDVs.empty() || !thePDVs[0].GetIsCommand()) return 0;
+  thePDVs.resize(1);
+  Attribute<0x0,0x0110> at = { 0 };
+  at.SetFromDataSet( PresentationDataValue::ConcatenatePDVBlobs(thePDVs) );
+  return at.GetValue();
+}
+
+uint16_t ULConnectionManager::SendRequestAsync(ULEvent& inEvent, ULConnectionCallback* inCallback)
+{
+  const uint16_t theMessageID = GetMessageID(inEvent.GetPDUs());
+  if (theMessageID == 0)
+    {
+    return 0;
+    }
+  //make room in the window first
+  const uint16_t maxops = mConnection->GetMaximumNumberOperationsInvoked();
+  if (maxops != 0 && !WaitForResponses(maxops - 1))
+    {
+    return 0;
+    }
+  //go through the transition table to send the request, but do not wait for
+  //the response as the event loop would
+  bool waitingForEvent = false;
+  EEventID raisedEvent = eEventDoesNotExist;
+  mTransitions.HandleEvent(this, inEvent, *mConnection, waitingForEvent, raisedEvent);
+  std::iostream *theProtocol = mConnection->GetProtocol();
+  if (mConnection->GetState() != eSta6TransferReady || !theProtocol || !theProtocol->good())
+    {
+    gdcmErrorMacro( "Could not send request " << theMessageID );
+    return 0;
+    }
+  mOperations.AddOperation(theMessageID, inCallback);
+  return theMessageID;
+}
+
+uint16_t ULConnectionManager::SendStoreAsync(const File & file, ULConnectionCallback* inCallback)
+{
+  if (mConnection == NULL)
+    {
+    return 0;
+    }
+  std::vector<BasePDU*> theDataPDU = PDUFactory::CreateCStoreRQPDU(*mConnection, file, false);
+  const DataSet* inDataSet = &file.GetDataSet();
+  DataSetEvent dse( inDataSet );
+  this->InvokeEvent( dse );
+
+  ULEvent theEvent(ePDATArequest, theDataPDU);
+  theEvent.SetFile( &file );
+  return SendRequestAsync(theEvent, inCallback);
+}
+
+uint16_t ULConnectionManager::SendFindAsync(const BaseRootQuery* inRootQuery, ULConnectionCallback* inCallback)
+{
+  if (mConnection == NULL)
+    {
+    return 0;
+    }
+  std::vector<BasePDU*> theDataPDU = PDUFactory::CreateCFindPDU( *mConnection, inRootQuery );
+  ULEvent theEvent(ePDATArequest, theDataPDU);
+  return SendRequestAsync(theEvent, inCallback);
+}
+
+bool ULConnectionManager::WaitForResponses(size_t n)
+{
+  std::iostream *theProtocol = mConnection ? mConnection->GetProtocol() : NULL;
+  while (mOperations.GetNumberOfOperations() > n)
+    {
+    BasePDU* thePDU = NULL;
+    if (!theProtocol || !mOperations.ReadResponse(*theProtocol, *mConnection, thePDU))
+      {
+      gdcmErrorMacro( "Association lost with " << mOperations.GetNumberOfOperations()
+        << " operations outstanding" );
+      mOperations.Clear();
+      if (thePDU != NULL)
+        {
+        //let the transition table handle the abort (or release)
+        ULEvent theEvent(PDUFactory::DetermineEventByPDU(thePDU), thePDU);
+        RunEventLoop(theEvent, mConnection, NULL, false);
+        }
+      return false;
+      }
+    }
+  return true;
+}
+
 bool ULConnectionManager::BreakConnection(const double& inTimeOut){
   std::vector<DataSet> theResult;
   if (mConnection == NULL){
     return false;
   }
+  //the responses of the asynchronous operations are still expected
+  if (mOperations.GetNumberOfOperations() && !WaitForResponses()){
+    return false;
+  }
   BasePDU* thePDU = PDUFactory::ConstructReleasePDU();
   ULEvent theEvent(eARELEASERequest, thePDU);
   mConnection->GetTimer().SetTimeout(inTimeOut);
@@ -1081,61 +1191,89 @@ EStateID ULConnectionManager::RunEventLoop(ULEvent& currentEvent, ULConnection*
                 std::vector<BasePDU*> theData;
                 BasePDU* thePDU;//outside the loop for the do/while stopping condition
                 bool interrupted = false;
-                do {
-                  uint8_t itemtype = 0x0;
-                  is.read( (char*)&itemtype, 1 );
-                  //what happens if nothing's read?
-                  thePDU = PDUFactory::ConstructPDU(itemtype);
-                  if (itemtype != 0x4 && thePDU != NULL){ //ie, not a pdatapdu
-                    std::vector<BasePDU*> interruptingPDUs;
-                    interruptingPDUs.push_back(thePDU);
-                    currentEvent.SetEvent(PDUFactory::DetermineEventByPDU(interruptingPDUs[0]));
-                    currentEvent.SetPDU(interruptingPDUs);
-                    interrupted= true;
-                    break;
-                  }
-                  if (thePDU != NULL){
-                    thePDU->Read(is);
-                    theData.push_back(thePDU);
-                  } else{
-                    break;
+                //incremental mode: the callback may want the cstore dataset written
+                //into a stream as it arrives, rather than concatenated in memory
+                std::ostream *theSpool = NULL;
+                if (theCommandCode == 1 && inCallback){
+                  TransferSyntax theCStoreTS = TransferSyntax::GetTSType(
+                    inWhichConnection->GetCStoreTransferSyntax().GetName() );
+                  theSpool = inCallback->BeginDataSet(theRSP, theCStoreTS);
+                }
+                if (theSpool){
+                  BasePDU* interruptingPDU = NULL;
+                  const bool complete = PDUFactory::ReadDataSetInto(is, *theSpool, interruptingPDU);
+                  inCallback->EndDataSet(complete);
+                  if (!complete){
+                    interrupted = true;
+                    if (interruptingPDU != NULL){
+                      std::vector<BasePDU*> interruptingPDUs;
+                      interruptingPDUs.push_back(interruptingPDU);
+                      currentEvent.SetEvent(PDUFactory::DetermineEventByPDU(interruptingPDUs[0]));
+                      currentEvent.SetPDU(interruptingPDUs);
+                    } else {
+                      gdcmErrorMacro( "Could not receive the C-STORE dataset" );
+                      theState = eStaDoesNotExist;
+                    }
                   }
-                  //!!!need to handle incoming PDUs that are not data, ie, an abort
-                } while(!thePDU->IsLastFragment());
+                } else {
+                  do {
+                    uint8_t itemtype = 0x0;
+                    is.read( (char*)&itemtype, 1 );
+                    //what happens if nothing's read?
+                    thePDU = PDUFactory::ConstructPDU(itemtype);
+                    if (itemtype != 0x4 && thePDU != NULL){ //ie, not a pdatapdu
+                      std::vector<BasePDU*> interruptingPDUs;
+                      interruptingPDUs.push_back(thePDU);
+                      currentEvent.SetEvent(PDUFactory::DetermineEventByPDU(interruptingPDUs[0]));
+                      currentEvent.SetPDU(interruptingPDUs);
+                      interrupted= true;
+                      break;
+                    }
+                    if (thePDU != NULL){
+                      thePDU->Read(is);
+                      theData.push_back(thePDU);
+                    } else{
+                      break;
+                    }
+                    //!!!need to handle incoming PDUs that are not data, ie, an abort
+                  } while(!thePDU->IsLastFragment());
+                }
                 if (!interrupted){//ie, if the remote server didn't hang up
-                  bool useimplicit = true;
-                  TransferSyntaxSub ts1;
-                  ts1.SetNameFromUID( UIDs::ImplicitVRLittleEndianDefaultTransferSyntaxforDICOM );
-                  if( mSecondaryConnection )
-                    {
-                    const TransferSyntaxSub & ts_ = mSecondaryConnection->GetCStoreTransferSyntax();
-                    if( strcmp(ts_.GetName(), ts1.GetName()) != 0)
+                  if (!theSpool){//already written by the callback otherwise
+                    bool useimplicit = true;
+                    TransferSyntaxSub ts1;
+                    ts1.SetNameFromUID( UIDs::ImplicitVRLittleEndianDefaultTransferSyntaxforDICOM );
+                    if( mSecondaryConnection )
                       {
-                      useimplicit = false;
+                      const TransferSyntaxSub & ts_ = mSecondaryConnection->GetCStoreTransferSyntax();
+                      if( strcmp(ts_.GetName(), ts1.GetName()) != 0)
+                        {
+                        useimplicit = false;
+                        }
                       }
-                    }
-                  DataSet theCompleteFindResponse;
-                  if( useimplicit )
-                    {
-                    inCallback->SetImplicitFlag(true);
-                    theCompleteFindResponse =
-                      PresentationDataValue::ConcatenatePDVBlobs(PDUFactory::GetPDVs(theData));
-                    }
-                  else
-                    {
-                    inCallback->SetImplicitFlag(false);
-                    theCompleteFindResponse =
-                      PresentationDataValue::ConcatenatePDVBlobsAsExplicit(PDUFactory::GetPDVs(theData));
-                    }
-                  //note that it's the responsibility of the event to delete the PDU in theFindRSP
-                  for (size_t i = 0; i < theData.size(); i++)
-                    {
-                    delete theData[i];
-                    }
-                  assert(inCallback);
-                    {
-                    inCallback->HandleDataSet(theCompleteFindResponse);
-                    }
+                    DataSet theCompleteFindResponse;
+                    if( useimplicit )
+                      {
+                      inCallback->SetImplicitFlag(true);
+                      theCompleteFindResponse =
+                        PresentationDataValue::ConcatenatePDVBlobs(PDUFactory::GetPDVs(theData));
+                      }
+                    else
+                      {
+                      inCallback->SetImplicitFlag(false);
+                      theCompleteFindResponse =
+                        PresentationDataValue::ConcatenatePDVBlobsAsExplicit(PDUFactory::GetPDVs(theData));
+                      }
+                    //note that it's the responsibility of the event to delete the PDU in theFindRSP
+                    for (size_t i = 0; i < theData.size(); i++)
+                      {
+                      delete theData[i];
+                      }
+                    assert(inCallback);
+                      {
+                      inCallback->HandleDataSet(theCompleteFindResponse);
+                      }
+                  }
                   //  DataSetEvent dse( &theCompleteFindResponse );
                   //  this->InvokeEvent( dse );
 
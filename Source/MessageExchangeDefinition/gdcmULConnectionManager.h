@@ -23,6 +23,7 @@
 #include "gdcmULConnectionInfo.h"
 #include "gdcmPresentationDataValue.h"
 #include "gdcmULConnectionCallback.h"
+#include "gdcmULOperationsWindow.h"
 #include "gdcmSubject.h"
 #include "gdcmPresentationContext.h"
 
@@ -49,6 +50,14 @@ namespace gdcm {
       ULConnection* mSecondaryConnection;
       ULTransitionTable mTransitions;
 
+      //asynchronous operations: number proposed, and the ones outstanding
+      uint16_t mMaxOperationsInvoked;
+      ULOperationsWindow mOperations;
+
+      //send the request PDUs without waiting for the response, which is
+      //recorded as an outstanding operation. returns the message id, 0 on error
+      uint16_t SendRequestAsync(ULEvent& inEvent, ULConnectionCallback* inCallback);
+
       //no copying
       ULConnectionManager(const ULConnectionManager& inCM);
 
@@ -152,6 +161,34 @@ namespace gdcm {
       void SendNCreate		(const BaseQuery* inQuery, ULConnectionCallback* inCallback);
       void SendNDelete		(const BaseQuery* inQuery, ULConnectionCallback* inCallback);
 
+      /// Number of operations to propose keeping outstanding on the next
+      /// association (Asynchronous Operations Window), 0 for no limit.
+      /// Default is 1, ie. synchronous operations only.
+      void SetMaximumNumberOperationsInvoked(uint16_t n) { mMaxOperationsInvoked = n; }
+      /// Once the association is established, return the number of operations
+      /// the peer accepted to have outstanding (1 when synchronous)
+      uint16_t GetMaximumNumberOperationsInvoked() const;
+
+      /// Asynchronous API: send the request and return without waiting for
+      /// its response, unless the window of outstanding operations is full in
+      /// which case responses are received first (see WaitForResponses).
+      /// Responses are handed to inCallback as they come in, the command to
+      /// HandleResponse, the data set if any (C-FIND matches) to
+      /// HandleDataSet. inCallback must outlive the operation.
+      /// Return the Message ID of the request, 0 on error.
+      /// \warning do not mix with the synchronous API: call WaitForResponses
+      /// before any other Send call.
+      uint16_t SendStoreAsync(const File & file, ULConnectionCallback* inCallback);
+      uint16_t SendFindAsync(const BaseRootQuery* inRootQuery, ULConnectionCallback* inCallback);
+
+      /// Receive responses until at most n operations are outstanding. Return
+      /// false if the association was lost, the outstanding operations are
+      /// then dropped.
+      bool WaitForResponses(size_t n = 0);
+
+      /// Number of operations sent with the asynchronous API whose final
+      /// response is not in yet
+      size_t GetNumberOfOutstandingOperations() const { return mOperations.GetNumberOfOperations(); }
     };
   }
 }
@@ -24,6 +24,7 @@
 #include <vector>
 
 namespace gdcm {
+  class File;
   namespace network {
 
 /**
@@ -39,6 +40,7 @@ class ULEvent {
       std::vector<BasePDU*> mBasePDU;
 	  std::istream * m_pStream ;
 	  std::streampos m_posDataSet ;
+      const File * m_pFile;
       void DeletePDUVector(){
         std::vector<BasePDU*>::iterator baseItor;
         for (baseItor = mBasePDU.begin(); baseItor < mBasePDU.end(); baseItor++){
@@ -55,12 +57,14 @@ class ULEvent {
         mBasePDU = inBasePDU;
  		m_pStream = iStream ;
  		m_posDataSet = posDataSet ; 
+      m_pFile = NULL;
       }
       ULEvent(const EEventID& inEventID, BasePDU* inBasePDU, std::istream * iStream = NULL, std::streampos posDataSet = 0 ){
         mEvent = inEventID;
         mBasePDU.push_back(inBasePDU);
  		m_pStream = iStream ;
  		m_posDataSet = posDataSet ; 
+      m_pFile = NULL;
       }
       ~ULEvent(){
         DeletePDUVector();
@@ -71,6 +75,11 @@ class ULEvent {
  	  std::istream * GetIStream() const { return m_pStream; }
  	  std::streampos GetDataSetPos() const { return m_posDataSet; }
 
+      /// When set, the data set of this File is serialized and sent right
+      /// after the PDUs, see PDataTFStreamBuf
+      void SetFile(const File *inFile) { m_pFile = inFile; }
+      const File * GetFile() const { return m_pFile; }
+
       void SetEvent(const EEventID& inEvent) { mEvent = inEvent; }
       void SetPDU(std::vector<BasePDU*> const & inPDU) {
         DeletePDUVector();
@@ -0,0 +1,132 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmULOperationsWindow.h"
+#include "gdcmULConnection.h"
+#include "gdcmULConnectionCallback.h"
+#include "gdcmPDUFactory.h"
+#include "gdcmPDataTFPDU.h"
+#include "gdcmAttribute.h"
+#include "gdcmDataSet.h"
+
+#include <istream>
+#include <vector>
+#include <cstring>
+
+namespace gdcm
+{
+namespace network
+{
+
+ULOperationsWindow::ULOperationsWindow()
+{
+}
+
+ULOperationsWindow::~ULOperationsWindow()
+{
+}
+
+void ULOperationsWindow::AddOperation(uint16_t messageid,
+  ULConnectionCallback *inCallback)
+{
+  assert( Operations.find( messageid ) == Operations.end() );
+  Operations[messageid] = inCallback;
+}
+
+bool ULOperationsWindow::ReadResponse(std::istream &is,
+  const ULConnection &inConnection, BasePDU* &outPDU)
+{
+  outPDU = NULL;
+  std::vector<PresentationDataValue> theCommand;
+  std::vector<PresentationDataValue> theData;
+  DataSet theRSP;
+  bool commandDone = false;
+  bool dataDone = false;
+  bool hasDataSet = false;
+  while( !commandDone || (hasDataSet && !dataDone) )
+    {
+    uint8_t itemtype = 0x0;
+    is.read( (char*)&itemtype, 1 );
+    if( !is ) return false;
+    if( itemtype != 0x4 )
+      {
+      // A-ABORT, A-RELEASE-RQ...: the association is going away
+      outPDU = PDUFactory::ConstructPDU(itemtype);
+      if( outPDU ) outPDU->Read( is );
+      return false;
+      }
+    PDataTFPDU thePDU;
+    thePDU.Read( is );
+    if( !is ) return false;
+    for( PDataTFPDU::SizeType i = 0; i < thePDU.GetNumberOfPresentationDataValues(); ++i )
+      {
+      const PresentationDataValue &pdv = thePDU.GetPresentationDataValue(i);
+      if( pdv.GetIsCommand() )
+        {
+        theCommand.push_back( pdv );
+        if( !pdv.GetIsLastFragment() ) continue;
+        commandDone = true;
+        theRSP = PresentationDataValue::ConcatenatePDVBlobs( theCommand );
+        // PS 3.7 E.1: 0101H means no data set follows the command
+        Attribute<0x0,0x0800> datasettype = { 0x0101 };
+        datasettype.SetFromDataSet( theRSP );
+        hasDataSet = datasettype.GetValue() != 0x0101;
+        }
+      else
+        {
+        theData.push_back( pdv );
+        if( pdv.GetIsLastFragment() ) dataDone = true;
+        }
+      }
+    }
+
+  Attribute<0x0,0x0120> respondedto = { 0 };
+  respondedto.SetFromDataSet( theRSP );
+  std::map<uint16_t, ULConnectionCallback*>::iterator it =
+    Operations.find( respondedto.GetValue() );
+  if( it == Operations.end() )
+    {
+    gdcmWarningMacro( "Response to unknown Message ID: " << respondedto.GetValue() );
+    return true;
+    }
+  ULConnectionCallback *theCallback = it->second;
+  Attribute<0x0,0x0900> status = { 0 };
+  status.SetFromDataSet( theRSP );
+  // Pending responses (FF00H, FF01H) are followed by others
+  if( status.GetValue() != 0xff00 && status.GetValue() != 0xff01 )
+    {
+    Operations.erase( it );
+    }
+
+  if( theCallback )
+    {
+    theCallback->HandleResponse( theRSP );
+    if( hasDataSet )
+      {
+      const PresentationContextAC *pc =
+        inConnection.GetPresentationContextACByID( theData[0].GetPresentationContextID() );
+      TransferSyntaxSub ts1;
+      ts1.SetNameFromUID( UIDs::ImplicitVRLittleEndianDefaultTransferSyntaxforDICOM );
+      const bool useimplicit = !pc
+        || strcmp( pc->GetTransferSyntax().GetName(), ts1.GetName() ) == 0;
+      theCallback->SetImplicitFlag( useimplicit );
+      theCallback->HandleDataSet( useimplicit
+        ? PresentationDataValue::ConcatenatePDVBlobs( theData )
+        : PresentationDataValue::ConcatenatePDVBlobsAsExplicit( theData ) );
+      }
+    }
+  return true;
+}
+
+} // end namespace network
+} // end namespace gdcm
@@ -0,0 +1,75 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#ifndef GDCMULOPERATIONSWINDOW_H
+#define GDCMULOPERATIONSWINDOW_H
+
+#include "gdcmTypes.h"
+
+#include <map>
+#include <iosfwd>
+
+namespace gdcm
+{
+namespace network
+{
+class BasePDU;
+class ULConnection;
+class ULConnectionCallback;
+
+/**
+ * \brief ULOperationsWindow
+ * Keep track of the operations outstanding on an association, when
+ * asynchronous operations were negotiated (PS 3.7 D.3.3.3).
+ *
+ * \details Each operation is known by the Message ID (0000,0110) of its
+ * request. Responses are read from the association one DIMSE message at a
+ * time, matched with their operation through the Message ID Being Responded
+ * To (0000,0120), and handed to the callback of that operation: the command
+ * to HandleResponse, then the data set (if any) to HandleDataSet. An
+ * operation is done with its first non pending response.
+ */
+class GDCM_EXPORT ULOperationsWindow
+{
+public:
+  ULOperationsWindow();
+  ~ULOperationsWindow();
+
+  /// Record the operation invoked by the request with Message ID messageid.
+  /// Its responses go to inCallback.
+  void AddOperation(uint16_t messageid, ULConnectionCallback *inCallback);
+
+  /// Return the number of operations whose final response is not in yet
+  size_t GetNumberOfOperations() const { return Operations.size(); }
+
+  /// Forget all operations (eg. the association is gone)
+  void Clear() { Operations.clear(); }
+
+  /// Read the next DIMSE message from is and hand it to the callback of the
+  /// operation it responds to. inConnection gives the transfer syntax of the
+  /// data set. Return false if another PDU came in, outPDU is then that PDU
+  /// (already read, to be deleted by the caller), or NULL on read error.
+  bool ReadResponse(std::istream &is, const ULConnection &inConnection,
+    BasePDU* &outPDU);
+
+private:
+  ULOperationsWindow(const ULOperationsWindow&); // Not implemented
+  void operator=(const ULOperationsWindow&); // Not implemented
+
+  std::map<uint16_t, ULConnectionCallback*> Operations;
+};
+
+} // end namespace network
+} // end namespace gdcm
+
+#endif //GDCMULOPERATIONSWINDOW_H
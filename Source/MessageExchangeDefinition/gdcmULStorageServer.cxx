@@ -0,0 +1,376 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmULStorageServer.h"
+#include "gdcmULConnection.h"
+#include "gdcmULConnectionInfo.h"
+#include "gdcmULWritingCallback.h"
+#include "gdcmULEvent.h"
+#include "gdcmPDUFactory.h"
+#include "gdcmPDataTFPDU.h"
+#include "gdcmAttribute.h"
+#include "gdcmWorkerPool.h"
+
+#include <socket++/sockinet.h>
+
+#include <vector>
+
+namespace gdcm
+{
+namespace network
+{
+
+/*
+ * Each index is a worker serving associations until the server is stopped.
+ * Counts are kept per worker and summed once it is done.
+ */
+class ULStorageServerJob : public WorkerPool::Job
+{
+public:
+  ULStorageServerJob(ULStorageServer &server, unsigned int n):
+    Server(server),Associations(n, 0),DataSets(n, 0) {}
+  void Execute(unsigned int index)
+    {
+    Server.Serve( Associations[index], DataSets[index] );
+    }
+  void Finish(unsigned int index)
+    {
+    Server.NumberOfAssociations += Associations[index];
+    Server.NumberOfDataSets += DataSets[index];
+    }
+
+private:
+  ULStorageServer &Server;
+  std::vector<unsigned long> Associations;
+  std::vector<unsigned long> DataSets;
+};
+
+ULStorageServer::ULStorageServer():Port(104),Directory("."),NumberOfThreads(1),
+  Timeout(30),Listener(NULL),Stopped(false),NumberOfAssociations(0),
+  NumberOfDataSets(0)
+{
+}
+
+ULStorageServer::~ULStorageServer()
+{
+  delete Listener;
+}
+
+uint16_t ULStorageServer::GetPort() const
+{
+  if( Listener ) return (uint16_t)Listener->localport();
+  return Port;
+}
+
+bool ULStorageServer::Listen()
+{
+  delete Listener;
+  Listener = NULL;
+  Stopped = false;
+  sockinetbuf *sin = new sockinetbuf( sockbuf::sock_stream );
+  try
+    {
+    // http://hea-www.harvard.edu/~fine/Tech/addrinuse.html
+    int val = 1;
+    sin->setopt( SO_REUSEADDR, &val, sizeof(val) );
+    sin->bind( Port );
+    sin->listen();
+    // Idle workers all wait for the next connection, only one of them gets
+    // it: the others must not block in accept
+    sin->nbio( true );
+    }
+  catch( sockerr &ex )
+    {
+    (void)ex;  //to avoid unreferenced variable warning on release
+    gdcmErrorMacro( "Unable to listen on port " << Port << ": " << ex.what() );
+    delete sin;
+    return false;
+    }
+  Listener = sin;
+  return true;
+}
+
+bool ULStorageServer::Run()
+{
+  if( !Listener )
+    {
+    gdcmErrorMacro( "Call Listen first" );
+    return false;
+    }
+  NumberOfAssociations = 0;
+  NumberOfDataSets = 0;
+  WorkerPool pool;
+  pool.SetNumberOfThreads( NumberOfThreads );
+  const unsigned int nworkers = pool.GetNumberOfThreads();
+  ULStorageServerJob job( *this, nworkers );
+  pool.Run( job, nworkers );
+  return true;
+}
+
+ULConnectionCallback *ULStorageServer::CreateCallback()
+{
+  ULWritingCallback *callback = new ULWritingCallback;
+  callback->SetDirectory( Directory );
+  callback->SetIncremental( true );
+  return callback;
+}
+
+void ULStorageServer::Serve(unsigned long &associations,
+  unsigned long &datasets)
+{
+  while( !Stopped )
+    {
+    try
+      {
+      // wake up regularly to notice Stop
+      if( !Listener->is_readready( 0, 100000 ) ) continue;
+      }
+    catch( sockerr &ex )
+      {
+      (void)ex;  //to avoid unreferenced variable warning on release
+      gdcmWarningMacro( "Waiting for connections: " << ex.what() );
+      continue;
+      }
+    ULConnectionInfo info;
+    ULConnection connection( info );
+    connection.GetTimer().SetTimeout( Timeout );
+    if( !connection.InitializeIncomingConnection( *Listener ) )
+      {
+      continue;
+      }
+    ++associations;
+    ULConnectionCallback *callback = CreateCallback();
+    try
+      {
+      datasets += ServeAssociation( connection, callback );
+      }
+    catch( std::exception &ex )
+      {
+      (void)ex;  //to avoid unreferenced variable warning on release
+      gdcmWarningMacro( "Association lost: " << ex.what() );
+      }
+    delete callback;
+    }
+}
+
+// Run the state machine on inEvent, then on the events its actions raise
+void ULStorageServer::HandleEvent(ULEvent &inEvent,
+  ULConnection &inConnection) const
+{
+  bool waitingForEvent = false;
+  EEventID raisedEvent = eEventDoesNotExist;
+  Transitions.HandleEvent( NULL, inEvent, inConnection, waitingForEvent, raisedEvent );
+  while( raisedEvent != eEventDoesNotExist )
+    {
+    inEvent.SetEvent( raisedEvent );
+    raisedEvent = eEventDoesNotExist;
+    Transitions.HandleEvent( NULL, inEvent, inConnection, waitingForEvent, raisedEvent );
+    }
+  inConnection.GetProtocol()->flush();
+}
+
+// Sort the PDVs of a P-DATA-TF PDU into the command and the data set ones
+static bool AddPDVs(const PDataTFPDU &inPDU,
+  std::vector<PresentationDataValue> &command,
+  std::vector<PresentationDataValue> &data, bool &dataDone)
+{
+  bool commandDone = false;
+  for( PDataTFPDU::SizeType i = 0; i < inPDU.GetNumberOfPresentationDataValues(); ++i )
+    {
+    const PresentationDataValue &pdv = inPDU.GetPresentationDataValue(i);
+    if( pdv.GetIsCommand() )
+      {
+      command.push_back( pdv );
+      if( pdv.GetIsLastFragment() ) commandDone = true;
+      }
+    else
+      {
+      data.push_back( pdv );
+      if( pdv.GetIsLastFragment() ) dataDone = true;
+      }
+    }
+  return commandDone;
+}
+
+// Read the rest of a message data set, some of its fragments may already be
+// in data. Return false if another PDU came in, outPDU is then that PDU (not
+// read yet), or NULL on read error.
+static bool ReadDataSet(std::istream &is,
+  std::vector<PresentationDataValue> &data, bool dataDone, BasePDU* &outPDU)
+{
+  outPDU = NULL;
+  while( !dataDone )
+    {
+    uint8_t itemtype = 0x0;
+    is.read( (char*)&itemtype, 1 );
+    if( !is ) return false;
+    if( itemtype != 0x4 )
+      {
+      outPDU = PDUFactory::ConstructPDU(itemtype);
+      return false;
+      }
+    PDataTFPDU thePDU;
+    thePDU.Read( is );
+    if( !is ) return false;
+    std::vector<PresentationDataValue> command;
+    AddPDVs( thePDU, command, data, dataDone );
+    }
+  return true;
+}
+
+unsigned long ULStorageServer::ServeAssociation(ULConnection &inConnection,
+  ULConnectionCallback *inCallback) const
+{
+  unsigned long count = 0;
+  std::iostream &s = *inConnection.GetProtocol();
+  while( inConnection.GetState() != eSta1Idle
+    && inConnection.GetState() != eSta13AwaitingClose
+    && inConnection.GetState() != eStaDoesNotExist )
+    {
+    uint8_t itemtype = 0x0;
+    s.read( (char*)&itemtype, 1 );
+    if( !s ) break; // closed by the peer, or timed out
+
+    BasePDU *thePDU = NULL;
+    if( itemtype == 0x4 && inConnection.GetState() == eSta6TransferReady )
+      {
+      // The command, and the start of the data set when it came along
+      PDataTFPDU theFirstPDU;
+      theFirstPDU.Read( s );
+      if( !s || !theFirstPDU.GetNumberOfPresentationDataValues() ) break;
+      std::vector<PresentationDataValue> theCommand;
+      std::vector<PresentationDataValue> theData;
+      bool dataDone = false;
+      bool commandDone = AddPDVs( theFirstPDU, theCommand, theData, dataDone );
+      while( !commandDone )
+        {
+        s.read( (char*)&itemtype, 1 );
+        if( !s || itemtype != 0x4 ) break;
+        PDataTFPDU theNextPDU;
+        theNextPDU.Read( s );
+        commandDone = AddPDVs( theNextPDU, theCommand, theData, dataDone );
+        }
+      if( !commandDone )
+        {
+        if( !s ) break;
+        thePDU = PDUFactory::ConstructPDU(itemtype);
+        if( !thePDU ) break;
+        }
+      else
+        {
+        const DataSet theRQ = PresentationDataValue::ConcatenatePDVBlobs( theCommand );
+        Attribute<0x0,0x0100> commandfield = { 0 };
+        commandfield.SetFromDataSet( theRQ );
+        // PS 3.7 E.1: 0101H means no data set follows the command
+        Attribute<0x0,0x0800> datasettype = { 0x0101 };
+        datasettype.SetFromDataSet( theRQ );
+        std::vector<BasePDU*> theRSP;
+        if( commandfield.GetValue() == 0x0030 && datasettype.GetValue() == 0x0101 )
+          {
+          theRSP = PDUFactory::CreateCEchoRSPPDU( &theRQ, &theFirstPDU );
+          }
+        else if( commandfield.GetValue() == 0x0001 && datasettype.GetValue() != 0x0101 )
+          {
+          const uint8_t pcid = theFirstPDU.GetPresentationDataValue(0).GetPresentationContextID();
+          const PresentationContextAC *pc = inConnection.GetPresentationContextACByID( pcid );
+          const TransferSyntax ts = pc
+            ? TransferSyntax::GetTSType( pc->GetTransferSyntax().GetName() )
+            : TransferSyntax::ImplicitVRLittleEndian;
+          bool complete = false;
+          bool stored = false;
+          if( inCallback && !inCallback->AcceptDataSet( theRQ ) )
+            {
+            // read the refused dataset through, without keeping it
+            std::ostream discard( NULL );
+            complete = dataDone || PDUFactory::ReadDataSetInto( s, discard, thePDU );
+            }
+          else if( inCallback )
+            {
+            std::ostream *theSpool = inCallback->BeginDataSet( theRQ, ts );
+            if( theSpool )
+              {
+              for( size_t i = 0; i < theData.size(); ++i )
+                {
+                const std::string &blob = theData[i].GetBlob();
+                theSpool->write( blob.c_str(), blob.size() );
+                }
+              complete = dataDone
+                || PDUFactory::ReadDataSetInto( s, *theSpool, thePDU );
+              stored = inCallback->EndDataSet( complete );
+              }
+            else
+              {
+              complete = ReadDataSet( s, theData, dataDone, thePDU );
+              if( complete )
+                {
+                const bool useimplicit = ts == TransferSyntax::ImplicitVRLittleEndian;
+                inCallback->SetImplicitFlag( useimplicit );
+                inCallback->HandleDataSet( useimplicit
+                  ? PresentationDataValue::ConcatenatePDVBlobs( theData )
+                  : PresentationDataValue::ConcatenatePDVBlobsAsExplicit( theData ) );
+                stored = true;
+                }
+              }
+            }
+          else
+            {
+            complete = ReadDataSet( s, theData, dataDone, thePDU );
+            }
+          if( !complete && !thePDU ) break;
+          if( complete )
+            {
+            if( stored ) ++count;
+            // PS 3.4 B.2.3: A700H Refused: Out of Resources
+            theRSP = PDUFactory::CreateCStoreRSPPDU( &theRQ, &theFirstPDU,
+              (uint16_t)(stored ? 0x0 : 0xA700) );
+            }
+          }
+        else
+          {
+          gdcmWarningMacro( "Unsupported command: " << commandfield.GetValue() );
+          ULEvent theAbort( eAABORTRequest, (BasePDU*)NULL );
+          HandleEvent( theAbort, inConnection );
+          break;
+          }
+        for( size_t i = 0; i < theRSP.size(); ++i )
+          {
+          theRSP[i]->Write( s );
+          delete theRSP[i];
+          }
+        s.flush();
+        if( !thePDU ) continue;
+        }
+      // the message was interrupted by thePDU, whose type was already read
+      thePDU->Read( s );
+      }
+    else
+      {
+      thePDU = PDUFactory::ConstructPDU(itemtype);
+      if( !thePDU )
+        {
+        gdcmWarningMacro( "Unknown PDU type: " << (int)itemtype );
+        ULEvent theAbort( eAABORTRequest, (BasePDU*)NULL );
+        HandleEvent( theAbort, inConnection );
+        break;
+        }
+      thePDU->Read( s );
+      }
+    // A-ASSOCIATE-RQ, A-RELEASE-RQ, A-ABORT...
+    ULEvent theEvent( PDUFactory::DetermineEventByPDU( thePDU ), thePDU );
+    HandleEvent( theEvent, inConnection );
+    }
+  return count;
+}
+
+} // end namespace network
+} // end namespace gdcm
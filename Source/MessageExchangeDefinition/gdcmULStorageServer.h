@@ -0,0 +1,123 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#ifndef GDCMULSTORAGESERVER_H
+#define GDCMULSTORAGESERVER_H
+
+#include "gdcmULTransitionTable.h"
+
+#include <string>
+
+class sockinetbuf;
+namespace gdcm
+{
+namespace network
+{
+class ULConnection;
+class ULConnectionCallback;
+class ULStorageServerJob;
+
+/**
+ * \brief ULStorageServer
+ * A Storage SCP: accept associations on a port, receive the data sets of
+ * their C-STORE requests and answer C-ECHO requests.
+ *
+ * \details Associations are served concurrently by a pool of worker threads
+ * (see WorkerPool), each one taking the next connection pending on the
+ * shared listening socket as soon as its previous association is released.
+ *
+ * Each association gets its own callback from CreateCallback. The default
+ * one is a ULWritingCallback in incremental mode: every data set is written
+ * to a Part 10 file of the output directory as it arrives, so that memory use
+ * stays bounded by the size of a PDU whatever the size of the objects. The
+ * C-STORE-RSP reports a failure (A700H) when the callback could not store the
+ * data set (see ULConnectionCallback::EndDataSet).
+ *
+ * \code
+ * ULStorageServer server;
+ * server.SetPort( 11112 );
+ * server.SetDirectory( "/incoming" );
+ * if( server.Listen() ) server.Run();
+ * \endcode
+ */
+class GDCM_EXPORT ULStorageServer
+{
+public:
+  ULStorageServer();
+  virtual ~ULStorageServer();
+
+  /// Port to listen on, 0 for any free one (see GetPort). Default is 104.
+  void SetPort(uint16_t port) { Port = port; }
+  /// Once listening, return the port actually listened on
+  uint16_t GetPort() const;
+
+  /// Directory the default callback writes the files to. Default is '.'
+  void SetDirectory(const std::string &dir) { Directory = dir; }
+  const std::string &GetDirectory() const { return Directory; }
+
+  /// Number of associations served concurrently, 0 for one per processor.
+  /// Default is 1.
+  void SetNumberOfThreads(unsigned int n) { NumberOfThreads = n; }
+  unsigned int GetNumberOfThreads() const { return NumberOfThreads; }
+
+  /// Seconds the peer may stay silent before its association is dropped.
+  /// Default is 30.
+  void SetTimeout(double t) { Timeout = t; }
+  double GetTimeout() const { return Timeout; }
+
+  /// Open the listening socket. Return false if the port cannot be bound.
+  bool Listen();
+
+  /// Serve associations until Stop is called. Return false if not listening.
+  bool Run();
+
+  /// Make Run return, once the associations in progress are over. Can be
+  /// called from any thread, including from a callback.
+  void Stop() { Stopped = true; }
+
+  /// Number of associations served, and of data sets stored, by the last
+  /// call to Run
+  unsigned long GetNumberOfAssociations() const { return NumberOfAssociations; }
+  unsigned long GetNumberOfDataSets() const { return NumberOfDataSets; }
+
+protected:
+  /// Return the callback receiving the data sets of a new association, it is
+  /// deleted once the association is over. Called concurrently from the
+  /// worker threads.
+  virtual ULConnectionCallback *CreateCallback();
+
+private:
+  ULStorageServer(const ULStorageServer&); // Not implemented
+  void operator=(const ULStorageServer&); // Not implemented
+
+  friend class ULStorageServerJob;
+  void Serve(unsigned long &associations, unsigned long &datasets);
+  unsigned long ServeAssociation(ULConnection &inConnection,
+    ULConnectionCallback *inCallback) const;
+  void HandleEvent(ULEvent &inEvent, ULConnection &inConnection) const;
+
+  uint16_t Port;
+  std::string Directory;
+  unsigned int NumberOfThreads;
+  double Timeout;
+  sockinetbuf *Listener;
+  ULTransitionTable Transitions;
+  volatile bool Stopped;
+  unsigned long NumberOfAssociations;
+  unsigned long NumberOfDataSets;
+};
+
+} // end namespace network
+} // end namespace gdcm
+
+#endif //GDCMULSTORAGESERVER_H
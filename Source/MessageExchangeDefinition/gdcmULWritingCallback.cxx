@@ -19,6 +19,9 @@
 
 #include "gdcmFile.h"
 #include "gdcmWriter.h"
+#include "gdcmUIDGenerator.h"
+
+#include <cstdio> // remove, rename
 
 namespace gdcm
 {
@@ -26,6 +29,14 @@ namespace gdcm
 namespace network
 {
 
+// the file names are made from UIDs sent by the peer: only accept those made
+// of digits and dots, nothing that could point outside of the directory
+static bool IsValidFileUID(const std::string &uid)
+{
+  return uid.find( '\0' ) == std::string::npos
+    && UIDGenerator::IsValid( uid.c_str() );
+}
+
 // writes the data set to disk immediately, rather than keeping it memory.
 // could have potential timing issues if datasets come over the network faster than
 // they can be written, which could be the case on very fast connections with slow disks
@@ -36,7 +47,17 @@ void ULWritingCallback::HandleDataSet(const DataSet& inDataSet)
     {
     const DataElement &de = inDataSet.GetDataElement(Tag(0x0008,0x0018));
     const ByteValue *bv = de.GetByteValue();
-    const std::string sopclassuid_str( bv->GetPointer(), bv->GetLength() );
+    std::string sopclassuid_str( bv->GetPointer(), bv->GetLength() );
+    while( !sopclassuid_str.empty() && sopclassuid_str[sopclassuid_str.size()-1] == 0 )
+      {
+      sopclassuid_str.erase( sopclassuid_str.size() - 1 );
+      }
+    if( !IsValidFileUID( sopclassuid_str ) )
+      {
+      gdcmErrorMacro( "Invalid SOP Instance UID, data set not written" );
+      DataSetHandled();
+      return;
+      }
     Writer w;
     std::string theLoc = mDirectoryName + "/" + sopclassuid_str.c_str() + ".dcm";
     w.SetFileName(theLoc.c_str());
@@ -68,5 +89,114 @@ void ULWritingCallback::HandleResponse(const DataSet& )
 {
 }
 
+// return the value of a UI element of inCommand, without its padding
+static std::string GetCommandUID(const DataSet& inCommand, const Tag& t)
+{
+  std::string ret;
+  if( inCommand.FindDataElement(t) )
+    {
+    const ByteValue *bv = inCommand.GetDataElement(t).GetByteValue();
+    if( bv ) ret.assign( bv->GetPointer(), bv->GetLength() );
+    }
+  while( !ret.empty() && (ret[ret.size()-1] == 0 || ret[ret.size()-1] == ' ') )
+    {
+    ret.erase( ret.size() - 1 );
+    }
+  return ret;
+}
+
+bool ULWritingCallback::AcceptDataSet(const DataSet& inCommand)
+{
+  const std::string sopinstanceuid_str = GetCommandUID( inCommand, Tag(0x0,0x1000) );
+  if( !IsValidFileUID( sopinstanceuid_str ) )
+    {
+    gdcmErrorMacro( "Invalid Affected SOP Instance UID, data set refused" );
+    return false;
+    }
+  return true;
+}
+
+std::ostream *ULWritingCallback::BeginDataSet(const DataSet& inCommand, const TransferSyntax& ts)
+{
+  if( !mIncremental ) return NULL;
+
+  // Affected SOP Class UID / Affected SOP Instance UID
+  const std::string sopclassuid_str = GetCommandUID( inCommand, Tag(0x0,0x0002) );
+  const std::string sopinstanceuid_str = GetCommandUID( inCommand, Tag(0x0,0x1000) );
+  if( sopclassuid_str.empty() || !IsValidFileUID( sopinstanceuid_str ) )
+    {
+    gdcmErrorMacro( "Missing or invalid Affected SOP Class/Instance UID, cannot write incrementally" );
+    return NULL;
+    }
+
+  // The File Meta Information is computed from the command, the dataset itself
+  // is going to be copied as is from the network
+  DataSet ds;
+  std::string uid = sopclassuid_str;
+  if( uid.size() % 2 ) uid.push_back( 0 );
+  DataElement de( Tag(0x0008,0x0016) );
+  de.SetVR( VR::UI );
+  de.SetByteValue( uid.c_str(), (uint32_t)uid.size() );
+  ds.Insert( de );
+  uid = sopinstanceuid_str;
+  if( uid.size() % 2 ) uid.push_back( 0 );
+  de.SetTag( Tag(0x0008,0x0018) );
+  de.SetByteValue( uid.c_str(), (uint32_t)uid.size() );
+  ds.Insert( de );
+  FileMetaInformation fmi;
+  fmi.SetDataSetTransferSyntax( ts );
+  try
+    {
+    fmi.FillFromDataSet( ds );
+    }
+  catch( std::exception &ex )
+    {
+    (void)ex;  //to avoid unreferenced variable warning on release
+    gdcmErrorMacro( "Could not create the File Meta Information: " << ex.what() );
+    return NULL;
+    }
+
+  // Spool to a temporary file of its own, renamed once complete: an
+  // interrupted transfer, or another association receiving the same instance,
+  // must not clobber a file already stored
+  mFileName = mDirectoryName + "/" + sopinstanceuid_str + ".dcm";
+  UIDGenerator suffix;
+  mSpoolFileName = mFileName + "." + suffix.Generate() + ".part";
+  mSpool.clear();
+  mSpool.open( mSpoolFileName.c_str(), std::ios::out | std::ios::binary );
+  if( !mSpool.is_open() )
+    {
+    gdcmErrorMacro( "Failed to open " << mSpoolFileName << std::endl );
+    return NULL;
+    }
+  fmi.Write( mSpool );
+  return &mSpool;
+}
+
+bool ULWritingCallback::EndDataSet(bool success)
+{
+  success = success && mSpool.good();
+  mSpool.close();
+  success = success && !mSpool.fail();
+  if( success && std::rename( mSpoolFileName.c_str(), mFileName.c_str() ) != 0 )
+    {
+    // rename does not replace an existing file on all systems
+    std::remove( mFileName.c_str() );
+    success = std::rename( mSpoolFileName.c_str(), mFileName.c_str() ) == 0;
+    }
+  if( success )
+    {
+    gdcmDebugMacro( "Wrote " << mFileName << " to disk. " << std::endl);
+    HandleFile( mFileName.c_str() );
+    }
+  else
+    {
+    gdcmErrorMacro( "Failed to write " << mFileName << std::endl );
+    std::remove( mSpoolFileName.c_str() );
+    }
+  DataSetHandled();
+  return success;
+}
+
 } // end namespace network
 } // end namespace gdcm
@@ -20,6 +20,9 @@
 
 #include "gdcmULConnectionCallback.h"
 
+#include <fstream>
+#include <string>
+
 namespace gdcm 
 {
 class DataSet;
@@ -30,19 +33,43 @@ namespace network
  * incoming datasets.  DataSets are immediately written to disk as soon as they
  * are received.  NOTE that if the incoming connection is faster than the disk
  * writing speed, this callback could cause some pileups!
+ * In incremental mode, the incoming C-STORE datasets are not even kept in
+ * memory: each fragment is appended to the file as soon as it is received.
  */
 class GDCM_EXPORT ULWritingCallback : public ULConnectionCallback
 {
   std::string mDirectoryName;
+  bool mIncremental;
+  std::ofstream mSpool;
+  std::string mSpoolFileName;
+  std::string mFileName;
 public:
-  ULWritingCallback() {};
+  ULWritingCallback():mIncremental(false) {};
   virtual ~ULWritingCallback() {} //empty, for later inheritance
 
   ///provide the directory into which all files are written.
   void SetDirectory(const std::string& inDirectoryName) { mDirectoryName = inDirectoryName; }
 
+  ///Incremental mode: the dataset of an incoming C-STORE is written as it
+  ///arrives to a Part 10 file named after its Affected SOP Instance UID, with a
+  ///File Meta Information generated from the command. Memory use is then bounded
+  ///by the size of a PDU. The data set is spooled to a temporary '.part' file
+  ///of the same directory, which only replaces the final file once complete.
+  ///HandleFile is called for each file written.
+  void SetIncremental(bool inIncremental) { mIncremental = inIncremental; }
+  bool GetIncremental() const { return mIncremental; }
+
   virtual void HandleDataSet(const DataSet& inDataSet);
   virtual void HandleResponse(const DataSet& inDataSet);
+
+  ///Refuse datasets whose Affected SOP Instance UID is not a valid UID, since
+  ///the file name is made from it
+  virtual bool AcceptDataSet(const DataSet& inCommand);
+  virtual std::ostream *BeginDataSet(const DataSet& inCommand, const TransferSyntax& ts);
+  virtual bool EndDataSet(bool success);
+
+  ///Called with the name of each file completely received in incremental mode
+  virtual void HandleFile(const char *filename) { (void)filename; }
 };
 } // end namespace network
 } // end namespace gdcm
@@ -310,6 +310,17 @@ UserInformation &UserInformation::operator=(const UserInformation& ui)
   return *this;
 }
 
+void UserInformation::SetAsynchronousOperationsWindowSub( AsynchronousOperationsWindowSub const & aows )
+{
+  if( !AOWS )
+    {
+    AOWS = new AsynchronousOperationsWindowSub;
+    }
+  *AOWS = aows;
+  ItemLength = (uint16_t)(Size() - 4);
+  assert( (size_t)ItemLength + 4 == Size() );
+}
+
 void UserInformation::AddRoleSelectionSub( RoleSelectionSub const & rss )
 {
   RSSI->RSSArray.push_back( rss );
@@ -54,6 +54,12 @@ public:
   const MaximumLengthSub &GetMaximumLengthSub() const { return MLS; }
   MaximumLengthSub &GetMaximumLengthSub() { return MLS; }
 
+  /// Propose (or accept) asynchronous operations. Without it operations
+  /// are synchronous
+  void SetAsynchronousOperationsWindowSub( AsynchronousOperationsWindowSub const & aows );
+  /// Return NULL if no asynchronous operations window was negotiated
+  const AsynchronousOperationsWindowSub *GetAsynchronousOperationsWindowSub() const { return AOWS; }
+
   void AddRoleSelectionSub( RoleSelectionSub const & r );
   void AddSOPClassExtendedNegociationSub( SOPClassExtendedNegociationSub const & s );
 
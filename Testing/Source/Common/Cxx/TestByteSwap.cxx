@@ -143,5 +143,28 @@ int TestByteSwap(int , char *[])
      return 1;
      }
 
+  // Ranges go through the vectorized kernels, signed values included
+  int16_t range16[37];
+  int32_t range32[37];
+  for( int i = 0; i < 37; ++i )
+    {
+    range16[i] = (int16_t)(0x8001 + 0x0102 * i);
+    range32[i] = (int32_t)(0x80010203 + 0x01020304 * i);
+    }
+  gdcm::ByteSwap<int16_t>::SwapRange(range16, 37);
+  gdcm::ByteSwap<int32_t>::SwapRange(range32, 37);
+  for( int i = 0; i < 37; ++i )
+    {
+    const uint16_t v16 = (uint16_t)(0x8001 + 0x0102 * i);
+    const uint32_t v32 = (uint32_t)(0x80010203 + 0x01020304 * i);
+    if( (uint16_t)range16[i] != (uint16_t)((v16 << 8) | (v16 >> 8))
+      || (uint32_t)range32[i] != ((v32 << 24) | ((v32 << 8) & 0x00ff0000)
+        | ((v32 >> 8) & 0x0000ff00) | (v32 >> 24)) )
+      {
+      std::cerr << std::hex << "range: " << range16[i] << " " << range32[i] << std::endl;
+      return 1;
+      }
+    }
+
   return 0;
 }
@@ -0,0 +1,431 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmPixelKernels.h"
+#include "gdcmSwapper.h"
+
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <cstdlib>
+
+/*
+ * Compare every instruction set supported by the processor against the
+ * scalar implementation, on unaligned buffers of odd sizes (so that the
+ * vectorized loops and the scalar tails are both exercised).
+ */
+static const size_t Sizes[] = { 0, 1, 3, 7, 8, 15, 16, 17, 31, 32, 33, 47, 48, 49, 63, 64, 65, 100, 1001 };
+static const size_t NSizes = sizeof(Sizes) / sizeof(*Sizes);
+
+static void Fill(std::vector<char> &v, unsigned int seed)
+{
+  for( size_t i = 0; i < v.size(); ++i )
+    {
+    seed = seed * 1103515245u + 12345u;
+    v[i] = (char)(seed >> 16);
+    }
+}
+
+static int TestByteSwap(gdcm::PixelKernels::InstructionSetType is)
+{
+  for( size_t s = 0; s < NSizes; ++s )
+    for( size_t offset = 0; offset < 4; ++offset )
+      for( size_t wordsize = 2; wordsize <= 4; wordsize += 2 )
+        {
+        const size_t n = Sizes[s];
+        std::vector<char> ref( offset + n * wordsize );
+        Fill( ref, (unsigned int)(n + offset) );
+        std::vector<char> v = ref;
+        gdcm::PixelKernels::SetInstructionSet( gdcm::PixelKernels::SCALAR );
+        if( wordsize == 2 ) gdcm::PixelKernels::ByteSwap16( &ref[0] + offset, n );
+        else gdcm::PixelKernels::ByteSwap32( &ref[0] + offset, n );
+        gdcm::PixelKernels::SetInstructionSet( is );
+        if( wordsize == 2 ) gdcm::PixelKernels::ByteSwap16( &v[0] + offset, n );
+        else gdcm::PixelKernels::ByteSwap32( &v[0] + offset, n );
+        if( ref != v )
+          {
+          std::cerr << "ByteSwap" << wordsize * 8 << " mismatch for n=" << n
+            << " offset=" << offset << std::endl;
+          return 1;
+          }
+        }
+  return 0;
+}
+
+static int TestPlanarConfiguration(gdcm::PixelKernels::InstructionSetType is)
+{
+  for( size_t s = 0; s < NSizes; ++s )
+    for( size_t offset = 0; offset < 3; ++offset )
+      {
+      const size_t n = Sizes[s];
+      std::vector<char> planes( offset + 3 * n );
+      Fill( planes, (unsigned int)n );
+      const char *r = &planes[0] + offset;
+      std::vector<char> ref( offset + 3 * n + 1 ), v( offset + 3 * n + 1 );
+      gdcm::PixelKernels::SetInstructionSet( gdcm::PixelKernels::SCALAR );
+      gdcm::PixelKernels::PlanarToInterleaved3( &ref[0] + offset, r, r + n, r + 2 * n, n );
+      gdcm::PixelKernels::SetInstructionSet( is );
+      gdcm::PixelKernels::PlanarToInterleaved3( &v[0] + offset, r, r + n, r + 2 * n, n );
+      if( ref != v )
+        {
+        std::cerr << "PlanarToInterleaved3 mismatch for n=" << n << std::endl;
+        return 1;
+        }
+      // And back:
+      std::vector<char> back( offset + 3 * n );
+      char *rb = &back[0] + offset;
+      gdcm::PixelKernels::InterleavedToPlanar3( rb, rb + n, rb + 2 * n, &v[0] + offset, n );
+      if( n && memcmp( rb, r, 3 * n ) != 0 )
+        {
+        std::cerr << "InterleavedToPlanar3 mismatch for n=" << n
+          << " offset=" << offset << std::endl;
+        return 1;
+        }
+      }
+  return 0;
+}
+
+static int TestByteSwapAndCleanup(gdcm::PixelKernels::InstructionSetType is)
+{
+  const unsigned short bitsstored[] = { 8, 10, 12, 15, 16 };
+  for( size_t bs = 0; bs < sizeof(bitsstored) / sizeof(*bitsstored); ++bs )
+    for( int hbdelta = 0; hbdelta < 2; ++hbdelta )
+      for( int flags = 0; flags < 4; ++flags )
+        for( size_t s = 0; s < NSizes; ++s )
+          {
+          const unsigned short bits = bitsstored[bs];
+          // HighBit = BitsStored - 1, and data where the stored bits are
+          // not the least significant ones
+          const unsigned short highbit = (unsigned short)(bits - 1 - hbdelta);
+          const bool byteswap = (flags & 1) != 0;
+          const bool sign = (flags & 2) != 0;
+          const size_t n = Sizes[s];
+          std::vector<char> ref( 1 + 2 * n );
+          Fill( ref, (unsigned int)(n + bits) );
+          std::vector<char> v = ref;
+          gdcm::PixelKernels::SetInstructionSet( gdcm::PixelKernels::SCALAR );
+          gdcm::PixelKernels::ByteSwapAndCleanup16( &ref[1], n, byteswap, bits, highbit, sign );
+          gdcm::PixelKernels::SetInstructionSet( is );
+          gdcm::PixelKernels::ByteSwapAndCleanup16( &v[1], n, byteswap, bits, highbit, sign );
+          if( ref != v )
+            {
+            std::cerr << "ByteSwapAndCleanup16 mismatch for n=" << n
+              << " bits=" << bits << " highbit=" << highbit
+              << " byteswap=" << byteswap << " sign=" << sign << std::endl;
+            return 1;
+            }
+          }
+  return 0;
+}
+
+static int TestLinearTransform(gdcm::PixelKernels::InstructionSetType is)
+{
+  const int slopes[] = { 1, 2, -3 };
+  const int intercepts[] = { 0, -1024, 32000 };
+  for( size_t k = 0; k < 3; ++k )
+    for( size_t s = 0; s < NSizes; ++s )
+      {
+      const size_t n = Sizes[s];
+      std::vector<char> in( 1 + 2 * n );
+      Fill( in, (unsigned int)n );
+      std::vector<char> ref( 1 + 2 * n ), v( 1 + 2 * n );
+      gdcm::PixelKernels::SetInstructionSet( gdcm::PixelKernels::SCALAR );
+      gdcm::PixelKernels::LinearTransform16( &ref[1], &in[1], n, slopes[k], intercepts[k] );
+      gdcm::PixelKernels::SetInstructionSet( is );
+      gdcm::PixelKernels::LinearTransform16( &v[1], &in[1], n, slopes[k], intercepts[k] );
+      if( ref != v )
+        {
+        std::cerr << "LinearTransform16 mismatch for n=" << n << std::endl;
+        return 1;
+        }
+      for( int sign = 0; sign < 2; ++sign )
+        {
+        std::vector<double> dref( n + 1 ), dv( n + 1 );
+        gdcm::PixelKernels::SetInstructionSet( gdcm::PixelKernels::SCALAR );
+        gdcm::PixelKernels::LinearTransform16ToDouble( &dref[0], &in[1], n, sign != 0, 0.1 * slopes[k], intercepts[k] + 0.5 );
+        gdcm::PixelKernels::SetInstructionSet( is );
+        gdcm::PixelKernels::LinearTransform16ToDouble( &dv[0], &in[1], n, sign != 0, 0.1 * slopes[k], intercepts[k] + 0.5 );
+        if( dref != dv )
+          {
+          std::cerr << "LinearTransform16ToDouble mismatch for n=" << n << std::endl;
+          return 1;
+          }
+        }
+      }
+  return 0;
+}
+
+static int TestApplyLookupTable(gdcm::PixelKernels::InstructionSetType is)
+{
+  std::vector<char> lut( 256 * 4 );
+  Fill( lut, 256 );
+  const unsigned char *rgbx = (const unsigned char*)&lut[0];
+  for( size_t s = 0; s < NSizes; ++s )
+    {
+    const size_t n = Sizes[s];
+    std::vector<char> in( n + 1 );
+    Fill( in, (unsigned int)n );
+    std::vector<char> ref( 3 * n + 1 ), v( 3 * n + 1 );
+    gdcm::PixelKernels::SetInstructionSet( gdcm::PixelKernels::SCALAR );
+    gdcm::PixelKernels::ApplyLookupTable8( &ref[1], &in[1], n, rgbx );
+    gdcm::PixelKernels::SetInstructionSet( is );
+    gdcm::PixelKernels::ApplyLookupTable8( &v[1], &in[1], n, rgbx );
+    if( ref != v )
+      {
+      std::cerr << "ApplyLookupTable8 mismatch for n=" << n << std::endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+static int TestPacked12Bits(gdcm::PixelKernels::InstructionSetType is)
+{
+  for( size_t s = 0; s < NSizes; ++s )
+    {
+    const size_t n = Sizes[s];
+    std::vector<char> packed( 3 * n + 1 );
+    Fill( packed, (unsigned int)n );
+    std::vector<char> ref( 4 * n + 1 ), v( 4 * n + 1 );
+    gdcm::PixelKernels::SetInstructionSet( gdcm::PixelKernels::SCALAR );
+    gdcm::PixelKernels::Unpack12Bits( &ref[1], &packed[1], n );
+    gdcm::PixelKernels::SetInstructionSet( is );
+    gdcm::PixelKernels::Unpack12Bits( &v[1], &packed[1], n );
+    // in place, from the end of the output buffer
+    std::vector<char> inplace( 4 * n + 1 );
+    std::copy( packed.begin() + 1, packed.end(), inplace.begin() + 1 + n );
+    gdcm::PixelKernels::Unpack12Bits( &inplace[1], &inplace[1] + n, n );
+    inplace[0] = v[0];
+    if( ref != v || inplace != v )
+      {
+      std::cerr << "Unpack12Bits mismatch for n=" << n << std::endl;
+      return 1;
+      }
+
+    // words are not all 12 bits values
+    std::vector<char> words( 4 * n + 1 );
+    Fill( words, (unsigned int)n + 1 );
+    std::vector<char> pref( 3 * n + 1 ), pv( 3 * n + 1 );
+    gdcm::PixelKernels::SetInstructionSet( gdcm::PixelKernels::SCALAR );
+    gdcm::PixelKernels::Pack12Bits( &pref[1], &words[1], n );
+    gdcm::PixelKernels::SetInstructionSet( is );
+    gdcm::PixelKernels::Pack12Bits( &pv[1], &words[1], n );
+    gdcm::PixelKernels::Pack12Bits( &words[1], &words[1], n );
+    if( pref != pv || !std::equal( pv.begin() + 1, pv.end(), words.begin() + 1 ) )
+      {
+      std::cerr << "Pack12Bits mismatch for n=" << n << std::endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+static int TestColorConversion(gdcm::PixelKernels::InstructionSetType is)
+{
+  for( size_t s = 0; s < NSizes; ++s )
+    {
+    const size_t n = Sizes[s];
+    std::vector<char> in( 3 * n + 1 );
+    Fill( in, (unsigned int)n + 2 );
+    for( int k = 0; k < 4; ++k )
+      {
+      const bool partial = k % 2 != 0;
+      std::vector<char> ref( 3 * n + 1 ), v( 3 * n + 1 ), inplace( in );
+      gdcm::PixelKernels::SetInstructionSet( gdcm::PixelKernels::SCALAR );
+      if( k < 2 ) gdcm::PixelKernels::YBRToRGB8( &ref[1], &in[1], n, partial );
+      else gdcm::PixelKernels::RGBToYBR8( &ref[1], &in[1], n, partial );
+      gdcm::PixelKernels::SetInstructionSet( is );
+      if( k < 2 )
+        {
+        gdcm::PixelKernels::YBRToRGB8( &v[1], &in[1], n, partial );
+        gdcm::PixelKernels::YBRToRGB8( &inplace[1], &inplace[1], n, partial );
+        }
+      else
+        {
+        gdcm::PixelKernels::RGBToYBR8( &v[1], &in[1], n, partial );
+        gdcm::PixelKernels::RGBToYBR8( &inplace[1], &inplace[1], n, partial );
+        }
+      inplace[0] = v[0];
+      if( ref != v || inplace != v )
+        {
+        std::cerr << "Color conversion " << k << " mismatch for n=" << n << std::endl;
+        return 1;
+        }
+      }
+
+    std::vector<char> sub( 4 * n + 1 );
+    Fill( sub, (unsigned int)n + 3 );
+    std::vector<char> ref( 6 * n + 1 ), v( 6 * n + 1 );
+    gdcm::PixelKernels::SetInstructionSet( gdcm::PixelKernels::SCALAR );
+    gdcm::PixelKernels::UpsampleYBR422( &ref[1], &sub[1], n );
+    gdcm::PixelKernels::SetInstructionSet( is );
+    gdcm::PixelKernels::UpsampleYBR422( &v[1], &sub[1], n );
+    // in place, from the end of the output buffer
+    std::vector<char> inplace( 6 * n + 1 );
+    std::copy( sub.begin() + 1, sub.end(), inplace.begin() + 1 + 2 * n );
+    gdcm::PixelKernels::UpsampleYBR422( &inplace[1], &inplace[1] + 2 * n, n );
+    inplace[0] = v[0];
+    if( ref != v || inplace != v )
+      {
+      std::cerr << "UpsampleYBR422 mismatch for n=" << n << std::endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+static int Clamp(double v)
+{
+  return v < 0 ? 0 : (v > 255 ? 255 : (int)(v + 0.5));
+}
+
+// The fixed point conversions are within 1 of the PS 3.3 C.7.6.3.1.2
+// equations
+static int TestColorAccuracy()
+{
+  gdcm::PixelKernels::SetInstructionSet( gdcm::PixelKernels::SCALAR );
+  for( int y = 0; y < 256; y += 3 )
+    for( int cb = 0; cb < 256; cb += 5 )
+      for( int cr = 0; cr < 256; cr += 7 )
+        {
+        const unsigned char ybr[3] = { (unsigned char)y, (unsigned char)cb, (unsigned char)cr };
+        unsigned char rgb[3];
+        gdcm::PixelKernels::YBRToRGB8( (char*)rgb, (const char*)ybr, 1, false );
+        int expected[3];
+        expected[0] = Clamp( y + 1.402 * (cr - 128) );
+        expected[1] = Clamp( y - 0.344136 * (cb - 128) - 0.714136 * (cr - 128) );
+        expected[2] = Clamp( y + 1.772 * (cb - 128) );
+        for( int c = 0; c < 3; ++c )
+          {
+          if( abs( rgb[c] - expected[c] ) > 1 ) return 1;
+          }
+        // YBR_FULL of an RGB pixel
+        gdcm::PixelKernels::RGBToYBR8( (char*)rgb, (const char*)ybr, 1, false );
+        expected[0] = Clamp( .299 * y + .587 * cb + .114 * cr );
+        expected[1] = Clamp( -.168736 * y - .331264 * cb + .5 * cr + 128 );
+        expected[2] = Clamp( .5 * y - .418688 * cb - .081312 * cr + 128 );
+        for( int c = 0; c < 3; ++c )
+          {
+          if( abs( rgb[c] - expected[c] ) > 1 ) return 1;
+          }
+        }
+  // YBR_PARTIAL black and white
+  const unsigned char partial[6] = { 16, 128, 128, 235, 128, 128 };
+  unsigned char bw[6];
+  gdcm::PixelKernels::YBRToRGB8( (char*)bw, (const char*)partial, 2, true );
+  const unsigned char expected[6] = { 0, 0, 0, 255, 255, 255 };
+  if( memcmp( bw, expected, 6 ) != 0 ) return 1;
+  gdcm::PixelKernels::RGBToYBR8( (char*)bw, (const char*)expected, 2, true );
+  if( memcmp( bw, partial, 6 ) != 0 ) return 1;
+  return 0;
+}
+
+// Check the scalar implementation on a few known values
+static int TestScalarReference()
+{
+  gdcm::PixelKernels::SetInstructionSet( gdcm::PixelKernels::SCALAR );
+  uint16_t v16[] = { 0x0102, 0xfffe, 0x0ff0 };
+  gdcm::PixelKernels::ByteSwap16( v16, 3 );
+  if( v16[0] != 0x0201 || v16[1] != 0xfeff || v16[2] != 0xf00f ) return 1;
+  uint32_t v32[] = { 0x01020304 };
+  gdcm::PixelKernels::ByteSwap32( v32, 1 );
+  if( v32[0] != 0x04030201 ) return 1;
+
+  // 12 bits stored: overlay bits are cleared, sign is propagated
+  uint16_t pixels[] = { 0xf7ff, 0x0800, 0xffff };
+  gdcm::PixelKernels::ByteSwapAndCleanup16( pixels, 3, false, 12, 11, false );
+  if( pixels[0] != 0x07ff || pixels[1] != 0x0800 || pixels[2] != 0x0fff ) return 1;
+  uint16_t spixels[] = { 0xf7ff, 0x0800, 0x0fff };
+  gdcm::PixelKernels::ByteSwapAndCleanup16( spixels, 3, false, 12, 11, true );
+  if( spixels[0] != 0x07ff || spixels[1] != 0xf800 || spixels[2] != 0xffff ) return 1;
+
+  const char planes[] = { 'r', 'R', 'g', 'G', 'b', 'B' };
+  char rgb[6];
+  gdcm::PixelKernels::PlanarToInterleaved3( rgb, planes, planes + 2, planes + 4, 2 );
+  if( memcmp( rgb, "rgbRGB", 6 ) != 0 ) return 1;
+
+  // 12 bits Stored Pixel Values into Hounsfield Units
+  const uint16_t sv[] = { 0, 1024, 4095 };
+  int16_t hu[3];
+  gdcm::PixelKernels::LinearTransform16( hu, sv, 3, 1, -1024 );
+  if( hu[0] != -1024 || hu[1] != 0 || hu[2] != 3071 ) return 1;
+  const int16_t ssv[] = { -2, 0, 3 };
+  double d[3];
+  gdcm::PixelKernels::LinearTransform16ToDouble( d, ssv, 3, true, 0.5, -1 );
+  if( d[0] != -2 || d[1] != -1 || d[2] != 0.5 ) return 1;
+
+  unsigned char rgbx[256 * 4] = { 0 };
+  memcpy( rgbx + 4 * 1, "abc?", 4 );
+  memcpy( rgbx + 4 * 200, "xyz?", 4 );
+  const unsigned char indexes[] = { 1, 200, 0, 1, 200 };
+  char palette[16];
+  memset( palette, '.', sizeof(palette) );
+  gdcm::PixelKernels::ApplyLookupTable8( palette, (const char*)indexes, 5, rgbx );
+  if( memcmp( palette, "abcxyz\0\0\0abcxyz.", 16 ) != 0 ) return 1;
+
+  const unsigned char packed[] = { 0x01, 0x23, 0x45 };
+  uint16_t unpacked[2];
+  gdcm::PixelKernels::Unpack12Bits( (char*)unpacked, (const char*)packed, 1 );
+  if( unpacked[0] != 0x301 || unpacked[1] != 0x452 ) return 1;
+
+  char upsampled[12];
+  gdcm::PixelKernels::UpsampleYBR422( upsampled, "abcdABCD", 2 );
+  if( memcmp( upsampled, "acdbcdACDBCD", 12 ) != 0 ) return 1;
+  return TestColorAccuracy();
+}
+
+int TestPixelKernels(int, char *[])
+{
+  const gdcm::PixelKernels::InstructionSetType best =
+    gdcm::PixelKernels::GetInstructionSet();
+  std::cout << "Instruction set: "
+    << gdcm::PixelKernels::GetInstructionSetString( best ) << std::endl;
+  if( !gdcm::PixelKernels::IsInstructionSetSupported( best ) ) return 1;
+
+  int res = TestScalarReference();
+  if( res ) std::cerr << "Wrong scalar reference" << std::endl;
+  const gdcm::PixelKernels::InstructionSetType sets[] = {
+    gdcm::PixelKernels::SSE2,
+    gdcm::PixelKernels::SSSE3,
+    gdcm::PixelKernels::AVX2,
+    gdcm::PixelKernels::NEON
+  };
+  for( size_t i = 0; i < sizeof(sets) / sizeof(*sets); ++i )
+    {
+    const gdcm::PixelKernels::InstructionSetType is = sets[i];
+    if( !gdcm::PixelKernels::IsInstructionSetSupported( is ) )
+      {
+      if( gdcm::PixelKernels::SetInstructionSet( is ) ) res = 1;
+      continue;
+      }
+    std::cout << "Testing " << gdcm::PixelKernels::GetInstructionSetString( is ) << std::endl;
+    res += TestByteSwap( is );
+    res += TestPlanarConfiguration( is );
+    res += TestByteSwapAndCleanup( is );
+    res += TestLinearTransform( is );
+    res += TestApplyLookupTable( is );
+    res += TestPacked12Bits( is );
+    res += TestColorConversion( is );
+    }
+
+  // SwapperDoOp::SwapArray goes through the kernels for large arrays
+  std::vector<uint16_t> a( 100 ), b( 100 );
+  for( size_t i = 0; i < a.size(); ++i ) a[i] = b[i] = (uint16_t)(i * 257 + 1);
+  gdcm::SwapperDoOp::SwapArray( &a[0], a.size() );
+  gdcm::SwapperDoOp::SwapArray( &a[0], a.size() );
+  if( a != b ) res = 1;
+
+  gdcm::PixelKernels::SetInstructionSet( best );
+  return res;
+}
@@ -0,0 +1,77 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmSmartPointer.h"
+#include "gdcmObject.h"
+
+#include <iostream>
+#include <vector>
+
+#include <pthread.h>
+
+/*
+ * Share one Object between threads copying and releasing SmartPointer to
+ * it: the reference count must stay consistent.
+ */
+static int ndeleted = 0;
+
+class Counted : public gdcm::Object {
+public:
+  ~Counted() { ++ndeleted; }
+};
+
+static const unsigned int ncopies = 100000;
+
+static void* func (void* arg)
+{
+  const gdcm::SmartPointer<Counted> &shared =
+    *reinterpret_cast< gdcm::SmartPointer<Counted>* >(arg);
+  std::vector< gdcm::SmartPointer<Counted> > copies( 16 );
+  for(unsigned int i = 0; i < ncopies; i++)
+    {
+    copies[ i % copies.size() ] = shared;
+    gdcm::SmartPointer<Counted> tmp = shared;
+    copies[ (i + 8) % copies.size() ] = 0;
+    }
+  return NULL;
+}
+
+int TestSmartPointer2(int , char *[])
+{
+  const unsigned int nthreads = 8;
+  pthread_t th[nthreads];
+  {
+  gdcm::SmartPointer<Counted> shared = new Counted;
+  unsigned int i;
+  for (i = 0; i < nthreads; i++)
+    {
+    const int ret = pthread_create (&th[i], NULL, func, (void*)&shared);
+    if( ret ) return 1;
+    }
+  for (i = 0; i < nthreads; i++)
+    pthread_join (th[i], NULL);
+
+  if( ndeleted != 0 )
+    {
+    std::cerr << "Object deleted while still referenced" << std::endl;
+    return 1;
+    }
+  }
+  if( ndeleted != 1 )
+    {
+    std::cerr << "Object deleted " << ndeleted << " times" << std::endl;
+    return 1;
+    }
+
+  return 0;
+}
@@ -0,0 +1,77 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmSortedVector.h"
+
+#include <set>
+#include <iterator>
+#include <iostream>
+
+int TestSortedVector(int argc, char *argv[])
+{
+  (void)argv; (void)argc;
+  typedef gdcm::SortedVector<int> SortedVectorType;
+  SortedVectorType sv;
+  std::set<int> ref;
+  if( !sv.empty() || sv.find(0) != sv.end() ) return 1;
+
+  // Mix of appends, insertions in the middle and duplicates
+  const int values[] = { 1, 5, 9, 3, 7, 9, 0, 12, 5, 4 };
+  const size_t n = sizeof(values) / sizeof(*values);
+  for( size_t i = 0; i < n; ++i )
+    {
+    std::pair<SortedVectorType::iterator,bool> r1 = sv.insert( values[i] );
+    std::pair<std::set<int>::iterator,bool> r2 = ref.insert( values[i] );
+    if( r1.second != r2.second || *r1.first != values[i] )
+      {
+      std::cerr << "insert failed: " << values[i] << std::endl;
+      return 1;
+      }
+    }
+  if( sv.size() != ref.size()
+    || !std::equal( sv.begin(), sv.end(), ref.begin() ) )
+    {
+    std::cerr << "not sorted" << std::endl;
+    return 1;
+    }
+
+  for( int v = -1; v < 14; ++v )
+    {
+    if( sv.count(v) != ref.count(v) ) return 1;
+    if( (sv.find(v) == sv.end()) != (ref.find(v) == ref.end()) ) return 1;
+    if( std::distance( sv.begin(), sv.lower_bound(v) )
+      != std::distance( ref.begin(), ref.lower_bound(v) ) ) return 1;
+    if( std::distance( sv.begin(), sv.upper_bound(v) )
+      != std::distance( ref.begin(), ref.upper_bound(v) ) ) return 1;
+    }
+
+  // erase by key / by iterator
+  if( sv.erase( 6 ) != 0 || sv.erase( 7 ) != 1 ) return 1;
+  ref.erase( 7 );
+  SortedVectorType::iterator it = sv.erase( sv.find( 3 ) );
+  ref.erase( 3 );
+  if( *it != 4 ) return 1;
+  if( sv.size() != ref.size()
+    || !std::equal( sv.begin(), sv.end(), ref.begin() ) )
+    {
+    std::cerr << "erase failed" << std::endl;
+    return 1;
+    }
+
+  SortedVectorType copy = sv;
+  if( !(copy == sv) ) return 1;
+  copy.clear();
+  if( !copy.empty() || copy == sv ) return 1;
+
+  return 0;
+}
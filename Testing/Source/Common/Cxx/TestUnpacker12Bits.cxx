@@ -132,5 +132,25 @@ int TestUnpacker12Bits(int, char *[])
 
 }
 
+{
+  // Unpack in place: the packed values are stored at the end of the output
+  std::vector<unsigned short> v;
+  for(uint16_t val = 0; val < 4096; ++val)
+    {
+    v.push_back( (uint16_t)((val * 7) % 4096) );
+    }
+  std::vector<unsigned short> buffer( v.size() );
+  char *out = (char*)&buffer[0];
+  const size_t packedlen = v.size() / 2 * 3;
+  char *packed = out + packedlen / 3;
+  if( !gdcm::Unpacker12Bits::Pack( packed, (char*)&v[0], v.size() * 2 )
+    || !gdcm::Unpacker12Bits::Unpack( out, packed, packedlen )
+    || buffer != v )
+    {
+    std::cerr << "In place unpacking failed" << std::endl;
+    ++res;
+    }
+}
+
   return res;
 }
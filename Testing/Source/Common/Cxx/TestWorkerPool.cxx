@@ -0,0 +1,86 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmWorkerPool.h"
+
+#include <iostream>
+#include <vector>
+
+// Record which worker ran each index, and the order of the Finish calls
+class RecordJob : public gdcm::WorkerPool::Job
+{
+public:
+  RecordJob(unsigned int n):Workers(n, ~0u),Results(n, 0),Failed(false) {}
+  void Execute(unsigned int index)
+    {
+    Results[index] = index * index;
+    }
+  void ExecuteOnWorker(unsigned int index, unsigned int worker)
+    {
+    Workers[index] = worker;
+    Execute(index);
+    }
+  void Finish(unsigned int index)
+    {
+    if( index != Finished.size() || Results[index] != index * index )
+      Failed = true;
+    Finished.push_back( index );
+    }
+  std::vector<unsigned int> Workers;
+  std::vector<unsigned int> Results;
+  std::vector<unsigned int> Finished;
+  bool Failed;
+};
+
+int TestWorkerPool(int, char *[])
+{
+  const unsigned int nthreads[] = { 1, 2, 4, 7 };
+  const unsigned int n = 100;
+  for( unsigned int t = 0; t < sizeof(nthreads) / sizeof(*nthreads); ++t )
+    {
+    gdcm::WorkerPool pool;
+    pool.SetNumberOfThreads( nthreads[t] );
+    RecordJob job( n );
+    pool.Run( job, n );
+    if( job.Failed || job.Finished.size() != n )
+      {
+      std::cerr << "Wrong Finish calls with " << nthreads[t] << " threads" << std::endl;
+      return 1;
+      }
+    for( unsigned int i = 0; i < n; ++i )
+      {
+      if( job.Workers[i] >= nthreads[t] )
+        {
+        std::cerr << "Wrong worker " << job.Workers[i] << " for index " << i
+          << " with " << nthreads[t] << " threads" << std::endl;
+        return 1;
+        }
+      }
+    }
+
+  // more threads than work
+  gdcm::WorkerPool pool;
+  pool.SetNumberOfThreads( 8 );
+  RecordJob job( 3 );
+  pool.Run( job, 3 );
+  if( job.Failed || job.Finished.size() != 3
+    || job.Workers[0] >= 3 || job.Workers[1] >= 3 || job.Workers[2] >= 3 )
+    {
+    std::cerr << "Wrong run with more threads than work" << std::endl;
+    return 1;
+    }
+
+  if( !pool.GetNumberOfProcessors() ) return 1;
+
+  return 0;
+}
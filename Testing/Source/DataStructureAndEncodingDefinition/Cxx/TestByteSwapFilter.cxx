@@ -12,10 +12,49 @@
 
 =========================================================================*/
 #include "gdcmByteSwapFilter.h"
+#include "gdcmDataSet.h"
 
 int TestByteSwapFilter(int, char *[])
 {
   gdcm::DataSet ds;
   gdcm::ByteSwapFilter bsf( ds );
+
+  // (0101,0202) swaps to itself, (0010,0020) and (1000,2000) swap to each
+  // other: none of them may be lost while the tags are swapped
+  const gdcm::Tag tags[] = {
+    gdcm::Tag(0x0010,0x0020), gdcm::Tag(0x0101,0x0202),
+    gdcm::Tag(0x0234,0x0456), gdcm::Tag(0x1000,0x2000) };
+  const unsigned int ntags = sizeof(tags) / sizeof(tags[0]);
+  for( unsigned int i = 0; i < ntags; ++i )
+    {
+    gdcm::DataElement de( tags[i] );
+    de.SetVR( gdcm::VR::US );
+    const uint16_t value = (uint16_t)(0x0102 * (i + 1));
+    de.SetByteValue( (const char*)&value, sizeof(value) );
+    ds.Insert( de );
+    }
+  bsf.SetByteSwapTag( true );
+  if( !bsf.ByteSwap() || ds.Size() != ntags )
+    {
+    std::cerr << "Elements lost: " << ds.Size() << std::endl;
+    return 1;
+    }
+  for( unsigned int i = 0; i < ntags; ++i )
+    {
+    const gdcm::Tag swapped(
+      (uint16_t)((tags[i].GetGroup() << 8) | (tags[i].GetGroup() >> 8)),
+      (uint16_t)((tags[i].GetElement() << 8) | (tags[i].GetElement() >> 8)) );
+    const uint16_t value = (uint16_t)(0x0102 * (i + 1));
+    const gdcm::ByteValue *bv = ds.GetDataElement( swapped ).GetByteValue();
+    uint16_t swappedvalue;
+    if( !bv || bv->GetLength() != 2
+      || !bv->GetBuffer( (char*)&swappedvalue, 2 )
+      || swappedvalue != (uint16_t)((value << 8) | (value >> 8)) )
+      {
+      std::cerr << "Wrong element: " << swapped << std::endl;
+      return 1;
+      }
+    }
+
   return 0;
 }
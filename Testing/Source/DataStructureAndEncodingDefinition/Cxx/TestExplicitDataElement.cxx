@@ -86,6 +86,59 @@ int TestExplicitDataElement2(const uint16_t group,
   return 0;
 }
 
+// Compare DecodePreValue with ReadPreValue on the same header. A header
+// rejected by DecodePreValue must be one ReadPreValue has to handle.
+int TestExplicitDataElement3(const uint16_t group,
+                             const uint16_t element,
+                             const char *vr,
+                             const uint32_t vl,
+                             bool vl32,
+                             size_t expected)
+{
+  std::string header;
+  header.append( reinterpret_cast<const char*>(&group), sizeof(group) );
+  header.append( reinterpret_cast<const char*>(&element), sizeof(element) );
+  header.append( vr, 2 );
+  if( vl32 )
+    {
+    header.append( "\0\0", 2 );
+    header.append( reinterpret_cast<const char*>(&vl), sizeof(vl) );
+    }
+  else
+    {
+    const uint16_t vl16 = (uint16_t)vl;
+    header.append( reinterpret_cast<const char*>(&vl16), sizeof(vl16) );
+    }
+
+  gdcm::ExplicitDataElement de1;
+  const size_t n = de1.DecodePreValue( header.c_str(), header.size() );
+  if( n != expected )
+    {
+    std::cerr << "DecodePreValue: " << n << " for " << vr << std::endl;
+    return 1;
+    }
+  // Truncated header:
+  if( de1.DecodePreValue( header.c_str(), header.size() - 1 ) != 0 )
+    {
+    std::cerr << "DecodePreValue on a truncated header" << std::endl;
+    return 1;
+    }
+  if( !n ) return 0;
+  std::stringstream ss( header );
+  gdcm::ExplicitDataElement de2;
+  if( !de2.ReadPreValue<gdcm::SwapperNoOp>(ss)
+    || de1.GetTag() != de2.GetTag()
+    || !(de1.GetVR() == de2.GetVR())
+    || de1.GetVL() != de2.GetVL()
+    || (size_t)ss.tellg() != n )
+    {
+    std::cerr << de1 << std::endl;
+    std::cerr << de2 << std::endl;
+    return 1;
+    }
+  return 0;
+}
+
 inline void WriteRead(gdcm::DataElement const &w, gdcm::DataElement &r)
 {
   // w will be written
@@ -107,6 +160,21 @@ int TestExplicitDataElement(int, char *[])
   r += TestExplicitDataElement1(group, element, vr, vl);
   r += TestExplicitDataElement2(group, element, vr, value);
 
+#ifndef GDCM_WORDS_BIGENDIAN
+  r += TestExplicitDataElement3(0x0028, 0x0010, "US", 2, false, 8);
+  r += TestExplicitDataElement3(0x0008, 0x0018, "UI", 0xfffe, false, 8);
+  r += TestExplicitDataElement3(0x7fe0, 0x0010, "OW", 0xffffffff, true, 12);
+  r += TestExplicitDataElement3(0x0008, 0x1140, "SQ", 0, true, 12);
+  r += TestExplicitDataElement3(0x0010, 0x0012, "UN", 0x12345678, true, 12);
+  // Unknown VR, read as UN:
+  r += TestExplicitDataElement3(0x0010, 0x0012, "ZZ", 4, true, 12);
+  // Left to ReadPreValue:
+  r += TestExplicitDataElement3(0x0010, 0x0012, "\0\4", 4, true, 0);
+  r += TestExplicitDataElement3(0xfffe, 0xe00d, "\0\0", 0, true, 0);
+  r += TestExplicitDataElement3(0xfffe, 0xe000, "\0\0", 0, true, 0);
+  r += TestExplicitDataElement3(0x0010, 0x0012, "OB", 4, false, 0); // reserved != 0
+#endif
+
   gdcm::ExplicitDataElement de1(gdcm::Tag(0x1234, 0x5678), 0x4321);
   gdcm::ExplicitDataElement de2(gdcm::Tag(0x1234, 0x6789), 0x9876);
   WriteRead(de1, de2);
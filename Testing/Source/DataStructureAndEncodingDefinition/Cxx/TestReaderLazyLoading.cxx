@@ -0,0 +1,213 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmReader.h"
+#include "gdcmWriter.h"
+#include "gdcmSystem.h"
+#include "gdcmTesting.h"
+#include "gdcmByteValue.h"
+#include "gdcmLazyValueLoader.h"
+
+#include <vector>
+#include <sstream>
+#include <cstring>
+
+/*
+ * Compare a regular read with a lazy read of the same file
+ */
+static int TestReadLazyLoading(const char* filename, bool verbose = false)
+{
+  if( verbose )
+    std::cout << "TestReadLazyLoading: " << filename << std::endl;
+  gdcm::Reader reader;
+  reader.SetFileName( filename );
+  if( !reader.Read() )
+    {
+    return 0;
+    }
+  gdcm::Reader lazyreader;
+  lazyreader.SetFileName( filename );
+  lazyreader.SetLazyLoadingThreshold( 256 );
+  if( !lazyreader.Read() )
+    {
+    std::cerr << "Failed to read lazily: " << filename << std::endl;
+    return 1;
+    }
+  const gdcm::DataSet &ds1 = reader.GetFile().GetDataSet();
+  const gdcm::DataSet &ds2 = lazyreader.GetFile().GetDataSet();
+  if( ds1.Size() != ds2.Size() )
+    {
+    std::cerr << "Size mismatch: " << filename << std::endl;
+    return 1;
+    }
+  gdcm::DataSet::ConstIterator it1 = ds1.Begin();
+  gdcm::DataSet::ConstIterator it2 = ds2.Begin();
+  for( ; it1 != ds1.End(); ++it1, ++it2 )
+    {
+    if( !(*it1 == *it2) )
+      {
+      std::cerr << "Element mismatch: " << it1->GetTag() << " in " << filename << std::endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+// Expose the stream the reader parsed
+class StreamReader : public gdcm::Reader
+{
+public:
+  std::istream *GetStream() const { return GetStreamPtr(); }
+};
+
+static int TestReadLazyLoadingRoundTrip(const char *subdir)
+{
+  std::string tmpdir = gdcm::Testing::GetTempDirectory( subdir );
+  if( !gdcm::System::FileIsDirectory( tmpdir.c_str() ) )
+    {
+    gdcm::System::MakeDirectory( tmpdir.c_str() );
+    }
+  std::string outfilename = gdcm::Testing::GetTempFilename( "lazy.dcm", subdir );
+
+  gdcm::Writer w;
+  gdcm::File &file = w.GetFile();
+  gdcm::DataSet &ds = file.GetDataSet();
+  const char sopclass[] = "1.2.840.10008.5.1.4.1.1.7";
+  const char sopinstance[] = "1.2.3.4.5.6.7.8.9.1";
+  gdcm::DataElement de( gdcm::Tag(0x0008,0x0016) );
+  de.SetVR( gdcm::VR::UI );
+  de.SetByteValue( sopclass, (uint32_t)strlen(sopclass) );
+  ds.Insert( de );
+  de.SetTag( gdcm::Tag(0x0008,0x0018) );
+  de.SetByteValue( sopinstance, (uint32_t)strlen(sopinstance) );
+  ds.Insert( de );
+  std::vector<char> pixels( 256 * 256 * 2 );
+  for( size_t i = 0; i < pixels.size(); ++i ) pixels[i] = (char)(i % 253);
+  gdcm::DataElement pixeldata( gdcm::Tag(0x7fe0,0x0010) );
+  pixeldata.SetVR( gdcm::VR::OW );
+  pixeldata.SetByteValue( &pixels[0], (uint32_t)pixels.size() );
+  ds.Insert( pixeldata );
+  file.GetHeader().SetDataSetTransferSyntax( gdcm::TransferSyntax::ExplicitVRLittleEndian );
+  w.SetFileName( outfilename.c_str() );
+  if( !w.Write() )
+    {
+    std::cerr << "Failed to write: " << outfilename << std::endl;
+    return 1;
+    }
+
+  gdcm::DataElement lazypixeldata;
+  std::string lazyoutput;
+  {
+  gdcm::Reader reader;
+  reader.SetFileName( outfilename.c_str() );
+  reader.SetLazyLoadingThreshold( 1024 );
+  if( !reader.Read() )
+    {
+    std::cerr << "Failed to read lazily: " << outfilename << std::endl;
+    return 1;
+    }
+  const gdcm::DataSet &rds = reader.GetFile().GetDataSet();
+  if( !rds.GetDataElement( de.GetTag() ).GetByteValue()->IsLoaded() )
+    {
+    std::cerr << "Small value was deferred" << std::endl;
+    return 1;
+    }
+  lazypixeldata = rds.GetDataElement( pixeldata.GetTag() );
+  const gdcm::ByteValue *bv = lazypixeldata.GetByteValue();
+  if( !bv || bv->IsLoaded() || bv->GetLength() != pixels.size() )
+    {
+    std::cerr << "Pixel Data was read" << std::endl;
+    return 1;
+    }
+  // Writing does not load the value
+  std::ostringstream os;
+  gdcm::Writer w2;
+  w2.SetStream( os );
+  w2.SetFile( reader.GetFile() );
+  if( !w2.Write() || bv->IsLoaded() )
+    {
+    std::cerr << "Write loaded the value" << std::endl;
+    return 1;
+    }
+  lazyoutput = os.str();
+  }
+
+  // The value outlives the reader, and is loaded on first access
+  const gdcm::ByteValue *bv = lazypixeldata.GetByteValue();
+  if( memcmp( bv->GetPointer(), &pixels[0], pixels.size() ) != 0 || !bv->IsLoaded() )
+    {
+    std::cerr << "Wrong Pixel Data" << std::endl;
+    return 1;
+    }
+
+  gdcm::Reader reader;
+  reader.SetFileName( outfilename.c_str() );
+  if( !reader.Read() ) return 1;
+  std::ostringstream os;
+  gdcm::Writer w3;
+  w3.SetStream( os );
+  w3.SetFile( reader.GetFile() );
+  if( !w3.Write() || os.str() != lazyoutput )
+    {
+    std::cerr << "Lazy write differs" << std::endl;
+    return 1;
+    }
+
+  // Deflated data sets are read through a zlib stream: the loader must still
+  // be detached from the file stream once done
+  std::string deflatedfilename = gdcm::Testing::GetTempFilename( "lazydeflated.dcm", subdir );
+  file.GetHeader().Clear();
+  file.GetHeader().SetDataSetTransferSyntax( gdcm::TransferSyntax::DeflatedExplicitVRLittleEndian );
+  w.SetFileName( deflatedfilename.c_str() );
+  if( !w.Write() )
+    {
+    std::cerr << "Failed to write: " << deflatedfilename << std::endl;
+    return 1;
+    }
+  StreamReader deflatedreader;
+  deflatedreader.SetFileName( deflatedfilename.c_str() );
+  deflatedreader.SetLazyLoadingThreshold( 1024 );
+  if( !deflatedreader.Read()
+    || gdcm::LazyValueLoader::GetLazyValueLoader( *deflatedreader.GetStream() ) )
+    {
+    std::cerr << "Loader left attached: " << deflatedfilename << std::endl;
+    return 1;
+    }
+
+  return TestReadLazyLoading( outfilename.c_str() )
+    + TestReadLazyLoading( deflatedfilename.c_str() );
+}
+
+int TestReaderLazyLoading(int argc, char *argv[])
+{
+  if( argc == 2 )
+    {
+    const char *filename = argv[1];
+    return TestReadLazyLoading(filename, true);
+    }
+
+  // else
+  gdcm::Trace::DebugOff();
+  gdcm::Trace::WarningOff();
+  int r = TestReadLazyLoadingRoundTrip( argv[0] );
+  int i = 0;
+  const char *filename;
+  const char * const *filenames = gdcm::Testing::GetFileNames();
+  while( (filename = filenames[i]) )
+    {
+    r += TestReadLazyLoading( filename );
+    ++i;
+    }
+
+  return r;
+}
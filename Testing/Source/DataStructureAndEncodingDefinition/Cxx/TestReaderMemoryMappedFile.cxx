@@ -0,0 +1,167 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmReader.h"
+#include "gdcmWriter.h"
+#include "gdcmSystem.h"
+#include "gdcmTesting.h"
+#include "gdcmByteValue.h"
+
+#include <vector>
+#include <cstring>
+
+/*
+ * Compare a regular read with a memory mapped read of the same file
+ */
+static int TestReadMemoryMappedFile(const char* filename, bool verbose = false)
+{
+  if( verbose )
+    std::cout << "TestReadMemoryMappedFile: " << filename << std::endl;
+  gdcm::Reader reader;
+  reader.SetFileName( filename );
+  if( !reader.Read() )
+    {
+    return 0;
+    }
+  gdcm::Reader mmreader;
+  mmreader.SetMemoryMappedFile( filename );
+  if( !mmreader.Read() )
+    {
+    std::cerr << "Failed to read mapped: " << filename << std::endl;
+    return 1;
+    }
+  const gdcm::DataSet &ds1 = reader.GetFile().GetDataSet();
+  const gdcm::DataSet &ds2 = mmreader.GetFile().GetDataSet();
+  if( ds1.Size() != ds2.Size() )
+    {
+    std::cerr << "Size mismatch: " << filename << std::endl;
+    return 1;
+    }
+  gdcm::DataSet::ConstIterator it1 = ds1.Begin();
+  gdcm::DataSet::ConstIterator it2 = ds2.Begin();
+  for( ; it1 != ds1.End(); ++it1, ++it2 )
+    {
+    if( !(*it1 == *it2) )
+      {
+      std::cerr << "Element mismatch: " << it1->GetTag() << " in " << filename << std::endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+static int TestReadMemoryMappedFileRoundTrip(const char *subdir)
+{
+  std::string tmpdir = gdcm::Testing::GetTempDirectory( subdir );
+  if( !gdcm::System::FileIsDirectory( tmpdir.c_str() ) )
+    {
+    gdcm::System::MakeDirectory( tmpdir.c_str() );
+    }
+  std::string outfilename = gdcm::Testing::GetTempFilename( "mmap.dcm", subdir );
+
+  gdcm::Writer w;
+  gdcm::File &file = w.GetFile();
+  gdcm::DataSet &ds = file.GetDataSet();
+  const char sopclass[] = "1.2.840.10008.5.1.4.1.1.7";
+  const char sopinstance[] = "1.2.3.4.5.6.7.8.9.0";
+  gdcm::DataElement de;
+  de.SetTag( gdcm::Tag(0x0008,0x0016) );
+  de.SetVR( gdcm::VR::UI );
+  de.SetByteValue( sopclass, (uint32_t)strlen(sopclass) );
+  ds.Insert( de );
+  de.SetTag( gdcm::Tag(0x0008,0x0018) );
+  de.SetByteValue( sopinstance, (uint32_t)strlen(sopinstance) );
+  ds.Insert( de );
+  std::vector<char> pixels( 512 * 512 * 2 );
+  for( size_t i = 0; i < pixels.size(); ++i ) pixels[i] = (char)(i % 251);
+  gdcm::DataElement pixeldata( gdcm::Tag(0x7fe0,0x0010) );
+  pixeldata.SetVR( gdcm::VR::OW );
+  pixeldata.SetByteValue( &pixels[0], (uint32_t)pixels.size() );
+  ds.Insert( pixeldata );
+  file.GetHeader().SetDataSetTransferSyntax( gdcm::TransferSyntax::ExplicitVRLittleEndian );
+  w.SetFileName( outfilename.c_str() );
+  if( !w.Write() )
+    {
+    std::cerr << "Failed to write: " << outfilename << std::endl;
+    return 1;
+    }
+
+  gdcm::Reader reader;
+  reader.SetMemoryMappedFile( outfilename.c_str() );
+  if( !reader.Read() )
+    {
+    std::cerr << "Failed to read mapped: " << outfilename << std::endl;
+    return 1;
+    }
+  const gdcm::DataSet &rds = reader.GetFile().GetDataSet();
+  const gdcm::ByteValue *bv = rds.GetDataElement( pixeldata.GetTag() ).GetByteValue();
+  if( !bv || bv->GetLength() != pixels.size()
+    || memcmp( bv->GetPointer(), &pixels[0], pixels.size() ) != 0 )
+    {
+    std::cerr << "Wrong Pixel Data" << std::endl;
+    return 1;
+    }
+  if( !bv->IsMemoryMapped() )
+    {
+    std::cerr << "Pixel Data was copied" << std::endl;
+    return 1;
+    }
+  // Mutating a mapped value must not change the file:
+  gdcm::ByteValue *mbv = const_cast<gdcm::ByteValue*>(bv);
+  mbv->Fill( 0 );
+  if( mbv->IsMemoryMapped() || mbv->GetPointer()[1] != 0 )
+    {
+    std::cerr << "Fill did not copy the value" << std::endl;
+    return 1;
+    }
+  // The values outlive the reader
+  gdcm::DataElement sop = rds.GetDataElement( gdcm::Tag(0x0008,0x0018) );
+  {
+  gdcm::Reader reader2;
+  reader2.SetMemoryMappedFile( outfilename.c_str() );
+  if( !reader2.Read() ) return 1;
+  sop = reader2.GetFile().GetDataSet().GetDataElement( gdcm::Tag(0x0008,0x0018) );
+  }
+  if( !sop.GetByteValue()->IsMemoryMapped()
+    || memcmp( sop.GetByteValue()->GetPointer(), sopinstance, strlen(sopinstance) ) != 0 )
+    {
+    std::cerr << "Wrong SOP Instance UID" << std::endl;
+    return 1;
+    }
+
+  return TestReadMemoryMappedFile( outfilename.c_str() );
+}
+
+int TestReaderMemoryMappedFile(int argc, char *argv[])
+{
+  if( argc == 2 )
+    {
+    const char *filename = argv[1];
+    return TestReadMemoryMappedFile(filename, true);
+    }
+
+  // else
+  gdcm::Trace::DebugOff();
+  gdcm::Trace::WarningOff();
+  int r = TestReadMemoryMappedFileRoundTrip( argv[0] );
+  int i = 0;
+  const char *filename;
+  const char * const *filenames = gdcm::Testing::GetFileNames();
+  while( (filename = filenames[i]) )
+    {
+    r += TestReadMemoryMappedFile( filename );
+    ++i;
+    }
+
+  return r;
+}
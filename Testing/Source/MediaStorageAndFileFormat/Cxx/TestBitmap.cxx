@@ -0,0 +1,127 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmImageChangeTransferSyntax.h"
+#include "gdcmImage.h"
+#include "gdcmSequenceOfFragments.h"
+
+#include <vector>
+#include <cstring>
+
+static int TestGetFrameBuffer(gdcm::Bitmap const &bitmap,
+  std::vector<char> const &pixels, const char *name)
+{
+  const unsigned int nframes = bitmap.GetDimension(2);
+  const size_t framelen = pixels.size() / nframes;
+  std::vector<char> frame( framelen );
+  for( unsigned int i = 0; i < nframes; ++i )
+    {
+    if( !bitmap.GetFrameBuffer( i, &frame[0] )
+      || memcmp( &frame[0], &pixels[i * framelen], framelen ) != 0 )
+      {
+      std::cerr << "Wrong frame #" << i << " for " << name << std::endl;
+      return 1;
+      }
+    }
+  if( bitmap.GetFrameBuffer( nframes, &frame[0] ) )
+    {
+    std::cerr << "Frame out of range accepted for " << name << std::endl;
+    return 1;
+    }
+  return 0;
+}
+
+static bool Compress(gdcm::Image const &input, gdcm::TransferSyntax::TSType ts,
+  gdcm::Image &output)
+{
+  gdcm::ImageChangeTransferSyntax change;
+  change.SetTransferSyntax( ts );
+  change.SetInput( input );
+  if( !change.Change() ) return false;
+  output = change.GetOutput();
+  return true;
+}
+
+/*
+ * Split each fragment of sf in two, optionally filling the Basic Offset
+ * Table
+ */
+static gdcm::SmartPointer<gdcm::SequenceOfFragments> SplitFragments(
+  gdcm::SequenceOfFragments const &sf, bool offsettable)
+{
+  gdcm::SmartPointer<gdcm::SequenceOfFragments> split = new gdcm::SequenceOfFragments;
+  std::vector<char> table;
+  uint32_t offset = 0;
+  for( unsigned int i = 0; i < sf.GetNumberOfFragments(); ++i )
+    {
+    const gdcm::ByteValue *bv = sf.GetFragment(i).GetByteValue();
+    const uint32_t len = bv->GetLength();
+    const uint32_t half = (len / 2) & ~1u;
+    for( int j = 0; j < 4; ++j ) table.push_back( (char)(offset >> (8 * j)) );
+    gdcm::Fragment frag;
+    frag.SetByteValue( bv->GetPointer(), half );
+    split->AddFragment( frag );
+    frag.SetByteValue( bv->GetPointer() + half, len - half );
+    split->AddFragment( frag );
+    offset += 8 + half + 8 + (len - half);
+    }
+  if( offsettable )
+    split->GetTable().SetByteValue( &table[0], (uint32_t)table.size() );
+  return split;
+}
+
+int TestBitmap(int , char *[])
+{
+  const unsigned int dims[3] = { 64, 48, 5 };
+  std::vector<char> pixels( dims[0] * dims[1] * dims[2] * 2 );
+  uint16_t *p = (uint16_t*)&pixels[0];
+  for( unsigned int z = 0; z < dims[2]; ++z )
+    for( unsigned int y = 0; y < dims[1]; ++y )
+      for( unsigned int x = 0; x < dims[0]; ++x )
+        *p++ = (uint16_t)((x * y + 97 * z) % 4096);
+
+  gdcm::SmartPointer<gdcm::Image> image = new gdcm::Image;
+  image->SetNumberOfDimensions( 3 );
+  image->SetDimensions( dims );
+  image->SetPixelFormat( gdcm::PixelFormat::UINT16 );
+  image->SetPhotometricInterpretation( gdcm::PhotometricInterpretation::MONOCHROME2 );
+  image->SetTransferSyntax( gdcm::TransferSyntax::ExplicitVRLittleEndian );
+  gdcm::DataElement pixeldata( gdcm::Tag(0x7fe0,0x0010) );
+  pixeldata.SetByteValue( &pixels[0], (uint32_t)pixels.size() );
+  image->SetDataElement( pixeldata );
+
+  int r = 0;
+  r += TestGetFrameBuffer( *image, pixels, "raw" );
+
+  gdcm::Image rle;
+  if( !Compress( *image, gdcm::TransferSyntax::RLELossless, rle ) ) return 1;
+  r += TestGetFrameBuffer( rle, pixels, "RLE" );
+
+  gdcm::Image j2k;
+  if( !Compress( *image, gdcm::TransferSyntax::JPEG2000Lossless, j2k ) ) return 1;
+  r += TestGetFrameBuffer( j2k, pixels, "JPEG 2000" );
+
+  // Several fragments per frame, located with the Basic Offset Table or by
+  // scanning for the start of each codestream:
+  const gdcm::SequenceOfFragments *sf = j2k.GetDataElement().GetSequenceOfFragments();
+  if( !sf ) return 1;
+  gdcm::DataElement split = j2k.GetDataElement();
+  split.SetValue( *SplitFragments( *sf, true ) );
+  j2k.SetDataElement( split );
+  r += TestGetFrameBuffer( j2k, pixels, "JPEG 2000 with offset table" );
+  split.SetValue( *SplitFragments( *sf, false ) );
+  j2k.SetDataElement( split );
+  r += TestGetFrameBuffer( j2k, pixels, "JPEG 2000 without offset table" );
+
+  return r;
+}
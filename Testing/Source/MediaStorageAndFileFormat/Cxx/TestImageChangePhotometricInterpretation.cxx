@@ -17,6 +17,9 @@
 #include "gdcmTesting.h"
 #include "gdcmSystem.h"
 
+#include <vector>
+#include <cstdlib>
+
 namespace gdcm
 {
 PhotometricInterpretation InvertPI(PhotometricInterpretation pi)
@@ -91,6 +94,122 @@ int TestImageChangePhotometricInterpretationFunc(const char *filename, bool verb
   return 0;
 }
 
+static gdcm::SmartPointer<gdcm::Image> CreateColorImage(const unsigned int dims[3],
+  gdcm::PhotometricInterpretation::PIType pi, unsigned int planarconf,
+  std::vector<char> const &pixels)
+{
+  gdcm::SmartPointer<gdcm::Image> image = new gdcm::Image;
+  image->SetNumberOfDimensions( 3 );
+  image->SetDimensions( dims );
+  gdcm::PixelFormat pf = gdcm::PixelFormat::UINT8;
+  pf.SetSamplesPerPixel( 3 );
+  image->SetPixelFormat( pf );
+  image->SetPhotometricInterpretation( pi );
+  image->SetPlanarConfiguration( planarconf );
+  image->SetTransferSyntax( gdcm::TransferSyntax::ExplicitVRLittleEndian );
+  gdcm::DataElement pixeldata( gdcm::Tag(0x7fe0,0x0010) );
+  pixeldata.SetByteValue( &pixels[0], (uint32_t)pixels.size() );
+  image->SetDataElement( pixeldata );
+  return image;
+}
+
+static bool ChangeColorSpace(gdcm::Image const &image,
+  gdcm::PhotometricInterpretation::PIType pi, std::vector<char> &pixels)
+{
+  gdcm::ImageChangePhotometricInterpretation filter;
+  filter.SetInput( image );
+  filter.SetPhotometricInterpretation( pi );
+  if( !filter.Change() ) return false;
+  const gdcm::Image &output = filter.GetOutput();
+  if( output.GetPhotometricInterpretation() != pi
+    || output.GetPlanarConfiguration() != 0 ) return false;
+  pixels.resize( output.GetBufferLength() );
+  return output.GetBuffer( &pixels[0] );
+}
+
+// RGB -> YBR_FULL -> RGB round trip on 8 bits pixels (interleaved or planar)
+static int TestRGBRoundTrip(unsigned int planarconf)
+{
+  const unsigned int dims[3] = { 18, 5, 2 };
+  const size_t npixels = dims[0] * dims[1] * dims[2];
+  std::vector<char> rgb( 3 * npixels );
+  for( size_t i = 0; i < rgb.size(); ++i )
+    {
+    rgb[i] = (char)((i * 37 + i / 11) % 251);
+    }
+  // The output is always interleaved
+  std::vector<char> expected( rgb );
+  if( planarconf )
+    {
+    const size_t framelen = dims[0] * dims[1];
+    for( size_t f = 0; f < dims[2]; ++f )
+      for( size_t i = 0; i < framelen; ++i )
+        for( size_t c = 0; c < 3; ++c )
+          expected[3 * (f * framelen + i) + c] = rgb[3 * f * framelen + c * framelen + i];
+    }
+
+  std::vector<char> ybr, rgb2;
+  gdcm::SmartPointer<gdcm::Image> image =
+    CreateColorImage( dims, gdcm::PhotometricInterpretation::RGB, planarconf, rgb );
+  if( !ChangeColorSpace( *image, gdcm::PhotometricInterpretation::YBR_FULL, ybr ) )
+    {
+    std::cerr << "Could not convert RGB into YBR_FULL" << std::endl;
+    return 1;
+    }
+  image = CreateColorImage( dims, gdcm::PhotometricInterpretation::YBR_FULL, 0, ybr );
+  if( !ChangeColorSpace( *image, gdcm::PhotometricInterpretation::RGB, rgb2 )
+    || rgb2.size() != expected.size() )
+    {
+    std::cerr << "Could not convert YBR_FULL into RGB" << std::endl;
+    return 1;
+    }
+  for( size_t i = 0; i < expected.size(); ++i )
+    {
+    if( abs( (unsigned char)rgb2[i] - (unsigned char)expected[i] ) > 3 )
+      {
+      std::cerr << "Wrong RGB round trip at " << i << ": " << (int)(unsigned char)rgb2[i]
+        << " instead of " << (int)(unsigned char)expected[i] << std::endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+// Uncompressed YBR_FULL_422 stores the chroma of two pixels once
+// (Y1,Y2,CB,CR), grey pixels are converted to their Y value
+static int TestYBR422ToRGB()
+{
+  const unsigned int dims[3] = { 18, 5, 1 };
+  const size_t npixels = dims[0] * dims[1];
+  std::vector<char> ybr422( 2 * npixels );
+  for( size_t i = 0; i < npixels / 2; ++i )
+    {
+    ybr422[4 * i] = (char)(i * 5);
+    ybr422[4 * i + 1] = (char)(255 - i);
+    ybr422[4 * i + 2] = (char)128;
+    ybr422[4 * i + 3] = (char)128;
+    }
+  gdcm::SmartPointer<gdcm::Image> image =
+    CreateColorImage( dims, gdcm::PhotometricInterpretation::YBR_FULL_422, 0, ybr422 );
+  std::vector<char> rgb;
+  if( !ChangeColorSpace( *image, gdcm::PhotometricInterpretation::RGB, rgb )
+    || rgb.size() != 3 * npixels )
+    {
+    std::cerr << "Could not convert YBR_FULL_422 into RGB" << std::endl;
+    return 1;
+    }
+  for( size_t i = 0; i < npixels; ++i )
+    {
+    const char y = ybr422[4 * (i / 2) + i % 2];
+    if( rgb[3 * i] != y || rgb[3 * i + 1] != y || rgb[3 * i + 2] != y )
+      {
+      std::cerr << "Wrong YBR_FULL_422 pixel " << i << std::endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
 int TestImageChangePhotometricInterpretation(int argc, char *argv[])
 {
   if( argc == 2 )
@@ -103,6 +222,9 @@ int TestImageChangePhotometricInterpretation(int argc, char *argv[])
   gdcm::Trace::DebugOff();
   gdcm::Trace::WarningOff();
   int r = 0, i = 0;
+  r += TestRGBRoundTrip( 0 );
+  r += TestRGBRoundTrip( 1 );
+  r += TestYBR422ToRGB();
   const char *filename;
   const char * const *filenames = gdcm::Testing::GetFileNames();
   while( (filename = filenames[i]) )
@@ -0,0 +1,90 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmImageChangeTransferSyntax.h"
+#include "gdcmImage.h"
+#include "gdcmSequenceOfFragments.h"
+
+#include <vector>
+#include <cstring>
+
+/*
+ * Check a multi-frame JPEG 2000 encoding on several threads gives the same
+ * fragments, in the same order, as a single threaded one
+ */
+static bool Compress(gdcm::Image const &input, unsigned int nthreads,
+  gdcm::Image &output)
+{
+  gdcm::ImageChangeTransferSyntax change;
+  change.SetTransferSyntax( gdcm::TransferSyntax::JPEG2000Lossless );
+  change.SetNumberOfThreads( nthreads );
+  change.SetInput( input );
+  if( !change.Change() ) return false;
+  output = change.GetOutput();
+  return true;
+}
+
+int TestImageChangeTransferSyntax8(int , char *[])
+{
+  const unsigned int dims[3] = { 64, 48, 12 };
+  std::vector<char> pixels( dims[0] * dims[1] * dims[2] * 2 );
+  uint16_t *p = (uint16_t*)&pixels[0];
+  for( unsigned int z = 0; z < dims[2]; ++z )
+    for( unsigned int y = 0; y < dims[1]; ++y )
+      for( unsigned int x = 0; x < dims[0]; ++x )
+        *p++ = (uint16_t)((x * y + 97 * z) % 4096);
+
+  gdcm::SmartPointer<gdcm::Image> image = new gdcm::Image;
+  image->SetNumberOfDimensions( 3 );
+  image->SetDimensions( dims );
+  image->SetPixelFormat( gdcm::PixelFormat::UINT16 );
+  image->SetPhotometricInterpretation( gdcm::PhotometricInterpretation::MONOCHROME2 );
+  image->SetTransferSyntax( gdcm::TransferSyntax::ExplicitVRLittleEndian );
+  gdcm::DataElement pixeldata( gdcm::Tag(0x7fe0,0x0010) );
+  pixeldata.SetByteValue( &pixels[0], (uint32_t)pixels.size() );
+  image->SetDataElement( pixeldata );
+
+  gdcm::Image j2k1, j2k4;
+  if( !Compress( *image, 1, j2k1 ) || !Compress( *image, 4, j2k4 ) )
+    {
+    std::cerr << "Could not compress" << std::endl;
+    return 1;
+    }
+  const gdcm::SequenceOfFragments *sf1 = j2k1.GetDataElement().GetSequenceOfFragments();
+  const gdcm::SequenceOfFragments *sf4 = j2k4.GetDataElement().GetSequenceOfFragments();
+  if( !sf1 || !sf4 || sf1->GetNumberOfFragments() != dims[2]
+    || sf4->GetNumberOfFragments() != dims[2] )
+    {
+    std::cerr << "Wrong number of fragments" << std::endl;
+    return 1;
+    }
+  for( unsigned int i = 0; i < dims[2]; ++i )
+    {
+    if( !(sf1->GetFragment(i) == sf4->GetFragment(i)) )
+      {
+      std::cerr << "Fragment " << i << " differ" << std::endl;
+      return 1;
+      }
+    }
+
+  // Lossless:
+  std::vector<char> decoded( pixels.size() );
+  if( !j2k4.GetBuffer( &decoded[0] )
+    || memcmp( &decoded[0], &pixels[0], pixels.size() ) != 0 )
+    {
+    std::cerr << "Decoded image differ" << std::endl;
+    return 1;
+    }
+
+  return 0;
+}
@@ -0,0 +1,115 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmImageChangeTransferSyntax.h"
+#include "gdcmImage.h"
+#include "gdcmSequenceOfFragments.h"
+
+#include <vector>
+#include <cstring>
+
+/*
+ * Check a multi-frame encapsulated image decoded on several threads
+ * (Bitmap::SetNumberOfThreads) gives the same buffer as a single threaded
+ * decode, for each codec
+ */
+static int TestFrameParallelDecode(gdcm::Image const &input,
+  gdcm::TransferSyntax::TSType tstype, std::vector<char> const &pixels)
+{
+  const gdcm::TransferSyntax ts = tstype;
+  gdcm::ImageChangeTransferSyntax change;
+  change.SetTransferSyntax( ts );
+  change.SetInput( input );
+  if( !change.Change() )
+    {
+    std::cerr << "Could not compress to " << ts << std::endl;
+    return 1;
+    }
+  gdcm::Image compressed = change.GetOutput();
+  const gdcm::SequenceOfFragments *sf = compressed.GetDataElement().GetSequenceOfFragments();
+  if( !sf || sf->GetNumberOfFragments() != input.GetDimension(2) )
+    {
+    std::cerr << "Wrong number of fragments for " << ts << std::endl;
+    return 1;
+    }
+
+  std::vector<char> decoded1( pixels.size() ), decoded4( pixels.size() );
+  compressed.SetNumberOfThreads( 1 );
+  if( !compressed.GetBuffer( &decoded1[0] ) )
+    {
+    std::cerr << "Could not decode " << ts << std::endl;
+    return 1;
+    }
+  compressed.SetNumberOfThreads( 4 );
+  if( !compressed.GetBuffer( &decoded4[0] ) )
+    {
+    std::cerr << "Could not decode " << ts << " on 4 threads" << std::endl;
+    return 1;
+    }
+  if( decoded1 != decoded4 || decoded1 != pixels )
+    {
+    std::cerr << "Decoded image differ for " << ts << std::endl;
+    return 1;
+    }
+
+  // Decompression through the filter:
+  gdcm::SmartPointer<gdcm::Image> copy = new gdcm::Image( compressed );
+  gdcm::ImageChangeTransferSyntax raw;
+  raw.SetTransferSyntax( gdcm::TransferSyntax::ExplicitVRLittleEndian );
+  raw.SetInput( *copy );
+  if( !raw.Change() )
+    {
+    std::cerr << "Could not decompress " << ts << std::endl;
+    return 1;
+    }
+  const gdcm::ByteValue *bv = raw.GetOutput().GetDataElement().GetByteValue();
+  if( !bv || bv->GetLength() < pixels.size()
+    || memcmp( bv->GetPointer(), &pixels[0], pixels.size() ) != 0 )
+    {
+    std::cerr << "Decompressed image differ for " << ts << std::endl;
+    return 1;
+    }
+
+  return 0;
+}
+
+int TestImageChangeTransferSyntax9(int , char *[])
+{
+  const unsigned int dims[3] = { 64, 48, 7 };
+  std::vector<char> pixels( dims[0] * dims[1] * dims[2] * 2 );
+  uint16_t *p = (uint16_t*)&pixels[0];
+  for( unsigned int z = 0; z < dims[2]; ++z )
+    for( unsigned int y = 0; y < dims[1]; ++y )
+      for( unsigned int x = 0; x < dims[0]; ++x )
+        *p++ = (uint16_t)((x * y + 97 * z) % 4096);
+
+  gdcm::SmartPointer<gdcm::Image> image = new gdcm::Image;
+  image->SetNumberOfDimensions( 3 );
+  image->SetDimensions( dims );
+  gdcm::PixelFormat pf = gdcm::PixelFormat::UINT16;
+  pf.SetBitsStored( 12 );
+  image->SetPixelFormat( pf );
+  image->SetPhotometricInterpretation( gdcm::PhotometricInterpretation::MONOCHROME2 );
+  image->SetTransferSyntax( gdcm::TransferSyntax::ExplicitVRLittleEndian );
+  gdcm::DataElement pixeldata( gdcm::Tag(0x7fe0,0x0010) );
+  pixeldata.SetByteValue( &pixels[0], (uint32_t)pixels.size() );
+  image->SetDataElement( pixeldata );
+
+  int r = 0;
+  r += TestFrameParallelDecode( *image, gdcm::TransferSyntax::JPEGLosslessProcess14_1, pixels );
+  r += TestFrameParallelDecode( *image, gdcm::TransferSyntax::JPEG2000Lossless, pixels );
+  r += TestFrameParallelDecode( *image, gdcm::TransferSyntax::JPEGLSLossless, pixels );
+  r += TestFrameParallelDecode( *image, gdcm::TransferSyntax::RLELossless, pixels );
+
+  return r;
+}
@@ -12,8 +12,66 @@
 
 =========================================================================*/
 #include "gdcmJPEGCodec.h"
+#include "gdcmDataElement.h"
+#include "gdcmSequenceOfFragments.h"
+#include "gdcmTransferSyntax.h"
 
-int TestJPEGCodec(int, char *[])
+#include <vector>
+
+// Encode a small image, then only read back the header of the first fragment
+static int TestGetHeaderInfo(bool lossless)
 {
+  const unsigned int dims[3] = { 16, 8, 1 };
+  std::vector<char> image( dims[0] * dims[1] );
+  for( size_t i = 0; i < image.size(); ++i )
+    {
+    image[i] = (char)(i * 3);
+    }
+  gdcm::DataElement raw( gdcm::Tag(0x7fe0,0x0010) );
+  raw.SetByteValue( &image[0], (uint32_t)image.size() );
+
+  gdcm::JPEGCodec encoder;
+  encoder.SetNumberOfDimensions( 2 );
+  encoder.SetDimensions( dims );
+  encoder.SetPhotometricInterpretation( gdcm::PhotometricInterpretation::MONOCHROME2 );
+  // last: forwards the above to the 8 bits implementation
+  encoder.SetPixelFormat( gdcm::PixelFormat::UINT8 );
+  encoder.SetLossless( lossless );
+  gdcm::DataElement jpeg;
+  if( !encoder.Code( raw, jpeg ) || !jpeg.GetSequenceOfFragments() )
+    {
+    std::cerr << "Could not encode" << std::endl;
+    return 1;
+    }
+  const gdcm::ByteValue *bv =
+    jpeg.GetSequenceOfFragments()->GetFragment(0).GetByteValue();
+
+  gdcm::JPEGCodec codec;
+  codec.SetPixelFormat( gdcm::PixelFormat::UINT8 );
+  gdcm::TransferSyntax ts;
+  if( !codec.GetHeaderInfo( bv->GetPointer(), bv->GetLength(), ts ) )
+    {
+    std::cerr << "Could not read the JPEG header" << std::endl;
+    return 1;
+    }
+  const gdcm::TransferSyntax expected = lossless
+    ? gdcm::TransferSyntax::JPEGLosslessProcess14_1
+    : gdcm::TransferSyntax::JPEGBaselineProcess1;
+  if( codec.IsLossy() == lossless || ts != expected
+    || codec.GetDimensions()[0] != dims[0] || codec.GetDimensions()[1] != dims[1]
+    || codec.GetPixelFormat().GetBitsStored() != 8 )
+    {
+    std::cerr << "Wrong JPEG header info: " << ts << " " << codec.GetPixelFormat()
+      << std::endl;
+    return 1;
+    }
   return 0;
 }
+
+int TestJPEGCodec(int, char *[])
+{
+  int res = 0;
+  res += TestGetHeaderInfo( true );
+  res += TestGetHeaderInfo( false );
+  return res;
+}
@@ -0,0 +1,119 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmJPEGLSCodec.h"
+#include "gdcmDataElement.h"
+#include "gdcmSequenceOfFragments.h"
+#include "gdcmTransferSyntax.h"
+
+#include <vector>
+#include <cstring>
+
+static void SetupCodec(gdcm::JPEGLSCodec &codec, gdcm::PixelFormat const &pf,
+  gdcm::PhotometricInterpretation::PIType pi, const unsigned int dims[3])
+{
+  codec.SetNumberOfDimensions( dims[2] > 1 ? 3 : 2 );
+  codec.SetDimensions( dims );
+  codec.SetPixelFormat( pf );
+  codec.SetPhotometricInterpretation( pi );
+}
+
+// Encode then decode an image, both into a DataElement and straight into a
+// user buffer
+static int TestRoundTrip(gdcm::PixelFormat const &pf,
+  gdcm::PhotometricInterpretation::PIType pi, unsigned int nframes,
+  int lossyerror)
+{
+  const unsigned int dims[3] = { 17, 6, nframes };
+  std::vector<char> image( dims[0] * dims[1] * dims[2] * pf.GetPixelSize() );
+  for( size_t i = 0; i < image.size(); ++i )
+    {
+    // keep the 16 bits samples within 15 bits
+    image[i] = (char)( (i % 2 && pf.GetBitsAllocated() == 16) ? i % 0x7f : i * 7 );
+    }
+  gdcm::DataElement raw( gdcm::Tag(0x7fe0,0x0010) );
+  raw.SetByteValue( &image[0], (uint32_t)image.size() );
+
+  gdcm::JPEGLSCodec encoder;
+  SetupCodec( encoder, pf, pi, dims );
+  if( lossyerror )
+    {
+    encoder.SetLossless( false );
+    encoder.SetLossyError( lossyerror );
+    }
+  gdcm::DataElement jpegls;
+  if( !encoder.Code( raw, jpegls ) || !jpegls.GetSequenceOfFragments() )
+    {
+    std::cerr << "Could not encode: " << pf << std::endl;
+    return 1;
+    }
+
+  gdcm::JPEGLSCodec decoder;
+  SetupCodec( decoder, pf, pi, dims );
+  gdcm::DataElement out;
+  const gdcm::ByteValue *bv = 0;
+  if( decoder.Decode( jpegls, out ) ) bv = out.GetByteValue();
+  if( !bv || bv->GetLength() < image.size() || decoder.IsLossy() != (lossyerror != 0) )
+    {
+    std::cerr << "Could not decode: " << pf << std::endl;
+    return 1;
+    }
+  const char *decoded = bv->GetPointer();
+  if( !lossyerror && memcmp( decoded, &image[0], image.size() ) != 0 )
+    {
+    std::cerr << "Wrong decoded pixels: " << pf << std::endl;
+    return 1;
+    }
+
+  std::vector<char> buffer( image.size() );
+  gdcm::JPEGLSCodec bufferdecoder;
+  SetupCodec( bufferdecoder, pf, pi, dims );
+  if( !bufferdecoder.Decode( jpegls, &buffer[0], buffer.size() )
+    || memcmp( decoded, &buffer[0], buffer.size() ) != 0
+    || bufferdecoder.IsLossy() != (lossyerror != 0) )
+    {
+    std::cerr << "Wrong pixels decoded into the buffer: " << pf << std::endl;
+    return 1;
+    }
+  // The buffer must have the exact size of the frames
+  if( bufferdecoder.Decode( jpegls, &buffer[0], buffer.size() - dims[2] ) )
+    {
+    std::cerr << "Decoded into a too small buffer: " << pf << std::endl;
+    return 1;
+    }
+  return 0;
+}
+
+int TestJPEGLSCodec(int, char *[])
+{
+  gdcm::JPEGLSCodec codec;
+  if( !codec.CanDecode( gdcm::TransferSyntax::JPEGLSLossless ) )
+    {
+    // built without JPEG-LS support
+    return 0;
+    }
+  gdcm::PixelFormat rgb8 = gdcm::PixelFormat::UINT8;
+  rgb8.SetSamplesPerPixel( 3 );
+  const gdcm::PhotometricInterpretation::PIType mono =
+    gdcm::PhotometricInterpretation::MONOCHROME2;
+  const gdcm::PhotometricInterpretation::PIType rgb =
+    gdcm::PhotometricInterpretation::RGB;
+
+  int res = 0;
+  res += TestRoundTrip( gdcm::PixelFormat::UINT8, mono, 1, 0 );
+  res += TestRoundTrip( gdcm::PixelFormat::UINT16, mono, 1, 0 );
+  res += TestRoundTrip( gdcm::PixelFormat::UINT16, mono, 3, 0 );
+  res += TestRoundTrip( rgb8, rgb, 2, 0 );
+  res += TestRoundTrip( gdcm::PixelFormat::UINT8, mono, 2, 2 );
+  return res;
+}
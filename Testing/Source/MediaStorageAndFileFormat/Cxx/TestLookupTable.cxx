@@ -13,8 +13,121 @@
 =========================================================================*/
 #include "gdcmLookupTable.h"
 
-int TestLookupTable(int, char *[])
+#include <sstream>
+#include <vector>
+#include <cstring>
+
+// Compare the buffer and the stream Decode with the expected RGB values
+static int TestDecode(const gdcm::LookupTable &lut, const std::vector<char> &input,
+  const std::vector<char> &expected)
+{
+  std::vector<char> output( 3 * input.size() + 1, 'x' );
+  if( !lut.Decode( &output[0], output.size(), input.empty() ? 0 : &input[0], input.size() ) )
+    {
+    std::cerr << "Decode failed" << std::endl;
+    return 1;
+    }
+  if( output.back() != 'x'
+    || (!expected.empty() && memcmp( &output[0], &expected[0], expected.size() ) != 0) )
+    {
+    std::cerr << "Wrong buffer Decode for " << input.size() << " bytes" << std::endl;
+    return 1;
+    }
+
+  std::stringstream is;
+  is.write( input.empty() ? 0 : &input[0], (std::streamsize)input.size() );
+  std::ostringstream os;
+  lut.Decode( is, os );
+  if( os.str() != std::string( expected.begin(), expected.end() ) )
+    {
+    std::cerr << "Wrong stream Decode for " << input.size() << " bytes" << std::endl;
+    return 1;
+    }
+  return 0;
+}
+
+static int TestLookupTable8()
+{
+  gdcm::LookupTable lut;
+  lut.Allocate( 8 );
+  unsigned char red[256], green[256], blue[256];
+  for( int i = 0; i < 256; ++i )
+    {
+    red[i] = (unsigned char)i;
+    green[i] = (unsigned char)(255 - i);
+    blue[i] = (unsigned char)(i * 7);
+    }
+  lut.InitializeRedLUT( 256, 0, 8 );
+  lut.InitializeGreenLUT( 256, 0, 8 );
+  lut.InitializeBlueLUT( 256, 0, 8 );
+  lut.SetRedLUT( red, 256 );
+  lut.SetGreenLUT( green, 256 );
+  lut.SetBlueLUT( blue, 256 );
+
+  // Odd sizes: exercise the vectorized loop and its tail
+  const size_t sizes[] = { 0, 1, 2, 9, 10, 11, 17, 1001, 70000 };
+  for( size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); ++s )
+    {
+    std::vector<char> input( sizes[s] );
+    std::vector<char> expected;
+    for( size_t i = 0; i < input.size(); ++i )
+      {
+      const unsigned char idx = (unsigned char)(i * 31 + i / 7);
+      input[i] = (char)idx;
+      expected.push_back( (char)red[idx] );
+      expected.push_back( (char)green[idx] );
+      expected.push_back( (char)blue[idx] );
+      }
+    if( TestDecode( lut, input, expected ) ) return 1;
+    }
+  return 0;
+}
+
+static int TestLookupTable16()
 {
   gdcm::LookupTable lut;
+  lut.Allocate( 16 );
+  std::vector<uint16_t> red( 65536 ), green( 65536 ), blue( 65536 );
+  for( size_t i = 0; i < 65536; ++i )
+    {
+    red[i] = (uint16_t)i;
+    green[i] = (uint16_t)(65535 - i);
+    blue[i] = (uint16_t)(i * 3);
+    }
+  // A length of 0 means 65536 entries
+  lut.InitializeRedLUT( 0, 0, 16 );
+  lut.InitializeGreenLUT( 0, 0, 16 );
+  lut.InitializeBlueLUT( 0, 0, 16 );
+  lut.SetRedLUT( (unsigned char*)&red[0], 65536 * 2 );
+  lut.SetGreenLUT( (unsigned char*)&green[0], 65536 * 2 );
+  lut.SetBlueLUT( (unsigned char*)&blue[0], 65536 * 2 );
+
+  const size_t sizes[] = { 0, 1, 3, 777, 40000 };
+  for( size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); ++s )
+    {
+    std::vector<uint16_t> indexes( sizes[s] );
+    std::vector<uint16_t> rgb;
+    for( size_t i = 0; i < indexes.size(); ++i )
+      {
+      const uint16_t idx = (uint16_t)(i * 7919);
+      indexes[i] = idx;
+      rgb.push_back( red[idx] );
+      rgb.push_back( green[idx] );
+      rgb.push_back( blue[idx] );
+      }
+    std::vector<char> input( indexes.size() * 2 );
+    if( !input.empty() ) memcpy( &input[0], &indexes[0], input.size() );
+    std::vector<char> expected( rgb.size() * 2 );
+    if( !expected.empty() ) memcpy( &expected[0], &rgb[0], expected.size() );
+    if( TestDecode( lut, input, expected ) ) return 1;
+    }
   return 0;
 }
+
+int TestLookupTable(int, char *[])
+{
+  int res = 0;
+  res += TestLookupTable8();
+  res += TestLookupTable16();
+  return res;
+}
@@ -12,11 +12,184 @@
 
 =========================================================================*/
 #include "gdcmRAWCodec.h"
+#include "gdcmDataElement.h"
+#include "gdcmByteValue.h"
+#include "gdcmUnpacker12Bits.h"
+
+#include <vector>
+#include <cstring>
+
+/*
+ * Compare the post-processing of RAWCodec (byte swap, overlay cleanup) with
+ * a pixel by pixel reference
+ */
+static uint16_t Reference(uint16_t c, gdcm::PixelFormat const &pf,
+  bool byteswap, bool cleanup)
+{
+  if( byteswap ) c = (uint16_t)((c >> 8) | (c << 8));
+  if( !cleanup ) return c;
+  const unsigned int bs = pf.GetBitsStored();
+  c = (uint16_t)(c >> (bs - pf.GetHighBit() - 1));
+  c = (uint16_t)(c & ((1u << bs) - 1));
+  if( pf.GetPixelRepresentation() && (c & (1u << (bs - 1))) )
+    c = (uint16_t)(c | (0xffff << bs));
+  return c;
+}
+
+static int TestPostProcessing(gdcm::PixelFormat const &pf, bool byteswap,
+  bool cleanup)
+{
+  const unsigned int dims[3] = { 17, 5, 1 };
+  std::vector<uint16_t> input( dims[0] * dims[1] );
+  for( size_t i = 0; i < input.size(); ++i )
+    input[i] = (uint16_t)(i * 2731 + 0x8001);
+
+  gdcm::RAWCodec codec;
+  codec.SetNumberOfDimensions( 2 );
+  codec.SetDimensions( dims );
+  codec.SetPixelFormat( pf );
+  codec.SetPhotometricInterpretation( gdcm::PhotometricInterpretation::MONOCHROME2 );
+  codec.SetNeedByteSwap( byteswap );
+  codec.SetNeedOverlayCleanup( cleanup );
+
+  const size_t len = input.size() * 2;
+  gdcm::DataElement in( gdcm::Tag(0x7fe0,0x0010) );
+  in.SetByteValue( (const char*)&input[0], (uint32_t)len );
+  gdcm::DataElement out;
+  std::vector<uint16_t> decoded( input.size() );
+  if( !codec.Decode( in, out ) || !out.GetByteValue()
+    || out.GetByteValue()->GetLength() != len
+    || !codec.DecodeBytes( (const char*)&input[0], len, (char*)&decoded[0], len ) )
+    {
+    std::cerr << "Could not decode" << std::endl;
+    return 1;
+    }
+  const uint16_t *outp = (const uint16_t*)out.GetByteValue()->GetPointer();
+  for( size_t i = 0; i < input.size(); ++i )
+    {
+    const uint16_t ref = Reference( input[i], pf, byteswap, cleanup );
+    if( outp[i] != ref || decoded[i] != ref )
+      {
+      std::cerr << "Wrong pixel #" << i << " " << outp[i] << " / "
+        << decoded[i] << " should be " << ref << std::endl;
+      return 1;
+      }
+    }
+  // The input must be left untouched:
+  if( input[1] != (uint16_t)(2731 + 0x8001) ) return 1;
+  return 0;
+}
+
+// Packed 12 bits pixels are unpacked into 16 bits allocated, an odd number of
+// packed bytes is padded
+static int TestUnpack12Bits()
+{
+  const unsigned int dims[3] = { 18, 5, 1 };
+  const size_t npixels = dims[0] * dims[1];
+  std::vector<uint16_t> pixels( npixels );
+  for( size_t i = 0; i < npixels; ++i )
+    pixels[i] = (uint16_t)((i * 2731) % 4096);
+  std::vector<char> packed( npixels / 2 * 3 );
+  gdcm::Unpacker12Bits::Pack( &packed[0], (const char*)&pixels[0], npixels * 2 );
+
+  gdcm::RAWCodec codec;
+  codec.SetNumberOfDimensions( 2 );
+  codec.SetDimensions( dims );
+  codec.SetPhotometricInterpretation( gdcm::PhotometricInterpretation::MONOCHROME2 );
+  codec.SetPixelFormat( gdcm::PixelFormat::UINT12 );
+  gdcm::DataElement in( gdcm::Tag(0x7fe0,0x0010) );
+  in.SetByteValue( &packed[0], (uint32_t)packed.size() );
+  gdcm::DataElement out;
+  if( !codec.Decode( in, out ) || !out.GetByteValue()
+    || out.GetByteValue()->GetLength() != npixels * 2
+    || memcmp( out.GetByteValue()->GetPointer(), &pixels[0], npixels * 2 ) != 0
+    || codec.GetPixelFormat().GetBitsAllocated() != 16 )
+    {
+    std::cerr << "Could not unpack 12 bits pixels" << std::endl;
+    return 1;
+    }
+
+  const gdcm::ByteValue *bv = in.GetByteValue();
+  std::vector<uint16_t> decoded( npixels );
+  codec.SetPixelFormat( gdcm::PixelFormat::UINT12 );
+  if( !codec.DecodeBytes( bv->GetPointer(), bv->GetLength(),
+      (char*)&decoded[0], npixels * 2 ) || decoded != pixels )
+    {
+    std::cerr << "Could not unpack 12 bits pixels into the buffer" << std::endl;
+    return 1;
+    }
+  return 0;
+}
+
+// 8 bits YBR_FULL_422 pixels with a subsampled chroma (Y1,Y2,CB,CR) are
+// upsampled into 3 samples per pixel
+static int TestUpsampleYBR422()
+{
+  const unsigned int dims[3] = { 6, 3, 2 };
+  const size_t npixels = dims[0] * dims[1] * dims[2];
+  std::vector<char> subsampled( 2 * npixels ), expected;
+  for( size_t i = 0; i < subsampled.size(); ++i )
+    subsampled[i] = (char)(i * 7 + 1);
+  for( size_t i = 0; i < npixels; ++i )
+    {
+    const char *pair = &subsampled[4 * (i / 2)];
+    expected.push_back( pair[i % 2] );
+    expected.push_back( pair[2] );
+    expected.push_back( pair[3] );
+    }
+
+  gdcm::RAWCodec codec;
+  codec.SetNumberOfDimensions( 3 );
+  codec.SetDimensions( dims );
+  codec.SetPhotometricInterpretation( gdcm::PhotometricInterpretation::YBR_FULL_422 );
+  gdcm::PixelFormat pf = gdcm::PixelFormat::UINT8;
+  pf.SetSamplesPerPixel( 3 );
+  codec.SetPixelFormat( pf );
+  gdcm::DataElement in( gdcm::Tag(0x7fe0,0x0010) );
+  in.SetByteValue( &subsampled[0], (uint32_t)subsampled.size() );
+  gdcm::DataElement out;
+  if( !codec.Decode( in, out ) || !out.GetByteValue()
+    || out.GetByteValue()->GetLength() != expected.size()
+    || memcmp( out.GetByteValue()->GetPointer(), &expected[0], expected.size() ) != 0 )
+    {
+    std::cerr << "Could not upsample YBR_FULL_422 pixels" << std::endl;
+    return 1;
+    }
+
+  std::vector<char> decoded( expected.size() );
+  if( !codec.DecodeBytes( &subsampled[0], subsampled.size(),
+      &decoded[0], decoded.size() ) || decoded != expected )
+    {
+    std::cerr << "Could not upsample YBR_FULL_422 pixels into the buffer" << std::endl;
+    return 1;
+    }
+  return 0;
+}
 
 int TestRAWCodec(int argc, char *argv[])
 {
   (void)argc;
   (void)argv;
 
-  return 0;
+  gdcm::PixelFormat pf12( gdcm::PixelFormat::UINT16 );
+  pf12.SetBitsStored( 12 );
+  pf12.SetHighBit( 11 );
+  gdcm::PixelFormat spf12( gdcm::PixelFormat::INT16 );
+  spf12.SetBitsStored( 12 );
+  spf12.SetHighBit( 11 );
+  gdcm::PixelFormat spf10( gdcm::PixelFormat::INT16 );
+  spf10.SetBitsStored( 10 );
+  spf10.SetHighBit( 9 );
+
+  int r = 0;
+  r += TestPostProcessing( gdcm::PixelFormat::UINT16, true, false );
+  r += TestPostProcessing( pf12, false, true );
+  r += TestPostProcessing( pf12, true, true );
+  r += TestPostProcessing( spf12, false, true );
+  r += TestPostProcessing( spf12, true, true );
+  r += TestPostProcessing( spf10, true, true );
+  r += TestUnpack12Bits();
+  r += TestUpsampleYBR422();
+
+  return r;
 }
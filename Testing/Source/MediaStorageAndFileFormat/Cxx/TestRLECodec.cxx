@@ -11,11 +11,155 @@
      PURPOSE.  See the above copyright notice for more information.
 
 =========================================================================*/
-#include "gdcmTypes.h"
+#include "gdcmRLECodec.h"
+#include "gdcmDataElement.h"
+#include "gdcmSequenceOfFragments.h"
+#include "gdcmTransferSyntax.h"
 
-int TestRLECodec(int, char *[])
+#include <vector>
+#include <cstring>
+
+static void SetupCodec(gdcm::RLECodec &codec, gdcm::PixelFormat const &pf,
+  gdcm::PhotometricInterpretation::PIType pi, unsigned int planarconf,
+  const unsigned int dims[3])
+{
+  codec.SetNumberOfDimensions( dims[2] > 1 ? 3 : 2 );
+  codec.SetDimensions( dims );
+  codec.SetPixelFormat( pf );
+  codec.SetPhotometricInterpretation( pi );
+  codec.SetPlanarConfiguration( planarconf );
+}
+
+// Encode then decode an image, the decoded pixels should match exactly
+static int TestRoundTrip(gdcm::PixelFormat const &pf,
+  gdcm::PhotometricInterpretation::PIType pi, unsigned int planarconf,
+  unsigned int nframes)
 {
-  // Compress a black images: should give a good result
-  // Compress a checkboard (black/white alternate). Should give a mediocre result
+  const unsigned int dims[3] = { 18, 5, nframes };
+  std::vector<char> image( dims[0] * dims[1] * dims[2] * pf.GetPixelSize() );
+  for( size_t i = 0; i < image.size(); ++i )
+    {
+    // runs and literals
+    image[i] = (char)( (i / 5) % 3 ? i / 7 : i * 13 );
+    }
+  gdcm::DataElement raw( gdcm::Tag(0x7fe0,0x0010) );
+  raw.SetByteValue( &image[0], (uint32_t)image.size() );
+
+  gdcm::RLECodec encoder;
+  SetupCodec( encoder, pf, pi, planarconf, dims );
+  gdcm::DataElement rle;
+  if( !encoder.Code( raw, rle ) || !rle.GetSequenceOfFragments() )
+    {
+    std::cerr << "Could not encode: " << pf << std::endl;
+    return 1;
+    }
+
+  // The encoded frames do not depend on the number of threads
+  gdcm::RLECodec parallelencoder;
+  SetupCodec( parallelencoder, pf, pi, planarconf, dims );
+  parallelencoder.SetNumberOfThreads( 4 );
+  gdcm::DataElement rle4;
+  if( !parallelencoder.Code( raw, rle4 ) || !rle4.GetSequenceOfFragments()
+    || !(*rle4.GetSequenceOfFragments() == *rle.GetSequenceOfFragments()) )
+    {
+    std::cerr << "Multi-threaded encoding differs: " << pf << std::endl;
+    return 1;
+    }
+
+  // The header probe only looks at the RLE Header of the first frame
+  const gdcm::ByteValue *frag0 =
+    rle.GetSequenceOfFragments()->GetFragment(0).GetByteValue();
+  gdcm::RLECodec prober;
+  gdcm::TransferSyntax ts;
+  if( !prober.GetHeaderInfo( frag0->GetPointer(), frag0->GetLength(), ts )
+    || prober.IsLossy() || ts != gdcm::TransferSyntax::RLELossless
+    || prober.GetHeaderInfo( frag0->GetPointer(), 63, ts ) )
+    {
+    std::cerr << "Wrong RLE header info: " << pf << std::endl;
+    return 1;
+    }
+
+  gdcm::RLECodec decoder;
+  SetupCodec( decoder, pf, pi, planarconf, dims );
+  decoder.SetBufferLength( (unsigned long)image.size() );
+  gdcm::DataElement out;
+  if( !decoder.Decode( rle, out ) )
+    {
+    std::cerr << "Could not decode: " << pf << std::endl;
+    return 1;
+    }
+  const gdcm::ByteValue *bv = out.GetByteValue();
+  if( !bv || bv->GetLength() < image.size()
+    || memcmp( bv->GetPointer(), &image[0], image.size() ) != 0 )
+    {
+    std::cerr << "Wrong decoded pixels: " << pf << " PlanarConfiguration: "
+      << planarconf << std::endl;
+    return 1;
+    }
   return 0;
 }
+
+// Hand made RLE frame: gap before the first segment, no-op run, replicate
+// and literal runs, and a last literal run cut by the end of the input
+static int TestDecodeFrame()
+{
+  const unsigned int dims[3] = { 4, 3, 1 };
+  gdcm::RLECodec codec;
+  SetupCodec( codec, gdcm::PixelFormat::UINT8,
+    gdcm::PhotometricInterpretation::MONOCHROME2, 0, dims );
+
+  std::vector<char> frame( 64 + 2 );
+  frame[0] = 1;  // NumSegments
+  frame[4] = 66; // Offset[0]
+  const signed char runs[] = { -128, -2, 7, 2, 1, 2, 3, 5, 9, 8 };
+  frame.insert( frame.end(), runs, runs + sizeof(runs) );
+  const char expected[] = { 7, 7, 7, 1, 2, 3, 9, 8, 0, 0, 0, 0 };
+
+  char out[sizeof(expected)];
+  memset( out, 'x', sizeof(out) );
+  if( !codec.DecodeFrame( &frame[0], frame.size(), out, sizeof(out) )
+    || memcmp( out, expected, sizeof(expected) ) != 0 )
+    {
+    std::cerr << "Wrong hand made RLE frame decoding" << std::endl;
+    return 1;
+    }
+
+  // Not enough input
+  frame.resize( frame.size() - 5 );
+  if( codec.DecodeFrame( &frame[0], frame.size(), out, sizeof(out) ) )
+    {
+    std::cerr << "Truncated RLE frame should not decode" << std::endl;
+    return 1;
+    }
+  // Segment offset out of the frame
+  frame[4] = 100;
+  if( codec.DecodeFrame( &frame[0], frame.size(), out, sizeof(out) ) )
+    {
+    std::cerr << "Invalid RLE Segment offset should not decode" << std::endl;
+    return 1;
+    }
+  return 0;
+}
+
+int TestRLECodec(int, char *[])
+{
+  gdcm::PixelFormat rgb8 = gdcm::PixelFormat::UINT8;
+  rgb8.SetSamplesPerPixel( 3 );
+  gdcm::PixelFormat rgb16 = gdcm::PixelFormat::UINT16;
+  rgb16.SetSamplesPerPixel( 3 );
+  const gdcm::PhotometricInterpretation::PIType mono =
+    gdcm::PhotometricInterpretation::MONOCHROME2;
+  const gdcm::PhotometricInterpretation::PIType rgb =
+    gdcm::PhotometricInterpretation::RGB;
+
+  int res = 0;
+  res += TestRoundTrip( gdcm::PixelFormat::UINT8, mono, 0, 1 );
+  res += TestRoundTrip( gdcm::PixelFormat::UINT16, mono, 0, 1 );
+  res += TestRoundTrip( gdcm::PixelFormat::INT16, mono, 0, 3 );
+  res += TestRoundTrip( gdcm::PixelFormat::UINT32, mono, 0, 2 );
+  res += TestRoundTrip( rgb8, rgb, 0, 1 );
+  res += TestRoundTrip( rgb8, rgb, 1, 2 );
+  res += TestRoundTrip( rgb16, rgb, 0, 1 );
+  res += TestDecodeFrame();
+  return res;
+}
@@ -13,6 +13,7 @@
 =========================================================================*/
 #include "gdcmRescaler.h"
 #include <limits>
+#include <vector>
 
 #include <stdlib.h> // atof
 
@@ -28,6 +29,56 @@ static bool check_roundtrip(const gdcm::PixelFormat & pf )
   return true;
 }
 
+// Compare Rescale on a whole image (lookup table / vectorized paths) with the
+// straightforward per pixel computation
+template <typename TIn, typename TOut>
+static bool check_rescale(const gdcm::PixelFormat & pf, double intercept, double slope,
+  gdcm::PixelFormat::ScalarType target, bool garbage )
+{
+  gdcm::Rescaler r;
+  r.SetIntercept( intercept );
+  r.SetSlope( slope );
+  r.SetPixelFormat( pf );
+  r.SetTargetPixelType( target );
+  r.SetUseTargetPixelType( true );
+
+  const size_t n = 100003;
+  const int64_t range = pf.GetMax() - pf.GetMin() + 1;
+  std::vector<TIn> in( n );
+  for( size_t i = 0; i < n; ++i )
+    {
+    in[i] = (TIn)(pf.GetMin() + (int64_t)(i * 7919) % range);
+    // Values outside of Bits Stored:
+    if( garbage && i % 1000 == 0 ) in[i] = std::numeric_limits<TIn>::max();
+    }
+  std::vector<TOut> out( n );
+  if( !r.Rescale( (char*)&out[0], (char*)&in[0], n * sizeof(TIn) ) ) return false;
+  for( size_t i = 0; i < n; ++i )
+    {
+    const TOut ref = (TOut)(slope * in[i] + intercept);
+    if( out[i] != ref )
+      {
+      std::cerr << "Wrong rescale of " << (double)in[i] << ": " << (double)out[i]
+        << " vs " << (double)ref << std::endl;
+      return false;
+      }
+    }
+
+  // Back to the Stored Pixel Values
+  if( !garbage && slope == 1 && target != gdcm::PixelFormat::FLOAT64 )
+    {
+    gdcm::Rescaler ir;
+    ir.SetIntercept( intercept );
+    ir.SetSlope( slope );
+    ir.SetPixelFormat( target );
+    ir.SetMinMaxForPixelType( (double)pf.GetMin() + intercept, (double)pf.GetMax() + intercept );
+    std::vector<TIn> check( n );
+    if( !ir.InverseRescale( (char*)&check[0], (char*)&out[0], n * sizeof(TOut) ) ) return false;
+    if( check != in ) return false;
+    }
+  return true;
+}
+
 int TestRescaler1(int, char *[])
 {
   gdcm::Rescaler ir;
@@ -153,6 +204,28 @@ $10 = {Intercept = 6.0999999999999999e-05, Slope = 3.774114, PF = {SamplesPerPix
   if( !check_roundtrip(gdcm::PixelFormat(1,8,8,7,1) ) ) return 1;
 }
 
+// Whole images
+{
+  // CT: 12 bits unsigned into Hounsfield Units
+  const gdcm::PixelFormat ct12(1,16,12,11,0);
+  if( !check_rescale<uint16_t,int16_t>(ct12, -1024, 1, gdcm::PixelFormat::INT16, false ) ) return 1;
+  if( !check_rescale<uint16_t,int16_t>(ct12, -1024, 2, gdcm::PixelFormat::INT16, false ) ) return 1;
+  if( !check_rescale<uint16_t,double>(ct12, -1024.5, 0.25, gdcm::PixelFormat::FLOAT64, true ) ) return 1;
+  if( !check_rescale<uint16_t,float>(ct12, -1024.5, 0.25, gdcm::PixelFormat::FLOAT32, true ) ) return 1;
+  if( !check_rescale<uint16_t,int32_t>(ct12, -1024, 3, gdcm::PixelFormat::INT32, true ) ) return 1;
+  // 16 bits signed
+  const gdcm::PixelFormat ct16(1,16,16,15,1);
+  if( !check_rescale<int16_t,int32_t>(ct16, -1024, 1, gdcm::PixelFormat::INT32, false ) ) return 1;
+  if( !check_rescale<int16_t,double>(ct16, 3.5, -1.75, gdcm::PixelFormat::FLOAT64, false ) ) return 1;
+  const gdcm::PixelFormat ct15(1,16,15,14,1);
+  if( !check_rescale<int16_t,int16_t>(ct15, -1024, 1, gdcm::PixelFormat::INT16, false ) ) return 1;
+  if( !check_rescale<int16_t,uint16_t>(ct15, 16384, 1, gdcm::PixelFormat::UINT16, false ) ) return 1;
+  // 8 bits
+  const gdcm::PixelFormat pf8(1,8,8,7,0);
+  if( !check_rescale<uint8_t,double>(pf8, 3, 0.5, gdcm::PixelFormat::FLOAT64, false ) ) return 1;
+  if( !check_rescale<uint8_t,int16_t>(pf8, -100, 2, gdcm::PixelFormat::INT16, false ) ) return 1;
+}
+
 
   return 0;
 }
@@ -0,0 +1,146 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmScanner.h"
+#include "gdcmWriter.h"
+#include "gdcmCommand.h"
+#include "gdcmFileNameEvent.h"
+#include "gdcmSystem.h"
+#include "gdcmTesting.h"
+#include "gdcmTrace.h"
+
+#include <fstream>
+#include <sstream>
+
+/*
+ * Check a multi-threaded scan gives the same result (and the same sequence
+ * of events) as a single threaded one
+ */
+class FileNameWatcher : public gdcm::Command
+{
+public:
+  static gdcm::SmartPointer<FileNameWatcher> New() { return new FileNameWatcher; }
+  void Execute(gdcm::Subject *caller, const gdcm::Event &event)
+    {
+    Execute( (const gdcm::Subject*)caller, event );
+    }
+  void Execute(const gdcm::Subject *, const gdcm::Event &event)
+    {
+    const gdcm::FileNameEvent &fe = dynamic_cast<const gdcm::FileNameEvent&>(event);
+    FileNames.push_back( fe.GetFileName() );
+    }
+  gdcm::Directory::FilenamesType FileNames;
+};
+
+static bool WriteFile(const std::string &filename, unsigned int i)
+{
+  gdcm::Writer w;
+  gdcm::DataSet &ds = w.GetFile().GetDataSet();
+  std::ostringstream sop;
+  sop << "1.2.3.4.5." << i;
+  std::ostringstream series;
+  series << "1.2.3.4." << (i % 3);
+  const char sopclass[] = "1.2.840.10008.5.1.4.1.1.7";
+  gdcm::DataElement de( gdcm::Tag(0x0008,0x0016) );
+  de.SetVR( gdcm::VR::UI );
+  de.SetByteValue( sopclass, (uint32_t)strlen(sopclass) );
+  ds.Insert( de );
+  de.SetTag( gdcm::Tag(0x0008,0x0018) );
+  de.SetByteValue( sop.str().c_str(), (uint32_t)sop.str().size() );
+  ds.Insert( de );
+  de.SetTag( gdcm::Tag(0x0020,0x000e) );
+  de.SetByteValue( series.str().c_str(), (uint32_t)series.str().size() );
+  ds.Insert( de );
+  w.GetFile().GetHeader().SetDataSetTransferSyntax( gdcm::TransferSyntax::ExplicitVRLittleEndian );
+  w.SetFileName( filename.c_str() );
+  return w.Write();
+}
+
+static int Scan(gdcm::Scanner &s, gdcm::Directory::FilenamesType const &filenames,
+  unsigned int nthreads, gdcm::Directory::FilenamesType &events)
+{
+  gdcm::SmartPointer<FileNameWatcher> watcher = FileNameWatcher::New();
+  s.AddObserver( gdcm::FileNameEvent(), watcher );
+  s.AddTag( gdcm::Tag(0x0008,0x0018) );
+  s.AddTag( gdcm::Tag(0x0020,0x000e) );
+  s.AddTag( gdcm::Tag(0x0002,0x0010) );
+  s.SetNumberOfThreads( nthreads );
+  if( !s.Scan( filenames ) ) return 1;
+  events = watcher->FileNames;
+  return 0;
+}
+
+int TestScanner3(int , char *argv[])
+{
+  gdcm::Trace::WarningOff();
+  gdcm::Trace::ErrorOff();
+  const char *subdir = argv[0];
+  std::string tmpdir = gdcm::Testing::GetTempDirectory( subdir );
+  if( !gdcm::System::FileIsDirectory( tmpdir.c_str() ) )
+    {
+    gdcm::System::MakeDirectory( tmpdir.c_str() );
+    }
+  gdcm::Directory::FilenamesType filenames;
+  const unsigned int nfiles = 50;
+  for( unsigned int i = 0; i < nfiles; ++i )
+    {
+    std::ostringstream os;
+    os << "scan" << i << ".dcm";
+    std::string filename = gdcm::Testing::GetTempFilename( os.str().c_str(), subdir );
+    if( i % 10 == 5 )
+      {
+      // Not a DICOM file:
+      std::ofstream out( filename.c_str() );
+      out << "not a DICOM file";
+      }
+    else if( !WriteFile( filename, i ) )
+      {
+      std::cerr << "Failed to write: " << filename << std::endl;
+      return 1;
+      }
+    filenames.push_back( filename );
+    }
+
+  gdcm::Scanner s1;
+  gdcm::Directory::FilenamesType events1;
+  if( Scan( s1, filenames, 1, events1 ) ) return 1;
+  gdcm::Scanner s4;
+  gdcm::Directory::FilenamesType events4;
+  if( Scan( s4, filenames, 4, events4 ) ) return 1;
+
+  if( events1 != filenames || events4 != filenames )
+    {
+    std::cerr << "Wrong FileNameEvent order" << std::endl;
+    return 1;
+    }
+  if( s1.GetValues() != s4.GetValues() || s1.GetValues().size() != 45 + 3 + 1 )
+    {
+    std::cerr << "Wrong values" << std::endl;
+    return 1;
+    }
+  std::ostringstream os1, os4;
+  s1.Print( os1 );
+  s4.Print( os4 );
+  if( os1.str() != os4.str() )
+    {
+    std::cerr << "Scan differ:\n" << os1.str() << "\n" << os4.str() << std::endl;
+    return 1;
+    }
+  if( s4.GetKeys().size() != 45 || s4.IsKey( filenames[5].c_str() ) )
+    {
+    std::cerr << "Wrong keys" << std::endl;
+    return 1;
+    }
+
+  return 0;
+}
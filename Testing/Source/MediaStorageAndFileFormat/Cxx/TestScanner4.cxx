@@ -0,0 +1,203 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmScanner.h"
+#include "gdcmWriter.h"
+#include "gdcmSystem.h"
+#include "gdcmTesting.h"
+#include "gdcmTrace.h"
+
+#include <fstream>
+#include <sstream>
+
+/*
+ * Check a Scan using a persistent index gives the same result as a regular
+ * Scan, and that modified files are read again
+ */
+static bool WriteFile(const std::string &filename, const std::string &sop)
+{
+  gdcm::Writer w;
+  gdcm::DataSet &ds = w.GetFile().GetDataSet();
+  const char sopclass[] = "1.2.840.10008.5.1.4.1.1.7";
+  gdcm::DataElement de( gdcm::Tag(0x0008,0x0016) );
+  de.SetVR( gdcm::VR::UI );
+  de.SetByteValue( sopclass, (uint32_t)strlen(sopclass) );
+  ds.Insert( de );
+  de.SetTag( gdcm::Tag(0x0008,0x0018) );
+  de.SetByteValue( sop.c_str(), (uint32_t)sop.size() );
+  ds.Insert( de );
+  w.GetFile().GetHeader().SetDataSetTransferSyntax( gdcm::TransferSyntax::ExplicitVRLittleEndian );
+  w.SetFileName( filename.c_str() );
+  return w.Write();
+}
+
+static std::string Scan(gdcm::Directory::FilenamesType const &filenames,
+  const char *index, bool sopclass = false)
+{
+  gdcm::Scanner s;
+  s.AddTag( gdcm::Tag(0x0008,0x0018) );
+  s.AddTag( gdcm::Tag(0x0002,0x0010) );
+  if( sopclass ) s.AddTag( gdcm::Tag(0x0008,0x0016) );
+  s.SetIndexFileName( index );
+  s.Scan( filenames );
+  std::ostringstream os;
+  s.Print( os );
+  return os.str();
+}
+
+int TestScanner4(int , char *argv[])
+{
+  gdcm::Trace::WarningOff();
+  gdcm::Trace::ErrorOff();
+  const char *subdir = argv[0];
+  std::string tmpdir = gdcm::Testing::GetTempDirectory( subdir );
+  if( !gdcm::System::FileIsDirectory( tmpdir.c_str() ) )
+    {
+    gdcm::System::MakeDirectory( tmpdir.c_str() );
+    }
+  const std::string index = gdcm::Testing::GetTempFilename( "scanner.idx", subdir );
+  gdcm::System::RemoveFile( index.c_str() );
+
+  gdcm::Directory::FilenamesType filenames;
+  for( unsigned int i = 0; i < 20; ++i )
+    {
+    std::ostringstream os;
+    os << "index" << i << ".dcm";
+    std::string filename = gdcm::Testing::GetTempFilename( os.str().c_str(), subdir );
+    std::ostringstream sop;
+    sop << "1.2.3.4.5." << i;
+    if( i == 7 )
+      {
+      std::ofstream out( filename.c_str() );
+      out << "not a DICOM file";
+      }
+    else if( !WriteFile( filename, sop.str() ) )
+      {
+      std::cerr << "Failed to write: " << filename << std::endl;
+      return 1;
+      }
+    filenames.push_back( filename );
+    }
+
+  const std::string ref = Scan( filenames, NULL );
+  if( Scan( filenames, index.c_str() ) != ref )
+    {
+    std::cerr << "Scan with a new index differ" << std::endl;
+    return 1;
+    }
+  if( !gdcm::System::FileExists( index.c_str() ) )
+    {
+    std::cerr << "No index written: " << index << std::endl;
+    return 1;
+    }
+  if( Scan( filenames, index.c_str() ) != ref )
+    {
+    std::cerr << "Scan with an existing index differ" << std::endl;
+    return 1;
+    }
+
+  // A modified file (different size) must be read again:
+  if( !WriteFile( filenames[3], "1.2.3.4.5.6.7.8.9" ) ) return 1;
+  const std::string ref2 = Scan( filenames, NULL );
+  if( ref2 == ref || Scan( filenames, index.c_str() ) != ref2 )
+    {
+    std::cerr << "Modified file not read again" << std::endl;
+    return 1;
+    }
+
+  // An index created for another set of tags is not used:
+  if( Scan( filenames, index.c_str(), true ) != Scan( filenames, NULL, true ) )
+    {
+    std::cerr << "Index used for a different set of tags" << std::endl;
+    return 1;
+    }
+
+  // A subset of the files (the index only keeps the last Scan):
+  gdcm::Directory::FilenamesType subset( filenames.begin(), filenames.begin() + 10 );
+  if( Scan( subset, index.c_str() ) != Scan( subset, NULL ) )
+    {
+    std::cerr << "Scan of a subset differ" << std::endl;
+    return 1;
+    }
+
+  // Garbage is not an index:
+  {
+  std::ofstream out( index.c_str(), std::ios::binary );
+  out << "GDCMSIX1 garbage";
+  }
+  if( Scan( filenames, index.c_str() ) != ref2 )
+    {
+    std::cerr << "Invalid index used" << std::endl;
+    return 1;
+    }
+
+  // Nor is a truncated index, or one with counts larger than the file:
+  if( Scan( filenames, index.c_str() ) != ref2 ) return 1;
+  std::string valid;
+  {
+  std::ifstream in( index.c_str(), std::ios::binary );
+  std::ostringstream os;
+  os << in.rdbuf();
+  valid = os.str();
+  }
+  {
+  std::ofstream out( index.c_str(), std::ios::binary );
+  out.write( valid.c_str(), valid.size() / 2 );
+  }
+  if( Scan( filenames, index.c_str() ) != ref2 )
+    {
+    std::cerr << "Truncated index used" << std::endl;
+    return 1;
+    }
+  // header and the 2 tags, then 0xFFFFFFFF strings:
+  const size_t stringcount = 8 + 4 + 4 + 2 * 4;
+  const uint32_t huge = 0xFFFFFFFF;
+  std::string corrupt = valid.substr( 0, stringcount );
+  corrupt.append( reinterpret_cast<const char*>(&huge), sizeof(huge) );
+  corrupt.append( valid, stringcount + sizeof(huge), std::string::npos );
+  {
+  std::ofstream out( index.c_str(), std::ios::binary );
+  out.write( corrupt.c_str(), corrupt.size() );
+  }
+  if( Scan( filenames, index.c_str() ) != ref2 )
+    {
+    std::cerr << "Corrupt index used" << std::endl;
+    return 1;
+    }
+  // first string of 0xFFFFFFFF bytes:
+  corrupt = valid;
+  corrupt.replace( stringcount + sizeof(huge), sizeof(huge),
+    reinterpret_cast<const char*>(&huge), sizeof(huge) );
+  {
+  std::ofstream out( index.c_str(), std::ios::binary );
+  out.write( corrupt.c_str(), corrupt.size() );
+  }
+  if( Scan( filenames, index.c_str() ) != ref2 )
+    {
+    std::cerr << "Corrupt index used" << std::endl;
+    return 1;
+    }
+
+  // A leftover in place of a fixed temporary name does not prevent saving:
+  const std::string stale = index + ".tmp";
+  gdcm::System::MakeDirectory( stale.c_str() );
+  gdcm::System::RemoveFile( index.c_str() );
+  Scan( filenames, index.c_str() );
+  if( !gdcm::System::FileExists( index.c_str() ) )
+    {
+    std::cerr << "No index written next to: " << stale << std::endl;
+    return 1;
+    }
+
+  return 0;
+}
@@ -0,0 +1,103 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmPDataTFStreamBuf.h"
+#include "gdcmPDataTFPDU.h"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+
+// Read back the PDUs: each one should hold one PDV of at most maxpdusize - 6
+// bytes, and only the last one should be flagged as the last fragment
+static int CheckPDUs(std::istream &is, const std::string &expected,
+  unsigned int maxpdusize)
+{
+  std::string blobs;
+  bool last = false;
+  while( is.peek() != EOF )
+    {
+    if( last )
+      {
+      std::cerr << "Data after the last fragment" << std::endl;
+      return 1;
+      }
+    uint8_t itemtype = 0;
+    is.read( (char*)&itemtype, 1 );
+    gdcm::network::PDataTFPDU pdu;
+    pdu.Read( is );
+    if( itemtype != 0x4 || pdu.GetNumberOfPresentationDataValues() != 1
+      || pdu.Size() > maxpdusize + 6 )
+      {
+      std::cerr << "Wrong PDU" << std::endl;
+      return 1;
+      }
+    const gdcm::network::PresentationDataValue &pdv =
+      pdu.GetPresentationDataValue(0);
+    if( pdv.GetPresentationContextID() != 3 || pdv.GetIsCommand() )
+      {
+      std::cerr << "Wrong PDV" << std::endl;
+      return 1;
+      }
+    last = pdv.GetIsLastFragment();
+    blobs += pdv.GetBlob();
+    }
+  if( !last || blobs != expected )
+    {
+    std::cerr << "Wrong data set for " << expected.size() << " bytes" << std::endl;
+    return 1;
+    }
+  return 0;
+}
+
+int TestPDataTFStreamBuf(int , char *[])
+{
+  const unsigned int maxpdusize = 106;
+  // exact multiples of the PDV payload (100 bytes) and odd sizes
+  const size_t sizes[] = { 1, 99, 100, 101, 200, 250, 1000, 12345 };
+  for( size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); ++s )
+    {
+    std::string ds( sizes[s], ' ' );
+    for( size_t i = 0; i < ds.size(); ++i ) ds[i] = (char)(i * 7 + i / 13);
+
+    // one large write: sent without going through the buffer
+    std::stringstream ss1;
+    gdcm::network::PDataTFStreamBuf buf1( ss1, 3, maxpdusize );
+    std::ostream os1( &buf1 );
+    os1.write( ds.c_str(), ds.size() );
+    if( !buf1.Finish() || buf1.GetNumberOfBytesSent() != ds.size() ) return 1;
+    if( CheckPDUs( ss1, ds, maxpdusize ) ) return 1;
+
+    // small writes and single characters
+    std::stringstream ss2;
+    gdcm::network::PDataTFStreamBuf buf2( ss2, 3, maxpdusize );
+    std::ostream os2( &buf2 );
+    for( size_t i = 0; i < ds.size(); )
+      {
+      const size_t len = std::min( ds.size() - i, (size_t)(i % 3 ? 1 : 37) );
+      if( len == 1 ) os2.put( ds[i] );
+      else os2.write( ds.c_str() + i, len );
+      i += len;
+      }
+    if( !buf2.Finish() ) return 1;
+    if( CheckPDUs( ss2, ds, maxpdusize ) ) return 1;
+    }
+
+  // nothing written, nothing sent
+  std::stringstream ss;
+  gdcm::network::PDataTFStreamBuf buf( ss, 3, maxpdusize );
+  if( !buf.Finish() || !ss.str().empty() ) return 1;
+
+  return 0;
+}
@@ -0,0 +1,149 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmULOperationsWindow.h"
+#include "gdcmULConnection.h"
+#include "gdcmULConnectionInfo.h"
+#include "gdcmULBasicCallback.h"
+#include "gdcmUserInformation.h"
+#include "gdcmAsynchronousOperationsWindowSub.h"
+#include "gdcmPDataTFStreamBuf.h"
+#include "gdcmPDataTFPDU.h"
+#include "gdcmBasePDU.h"
+#include "gdcmCommandDataSet.h"
+#include "gdcmAttribute.h"
+#include "gdcmImplicitDataElement.h"
+#include "gdcmSwapper.h"
+
+#include <iostream>
+#include <sstream>
+
+// Write a response command for the request messageid
+static void WriteResponse(std::ostream &os, uint16_t commandfield,
+  uint16_t messageid, uint16_t status, bool hasdataset)
+{
+  gdcm::CommandDataSet command;
+  gdcm::Attribute<0x0,0x0100> cf = { commandfield };
+  command.Insert( cf.GetAsDataElement() );
+  gdcm::Attribute<0x0,0x0120> id = { messageid };
+  command.Insert( id.GetAsDataElement() );
+  gdcm::Attribute<0x0,0x0800> type = { (uint16_t)(hasdataset ? 0x0001 : 0x0101) };
+  command.Insert( type.GetAsDataElement() );
+  gdcm::Attribute<0x0,0x0900> st = { status };
+  command.Insert( st.GetAsDataElement() );
+
+  gdcm::network::PresentationDataValue pdv;
+  pdv.SetPresentationContextID( 1 );
+  pdv.SetDataSet( command );
+  pdv.SetCommand( true );
+  pdv.SetLastFragment( true );
+  gdcm::network::PDataTFPDU pdu;
+  pdu.AddPresentationDataValue( pdv );
+  pdu.Write( os );
+}
+
+// Write a C-FIND match, cut into small PDUs
+static void WriteMatch(std::ostream &os, const char *patientid)
+{
+  gdcm::DataSet ds;
+  gdcm::Attribute<0x10,0x20> pid;
+  pid.SetValue( patientid );
+  ds.Insert( pid.GetAsDataElement() );
+  gdcm::network::PDataTFStreamBuf buf( os, 1, 16 );
+  std::ostream pdataos( &buf );
+  ds.Write<gdcm::ImplicitDataElement,gdcm::SwapperNoOp>( pdataos );
+  buf.Finish();
+}
+
+int TestULOperationsWindow(int , char *[])
+{
+  // Asynchronous Operations Window negotiation sub-item
+  gdcm::network::AsynchronousOperationsWindowSub aows;
+  aows.SetMaximumNumberOperationsInvoked( 16 );
+  aows.SetMaximumNumberOperationsPerformed( 1 );
+  gdcm::network::UserInformation ui;
+  if( ui.GetAsynchronousOperationsWindowSub() ) return 1;
+  ui.SetAsynchronousOperationsWindowSub( aows );
+  std::stringstream uiss;
+  ui.Write( uiss );
+  uint8_t itemtype = 0;
+  uiss.read( (char*)&itemtype, 1 );
+  gdcm::network::UserInformation ui2;
+  ui2.Read( uiss );
+  const gdcm::network::AsynchronousOperationsWindowSub *aows2 =
+    ui2.GetAsynchronousOperationsWindowSub();
+  if( itemtype != 0x50 || !aows2 || aows2->GetMaximumNumberOperationsInvoked() != 16
+    || aows2->GetMaximumNumberOperationsPerformed() != 1 )
+    {
+    std::cerr << "Wrong Asynchronous Operations Window" << std::endl;
+    return 1;
+    }
+
+  // Responses come back in any order
+  std::stringstream ss;
+  WriteResponse( ss, 0x8001, 2, 0x0, false ); // C-STORE-RSP
+  WriteResponse( ss, 0x8020, 3, 0xff00, true ); // C-FIND-RSP pending
+  WriteMatch( ss, "ABCDEFGHIJKLMNOPQRSTUVWXYZ" );
+  WriteResponse( ss, 0x8001, 99, 0x0, false ); // not ours
+  WriteResponse( ss, 0x8020, 3, 0xff00, true );
+  WriteMatch( ss, "12345678" );
+  WriteResponse( ss, 0x8020, 3, 0x0, false ); // C-FIND-RSP done
+  WriteResponse( ss, 0x8001, 1, 0xa700, false );
+  ss.write( "\x07\x00\x00\x00\x00\x04\x00\x00\x00\x00", 10 ); // A-ABORT
+
+  gdcm::network::ULConnectionInfo info;
+  gdcm::network::ULConnection connection( info );
+  gdcm::network::ULOperationsWindow window;
+  gdcm::network::ULBasicCallback store1, store2, find;
+  window.AddOperation( 1, &store1 );
+  window.AddOperation( 2, &store2 );
+  window.AddOperation( 3, &find );
+  if( window.GetNumberOfOperations() != 3 ) return 1;
+
+  gdcm::network::BasePDU *pdu = NULL;
+  const size_t expected[] = { 2, 2, 2, 2, 1, 0 };
+  for( size_t i = 0; i < sizeof(expected) / sizeof(*expected); ++i )
+    {
+    if( !window.ReadResponse( ss, connection, pdu )
+      || window.GetNumberOfOperations() != expected[i] )
+      {
+      std::cerr << "Wrong response #" << i << std::endl;
+      return 1;
+      }
+    }
+  if( window.ReadResponse( ss, connection, pdu ) || !pdu )
+    {
+    std::cerr << "A-ABORT not reported" << std::endl;
+    return 1;
+    }
+  delete pdu;
+
+  if( store1.GetResponses().size() != 1 || store2.GetResponses().size() != 1
+    || find.GetResponses().size() != 3 || find.GetDataSets().size() != 2
+    || !store1.GetDataSets().empty() )
+    {
+    std::cerr << "Responses not dispatched by Message ID" << std::endl;
+    return 1;
+    }
+  gdcm::Attribute<0x0,0x0900> status;
+  status.SetFromDataSet( store1.GetResponses()[0] );
+  gdcm::Attribute<0x10,0x20> pid;
+  pid.SetFromDataSet( find.GetDataSets()[0] );
+  if( status.GetValue() != 0xa700 || pid.GetValue() != "ABCDEFGHIJKLMNOPQRSTUVWXYZ" )
+    {
+    std::cerr << "Wrong response content" << std::endl;
+    return 1;
+    }
+
+  return 0;
+}
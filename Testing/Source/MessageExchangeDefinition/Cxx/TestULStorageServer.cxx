@@ -0,0 +1,276 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmULStorageServer.h"
+#include "gdcmULWritingCallback.h"
+#include "gdcmCompositeNetworkFunctions.h"
+#include "gdcmWorkerPool.h"
+#include "gdcmUIDGenerator.h"
+#include "gdcmAttribute.h"
+#include "gdcmWriter.h"
+#include "gdcmReader.h"
+#include "gdcmSystem.h"
+#include "gdcmTesting.h"
+#include "gdcmTrace.h"
+
+#include <cstring>
+#include <fstream>
+
+static const char sopclass[] = "1.2.840.10008.5.1.4.1.1.7";
+
+// A Secondary Capture object with some Pixel Data
+static bool WriteFile(const std::string &filename, std::string &instanceuid)
+{
+  gdcm::UIDGenerator uid;
+  instanceuid = uid.Generate();
+  gdcm::Writer writer;
+  gdcm::DataSet &ds = writer.GetFile().GetDataSet();
+  gdcm::DataElement de( gdcm::Tag(0x8,0x16) );
+  de.SetVR( gdcm::VR::UI );
+  de.SetByteValue( sopclass, (uint32_t)strlen(sopclass) + 1 );
+  ds.Insert( de );
+  std::string value = instanceuid;
+  if( value.size() % 2 ) value.push_back( 0 );
+  de.SetTag( gdcm::Tag(0x8,0x18) );
+  de.SetByteValue( value.c_str(), (uint32_t)value.size() );
+  ds.Insert( de );
+  gdcm::Attribute<0x10,0x20> pid = { "12345678" };
+  ds.Insert( pid.GetAsDataElement() );
+  std::vector<char> pixels( 30000 );
+  for( size_t i = 0; i < pixels.size(); ++i ) pixels[i] = (char)i;
+  gdcm::DataElement pd( gdcm::Tag(0x7fe0,0x10) );
+  pd.SetVR( gdcm::VR::OB );
+  pd.SetByteValue( &pixels[0], (uint32_t)pixels.size() );
+  ds.Insert( pd );
+  writer.GetFile().GetHeader().SetDataSetTransferSyntax(
+    gdcm::TransferSyntax::ImplicitVRLittleEndian );
+  writer.SetCheckFileMetaInformation( true );
+  writer.SetFileName( filename.c_str() );
+  return writer.Write();
+}
+
+// Refuses to keep anything
+class RefusingCallback : public gdcm::network::ULWritingCallback
+{
+public:
+  virtual bool EndDataSet(bool success)
+    {
+    ULWritingCallback::EndDataSet( success );
+    return false;
+    }
+};
+
+// Refuses everything before receiving it
+class RejectingCallback : public gdcm::network::ULWritingCallback
+{
+public:
+  virtual bool AcceptDataSet(const gdcm::DataSet &)
+    {
+    return false;
+    }
+};
+
+class TestServer : public gdcm::network::ULStorageServer
+{
+public:
+  TestServer():Refuse(0) {}
+  int Refuse; // 0: store, 1: refuse once received, 2: refuse upfront
+protected:
+  virtual gdcm::network::ULConnectionCallback *CreateCallback()
+    {
+    if( !Refuse ) return ULStorageServer::CreateCallback();
+    gdcm::network::ULWritingCallback *callback;
+    if( Refuse == 1 ) callback = new RefusingCallback;
+    else callback = new RejectingCallback;
+    callback->SetDirectory( GetDirectory() );
+    callback->SetIncremental( true );
+    return callback;
+    }
+};
+
+// Index 0 runs the server, index 1 the client which then stops the server
+class ServerJob : public gdcm::WorkerPool::Job
+{
+public:
+  ServerJob(TestServer &server, const gdcm::Directory::FilenamesType &filenames):
+    Server(server),Filenames(filenames),Echo(false),Stored(false) {}
+  void Execute(unsigned int index)
+    {
+    if( index == 0 )
+      {
+      Server.Run();
+      return;
+      }
+    const uint16_t port = Server.GetPort();
+    Echo = gdcm::CompositeNetworkFunctions::CEcho( "localhost", port );
+    Stored = gdcm::CompositeNetworkFunctions::CStore( "localhost", port,
+      Filenames, 2, &Report );
+    Server.Stop();
+    }
+
+  TestServer &Server;
+  const gdcm::Directory::FilenamesType &Filenames;
+  bool Echo;
+  bool Stored;
+  gdcm::CompositeNetworkFunctions::StoreReport Report;
+};
+
+int TestULStorageServer(int , char *[])
+{
+  const char subdir[] = "TestULStorageServer";
+  std::string tmpdir = gdcm::Testing::GetTempDirectory( subdir );
+  if( !gdcm::System::FileIsDirectory( tmpdir.c_str() ) )
+    {
+    gdcm::System::MakeDirectory( tmpdir.c_str() );
+    }
+  const std::string indir = tmpdir + "/in";
+  const std::string outdir = tmpdir + "/out";
+  gdcm::System::MakeDirectory( indir.c_str() );
+  gdcm::System::MakeDirectory( outdir.c_str() );
+
+  const unsigned int nfiles = 6;
+  gdcm::Directory::FilenamesType filenames;
+  std::vector<std::string> instanceuids;
+  for( unsigned int i = 0; i < nfiles; ++i )
+    {
+    std::string uid;
+    const std::string filename = indir + "/" + (char)('a' + i) + ".dcm";
+    if( !WriteFile( filename, uid ) ) return 1;
+    filenames.push_back( filename );
+    instanceuids.push_back( uid );
+    }
+
+  TestServer server;
+  server.SetPort( 0 );
+  server.SetDirectory( outdir );
+  server.SetNumberOfThreads( 2 );
+  server.SetTimeout( 10 );
+  gdcm::Trace::ErrorOff();
+  if( server.Run() )
+    {
+    std::cerr << "Run should fail when not listening" << std::endl;
+    return 1;
+    }
+  gdcm::Trace::ErrorOn();
+  if( !server.Listen() || !server.GetPort() )
+    {
+    std::cerr << "Could not listen" << std::endl;
+    return 1;
+    }
+
+  gdcm::WorkerPool pool;
+  pool.SetNumberOfThreads( 2 );
+  ServerJob job( server, filenames );
+  pool.Run( job, 2 );
+  if( !job.Echo || !job.Stored )
+    {
+    std::cerr << "Echo/Store failed" << std::endl;
+    return 1;
+    }
+  if( server.GetNumberOfDataSets() != nfiles
+    || server.GetNumberOfAssociations() != 1 + job.Report.NumberOfAssociations )
+    {
+    std::cerr << "Wrong count: " << server.GetNumberOfDataSets() << " data sets, "
+      << server.GetNumberOfAssociations() << " associations" << std::endl;
+    return 1;
+    }
+  for( unsigned int i = 0; i < nfiles; ++i )
+    {
+    const std::string filename = outdir + "/" + instanceuids[i] + ".dcm";
+    gdcm::Reader reader;
+    reader.SetFileName( filename.c_str() );
+    if( !reader.Read() )
+      {
+      std::cerr << "Could not read back: " << filename << std::endl;
+      return 1;
+      }
+    const gdcm::DataSet &ds = reader.GetFile().GetDataSet();
+    gdcm::Attribute<0x10,0x20> pid;
+    pid.SetFromDataSet( ds );
+    const gdcm::ByteValue *bv = ds.GetDataElement( gdcm::Tag(0x7fe0,0x10) ).GetByteValue();
+    if( pid.GetValue() != "12345678" || !bv || bv->GetLength() != 30000
+      || bv->GetPointer()[29999] != (char)29999 )
+      {
+      std::cerr << "Wrong file received: " << filename << std::endl;
+      return 1;
+      }
+    gdcm::System::RemoveFile( filename.c_str() );
+    }
+
+  // A file that cannot be read is reported as not sent, the association it
+  // was given to keeps storing the other files
+  const std::string bogus = indir + "/bogus.dcm";
+  std::ofstream out( bogus.c_str() );
+  out << "not a DICOM file";
+  out.close();
+  gdcm::Directory::FilenamesType withbogus = filenames;
+  withbogus.insert( withbogus.begin() + 1, bogus );
+  if( !server.Listen() ) return 1;
+  ServerJob job1( server, withbogus );
+  gdcm::Trace::ErrorOff();
+  pool.Run( job1, 2 );
+  gdcm::Trace::ErrorOn();
+  if( job1.Stored || server.GetNumberOfDataSets() != nfiles
+    || job1.Report.Statuses.size() != nfiles + 1 )
+    {
+    std::cerr << "Unreadable file stopped the C-Store: "
+      << server.GetNumberOfDataSets() << " data sets" << std::endl;
+    return 1;
+    }
+  for( unsigned int i = 0; i <= nfiles; ++i )
+    {
+    if( job1.Report.Statuses[i] != (i == 1 ? -1 : 0) )
+      {
+      std::cerr << "Wrong status for " << withbogus[i] << ": "
+        << job1.Report.Statuses[i] << std::endl;
+      return 1;
+      }
+    }
+  for( unsigned int i = 0; i < nfiles; ++i )
+    {
+    const std::string filename = outdir + "/" + instanceuids[i] + ".dcm";
+    if( !gdcm::System::FileExists( filename.c_str() ) )
+      {
+      std::cerr << "Not received: " << filename << std::endl;
+      return 1;
+      }
+    gdcm::System::RemoveFile( filename.c_str() );
+    }
+
+  // Data sets that could not be stored, or were refused, are reported as such
+  // to the SCU
+  for( server.Refuse = 1; server.Refuse <= 2; ++server.Refuse )
+    {
+    if( !server.Listen() ) return 1;
+    ServerJob job2( server, filenames );
+    gdcm::Trace::ErrorOff();
+    pool.Run( job2, 2 );
+    gdcm::Trace::ErrorOn();
+    if( job2.Stored || server.GetNumberOfDataSets() != 0
+      || job2.Report.Statuses.size() != nfiles )
+      {
+      std::cerr << "Refused data sets not reported" << std::endl;
+      return 1;
+      }
+    for( unsigned int i = 0; i < nfiles; ++i )
+      {
+      if( job2.Report.Statuses[i] != 0xA700 )
+        {
+        std::cerr << "Wrong status: " << job2.Report.Statuses[i] << std::endl;
+        return 1;
+        }
+      }
+    }
+
+  return 0;
+}
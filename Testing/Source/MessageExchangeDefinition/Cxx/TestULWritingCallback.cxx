@@ -0,0 +1,193 @@
+/*=========================================================================
+
+  Program: GDCM (Grassroots DICOM). A DICOM library
+
+  Copyright (c) 2006-2011 Mathieu Malaterre
+  All rights reserved.
+  See Copyright.txt or http://gdcm.sourceforge.net/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "gdcmULWritingCallback.h"
+#include "gdcmPDUFactory.h"
+#include "gdcmPDataTFStreamBuf.h"
+#include "gdcmBasePDU.h"
+#include "gdcmAttribute.h"
+#include "gdcmCommandDataSet.h"
+#include "gdcmImplicitDataElement.h"
+#include "gdcmSwapper.h"
+#include "gdcmReader.h"
+#include "gdcmSystem.h"
+#include "gdcmDirectory.h"
+#include "gdcmTesting.h"
+
+#include <sstream>
+#include <cstring>
+#include <vector>
+
+class FileCallback : public gdcm::network::ULWritingCallback
+{
+public:
+  std::vector<std::string> Files;
+  virtual void HandleFile(const char *filename) { Files.push_back( filename ); }
+};
+
+static const char sopclass[] = "1.2.840.10008.5.1.4.1.1.7";
+static const char sopinstance[] = "1.2.3.4.5.6.7";
+
+// A C-STORE command and its data set, the data set cut into small PDUs
+static void CreateCStore(gdcm::CommandDataSet &command, std::stringstream &pdus)
+{
+  gdcm::DataElement de( gdcm::Tag(0x0,0x2) );
+  de.SetVR( gdcm::VR::UI );
+  de.SetByteValue( sopclass, (uint32_t)strlen(sopclass) + 1 );
+  command.Insert( de );
+  de.SetTag( gdcm::Tag(0x0,0x1000) );
+  de.SetByteValue( sopinstance, (uint32_t)strlen(sopinstance) + 1 );
+  command.Insert( de );
+
+  gdcm::DataSet ds;
+  de.SetTag( gdcm::Tag(0x8,0x16) );
+  de.SetByteValue( sopclass, (uint32_t)strlen(sopclass) + 1 );
+  ds.Insert( de );
+  de.SetTag( gdcm::Tag(0x8,0x18) );
+  de.SetByteValue( sopinstance, (uint32_t)strlen(sopinstance) + 1 );
+  ds.Insert( de );
+  gdcm::Attribute<0x10,0x20> pid = { "12345678" };
+  ds.Insert( pid.GetAsDataElement() );
+  std::vector<char> pixels( 1000 );
+  for( size_t i = 0; i < pixels.size(); ++i ) pixels[i] = (char)i;
+  gdcm::DataElement pd( gdcm::Tag(0x7fe0,0x10) );
+  pd.SetVR( gdcm::VR::OB );
+  pd.SetByteValue( &pixels[0], (uint32_t)pixels.size() );
+  ds.Insert( pd );
+
+  gdcm::network::PDataTFStreamBuf buf( pdus, 1, 106 );
+  std::ostream os( &buf );
+  ds.Write<gdcm::ImplicitDataElement,gdcm::SwapperNoOp>( os );
+  buf.Finish();
+}
+
+int TestULWritingCallback(int , char *[])
+{
+  const char subdir[] = "TestULWritingCallback";
+  std::string tmpdir = gdcm::Testing::GetTempDirectory( subdir );
+  if( !gdcm::System::FileIsDirectory( tmpdir.c_str() ) )
+    {
+    gdcm::System::MakeDirectory( tmpdir.c_str() );
+    }
+  const gdcm::TransferSyntax ts = gdcm::TransferSyntax::ImplicitVRLittleEndian;
+
+  gdcm::CommandDataSet command;
+  std::stringstream pdus;
+  CreateCStore( command, pdus );
+
+  // Not in incremental mode: data sets are received in memory
+  FileCallback callback;
+  callback.SetDirectory( tmpdir );
+  if( callback.BeginDataSet( command, ts ) ) return 1;
+
+  callback.SetIncremental( true );
+  std::ostream *os = callback.BeginDataSet( command, ts );
+  gdcm::network::BasePDU *pdu = NULL;
+  if( !os || !gdcm::network::PDUFactory::ReadDataSetInto( pdus, *os, pdu ) || pdu )
+    {
+    std::cerr << "Could not receive the data set" << std::endl;
+    return 1;
+    }
+  callback.EndDataSet( true );
+  const std::string filename = tmpdir + "/" + sopinstance + ".dcm";
+  if( callback.Files.size() != 1 || callback.Files[0] != filename )
+    {
+    std::cerr << "Wrong file name" << std::endl;
+    return 1;
+    }
+
+  gdcm::Reader reader;
+  reader.SetFileName( filename.c_str() );
+  if( !reader.Read() )
+    {
+    std::cerr << "Could not read back: " << filename << std::endl;
+    return 1;
+    }
+  const gdcm::File &file = reader.GetFile();
+  gdcm::Attribute<0x10,0x20> pid;
+  pid.SetFromDataSet( file.GetDataSet() );
+  const gdcm::ByteValue *bv =
+    file.GetDataSet().GetDataElement( gdcm::Tag(0x7fe0,0x10) ).GetByteValue();
+  if( file.GetHeader().GetDataSetTransferSyntax() != ts
+    || file.GetHeader().GetMediaStorage() != gdcm::MediaStorage::SecondaryCaptureImageStorage
+    || pid.GetValue() != "12345678"
+    || !bv || bv->GetLength() != 1000 || bv->GetPointer()[999] != (char)999 )
+    {
+    std::cerr << "Wrong file received" << std::endl;
+    return 1;
+    }
+
+  // Resend interrupted by an A-ABORT: the copy already stored is kept, and
+  // no temporary file is left behind
+  std::string truncated = pdus.str().substr( 0, 2 * 112 );
+  truncated += std::string( "\x07\x00\x00\x00\x00\x04\x00\x00\x00\x00", 10 );
+  std::stringstream interrupted( truncated );
+  FileCallback callback2;
+  callback2.SetDirectory( tmpdir );
+  callback2.SetIncremental( true );
+  os = callback2.BeginDataSet( command, ts );
+  if( !os || gdcm::network::PDUFactory::ReadDataSetInto( interrupted, *os, pdu ) || !pdu )
+    {
+    std::cerr << "Interrupted transfer not detected" << std::endl;
+    return 1;
+    }
+  delete pdu;
+  if( callback2.EndDataSet( false ) || !callback2.Files.empty() )
+    {
+    std::cerr << "Interrupted transfer reported as stored" << std::endl;
+    return 1;
+    }
+  gdcm::Directory dir;
+  dir.Load( tmpdir );
+  if( dir.GetFilenames().size() != 1 || dir.GetFilenames()[0] != filename )
+    {
+    std::cerr << "Interrupted transfer should leave the stored file only" << std::endl;
+    return 1;
+    }
+  gdcm::Reader reader2;
+  reader2.SetFileName( filename.c_str() );
+  if( !reader2.Read() )
+    {
+    std::cerr << "Stored file was damaged: " << filename << std::endl;
+    return 1;
+    }
+
+  // A peer sending a UID which is not one cannot write outside of the directory
+  const char evil[] = "../TestULWritingCallbackEvil";
+  gdcm::CommandDataSet evilcommand( command );
+  gdcm::DataElement evilde( gdcm::Tag(0x0,0x1000) );
+  evilde.SetVR( gdcm::VR::UI );
+  evilde.SetByteValue( evil, (uint32_t)strlen(evil) );
+  evilcommand.Replace( evilde );
+  FileCallback callback3;
+  callback3.SetDirectory( tmpdir );
+  callback3.SetIncremental( true );
+  if( callback3.AcceptDataSet( evilcommand ) || callback3.BeginDataSet( evilcommand, ts ) )
+    {
+    std::cerr << "Invalid Affected SOP Instance UID accepted" << std::endl;
+    return 1;
+    }
+  callback3.SetIncremental( false );
+  gdcm::DataSet evilds = file.GetDataSet();
+  evilde.SetTag( gdcm::Tag(0x8,0x18) );
+  evilds.Replace( evilde );
+  callback3.HandleDataSet( evilds );
+  const std::string evilname = tmpdir + "/" + evil + ".dcm";
+  if( gdcm::System::FileExists( evilname.c_str() ) )
+    {
+    std::cerr << "Written outside of the directory: " << evilname << std::endl;
+    return 1;
+    }
+
+  return 0;
+}